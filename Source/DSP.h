@@ -19,269 +19,2156 @@ typedef float TAudioSampleType;
 typedef TAudioSampleType TFloatParamType;
 typedef int TIntegerParamType;
 
-typedef struct {
-    TFloatParamType a0, a1, a2, b1, b2;
-} LRCoefficients;
+#include <type_traits>
 
+//RRS: The audio path is also available in double precision: DSPT<double> (and the FilterT, OversamplerT... it is built from) keeps
+//RRS: coefficients, states and samples in double, while parameters (drive, mix, frequencies) stay TFloatParamType. Inside those
+//RRS: templates TAudioSampleType names their own sample type; DSP, Filter etc. below are the float instances.
 
-struct Filter{
+template <typename TSample>
+struct LRCoefficientsT {
+    TSample a0, a1, a2, b1, b2;
+};
+
+// One biquad advanced 4 samples at a time in state-space form, with s = (w[n-1], w[n-2]) of the DF2 sections below:
+//   y[n+k] = os0[k] s0 + os1[k] s1 + sum_j t[j][k] x[n+j]      s' = ps0 s0 + ps1 s1 + sum_j k[j] x[n+j]
+template <typename TSample>
+struct BlockLRCoefficientsT {
+    TSample os0[4], os1[4];     // output response to the incoming state
+    TSample t[4][4];            // t[j][k]: output k to input j (h[k - j], zero above the diagonal)
+    TSample ps0[2], ps1[2];     // A^4
+    TSample k[4][2];            // A^(3 - j) B
+};
+
+typedef LRCoefficientsT<TAudioSampleType> LRCoefficients;
+typedef BlockLRCoefficientsT<TAudioSampleType> BlockLRCoefficients;
+
+
+template <typename TSample>
+struct FilterT{
+
+    typedef TSample TAudioSampleType;
+    typedef LRCoefficientsT<TSample> LRCoefficients;
+    typedef BlockLRCoefficientsT<TSample> BlockLRCoefficients;
     
     LRCoefficients hpfCoeffs;
     LRCoefficients lpfCoeffs;
+    TAudioSampleType apfCoeff;  // first-order allpass the LR2 pair sums to: (apfCoeff + z^-1) / (1 + apfCoeff z^-1)
+    BlockLRCoefficients hpfBlock;
+    BlockLRCoefficients lpfBlock;
     
     
+    // LR2 = two identical first-order sections: with t = tan(pi f / fs) and a = (t - 1) / (t + 1) the shared denominator is
+    // (1 + a z^-1)^2. Computed in double, and the gains are normalized from the rounded denominator, so the LP has unit
+    // gain at DC, the HP at Nyquist, and LP + inverted HP stays the allpass of apfLRCoeffs() at any crossover frequency.
+    static double _lrPole(TFloatParamType f_crossover, TFloatParamType fs)
+    {
+        double t = tan(M_PI * (double) f_crossover / (double) fs);
+        return (t - 1.0) / (t + 1.0);
+    }
+
     void hpfLRCoeffs(TFloatParamType f_crossover, TFloatParamType fs)
     {
-        TFloatParamType theta = M_PI * f_crossover / fs;
-        TFloatParamType Wc = M_PI * f_crossover;
-        TFloatParamType k = Wc / tan(theta);
-        TFloatParamType d = pow(k, 2.0) + pow(Wc, 2.0) + 2.0 * k * Wc;
-        
-        hpfCoeffs.a0 = pow(Wc, 2.0) / d;
-        hpfCoeffs.a1 = -2.0 * pow(Wc, 2.0) / d;
-        hpfCoeffs.a2 = hpfCoeffs.a0;
-        hpfCoeffs.b1 = (-2.0 * pow(k, 2.0) + 2.0 * pow(Wc, 2.0)) / d;
-        hpfCoeffs.b2 = (-2.0 * k * Wc + pow(k, 2.0) + pow(Wc, 2.0)) / d;
+        _hpfFromPole((TAudioSampleType) _lrPole(f_crossover, fs));
     }
 
     void lpfLRCoeffs(TFloatParamType f_crossover, TFloatParamType fs)
     {
-        TFloatParamType theta = M_PI * f_crossover / fs;
-        TFloatParamType Wc = M_PI * f_crossover;
-        TFloatParamType k = Wc / tan(theta);
-        TFloatParamType d = pow(k, 2.0) + pow(Wc, 2.0) + 2.0 * k * Wc;
-        
-        lpfCoeffs.a0 = pow(Wc, 2.0) / d;
-        lpfCoeffs.a1 = 2.0 * pow(Wc, 2.0) / d;
+        _lpfFromPole((TAudioSampleType) _lrPole(f_crossover, fs));
+    }
+
+    // LP + inverted HP = (Wc - s) / (Wc + s), bilinear with the same prewarping as the pair
+    void apfLRCoeffs(TFloatParamType f_crossover, TFloatParamType fs)
+    {
+        apfCoeff = (TAudioSampleType) _lrPole(f_crossover, fs);
+    }
+
+    //RRS: Every coefficient set (LP, HP, allpass, block form) from a pole looked up in CrossoverCoefficientCache: no transcendental calls,
+    //RRS: no allocations, safe on the audio thread
+    void setLRPole(TAudioSampleType a)
+    {
+        _hpfFromPole(a);
+        _lpfFromPole(a);
+        apfCoeff = a;
+        blockLRCoeffs();
+    }
+
+    void _hpfFromPole(TAudioSampleType a)
+    {
+        hpfCoeffs.b1 = 2.0f * a;
+        hpfCoeffs.b2 = a * a;
+        hpfCoeffs.a0 = (TAudioSampleType) ((1.0 - (double) hpfCoeffs.b1 + (double) hpfCoeffs.b2) / 4.0);
+        hpfCoeffs.a1 = -2.0f * hpfCoeffs.a0;
+        hpfCoeffs.a2 = hpfCoeffs.a0;
+    }
+
+    void _lpfFromPole(TAudioSampleType a)
+    {
+        lpfCoeffs.b1 = 2.0f * a;
+        lpfCoeffs.b2 = a * a;
+        lpfCoeffs.a0 = (TAudioSampleType) ((1.0 + (double) lpfCoeffs.b1 + (double) lpfCoeffs.b2) / 4.0);
+        lpfCoeffs.a1 = 2.0f * lpfCoeffs.a0;
         lpfCoeffs.a2 = lpfCoeffs.a0;
-        lpfCoeffs.b1 = (-2.0 * pow(k, 2.0) + 2.0 * pow(Wc, 2.0)) / d;
-        lpfCoeffs.b2 = (-2.0 * k * Wc + pow(k, 2.0) + pow(Wc, 2.0)) / d;
     }
 
-    TFloatParamType lowpass_filter(TFloatParamType input, TFloatParamType *state1, TFloatParamType *state2, TFloatParamType a0, TFloatParamType a1, TFloatParamType a2, TFloatParamType b1, TFloatParamType b2) {
-        TFloatParamType output = a0 * input + a1 * (*state1) + a2 * (*state2);
+    // State map for a pole change from aOld to aNew: w' = C(aNew)^-1 C(aOld) w, with C the zero-input response of the LP and HP
+    // sections to (w[n-1], w[n-2])
+    static void _lrStateMap(double aOld, double aNew, double m[2][2])
+    {
+        // Rows LP then HP: a1 - a0 b1 and a2 - a0 b2 of each section
+        double c[2][2][2];
+
+        for (int k = 0; k < 2; ++k)
+        {
+            double a = k == 0 ? aOld : aNew;
+            double gl = (1.0 + a) * (1.0 + a) / 4.0, gh = (1.0 - a) * (1.0 - a) / 4.0;
+            c[k][0][0] = gl * 2.0 * (1.0 - a);   c[k][0][1] = gl * (1.0 - a * a);
+            c[k][1][0] = -gh * 2.0 * (1.0 + a);  c[k][1][1] = gh * (1.0 - a * a);
+        }
+
+        double det = c[1][0][0] * c[1][1][1] - c[1][0][1] * c[1][1][0];
+        double inv[2][2] = { {  c[1][1][1] / det, -c[1][0][1] / det },
+                             { -c[1][1][0] / det,  c[1][0][0] / det } };
+
+        for (int i = 0; i < 2; ++i)
+            for (int j = 0; j < 2; ++j)
+                m[i][j] = inv[i][0] * c[0][0][j] + inv[i][1] * c[0][1][j];
+    }
+
+    // Block form of both sections, for the time-parallel kernels; call after hpfLRCoeffs()/lpfLRCoeffs()
+    void blockLRCoeffs()
+    {
+        _blockCoeffs(hpfCoeffs, hpfBlock);
+        _blockCoeffs(lpfCoeffs, lpfBlock);
+    }
+
+    // Every column is the response of 4 DF2 steps (run in double) to one unit state or input
+    static void _blockCoeffs(const LRCoefficients& c, BlockLRCoefficients& block)
+    {
+        for (int unit = 0; unit < 6; ++unit)
+        {
+            double s1 = unit == 0 ? 1.0 : 0.0, s2 = unit == 1 ? 1.0 : 0.0;
+
+            for (int n = 0; n < 4; ++n)
+            {
+                double x = unit - 2 == n ? 1.0 : 0.0;
+                double w = x - c.b1 * s1 - c.b2 * s2;
+                double y = c.a0 * w + c.a1 * s1 + c.a2 * s2;
+                s2 = s1;
+                s1 = w;
+
+                if (unit == 0)      block.os0[n] = (TAudioSampleType) y;
+                else if (unit == 1) block.os1[n] = (TAudioSampleType) y;
+                else                block.t[unit - 2][n] = (TAudioSampleType) y;
+            }
+
+            TAudioSampleType* p = unit == 0 ? block.ps0 : (unit == 1 ? block.ps1 : block.k[unit - 2]);
+            p[0] = (TAudioSampleType) s1;
+            p[1] = (TAudioSampleType) s2;
+        }
+    }
+
+    // Direct Form II: state1/state2 hold w[n-1]/w[n-2]
+    TAudioSampleType lowpass_filter(TAudioSampleType input, TAudioSampleType *state1, TAudioSampleType *state2, TAudioSampleType a0, TAudioSampleType a1, TAudioSampleType a2, TAudioSampleType b1, TAudioSampleType b2) const {
+        TAudioSampleType w = input - b1 * (*state1) - b2 * (*state2);
+        TAudioSampleType output = a0 * w + a1 * (*state1) + a2 * (*state2);
         *state2 = *state1;
-        *state1 = input - b1 * (*state1) - b2 * (*state2);
+        *state1 = w;
         return output;
     }
 
-    TFloatParamType highpass_filter(TFloatParamType input, TFloatParamType *state1, TFloatParamType *state2, TFloatParamType a0, TFloatParamType a1, TFloatParamType a2, TFloatParamType b1, TFloatParamType b2) {
+    TAudioSampleType highpass_filter(TAudioSampleType input, TAudioSampleType *state1, TAudioSampleType *state2, TAudioSampleType a0, TAudioSampleType a1, TAudioSampleType a2, TAudioSampleType b1, TAudioSampleType b2) const {
         
-        TFloatParamType output = a0 * input + a1 * (*state1) + a2 * (*state2);
+        TAudioSampleType w = input - b1 * (*state1) - b2 * (*state2);
+        TAudioSampleType output = a0 * w + a1 * (*state1) + a2 * (*state2);
         *state2 = *state1;
-        *state1 = input - b1 * (*state1) - b2 * (*state2);
-        return output * (-1);
+        *state1 = w;
+        return output * (-1); // LR2: inverted high band sums with the low band to an allpass
+    }
+
+    // First-order allpass (a + z^-1) / (1 + a z^-1), transposed DF2: state holds s[n-1]
+    TAudioSampleType allpass_filter(TAudioSampleType input, TAudioSampleType *state, TAudioSampleType a) const {
+        TAudioSampleType output = a * input + *state;
+        *state = input - a * output;
+        return output;
+    }
+};
+
+typedef FilterT<TAudioSampleType> Filter;
+
+//RRS: The LR2 pole a(f) at one sample rate, tabulated by SetSampleRate() so crossover changes need no tan() on the audio thread.
+//RRS: frexp() gives the octave above kMinFrequency; within an octave the entries are linear in f, as is 1 + a ~ 2 pi f / fs at low f,
+//RRS: and the lookup interpolates linearly between them.
+template <typename TSample>
+struct CrossoverCoefficientCacheT
+{
+    typedef TSample TAudioSampleType;
+
+    enum { kStepsPerOctave = 32, kOctaves = 15 };   // 10 Hz .. 327 kHz
+    static constexpr TFloatParamType kMinFrequency = 10.f;
+
+    TFloatParamType fs;                             // 0 until Build()
+    TFloatParamType fMax;
+    TAudioSampleType poles[kOctaves * kStepsPerOctave + 1];
+
+    void Build(TFloatParamType a_fSampleRate)
+    {
+        fs = a_fSampleRate;
+        fMax = 0.49f * fs;
+
+        for (int i = 0; i <= kOctaves * kStepsPerOctave; ++i)
+        {
+            double f = ldexp(kMinFrequency * (1.0 + (double) (i % kStepsPerOctave) / kStepsPerOctave), i / kStepsPerOctave);
+            poles[i] = (TAudioSampleType) FilterT<TSample>::_lrPole((TFloatParamType) (f < 0.4999 * fs ? f : 0.4999 * fs), fs);
+        }
+    }
+
+    TAudioSampleType Pole(TFloatParamType f) const { return PoleAt(Position(f)); }
+
+    //RRS: Continuous table position of f, roughly log-frequency: crossover glides are interpolated in this domain
+    TFloatParamType Position(TFloatParamType f) const
+    {
+        TFloatParamType x = (f < kMinFrequency ? kMinFrequency : (f > fMax ? fMax : f)) / kMinFrequency;
+        int octave;
+        TFloatParamType m = frexpf(x, &octave);     // x = m * 2^octave, m in [0.5, 1)
+
+        return (TFloatParamType) ((octave - 1) * kStepsPerOctave) + (2.f * m - 1.f) * kStepsPerOctave;
+    }
+
+    TAudioSampleType PoleAt(TFloatParamType position) const
+    {
+        int i = (int) position;
+        i = i < 0 ? 0 : (i >= kOctaves * kStepsPerOctave ? kOctaves * kStepsPerOctave - 1 : i);
+
+        return poles[i] + (position - (TFloatParamType) i) * (poles[i + 1] - poles[i]);
+    }
+};
+
+typedef CrossoverCoefficientCacheT<TAudioSampleType> CrossoverCoefficientCache;
+
+//RRS: Linear glide to the latest target over a fixed number of samples, advanced block by block: each block gets its start value and
+//RRS: a per-sample increment. SetTarget() with a new value restarts the glide from wherever it is; length 0 reaches it over the next block.
+struct ParameterSmoother
+{
+    TFloatParamType current, target;
+    TIntegerParamType remaining;    // samples left in the glide
+    TIntegerParamType length;       // samples per glide
+
+    void Reset(TFloatParamType a_fValue)
+    {
+        current = target = a_fValue;
+        remaining = 0;
+    }
+
+    void SetTarget(TFloatParamType a_fValue)
+    {
+        if (a_fValue == target)
+            return;
+
+        target = a_fValue;
+        remaining = length > 0 ? length : 1;
+    }
+
+    bool IsRamping() const { return remaining > 0; }
+
+    void Next(TIntegerParamType a_nSampleCount, TFloatParamType& a_fStart, TFloatParamType& a_fIncrement)
+    {
+        a_fStart = current;
+        a_fIncrement = 0.f;
+
+        if (remaining <= 0 || a_nSampleCount <= 0)
+            return;
+
+        TIntegerParamType step = a_nSampleCount < remaining ? a_nSampleCount : remaining;
+        TFloatParamType end = step == remaining ? target : current + (target - current) * (TFloatParamType) step / (TFloatParamType) remaining;
+
+        a_fIncrement = (end - current) / (TFloatParamType) a_nSampleCount;
+        current = end;
+        remaining -= step;
+    }
+};
+
+//RRS: Samples until the zero-input response of a_nOrder coincident real poles at a_fPole has decayed to a_fTolerance of where it
+//RRS: started, using the envelope C(n + order - 1, order - 1) |a|^n. Used to size warm-up (pre-roll) runs.
+static inline TIntegerParamType pole_settling_samples(double a_fPole, TIntegerParamType a_nOrder, double a_fTolerance)
+{
+    const double r = fabs(a_fPole);
+    if (r < 1e-12)
+        return a_nOrder;
+
+    const double logTolerance = log(a_fTolerance), logR = log(r);
+    double logEnvelope = 0.0;
+    TIntegerParamType n = 0;
+
+    while (logEnvelope > logTolerance && n < (1 << 24))
+    {
+        logEnvelope += log((double) (n + a_nOrder) / (double) (n + 1)) + logR;
+        ++n;
     }
+
+    return n;
+}
+
+//RRS: All of a DSP's state and scratch lives in one block, aligned to a cache line and handed out front to back by Take(), every
+//RRS: array starting on a line of its own. The layout is written down once (DSP::_CarveArena()) and run twice: first on an arena
+//RRS: without memory, which only measures (Take() returns NULL, nothing may be written), then on the real one.
+struct MemoryArena
+{
+    enum { kAlignment = 64 };
+
+    void* raw;              // as returned by malloc()
+    unsigned char* base;    // raw, aligned up; NULL while measuring
+    size_t capacity;
+    size_t used;
+
+    void Init() { raw = NULL; base = NULL; capacity = used = 0; }
+
+    bool IsMeasuring() const { return base == NULL; }
+
+    template <typename T>
+    T* Take(size_t a_nCount)
+    {
+        size_t offset = (used + kAlignment - 1) & ~(size_t) (kAlignment - 1);
+        used = offset + a_nCount * sizeof(T);
+        return base != NULL ? (T*) (base + offset) : NULL;
+    }
+
+    //RRS: Room for a_nBytes, zeroed and ready to be carved again; only allocates when it has to grow. Memory allocations are allowed inside
+    void Reserve(size_t a_nBytes)
+    {
+        if (a_nBytes > capacity || base == NULL)
+        {
+            free(raw);
+            raw = malloc(a_nBytes + kAlignment - 1);
+            base = (unsigned char*) (((uintptr_t) raw + kAlignment - 1) & ~(uintptr_t) (kAlignment - 1));
+            capacity = a_nBytes;
+        }
+
+        memset(base, 0, a_nBytes);
+        used = 0;
+    }
+
+    void Release()
+    {
+        free(raw);
+        Init();
+    }
+};
+
+// 2-band crossover states of a group of 4 channels, one cache line (two in double): [LP w1 | HP w1 | LP w2 | HP w2], a lane per
+// channel, so a channel's whole hot state sits together and the SIMD kernels load the lanes of 4 (or 2) channels at once
+enum CrossoverStateLayout
+{
+    kStateLow1 = 0,
+    kStateHigh1 = 4,
+    kStateLow2 = 8,
+    kStateHigh2 = 12,
+    kStateGroup = 16
+};
+
+#include "DSPRealtime.h"
+#include "DSPSimd.h"
+#include "DSPFormats.h"
+#include "DSPWorkers.h"
+#include "DSPOversampling.h"
+
+enum SaturationMode
+{
+    kSaturationNaive = 0,   // tubeSaturation() per sample
+    kSaturationADAA1,       // first-order antiderivative anti-aliasing, half a sample of delay
+    kSaturationADAA2        // second-order antiderivative anti-aliasing, one sample of delay
+};
+
+enum FilterKernel
+{
+    kFilterKernelSequential = 0,    // channels that do not fill a SIMD lane group run one sample at a time
+    kFilterKernelTimeParallel       // ... or 4 samples per vector step (lr_process_block_sse2), so mono gets SIMD too
+};
+
+enum CrossoverTopology
+{
+    kCrossoverTwoFilter = 0,    // independent LP and HP sections
+    kCrossoverComplementary     // LP section only, the (inverted) high band is allpass(x) - LP(x): one biquad less per split
+};
+
+#include "DSPMultiband.h"
+#include "DSPLinearPhase.h"
+#include "DSPMetering.h"
+#include "DSPPreset.h"
+
+//RRS: Per-channel history of the ADAA saturator (kept in double: the divided differences cancel badly in float)
+struct AdaaState
+{
+    double x1, x2;      // previous two inputs
+    double ad1;         // tubeSaturationAD1(x1) for ADAA1, the previous divided difference of AD2 for ADAA2
+    double dry1;        // previous undriven input, to line the dry signal up with the ADAA delay for the mix
 };
 
 
-struct DSP
+//RRS: TSample is float (DSP) or double; each gets its own kernels, picked at compile time
+template <typename TSample>
+struct DSPT
 {
+    typedef TSample TAudioSampleType;
+    typedef FilterT<TSample> Filter;
+    typedef LRCoefficientsT<TSample> LRCoefficients;
+    typedef OversamplerT<TSample> Oversampler;
+    typedef MultibandCrossoverT<TSample> MultibandCrossover;
+    typedef LinearPhaseCrossoverT<TSample> LinearPhaseCrossover;
+    typedef PresetSnapshotT<TSample> PresetSnapshot;
     
-    TFloatParamType* high_states_1;
-    TFloatParamType* high_states_2;
-    TFloatParamType* low_states_1;
-    TFloatParamType* low_states_2;
-    TFloatParamType* outputSamples;
-    TFloatParamType* low_outputs;
-    TFloatParamType* high_outputs;
-    TFloatParamType* dist_lows;
+    // Everything below that points to memory points into _arena, which Release() frees in one go
+    MemoryArena _arena = { NULL, NULL, 0, 0 };
+
+    TAudioSampleType* crossoverStates;  // CrossoverStateLayout groups, see _CrossoverStates()
+    TAudioSampleType* allpass_states;   // complementary topology only
+    TIntegerParamType _nTopology;
     
     
     TFloatParamType f_crossover = 0.f; // Crossover frequency
     TFloatParamType initValue = 0.f;
     Filter* filters;
 
-    TAudioSampleType** inBuffer;
-    TAudioSampleType** outBuffer;
-
+    // What the arena is carved for; they only grow (see Preallocate()), and so do the oversampling factor and linear-phase kernel
+    // length the arena has been sized for
     TIntegerParamType _nMaxChannels;
     TIntegerParamType _nMaxBlockSize;
-    TFloatParamType _fGain_01;
+    TIntegerParamType _nPreallocatedOversampling;
+    TIntegerParamType _nPreallocatedKernel;
+    TIntegerParamType _nSimdLevel;
+    TIntegerParamType _nFilterKernel;
     TFloatParamType fs;
+    CrossoverCoefficientCacheT<TSample> crossoverCache;
+
+    // Parameters glide to the values set by the setters over _fSmoothingTime_ms; the crossover in cache position
+    ParameterSmoother _gain, _drive, _mix, _crossover;
+    TFloatParamType _fSmoothingTime_ms;
+    TAudioSampleType** _vSubBlocks;     // channel pointers into the host block while the crossover glides
+
+    TIntegerParamType _nSaturationMode;
+    AdaaState* adaaStates;
+
+    // Low-band oversampling (see DSPOversampling.h)
+    TIntegerParamType _nOversampling;
+    TIntegerParamType _nOversamplingMode;
+    TIntegerParamType _nOversampledChannels;
+    TIntegerParamType _nLatency;
+    Oversampler* oversamplers;
+    TAudioSampleType* lowBand;          // one block of low band per channel group, reused for each channel in it
+    TAudioSampleType* highDelay;        // _nLatency samples per channel, delays the dry high band to match
+    TIntegerParamType* highDelayPos;
+
+    // N-band crossover tree (see DSPMultiband.h), used instead of the 2-band path when _bMultiband
+    MultibandCrossover multiband;
+    bool _bMultiband;
+
+    // FIR split in place of the LR2 filters of the 2-band path (see DSPLinearPhase.h), when _bLinearPhase
+    LinearPhaseCrossover linearPhase;
+    bool _bLinearPhase;
+
+    // Telemetry for the editor (see DSPMetering.h), when SetTelemetry() has given somewhere to put it. The band sums are per channel
+    // group, [group][band], so workers never share one; the calling thread folds them into the ballistics below once per block
+    BandMeterBuffer* _pMeters;
+    SpectrumAnalyzer* _pAnalyzer;
+    MeterSums* meterSums;
+    double _meterPeak[BandMeterFrame::kMaxBands];
+    double _meterMeanSquare[BandMeterFrame::kMaxBands];
+    double _meterActivity[BandMeterFrame::kMaxBands];
+    uint64_t _nMeterBlocks;
+
+    // Channel groups are spread over these workers, when set (see SetWorkerPool())
+    WorkerPool* _pWorkers;
+
+    // Silence fast path (see Process()): once the input is digital silence and every state has decayed below _kSilenceThreshold,
+    // the states are flushed to zero and Process() does nothing until the input is non-zero again
+    bool _bSkipSilence;
+    bool _bIdle;
+
+    // ProcessInterleaved() runs Process() on _nInterleavedChunk frames at a time, deinterleaved into interleavedBlocks (a channel
+    // each, _vInterleavedBlocks points at them); integer frames are converted through interleavedScratch on the way in and out
+    TIntegerParamType _nInterleavedChunk;
+    TAudioSampleType* interleavedBlocks;
+    TAudioSampleType* interleavedScratch;
+    TAudioSampleType** _vInterleavedBlocks;
+    uint32_t _dither[4];                // TPDF dither generators of the integer outputs, see DSPFormats.h
+    bool _bDither;
+
+    // Preset switching (see DSPPreset.h): SubmitPreset() designs into the spare one of _presetSnapshots and bumps _nPresetPublished,
+    // Process() copies the published one in and bumps _nPresetAdopted. While _nFadeRemaining > 0 the 2-band split runs the old filter
+    // (_fadeFilter, on fadeStates and fadeAllpass: the states as they were at the switch) beside the new one, and crossfades the bands
+    PresetSnapshot _presetSnapshots[2];
+    std::atomic<uint32_t> _nPresetPublished { 0 };
+    std::atomic<uint32_t> _nPresetAdopted { 0 };
+    Filter _fadeFilter;
+    TAudioSampleType* fadeStates;       // CrossoverStateLayout, like crossoverStates
+    TAudioSampleType* fadeAllpass;
+    TIntegerParamType _nFadeLength;
+    TIntegerParamType _nFadeRemaining;
+    TFloatParamType _fadeWeight;        // of the new filter, at the first sample of the (sub-)block being processed
+    TFloatParamType _fadeWeightInc;
 
     
     void Init() {
-        inBuffer =  NULL;
-        outBuffer =  NULL;
+        // Starting over: whatever a previous round allocated goes first. Called once per instance; reconfiguring later goes through
+        // Preallocate() and the setters, which keep the memory (and the states) whenever the layout allows
+        _arena.Release();
+
+        fs = 0;
+        crossoverCache.fs = 0;
         _nMaxChannels = 1;
         _nMaxBlockSize = 1;
-        _fGain_01 = 1;
+        _nPreallocatedOversampling = 1;
+        _nPreallocatedKernel = 0;
+        _fSmoothingTime_ms = 20;
+        _gain.Reset(1);
+        _drive.Reset(1);
+        _mix.Reset(1);
+        _crossover.Reset(0);
+        _gain.length = _drive.length = _mix.length = _crossover.length = 0;
+        _vSubBlocks = NULL;
+        _nSimdLevel = simd_detect_level();
+        _nFilterKernel = kFilterKernelTimeParallel;
         
-        high_states_1 =  NULL;
-        high_states_2 =  NULL;
-        low_states_1 =  NULL;
-        low_states_2 =  NULL;
-        outputSamples =  NULL;
-        low_outputs =  NULL;
-        high_outputs =  NULL;
-        dist_lows =  NULL;
+        crossoverStates = NULL;
+        filters = NULL;
+        allpass_states = NULL;
+        _nTopology = kCrossoverTwoFilter;
+
+        _nSaturationMode = kSaturationNaive;
+        adaaStates = NULL;
+
+        _nOversampling = 1;
+        _nOversamplingMode = kOversamplingQuality;
+        _nOversampledChannels = 0;
+        _nLatency = 0;
+        oversamplers = NULL;
+        lowBand = NULL;
+        highDelay = NULL;
+        highDelayPos = NULL;
+
+        multiband.Init();
+        _bMultiband = false;
+
+        linearPhase.Init();
+        _bLinearPhase = false;
+
+        _pMeters = NULL;
+        _pAnalyzer = NULL;
+        meterSums = NULL;
+        for (TIntegerParamType b = 0; b < BandMeterFrame::kMaxBands; ++b)
+            _meterPeak[b] = _meterMeanSquare[b] = _meterActivity[b] = 0;
+        _nMeterBlocks = 0;
+
+        _pWorkers = NULL;
+
+        _bSkipSilence = true;
+        _bIdle = false;
+
+        interleavedBlocks = NULL;
+        interleavedScratch = NULL;
+        _vInterleavedBlocks = NULL;
+        _nInterleavedChunk = 0;
+        dither_seed(_dither, 1);
+        _bDither = false;
+
+        _nPresetPublished.store(0);
+        _nPresetAdopted.store(0);
+        fadeStates = NULL;
+        fadeAllpass = NULL;
+        _nFadeLength = 0;
+        _nFadeRemaining = 0;
+        _fadeWeight = 1.f;
+        _fadeWeightInc = 0.f;
         
     } //RRS: All initializations needed for your DSP, memory allocations are allowed inside
 
+    //RRS: Grows the buffers for blocks of up to a_nMaxBlockSize; a smaller size keeps the larger buffers, and the states with them.
     //RRS: Memory allocations are allowed inside
     void SetMaxBlockSize(TIntegerParamType a_nMaxBlockSize)
     {
-        if (_nMaxBlockSize != a_nMaxBlockSize)
+        // Process() works directly on the host buffers; only the oversampling scratch and the block-wise buffers are sized by the block
+        // length
+        if (a_nMaxBlockSize > _nMaxBlockSize || !_IsCarved())
         {
-            _nMaxBlockSize = a_nMaxBlockSize;
+            _nMaxBlockSize = a_nMaxBlockSize > _nMaxBlockSize ? a_nMaxBlockSize : _nMaxBlockSize;
 
-            _ReAllocInternalBuffers(_nMaxChannels);
+            _ReBuildArena();
         }
     }
     
+    //RRS: Once SetSampleRate() has built the coefficient cache, Process() glides the coefficients to the new crossover (see SetSmoothingTime());
+    //RRS: before that the value is only stored. Assertion: No memory allocations are allowed inside!
     void SetCrossoverFrequency(TFloatParamType a_nCrossoverFreq)
     {
         f_crossover = a_nCrossoverFreq;
+        multiband.splitFrequency[0] = a_nCrossoverFreq;
+        linearPhase.SetWantedFrequency(a_nCrossoverFreq);
+
+        if (crossoverCache.fs > 0)
+            _crossover.SetTarget(crossoverCache.Position(f_crossover));
     }
-    
-    //RRS: Memory allocations are allowed inside
-    void SetMaxChannels(TIntegerParamType a_nMaxChannels)
+
+    // Coefficients of the 2-band split (and split 0 of the multiband tree) from an interpolated pole, or copied from a_pDesigned (a
+    // preset snapshot's, with pole a) when given.
+    // The DF2 states w hold x / A(z), whose level moves with the pole, so they are remapped as well: both sections share A(z), and
+    // the new states are the ones for which the zero-input LP and HP outputs (one row each of the observation matrix C) stay the same.
+    void _SetCrossoverPole(TAudioSampleType a, const Filter* a_pDesigned = NULL)
     {
-        if (_nMaxChannels != a_nMaxChannels)
-            _ReAllocInternalBuffers(a_nMaxChannels);
+        double m[2][2];
+        Filter::_lrStateMap(filters[0].apfCoeff, a, m);
 
-        filters = (Filter*) malloc(2 * sizeof(Filter));
+        for (TIntegerParamType channel = 0; channel < _nMaxChannels; channel++)
+        {
+            if (a_pDesigned != NULL)
+                filters[channel] = *a_pDesigned;
+            else
+                filters[channel].setLRPole(a);
 
-        high_states_1 = (TFloatParamType*) malloc(_nMaxChannels);
-        high_states_2 = (TFloatParamType*) malloc(_nMaxChannels);
-        low_states_1 = (TFloatParamType *) malloc(_nMaxChannels);
-        low_states_2 = (TFloatParamType *) malloc(_nMaxChannels);
-        outputSamples = (TFloatParamType *) malloc(_nMaxChannels);
-        low_outputs = (TFloatParamType *) malloc(_nMaxChannels);
-        high_outputs = (TFloatParamType *) malloc(_nMaxChannels);
-        dist_lows = (TFloatParamType *) malloc(_nMaxChannels);
-    }
+            TAudioSampleType* st = _CrossoverStates(channel);
 
-    //RRS: Sample rate is not constant, so you have to reinitialize your sample rate dependent params (such as filters coeffs) on this call from our framework
-    void SetSampleRate(TFloatParamType a_fSampleRate_Hz) {
-        fs = a_fSampleRate_Hz;
-        
-        for(TIntegerParamType channel = 0; channel < _nMaxChannels; channel++)
-        {
-            filters[channel].hpfLRCoeffs(f_crossover, fs);
-            filters[channel].lpfLRCoeffs(f_crossover, fs);
+            double w1 = st[kStateLow1], w2 = st[kStateLow2];
+            st[kStateLow1] = (TAudioSampleType) (m[0][0] * w1 + m[0][1] * w2);
+            st[kStateLow2] = (TAudioSampleType) (m[1][0] * w1 + m[1][1] * w2);
+
+            w1 = st[kStateHigh1]; w2 = st[kStateHigh2];
+            st[kStateHigh1] = (TAudioSampleType) (m[0][0] * w1 + m[0][1] * w2);
+            st[kStateHigh2] = (TAudioSampleType) (m[1][0] * w1 + m[1][1] * w2);
         }
-    } //RRS: Memory allocations are allowed inside
 
-    void SetGain(TFloatParamType a_fGain_01) { _fGain_01 = a_fGain_01; } //RRS: Assertion: No memory allocations are allowed inside!
-    void SetSomeParam1(TFloatParamType a_fSomeParam1Value) {} //RRS: Assertion: No memory allocations are allowed inside!
-    void SetSomeParam2(TFloatParamType a_fSomeParam2Value) {} //RRS: Assertion: No memory allocations are allowed inside!
-        
-    void Release() { _ReleaseInternalBuffers();
-        //RRS: All previously allocated memory can be deallocated here
-    }
-    
-    float ProcessSampleLow(TFloatParamType* readData, Filter channelFilter, TIntegerParamType channel, TIntegerParamType index){
-        auto sample = channelFilter.lowpass_filter(readData[index], &low_states_1[channel], &low_states_2[channel], channelFilter.lpfCoeffs.a0, channelFilter.lpfCoeffs.a1, channelFilter.lpfCoeffs.a2, channelFilter.lpfCoeffs.b1, channelFilter.lpfCoeffs.b2);
-        
-        return sample;
+        if (a_pDesigned != NULL)
+            multiband.splits[0] = *a_pDesigned;
+        else
+            multiband.splits[0].setLRPole(a);
+        multiband.MapSplitStates(0, m);
     }
 
-    float ProcessSampleHigh(TFloatParamType* readData, Filter channelFilter, TIntegerParamType channel, TIntegerParamType index){
-        auto sample = channelFilter.highpass_filter(readData[index], &high_states_1[channel], &high_states_2[channel], channelFilter.hpfCoeffs.a0, channelFilter.hpfCoeffs.a1, channelFilter.hpfCoeffs.a2, channelFilter.hpfCoeffs.b1, channelFilter.hpfCoeffs.b2);
-        
-        return sample;
-    }
-        
-        
-    //RRS: Assertion: No memory allocations are allowed inside!
-    void Process(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType a_nChannels, TIntegerParamType a_nSampleCount)
+    //RRS: Number of bands, 1..8 (default 2: saturated low band, clean high band). Assertion: No memory allocations are allowed inside!
+    void SetNumBands(TIntegerParamType a_nBands)
     {
-        //RRS: Assertion: a_nChannels less or equal _nMaxChannels set in SetMaxChannels()
-        //RRS: Assertion: a_nSampleCount less or equal _nMaxBlockSize set in SetMaxBlockSize()
-        
-        //RRS: Here we copy the input audio data into internal buffers, apply Gain and then copy the processed data back to the input buffers (in-place).
-        //RRS: There is no need for this copy operation (and these internal buffers): it's just a demonstration of how to work with the internal buffers if you need them.
+        multiband.nBands = a_nBands < 1 ? 1 : (a_nBands > MultibandCrossover::kMaxBands ? (TIntegerParamType) MultibandCrossover::kMaxBands : a_nBands);
+        _UpdateMultiband();
+    }
 
-        
-        for (TIntegerParamType channel = 0; channel < a_nChannels; ++channel)
+    //RRS: Split point between band a_nSplit and a_nSplit + 1, ascending; split 0 is SetCrossoverFrequency(). The others take the new pole
+    //RRS: at once, with their states remapped to it as in _SetCrossoverPole(). Assertion: No memory allocations are allowed inside!
+    void SetBandCrossoverFrequency(TIntegerParamType a_nSplit, TFloatParamType a_fFrequency)
+    {
+        if (a_nSplit == 0)
+            SetCrossoverFrequency(a_fFrequency);
+        else if (a_nSplit > 0 && a_nSplit < MultibandCrossover::kMaxSplits)
         {
-            memcpy(inBuffer[channel], a_vAudioBlocksInPlace[channel], a_nSampleCount * sizeof(TAudioSampleType));
-            
-            TFloatParamType* readData = inBuffer[channel];
-            TFloatParamType* writeData = outBuffer[channel];
-            auto monoFilter = filters[channel];
-            
-            // Process audio samples
-            for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+            multiband.splitFrequency[a_nSplit] = a_fFrequency;
+
+            if (crossoverCache.fs > 0)
             {
-                low_outputs[channel] = monoFilter.lowpass_filter(readData[i], &low_states_1[channel], &low_states_2[channel], monoFilter.lpfCoeffs.a0, monoFilter.lpfCoeffs.a1, monoFilter.lpfCoeffs.a2, monoFilter.lpfCoeffs.b1, monoFilter.lpfCoeffs.b2);
-                high_outputs[channel]  =  monoFilter.highpass_filter(readData[i], &high_states_1[channel], &high_states_2[channel], monoFilter.hpfCoeffs.a0, monoFilter.hpfCoeffs.a1, monoFilter.hpfCoeffs.a2, monoFilter.hpfCoeffs.b1, monoFilter.hpfCoeffs.b2);
-                
-                dist_lows[channel] = tubeSaturation(low_outputs[channel], 1.f); // Apply Saturation
-                outputSamples[channel] = dist_lows[channel] + high_outputs[channel];  // Sum Signals
-                
-                writeData[i] = outputSamples[channel];   // Copy to Buffer
+                const TAudioSampleType a = crossoverCache.Pole(a_fFrequency);
+
+                double m[2][2];
+                Filter::_lrStateMap(multiband.splits[a_nSplit].apfCoeff, a, m);
+                multiband.splits[a_nSplit].setLRPole(a);
+                multiband.MapSplitStates(a_nSplit, m);
             }
-            
-            memcpy(a_vAudioBlocksInPlace[channel], outBuffer[channel], a_nSampleCount * sizeof(TAudioSampleType));
         }
     }
 
-    void _ReleaseInternalBuffers()
+    //RRS: Per-band drive multiplier on top of SetDrive(). Assertion: No memory allocations are allowed inside!
+    void SetBandSaturation(TIntegerParamType a_nBand, TFloatParamType a_fAmount)
     {
-        if (inBuffer)
-        {
-            for (TIntegerParamType n = 0; n < _nMaxChannels; ++n)
-            {
-                delete[] inBuffer[n];
-            }
-            
-            delete[] inBuffer;
-        }
-        
-        if (outBuffer)
+        if (a_nBand >= 0 && a_nBand < MultibandCrossover::kMaxBands)
+            multiband.bandAmount[a_nBand] = a_fAmount;
+        _UpdateMultiband();
+    }
+
+    //RRS: A bypassed band passes through the crossover unsaturated. Assertion: No memory allocations are allowed inside!
+    void SetBandBypass(TIntegerParamType a_nBand, bool a_bBypass)
+    {
+        if (a_nBand >= 0 && a_nBand < MultibandCrossover::kMaxBands)
+            multiband.bandBypass[a_nBand] = a_bBypass;
+        _UpdateMultiband();
+    }
+
+    // Anything the fused 2-band kernels cannot express (more or fewer bands, a saturated high band, a scaled or bypassed low band)
+    // goes through the multiband tree
+    void _UpdateMultiband()
+    {
+        bool bMultiband = multiband.nBands != 2 || multiband.bandBypass[0] || !multiband.bandBypass[1] || multiband.bandAmount[0] != 1.f;
+
+        if (bMultiband && !_bMultiband && multiband.nStride > 0)
+            multiband.Reset();
+
+        _bMultiband = bMultiband;
+    }
+    
+    //RRS: Grows the states for up to a_nMaxChannels; fewer keeps the ones there are (Process() takes any count up to the largest).
+    //RRS: Memory allocations are allowed inside
+    void SetMaxChannels(TIntegerParamType a_nMaxChannels)
+    {
+        if (a_nMaxChannels > _nMaxChannels || !_IsCarved())
         {
-            for (TIntegerParamType n = 0; n < _nMaxChannels; ++n)
-            {
-                delete[] outBuffer[n];
-            }
+            _nMaxChannels = a_nMaxChannels > _nMaxChannels ? a_nMaxChannels : _nMaxChannels;
 
-            delete[] outBuffer;
+            _ReBuildArena();
         }
+    }
+
+    //RRS: Declares the most this instance will be asked for, and makes room once for the largest layout within it: any oversampling
+    //RRS: factor up to a_nMaxOversampling in either mode, any saturation mode, either linear-phase layout up to a_nMaxKernelLength taps.
+    //RRS: Setters that stay within these bounds then reuse the memory, and SetSampleRate() only ever recomputes coefficients.
+    //RRS: Idempotent: declaring no more than before changes nothing, states included. Memory allocations are allowed inside
+    void Preallocate(TIntegerParamType a_nMaxChannels, TIntegerParamType a_nMaxBlockSize, TIntegerParamType a_nMaxOversampling, TIntegerParamType a_nMaxKernelLength)
+    {
+        const TIntegerParamType nChannels = a_nMaxChannels > _nMaxChannels ? a_nMaxChannels : _nMaxChannels;
+        const TIntegerParamType nBlockSize = a_nMaxBlockSize > _nMaxBlockSize ? a_nMaxBlockSize : _nMaxBlockSize;
+        const TIntegerParamType nOversampling = a_nMaxOversampling > _nPreallocatedOversampling ? a_nMaxOversampling : _nPreallocatedOversampling;
+        const TIntegerParamType nKernel = a_nMaxKernelLength > _nPreallocatedKernel ? a_nMaxKernelLength : _nPreallocatedKernel;
+
+        if (_IsCarved() && nChannels == _nMaxChannels && nBlockSize == _nMaxBlockSize && nOversampling == _nPreallocatedOversampling &&
+            nKernel == _nPreallocatedKernel)
+            return;
 
-        inBuffer =  NULL;
-        outBuffer =  NULL;
+        _nMaxChannels = nChannels;
+        _nMaxBlockSize = nBlockSize;
+        _nPreallocatedOversampling = nOversampling;
+        _nPreallocatedKernel = nKernel;
+
+        size_t nLargest = _MeasureLargestLayout();
+        if (nLargest > _arena.capacity || !_IsCarved())
+            _arena.Reserve(nLargest);
+
+        _ReBuildArena();
     }
 
-    void _ReAllocInternalBuffers(TIntegerParamType a_nNewMaxChannels)
+    //RRS: Oversampling of the saturated low band: a_nFactor is 1 (off), 2, 4 or 8; a_nMode is kOversamplingQuality or kOversamplingLowLatency
+    //RRS: Changes GetLatencySamples(); setting what is already set keeps the states. Memory allocations are allowed inside
+    void SetOversampling(TIntegerParamType a_nFactor, TIntegerParamType a_nMode)
     {
-        _ReleaseInternalBuffers();
-        
-        inBuffer = new TAudioSampleType*[_nMaxChannels = a_nNewMaxChannels];
-        outBuffer = new TAudioSampleType*[_nMaxChannels = a_nNewMaxChannels];
-        
-        for (TIntegerParamType n = 0; n < _nMaxChannels; ++n)
-        {
-            inBuffer[n] = new TAudioSampleType[_nMaxBlockSize];
-            outBuffer[n] = new TAudioSampleType[_nMaxBlockSize];
-        }
+        TIntegerParamType nFactor = a_nFactor >= 8 ? 8 : (a_nFactor >= 4 ? 4 : (a_nFactor >= 2 ? 2 : 1));
+
+        if (_IsCarved() && nFactor == _nOversampling && a_nMode == _nOversamplingMode)
+            return;
+
+        _nOversampling = nFactor;
+        _nOversamplingMode = a_nMode;
+
+        _ReBuildArena();
     }
-        
-    TFloatParamType tubeSaturation(TFloatParamType x, TFloatParamType mixAmount)
+
+    //RRS: kSaturationNaive, kSaturationADAA1 or kSaturationADAA2; combines with oversampling (ADAA then runs at the top rate)
+    //RRS: Changes GetLatencySamples(); setting what is already set keeps the states. Memory allocations are allowed inside
+    void SetSaturationMode(TIntegerParamType a_nSaturationMode)
     {
-        TFloatParamType a = mixAmount;
-        TFloatParamType y = 0.f;
+        if (_IsCarved() && a_nSaturationMode == _nSaturationMode)
+            return;
 
-        // Soft clipping based on quadratic function
-        TFloatParamType threshold1 = 1.0f/3.0f;
-        TFloatParamType threshold2 = 2.0f/3.0f;
-        
-        if(a == 0.0f)
-            y = x;
-        else if(x > threshold2)
-            y = 1.0f;
-        else if(x > threshold1)
-            y = (3.0f - ((2.0f - 3.0f*x)) *  ((2.0f - 3.0f*x)))/3.0f;
-        else if(x < -threshold2)
-            y = -1.0f;
-        else if(x < -threshold1)
-            y = -(3.0f - ((2.0f + 3.0f*x)) * ((2.0f + 3.0f*x)))/3.0f;
-        else
-            y = (2.0f* x);
-        
-        return y;
+        _nSaturationMode = a_nSaturationMode;
+
+        _ReBuildArena();
     }
-};
+
+    //RRS: Linear-phase 2-band split: a_nMode is kLinearPhaseOff, kLinearPhaseUniform or kLinearPhaseLowLatency (see DSPLinearPhase.h),
+    //RRS: a_nKernelLength the FIR length in taps (odd, 63 .. 32767; longer reaches lower crossovers). Crossover changes then take
+    //RRS: effect through UpdateLinearPhaseKernel(). The multiband path stays minimum phase. Changes GetLatencySamples(); setting what
+    //RRS: is already set keeps the states. Memory allocations are allowed inside
+    void SetLinearPhase(TIntegerParamType a_nMode, TIntegerParamType a_nKernelLength)
+    {
+        if (_IsCarved() && a_nMode == linearPhase.nMode && LinearPhaseCrossover::KernelLength(a_nKernelLength) == linearPhase.nKernelLength)
+            return;
+
+        linearPhase.Configure(a_nMode, a_nKernelLength);
+        _bLinearPhase = linearPhase.nSegments > 0;
+
+        _ReBuildArena();
+    }
+
+    //RRS: Designs the linear-phase kernel for the last SetCrossoverFrequency(), if it changed, and hands it to Process(), which
+    //RRS: crossfades to it within its longest partition. Call periodically from a thread other than the audio thread (the design is
+    //RRS: O(kernel length log) and not realtime-safe); false when there was nothing to do or the previous kernel is still fading in
+    bool UpdateLinearPhaseKernel()
+    {
+        return _bLinearPhase && fs > 0 && linearPhase.BuildPendingKernel(fs);
+    }
+
+    //RRS: Latency of Process() in samples, to be reported to the host
+    TIntegerParamType GetLatencySamples() const { return _bMultiband ? 0 : _nLatency + linearPhase.nLatency; }
+
+    //RRS: How far back a cold-started copy must begin for its output to match this one to within a_fTolerance of the signal level,
+    //RRS: from the pole radii of the crossover (and oversampling filters). Call after SetSampleRate() and the other setters.
+    TIntegerParamType GetSettlingSamples(TFloatParamType a_fTolerance) const
+    {
+        return _SettlingSamples(a_fTolerance, filters[0].apfCoeff);
+    }
+
+    //RRS: How long the output rings on once the input falls silent, down to _kSilenceThreshold of its level: the tail length to report
+    //RRS: to the host. The crossover may glide down to a_fLowestCrossover_Hz before then (the lower, the longer the ring).
+    //RRS: Call after SetSampleRate() and the other setters; not on the audio thread (the decay is walked sample by sample)
+    TIntegerParamType GetTailSamples(TFloatParamType a_fLowestCrossover_Hz) const
+    {
+        TFloatParamType f = a_fLowestCrossover_Hz < f_crossover ? a_fLowestCrossover_Hz : f_crossover;
+        return _SettlingSamples(_kSilenceThreshold, Filter::_lrPole(f, fs));
+    }
+
+    // Settling of the current configuration, with a_fPole for the 2-band split (split 0 of the tree)
+    TIntegerParamType _SettlingSamples(double a_fTolerance, double a_fPole) const
+    {
+        TIntegerParamType n = 0;
+
+        if (_bMultiband)
+        {
+            // A band runs through a chain of splits and phase-compensation allpasses; settling each in turn is an upper bound
+            for (TIntegerParamType k = 0; k < multiband.nBands - 1; ++k)
+            {
+                double a = k == 0 ? a_fPole : (double) multiband.splits[k].apfCoeff;
+                n += pole_settling_samples(a, 2, a_fTolerance) + pole_settling_samples(a, 1, a_fTolerance);
+            }
+
+            return n;
+        }
+
+        // The FIR forgets its input after its length, and its delay lines after the latency
+        n = _bLinearPhase ? linearPhase.nKernelLength + linearPhase.nLatency : pole_settling_samples(a_fPole, 2, a_fTolerance);
+
+        if (oversamplers != NULL)
+            n += oversamplers[0].GetSettlingSamples(a_fTolerance);
+
+        return n + _nLatency + 2;   // the high-band delay line and the ADAA history
+    }
+
+    //RRS: kCrossoverTwoFilter or kCrossoverComplementary; both have the same response. The lane-packed SIMD kernels evaluate LP and HP
+    //RRS: in one vector instruction and keep the two-filter form; the scalar, block-wise and multiband paths follow this setting.
+    //RRS: Assertion: No memory allocations are allowed inside!
+    void SetCrossoverTopology(TIntegerParamType a_nTopology)
+    {
+        if (a_nTopology == _nTopology)
+            return;
+
+        _nTopology = a_nTopology;
+        multiband.topology = a_nTopology;
+
+        // The allpass state is only advanced by the complementary form
+        if (allpass_states != NULL)
+            memset(allpass_states, 0, (size_t) ((_nMaxChannels + 3) & ~3) * sizeof(TAudioSampleType));
+        if (multiband.nStride > 0)
+            multiband.Reset();
+    }
+
+    //RRS: Process() runs its groups of 4 channels as tasks of a_pWorkers (not owned; NULL runs them in turn on the calling thread).
+    //RRS: The multiband path stays on the calling thread. Same output either way. Assertion: No memory allocations are allowed inside!
+    void SetWorkerPool(WorkerPool* a_pWorkers) { _pWorkers = a_pWorkers; }
+
+    //RRS: On (the default), Process() returns at once on silent input after the output has decayed, see _bIdle; off, every block is
+    //RRS: processed in full. Either way the outputs agree to the level of _kSilenceThreshold. Assertion: No memory allocations are allowed inside!
+    void SetSkipSilence(bool a_bSkipSilence)
+    {
+        _bSkipSilence = a_bSkipSilence;
+        _bIdle = false;
+    }
+
+    //RRS: Band meters into a_pMeters and the output into a_pAnalyzer, once per Process() (either may be NULL, not owned). Meters leave
+    //RRS: Process() on the path it would take anyway, since every path measures its bands where it has them (see DSPMetering.h); the
+    //RRS: output is the same with them or without. Assertion: No memory allocations are allowed inside!
+    void SetTelemetry(BandMeterBuffer* a_pMeters, SpectrumAnalyzer* a_pAnalyzer)
+    {
+        _pMeters = a_pMeters;
+        _pAnalyzer = a_pAnalyzer;
+    }
+
+    //RRS: TPDF dither (1 LSB peak each way) before the integer outputs of ProcessInterleaved() are rounded; off by default.
+    //RRS: a_nSeed restarts the noise, so renders can be repeated bit for bit. Assertion: No memory allocations are allowed inside!
+    void SetDither(bool a_bDither, uint32_t a_nSeed = 1)
+    {
+        _bDither = a_bDither;
+        dither_seed(_dither, a_nSeed);
+    }
+
+    //RRS: Caps the kernel used by Process() (kSimdScalar/kSimdSSE2/kSimdAVX2); requests above what the CPU supports are clamped
+    void SetSimdLevel(TIntegerParamType a_nSimdLevel)
+    {
+        TIntegerParamType nSupported = simd_detect_level();
+        _nSimdLevel = a_nSimdLevel < nSupported ? a_nSimdLevel : nSupported;
+    }
+
+    //RRS: kFilterKernelSequential or kFilterKernelTimeParallel for the channels left over after the lane-packed kernels
+    //RRS: (a mono bus, the third of three); same response, rounding differs. Assertion: No memory allocations are allowed inside!
+    void SetFilterKernel(TIntegerParamType a_nFilterKernel) { _nFilterKernel = a_nFilterKernel; }
+
+    //RRS: Sample rate is not constant, so you have to reinitialize your sample rate dependent params (such as filters coeffs) on this call from our framework
+    void SetSampleRate(TFloatParamType a_fSampleRate_Hz) {
+        fs = a_fSampleRate_Hz;
+
+        crossoverCache.Build(fs);
+
+        // Exact here; the cache serves the changes in between
+        for(TIntegerParamType channel = 0; channel < _nMaxChannels; channel++)
+        {
+            filters[channel].hpfLRCoeffs(f_crossover, fs);
+            filters[channel].lpfLRCoeffs(f_crossover, fs);
+            filters[channel].apfLRCoeffs(f_crossover, fs);
+            filters[channel].blockLRCoeffs();
+        }
+
+        multiband.UpdateCoefficients(fs);
+        linearPhase.BuildKernelNow(f_crossover, fs);
+
+        // A new sample rate is a reset point: start from the targets instead of gliding to them
+        _crossover.Reset(crossoverCache.Position(f_crossover));
+        _gain.Reset(_gain.target);
+        _drive.Reset(_drive.target);
+        _mix.Reset(_mix.target);
+        SetSmoothingTime(_fSmoothingTime_ms);
+    } //RRS: Memory allocations are allowed inside
+
+    //RRS: Glide time of gain, drive, mix and crossover changes; 0 ramps to each new value across the next block. Assertion: No memory allocations are allowed inside!
+    void SetSmoothingTime(TFloatParamType a_fSmoothingTime_ms)
+    {
+        _fSmoothingTime_ms = a_fSmoothingTime_ms;
+        _gain.length = _drive.length = _mix.length = _crossover.length = (TIntegerParamType) (a_fSmoothingTime_ms * 0.001f * fs);
+    }
+
+    void SetGain(TFloatParamType a_fGain_01) { _gain.SetTarget(a_fGain_01); } //RRS: Output gain, linear. Assertion: No memory allocations are allowed inside!
+    void SetDrive(TFloatParamType a_fDrive) { _drive.SetTarget(a_fDrive); } //RRS: Input gain into the saturator. Assertion: No memory allocations are allowed inside!
+    void SetMix(TFloatParamType a_fMix_01) { _mix.SetTarget(a_fMix_01); } //RRS: Saturated/dry blend of the low band. Assertion: No memory allocations are allowed inside!
+    void SetSomeParam1(TFloatParamType a_fSomeParam1Value) {} //RRS: Assertion: No memory allocations are allowed inside!
+    void SetSomeParam2(TFloatParamType a_fSomeParam2Value) {} //RRS: Assertion: No memory allocations are allowed inside!
+
+    //RRS: Every setting as a DSPPreset; parameters that are still gliding give their targets
+    void GetPreset(DSPPreset& a_preset) const
+    {
+        a_preset.gain = _gain.target;
+        a_preset.drive = _drive.target;
+        a_preset.mix = _mix.target;
+        a_preset.smoothing_ms = _fSmoothingTime_ms;
+        a_preset.nBands = multiband.nBands;
+        a_preset.bandBypass = 0;
+
+        for (TIntegerParamType k = 0; k < DSPPreset::kMaxSplits; ++k)
+            a_preset.splitFrequency_Hz[k] = k == 0 ? f_crossover : multiband.splitFrequency[k];
+
+        for (TIntegerParamType b = 0; b < DSPPreset::kMaxBands; ++b)
+        {
+            a_preset.bandAmount[b] = multiband.bandAmount[b];
+            a_preset.bandBypass |= (uint8_t) (multiband.bandBypass[b] ? 1 << b : 0);
+        }
+
+        a_preset.oversampling = _nOversampling;
+        a_preset.oversamplingMode = _nOversamplingMode;
+        a_preset.saturationMode = _nSaturationMode;
+        a_preset.topology = _nTopology;
+        a_preset.linearPhaseMode = linearPhase.nMode;
+        a_preset.linearPhaseKernel = linearPhase.nKernelLength;
+    }
+
+    //RRS: Every setting of a_preset at once, through the setters: parameters glide as they would from them, and the structural
+    //RRS: settings may rebuild the arena (see DSPPreset.h). Not on the audio thread. Memory allocations are allowed inside
+    void ApplyPreset(const DSPPreset& a_preset)
+    {
+        SetSmoothingTime(a_preset.smoothing_ms);
+        SetGain(a_preset.gain);
+        SetDrive(a_preset.drive);
+        SetMix(a_preset.mix);
+
+        for (TIntegerParamType k = 0; k < DSPPreset::kMaxSplits; ++k)
+            SetBandCrossoverFrequency(k, a_preset.splitFrequency_Hz[k]);
+
+        for (TIntegerParamType b = 0; b < DSPPreset::kMaxBands; ++b)
+        {
+            SetBandSaturation(b, a_preset.bandAmount[b]);
+            SetBandBypass(b, (a_preset.bandBypass >> b) & 1);
+        }
+        SetNumBands(a_preset.nBands);
+
+        SetCrossoverTopology(a_preset.topology);
+        SetOversampling(a_preset.oversampling, a_preset.oversamplingMode);
+        SetSaturationMode(a_preset.saturationMode);
+        SetLinearPhase(a_preset.linearPhaseMode, a_preset.linearPhaseKernel);
+    }
+
+    //RRS: Preset switch while Process() runs: designs a_preset's filters for the current sample rate here, on the calling thread (any
+    //RRS: but the audio thread, one at a time), and publishes them for the next Process() to swap in, with a kPresetFade_ms crossfade
+    //RRS: of the 2-band split. Only the non-structural settings; the structural ones go through ApplyPreset(). False when there is no
+    //RRS: sample rate yet, or Process() has not taken the previous preset yet (call again later)
+    bool SubmitPreset(const DSPPreset& a_preset)
+    {
+        const uint32_t p = _nPresetPublished.load(std::memory_order_relaxed);
+
+        if (fs <= 0 || _nPresetAdopted.load(std::memory_order_acquire) != p)
+            return false;
+
+        _presetSnapshots[(p + 1) & 1].Design(a_preset, fs);
+        _nPresetPublished.store(p + 1, std::memory_order_release);
+        return true;
+    }
+        
+    void Release() {
+        _arena.Release();
+        _ForgetArena();
+        //RRS: All previously allocated memory can be deallocated here
+    }
+    
+    //RRS: Assertion: No memory allocations are allowed inside!
+    void Process(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType a_nChannels, TIntegerParamType a_nSampleCount)
+    {
+        //RRS: Assertion: a_nChannels less or equal _nMaxChannels set in SetMaxChannels()
+        //RRS: Assertion: a_nSampleCount less or equal _nMaxBlockSize set in SetMaxBlockSize()
+
+        // Instrumented builds (DSPRealtime.h) count any allocation or lock from here on
+        RealtimeScope realtimeScope;
+
+        _AdoptPreset();
+
+        // Drive and mix ramp linearly across this block, towards their targets
+        SaturationRamp r = _NextSaturationRamp(a_nSampleCount);
+        TFloatParamType gain, gainInc;
+        _gain.Next(a_nSampleCount, gain, gainInc);
+
+        // Silence in, and nothing left ringing from before: silence out, which is what the buffers already hold
+        bool bSilent = _bSkipSilence && _IsSilent(a_vAudioBlocksInPlace, a_nChannels, a_nSampleCount);
+
+        if (bSilent && _bIdle)
+        {
+            _SkipCrossoverGlide(a_nSampleCount);
+            _PublishTelemetry(a_vAudioBlocksInPlace, a_nChannels, a_nSampleCount);
+            return;
+        }
+
+        _bIdle = false;
+
+        // Weight of the new filter during a preset crossfade, linear from where the previous block left it
+        const TFloatParamType fadeWeight = _nFadeRemaining > 0 ? 1.f - (TFloatParamType) _nFadeRemaining / (TFloatParamType) _nFadeLength : 1.f;
+        _fadeWeight = fadeWeight;
+        _fadeWeightInc = _nFadeRemaining > 0 ? 1.f / (TFloatParamType) _nFadeLength : 0.f;
+
+        // The linear-phase split takes its crossover from the kernel published last; the LR filters only follow the glide
+        bool bLinearPhase = _bLinearPhase && ! _bMultiband;
+        if (bLinearPhase)
+        {
+            linearPhase.BeginBlock();
+            _SkipCrossoverGlide(a_nSampleCount);
+        }
+
+        if (_crossover.IsRamping() && ! bLinearPhase)
+        {
+            // While the crossover glides, the coefficients are re-interpolated every _kCrossoverUpdateInterval samples
+            for (TIntegerParamType offset = 0; offset < a_nSampleCount; offset += _kCrossoverUpdateInterval)
+            {
+                TIntegerParamType n = a_nSampleCount - offset < _kCrossoverUpdateInterval ? a_nSampleCount - offset : _kCrossoverUpdateInterval;
+                TFloatParamType position, positionInc;
+                _crossover.Next(n, position, positionInc);
+                _SetCrossoverPole(crossoverCache.PoleAt(position + 0.5f * n * positionInc));
+
+                for (TIntegerParamType channel = 0; channel < a_nChannels; ++channel)
+                    _vSubBlocks[channel] = a_vAudioBlocksInPlace[channel] + offset;
+
+                SaturationRamp sub = { r.drive + r.driveInc * offset, r.driveInc, r.mix + r.mixInc * offset, r.mixInc };
+                _fadeWeight = fadeWeight + _fadeWeightInc * offset;
+                _ProcessChannels(_vSubBlocks, a_nChannels, n, sub);
+            }
+        }
+        else
+        {
+            _ProcessChannels(a_vAudioBlocksInPlace, a_nChannels, a_nSampleCount, r);
+        }
+
+        if (gain != 1.f || gainInc != 0.f)
+            for (TIntegerParamType channel = 0; channel < a_nChannels; ++channel)
+            {
+                TAudioSampleType* __restrict data = a_vAudioBlocksInPlace[channel];
+
+                for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+                    data[i] *= gain + gainInc * i;
+            }
+
+        if (bLinearPhase)
+            linearPhase.EndBlock();
+
+        _nFadeRemaining = _nFadeRemaining > a_nSampleCount ? _nFadeRemaining - a_nSampleCount : 0;
+
+        _PublishTelemetry(a_vAudioBlocksInPlace, a_nChannels, a_nSampleCount);
+
+        // The tail of a silent block: once it is inaudible, what is left of it goes, so the states cannot end up denormal
+        if (bSilent && _StatePeak() < _kSilenceThreshold)
+        {
+            _ClearStates();
+            _bIdle = true;
+        }
+    }
+
+    //RRS: Process() on interleaved frames, in place: [frame][channel] in TAudioSampleType, 16-bit or packed 24-bit integer. Any number of
+    //RRS: frames; they are converted a cache-sized chunk at a time, so the block is read and written once. Integer outputs saturate
+    //RRS: at full scale and are dithered when SetDither() is on. Assertion: No memory allocations are allowed inside!
+    void ProcessInterleaved(TAudioSampleType* a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames) { _ProcessInterleaved(a_pFrames, a_nChannels, a_nFrames); }
+    void ProcessInterleaved(int16_t* a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames) { _ProcessInterleaved(a_pFrames, a_nChannels, a_nFrames); }
+    void ProcessInterleaved(Int24* a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames) { _ProcessInterleaved(a_pFrames, a_nChannels, a_nFrames); }
+
+    template <typename TFrame>
+    void _ProcessInterleaved(TFrame* a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames)
+    {
+        //RRS: Assertion: a_nChannels less or equal _nMaxChannels set in SetMaxChannels()
+        for (TIntegerParamType channel = 0; channel < a_nChannels; ++channel)
+            _vInterleavedBlocks[channel] = interleavedBlocks + channel * _nInterleavedChunk;
+
+        for (TIntegerParamType offset = 0; offset < a_nFrames; offset += _nInterleavedChunk)
+        {
+            TIntegerParamType n = a_nFrames - offset < _nInterleavedChunk ? a_nFrames - offset : _nInterleavedChunk;
+            TFrame* frames = a_pFrames + (size_t) offset * a_nChannels;
+
+            _ReadFrames(frames, a_nChannels, n);
+            Process(_vInterleavedBlocks, a_nChannels, n);
+            _WriteFrames(frames, a_nChannels, n);
+        }
+    }
+
+    // With the stride known at compile time the compiler turns these into vector permutes; mono, stereo and quad get their own
+    template <TIntegerParamType kChannels>
+    static void _DeinterleaveN(const TAudioSampleType* __restrict a_pFrames, TAudioSampleType** a_vBlocks, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames)
+    {
+        if (kChannels == 0)
+        {
+            for (TIntegerParamType channel = 0; channel < a_nChannels; ++channel)
+            {
+                TAudioSampleType* __restrict data = a_vBlocks[channel];
+
+                for (TIntegerParamType i = 0; i < a_nFrames; ++i)
+                    data[i] = a_pFrames[(size_t) i * a_nChannels + channel];
+            }
+            return;
+        }
+
+        TAudioSampleType* __restrict data[kChannels > 0 ? kChannels : 1];
+        for (TIntegerParamType channel = 0; channel < kChannels; ++channel)
+            data[channel] = a_vBlocks[channel];
+
+        for (TIntegerParamType i = 0; i < a_nFrames; ++i)
+            for (TIntegerParamType channel = 0; channel < kChannels; ++channel)
+                data[channel][i] = a_pFrames[(size_t) i * kChannels + channel];
+    }
+
+    template <TIntegerParamType kChannels>
+    static void _InterleaveN(TAudioSampleType** a_vBlocks, TAudioSampleType* __restrict a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames)
+    {
+        if (kChannels == 0)
+        {
+            for (TIntegerParamType channel = 0; channel < a_nChannels; ++channel)
+            {
+                const TAudioSampleType* __restrict data = a_vBlocks[channel];
+
+                for (TIntegerParamType i = 0; i < a_nFrames; ++i)
+                    a_pFrames[(size_t) i * a_nChannels + channel] = data[i];
+            }
+            return;
+        }
+
+        const TAudioSampleType* __restrict data[kChannels > 0 ? kChannels : 1];
+        for (TIntegerParamType channel = 0; channel < kChannels; ++channel)
+            data[channel] = a_vBlocks[channel];
+
+        for (TIntegerParamType i = 0; i < a_nFrames; ++i)
+            for (TIntegerParamType channel = 0; channel < kChannels; ++channel)
+                a_pFrames[(size_t) i * kChannels + channel] = data[channel][i];
+    }
+
+    static void _Deinterleave(const TAudioSampleType* a_pFrames, TAudioSampleType** a_vBlocks, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames)
+    {
+        switch (a_nChannels)
+        {
+            case 1:  _DeinterleaveN<1>(a_pFrames, a_vBlocks, a_nChannels, a_nFrames); break;
+            case 2:  _DeinterleaveN<2>(a_pFrames, a_vBlocks, a_nChannels, a_nFrames); break;
+            case 4:  _DeinterleaveN<4>(a_pFrames, a_vBlocks, a_nChannels, a_nFrames); break;
+            default: _DeinterleaveN<0>(a_pFrames, a_vBlocks, a_nChannels, a_nFrames); break;
+        }
+    }
+
+    static void _Interleave(TAudioSampleType** a_vBlocks, TAudioSampleType* a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames)
+    {
+        switch (a_nChannels)
+        {
+            case 1:  _InterleaveN<1>(a_vBlocks, a_pFrames, a_nChannels, a_nFrames); break;
+            case 2:  _InterleaveN<2>(a_vBlocks, a_pFrames, a_nChannels, a_nFrames); break;
+            case 4:  _InterleaveN<4>(a_vBlocks, a_pFrames, a_nChannels, a_nFrames); break;
+            default: _InterleaveN<0>(a_vBlocks, a_pFrames, a_nChannels, a_nFrames); break;
+        }
+    }
+
+    void _ReadFrames(const TAudioSampleType* a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames)
+    {
+        _Deinterleave(a_pFrames, _vInterleavedBlocks, a_nChannels, a_nFrames);
+    }
+
+    void _WriteFrames(TAudioSampleType* a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames)
+    {
+        _Interleave(_vInterleavedBlocks, a_pFrames, a_nChannels, a_nFrames);
+    }
+
+    // Integer frames: converted as one contiguous run (the vector kernels do not see the channels), then (de)interleaved in cache
+    template <typename TInt>
+    void _ReadFrames(const TInt* a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames)
+    {
+        convert_from_int(a_pFrames, interleavedScratch, (size_t) a_nFrames * a_nChannels, _nSimdLevel);
+        _Deinterleave(interleavedScratch, _vInterleavedBlocks, a_nChannels, a_nFrames);
+    }
+
+    template <typename TInt>
+    void _WriteFrames(TInt* a_pFrames, TIntegerParamType a_nChannels, TIntegerParamType a_nFrames)
+    {
+        _Interleave(_vInterleavedBlocks, interleavedScratch, a_nChannels, a_nFrames);
+        convert_to_int(interleavedScratch, a_pFrames, (size_t) a_nFrames * a_nChannels, _bDither ? _dither : NULL, _nSimdLevel);
+    }
+
+    // -200 dBFS: below anything audible, and far above the denormals
+    static constexpr TFloatParamType _kSilenceThreshold = 1e-10f;
+
+    //RRS: True when every sample of the block is zero (of either sign); stops at the first chunk that is not
+    static bool _IsSilent(TAudioSampleType** a_vAudioBlocks, TIntegerParamType a_nChannels, TIntegerParamType a_nSampleCount)
+    {
+        const TIntegerParamType kChunk = 64;
+
+        for (TIntegerParamType channel = 0; channel < a_nChannels; ++channel)
+        {
+            const TAudioSampleType* __restrict data = a_vAudioBlocks[channel];
+
+            for (TIntegerParamType offset = 0; offset < a_nSampleCount; offset += kChunk)
+            {
+                TIntegerParamType end = offset + kChunk < a_nSampleCount ? offset + kChunk : a_nSampleCount;
+                TAudioSampleType peak = 0;
+
+                for (TIntegerParamType i = offset; i < end; ++i)
+                {
+                    TAudioSampleType a = std::fabs(data[i]);
+                    peak = a > peak ? a : peak;
+                }
+
+                if (peak > 0)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // While idle every state is zero, so a crossover glide can skip straight to where this block would have left it
+    void _SkipCrossoverGlide(TIntegerParamType a_nSampleCount)
+    {
+        if (! _crossover.IsRamping())
+            return;
+
+        TFloatParamType position, positionInc;
+        _crossover.Next(a_nSampleCount, position, positionInc);
+        _SetCrossoverPole(crossoverCache.PoleAt(position + a_nSampleCount * positionInc));
+    }
+
+    static TAudioSampleType _Peak(const TAudioSampleType* a_pData, size_t a_nCount)
+    {
+        TAudioSampleType peak = 0;
+
+        for (size_t i = 0; i < a_nCount; ++i)
+        {
+            TAudioSampleType a = std::fabs(a_pData[i]);
+            peak = a > peak ? a : peak;
+        }
+
+        return peak;
+    }
+
+    //RRS: Largest magnitude held by the path in use: filter and allpass states, the high-band delay, the ADAA history, the oversamplers
+    TAudioSampleType _StatePeak() const
+    {
+        if (_bMultiband)
+            return multiband.StatePeak();
+
+        const size_t nGroups = (size_t) ((_nMaxChannels + 3) >> 2);
+        TAudioSampleType peak = _Peak(crossoverStates, nGroups * kStateGroup);
+
+        if (_nTopology == kCrossoverComplementary)
+        {
+            TAudioSampleType a = _Peak(allpass_states, nGroups * 4);
+            peak = a > peak ? a : peak;
+        }
+
+        if (highDelay != NULL && _nLatency > 0)
+        {
+            TAudioSampleType a = _Peak(highDelay, (size_t) (_nMaxChannels * _nLatency));
+            peak = a > peak ? a : peak;
+        }
+
+        for (TIntegerParamType channel = 0; adaaStates != NULL && channel < _nMaxChannels; ++channel)
+        {
+            const AdaaState& s = adaaStates[channel];
+
+            for (double v : { s.x1, s.x2, s.dry1 })
+                peak = fabs(v) > peak ? (TAudioSampleType) fabs(v) : peak;
+        }
+
+        for (TIntegerParamType channel = 0; channel < _nOversampledChannels; ++channel)
+        {
+            TAudioSampleType a = oversamplers[channel].StatePeak();
+            peak = a > peak ? a : peak;
+        }
+
+        if (_bLinearPhase)
+        {
+            TAudioSampleType a = linearPhase.StatePeak();
+            peak = a > peak ? a : peak;
+        }
+
+        return peak;
+    }
+
+    //RRS: Every state back to zero, as after SetMaxChannels(); the coefficients stay
+    void _ClearStates()
+    {
+        const size_t nGroups = (size_t) ((_nMaxChannels + 3) >> 2);
+
+        memset(crossoverStates, 0, nGroups * kStateGroup * sizeof(TAudioSampleType));
+        memset(allpass_states, 0, nGroups * 4 * sizeof(TAudioSampleType));
+        multiband.Reset();
+
+        if (highDelay != NULL)
+            memset(highDelay, 0, (size_t) (_nMaxChannels * (_nLatency > 0 ? _nLatency : 1)) * sizeof(TAudioSampleType));
+
+        if (adaaStates != NULL)
+            memset(adaaStates, 0, (size_t) _nMaxChannels * sizeof(AdaaState));
+
+        for (TIntegerParamType channel = 0; channel < _nOversampledChannels; ++channel)
+            oversamplers[channel].Reset();
+
+        if (_bLinearPhase)
+            linearPhase.Reset();
+
+        _nFadeRemaining = 0;
+    }
+
+    static constexpr TIntegerParamType _kCrossoverUpdateInterval = 32;
+
+    // Length of the crossfade between the old and new 2-band filters when a preset is swapped in
+    static constexpr TFloatParamType kPresetFade_ms = 10.f;
+
+    // Frames per Process() call of ProcessInterleaved(): a multiple of _kCrossoverUpdateInterval, and 16 channels of it in both
+    // float buffers still fit in L2
+    static constexpr TIntegerParamType _kInterleavedChunk = 256;
+
+    // Below this many samples a block is not worth handing to the workers; the crossover glide's sub-blocks still are
+    static constexpr TIntegerParamType _kMinParallelSamples = _kCrossoverUpdateInterval;
+
+    struct _ChannelJob
+    {
+        DSPT* dsp;
+        TAudioSampleType** blocks;
+        TIntegerParamType nChannels, nSampleCount;
+        SaturationRamp r;
+    };
+
+    static void _RunChannelGroup(void* a_pJob, TIntegerParamType a_nGroup)
+    {
+        _ChannelJob& job = *(_ChannelJob*) a_pJob;
+        TIntegerParamType first = a_nGroup * 4;
+        TIntegerParamType end = first + 4 < job.nChannels ? first + 4 : job.nChannels;
+
+        job.dsp->_ProcessSection(job.blocks, first, end, job.nSampleCount, job.r);
+    }
+
+    //RRS: One section of Process() over all channels: a task per group of 4 channels on the worker pool, which share no state
+    void _ProcessChannels(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType a_nChannels, TIntegerParamType a_nSampleCount, SaturationRamp r)
+    {
+        if (_bMultiband)
+        {
+            _ProcessMultiband(a_vAudioBlocksInPlace, a_nChannels, a_nSampleCount, r);
+            return;
+        }
+
+        if (_pWorkers == NULL || a_nChannels <= 4 || a_nSampleCount < _kMinParallelSamples)
+        {
+            _ProcessSection(a_vAudioBlocksInPlace, 0, a_nChannels, a_nSampleCount, r);
+            return;
+        }
+
+        _ChannelJob job = { this, a_vAudioBlocksInPlace, a_nChannels, a_nSampleCount, r };
+        _pWorkers->Run(_RunChannelGroup, &job, (a_nChannels + 3) >> 2);
+    }
+
+    //RRS: Channels [a_nFirst, a_nEnd) of one 2-band section with fixed crossover coefficients; a_nFirst is a multiple of 4
+    void _ProcessSection(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType a_nFirst, TIntegerParamType a_nEnd, TIntegerParamType a_nSampleCount, SaturationRamp r)
+    {
+        if (_nOversampling > 1 || _nSaturationMode != kSaturationNaive || _bLinearPhase || _nFadeRemaining > 0)
+        {
+            _ProcessBlockwise(a_vAudioBlocksInPlace, a_nFirst, a_nEnd, a_nSampleCount, r);
+            return;
+        }
+
+        // Both meter as they go when meters are attached, at the cost of a few operations per step, so an open editor does not move
+        // the block onto another path
+        TIntegerParamType channel = _pMeters != NULL ? _ProcessFused<true>(a_vAudioBlocksInPlace, a_nFirst, a_nEnd, a_nSampleCount, r)
+                                                     : _ProcessFused<false>(a_vAudioBlocksInPlace, a_nFirst, a_nEnd, a_nSampleCount, r);
+
+        if (_pMeters != NULL)
+            _ProcessScalar<true>(a_vAudioBlocksInPlace, channel, a_nEnd, a_nSampleCount, r);
+        else
+            _ProcessScalar<false>(a_vAudioBlocksInPlace, channel, a_nEnd, a_nSampleCount, r);
+    }
+
+    // Scalar path for the channels the fused kernels left: in-place on the host buffer, filter state held in locals for the whole
+    // block. With kMeter each channel's bands are summed in locals too and added to its group's meterSums
+    template <bool kMeter>
+    void _ProcessScalar(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType a_nFirst, TIntegerParamType a_nEnd, TIntegerParamType a_nSampleCount, SaturationRamp r)
+    {
+        for (TIntegerParamType channel = a_nFirst; channel < a_nEnd; ++channel)
+        {
+            TAudioSampleType* __restrict data = a_vAudioBlocksInPlace[channel];
+            const Filter& monoFilter = filters[channel];
+            const LRCoefficients lp = monoFilter.lpfCoeffs;
+            const LRCoefficients hp = monoFilter.hpfCoeffs;
+
+            TAudioSampleType* st = _CrossoverStates(channel);
+            TAudioSampleType ls1 = st[kStateLow1], ls2 = st[kStateLow2];
+            TAudioSampleType hs1 = st[kStateHigh1], hs2 = st[kStateHigh2];
+            MeterSums bands[2] = {};
+
+            if (_nTopology == kCrossoverComplementary)
+            {
+                const TAudioSampleType ap = monoFilter.apfCoeff;
+                TAudioSampleType as = allpass_states[channel];
+
+                for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+                {
+                    TAudioSampleType x = data[i];
+                    TAudioSampleType low = monoFilter.lowpass_filter(x, &ls1, &ls2, lp.a0, lp.a1, lp.a2, lp.b1, lp.b2);
+                    TAudioSampleType high = monoFilter.allpass_filter(x, &as, ap) - low;
+                    TFloatParamType drive = r.drive + r.driveInc * i;
+
+                    data[i] = tubeSaturation(drive * low, r.mix + r.mixInc * i, low) + high;
+
+                    if constexpr (kMeter)
+                        meter_sample(bands, low, (TAudioSampleType) (drive * low), high);
+                }
+
+                allpass_states[channel] = as;
+            }
+            else
+            {
+                // Process audio samples
+                for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+                {
+                    TAudioSampleType x = data[i];
+                    TAudioSampleType low = monoFilter.lowpass_filter(x, &ls1, &ls2, lp.a0, lp.a1, lp.a2, lp.b1, lp.b2);
+                    TAudioSampleType high = monoFilter.highpass_filter(x, &hs1, &hs2, hp.a0, hp.a1, hp.a2, hp.b1, hp.b2);
+                    TFloatParamType drive = r.drive + r.driveInc * i;
+
+                    data[i] = tubeSaturation(drive * low, r.mix + r.mixInc * i, low) + high; // Saturate the low band and sum
+
+                    if constexpr (kMeter)
+                        meter_sample(bands, low, (TAudioSampleType) (drive * low), high);
+                }
+            }
+
+            st[kStateLow1] = ls1;  st[kStateLow2] = ls2;
+            st[kStateHigh1] = hs1; st[kStateHigh2] = hs2;
+
+            if constexpr (kMeter)
+            {
+                MeterSums* sums = meterSums + (channel >> 2) * BandMeterFrame::kMaxBands;
+
+                for (int b = 0; b < 2; ++b)
+                {
+                    sums[b].peak = bands[b].peak > sums[b].peak ? bands[b].peak : sums[b].peak;
+                    sums[b].sumSquares += bands[b].sumSquares;
+                    sums[b].nActive += bands[b].nActive;
+                }
+            }
+        }
+    }
+
+    // The fused SIMD kernels over as many of channels [a_nFirst, a_nEnd) as they take, widest first; returns the first channel left
+    // over. With kMeter they add each channel group's bands to its meterSums
+    template <bool kMeter>
+    TIntegerParamType _ProcessFused(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType a_nFirst, TIntegerParamType a_nEnd, TIntegerParamType a_nSampleCount, SaturationRamp r)
+    {
+        TIntegerParamType channel = a_nFirst;
+
+#if RRS_SIMD_X86
+        auto bands = [this](TIntegerParamType c) { return meterSums + (c >> 2) * BandMeterFrame::kMaxBands; };
+
+        // Leftover channels fall through to the narrower kernels
+        if constexpr (std::is_same<TSample, float>::value)
+        {
+            if (_nSimdLevel >= kSimdAVX2)
+                for (; channel + 4 <= a_nEnd; channel += 4)
+                    lr_process_avx2<kMeter>(a_vAudioBlocksInPlace, channel, a_nSampleCount, filters, _CrossoverStates(channel), r, bands(channel));
+
+            if (_nSimdLevel >= kSimdSSE2)
+                for (; channel + 2 <= a_nEnd; channel += 2)
+                    lr_process_sse2<kMeter>(a_vAudioBlocksInPlace, channel, a_nSampleCount, filters, _CrossoverStates(channel), r, bands(channel));
+
+            if (_nSimdLevel >= kSimdSSE2 && _nFilterKernel == kFilterKernelTimeParallel && _nTopology == kCrossoverTwoFilter)
+                for (; channel < a_nEnd; ++channel)
+                {
+                    TAudioSampleType* st = _CrossoverStates(channel);
+                    lr_process_block_sse2<kMeter>(a_vAudioBlocksInPlace[channel], a_nSampleCount, filters[channel],
+                                                  st + kStateLow1, st + kStateLow2, st + kStateHigh1, st + kStateHigh2, r, bands(channel));
+                }
+        }
+        else
+        {
+            // Half as many lanes per vector: [LP c, LP c+1 | HP c, HP c+1] for AVX2, [LP c, HP c] for SSE2, which leaves no channel over
+            if (_nSimdLevel >= kSimdAVX2)
+                for (; channel + 2 <= a_nEnd; channel += 2)
+                    lr_process_avx2_pd<kMeter>(a_vAudioBlocksInPlace, channel, a_nSampleCount, filters, _CrossoverStates(channel), r, bands(channel));
+
+            if (_nSimdLevel >= kSimdSSE2)
+                for (; channel < a_nEnd; ++channel)
+                    lr_process_sse2_pd<kMeter>(a_vAudioBlocksInPlace[channel], a_nSampleCount, filters[channel], _CrossoverStates(channel), r, bands(channel));
+        }
+#else
+        (void) a_vAudioBlocksInPlace; (void) a_nEnd; (void) a_nSampleCount; (void) r;
+#endif
+
+        return channel;
+    }
+
+    //RRS: Block-wise path: split, saturate the low band (oversampled and/or ADAA), add the delay-compensated high band
+    void _ProcessBlockwise(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType a_nFirst, TIntegerParamType a_nEnd, TIntegerParamType a_nSampleCount, SaturationRamp r)
+    {
+        for (TIntegerParamType channel = a_nFirst; channel < a_nEnd; ++channel)
+        {
+            TAudioSampleType* __restrict data = a_vAudioBlocksInPlace[channel];
+            TAudioSampleType* __restrict low = lowBand + (channel >> 2) * _nMaxBlockSize;
+
+            if (_bLinearPhase)
+            {
+                linearPhase.Split(channel, data, low, a_nSampleCount);
+                _SaturateLowBand(channel, data, low, a_nSampleCount, r);
+                continue;
+            }
+
+            if (_nFadeRemaining > 0)
+            {
+                _SplitCrossfade(channel, data, low, a_nSampleCount);
+                _SaturateLowBand(channel, data, low, a_nSampleCount, r);
+                continue;
+            }
+
+            const Filter& monoFilter = filters[channel];
+            const LRCoefficients lp = monoFilter.lpfCoeffs;
+            const LRCoefficients hp = monoFilter.hpfCoeffs;
+
+            TAudioSampleType* st = _CrossoverStates(channel);
+            TAudioSampleType ls1 = st[kStateLow1], ls2 = st[kStateLow2];
+            TAudioSampleType hs1 = st[kStateHigh1], hs2 = st[kStateHigh2];
+
+            if (_nTopology == kCrossoverComplementary)
+            {
+                const TAudioSampleType ap = monoFilter.apfCoeff;
+                TAudioSampleType as = allpass_states[channel];
+
+                for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+                {
+                    TAudioSampleType x = data[i];
+                    low[i] = monoFilter.lowpass_filter(x, &ls1, &ls2, lp.a0, lp.a1, lp.a2, lp.b1, lp.b2);
+                    data[i] = monoFilter.allpass_filter(x, &as, ap) - low[i];
+                }
+
+                allpass_states[channel] = as;
+            }
+            else
+            {
+                for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+                {
+                    TAudioSampleType x = data[i];
+                    low[i] = monoFilter.lowpass_filter(x, &ls1, &ls2, lp.a0, lp.a1, lp.a2, lp.b1, lp.b2);
+                    data[i] = monoFilter.highpass_filter(x, &hs1, &hs2, hp.a0, hp.a1, hp.a2, hp.b1, hp.b2);
+                }
+            }
+
+            st[kStateLow1] = ls1;  st[kStateLow2] = ls2;
+            st[kStateHigh1] = hs1; st[kStateHigh2] = hs2;
+
+            _SaturateLowBand(channel, data, low, a_nSampleCount, r);
+        }
+    }
+
+    // The 2-band split during a preset crossfade: the new filter on the current states and the old one (_fadeFilter) on the states
+    // as they were at the switch, each band blended from old to new along the fade
+    void _SplitCrossfade(TIntegerParamType channel, TAudioSampleType* __restrict data, TAudioSampleType* __restrict low, TIntegerParamType a_nSampleCount)
+    {
+        const Filter& nf = filters[channel];
+        const Filter& of = _fadeFilter;
+        const bool bComplementary = _nTopology == kCrossoverComplementary;
+
+        TAudioSampleType* st = _CrossoverStates(channel);
+        TAudioSampleType* ot = fadeStates + (channel >> 2) * kStateGroup + (channel & 3);
+        TAudioSampleType ls1 = st[kStateLow1], ls2 = st[kStateLow2], hs1 = st[kStateHigh1], hs2 = st[kStateHigh2];
+        TAudioSampleType ol1 = ot[kStateLow1], ol2 = ot[kStateLow2], oh1 = ot[kStateHigh1], oh2 = ot[kStateHigh2];
+        TAudioSampleType as = allpass_states[channel], oas = fadeAllpass[channel];
+
+        for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+        {
+            TAudioSampleType x = data[i];
+            TFloatParamType w = _fadeWeight + _fadeWeightInc * i;
+            w = w < 1.f ? w : 1.f;
+
+            TAudioSampleType newLow = nf.lowpass_filter(x, &ls1, &ls2, nf.lpfCoeffs.a0, nf.lpfCoeffs.a1, nf.lpfCoeffs.a2, nf.lpfCoeffs.b1, nf.lpfCoeffs.b2);
+            TAudioSampleType oldLow = of.lowpass_filter(x, &ol1, &ol2, of.lpfCoeffs.a0, of.lpfCoeffs.a1, of.lpfCoeffs.a2, of.lpfCoeffs.b1, of.lpfCoeffs.b2);
+            TAudioSampleType newHigh, oldHigh;
+
+            if (bComplementary)
+            {
+                newHigh = nf.allpass_filter(x, &as, nf.apfCoeff) - newLow;
+                oldHigh = of.allpass_filter(x, &oas, of.apfCoeff) - oldLow;
+            }
+            else
+            {
+                newHigh = nf.highpass_filter(x, &hs1, &hs2, nf.hpfCoeffs.a0, nf.hpfCoeffs.a1, nf.hpfCoeffs.a2, nf.hpfCoeffs.b1, nf.hpfCoeffs.b2);
+                oldHigh = of.highpass_filter(x, &oh1, &oh2, of.hpfCoeffs.a0, of.hpfCoeffs.a1, of.hpfCoeffs.a2, of.hpfCoeffs.b1, of.hpfCoeffs.b2);
+            }
+
+            low[i] = oldLow + w * (newLow - oldLow);
+            data[i] = oldHigh + w * (newHigh - oldHigh);
+        }
+
+        st[kStateLow1] = ls1;  st[kStateLow2] = ls2;  st[kStateHigh1] = hs1;  st[kStateHigh2] = hs2;
+        ot[kStateLow1] = ol1;  ot[kStateLow2] = ol2;  ot[kStateHigh1] = oh1;  ot[kStateHigh2] = oh2;
+        allpass_states[channel] = as;
+        fadeAllpass[channel] = oas;
+    }
+
+    // Top of Process(): swaps in a snapshot SubmitPreset() has published since the last one. Gain, drive and mix glide to it as from
+    // their setters, the tree's splits take their designed filters with remapped states, and the 2-band split starts a crossfade from
+    // the old filter. A switch that arrives during a crossfade waits for it to finish
+    void _AdoptPreset()
+    {
+        const uint32_t p = _nPresetPublished.load(std::memory_order_acquire);
+
+        if (p == _nPresetAdopted.load(std::memory_order_relaxed) || _nFadeRemaining > 0)
+            return;
+
+        const PresetSnapshot& s = _presetSnapshots[p & 1];
+        const DSPPreset& preset = s.preset;
+        const bool bDesigned = s.fs == fs && filters != NULL;
+
+        SetSmoothingTime(preset.smoothing_ms);
+        SetGain(preset.gain);
+        SetDrive(preset.drive);
+        SetMix(preset.mix);
+
+        for (TIntegerParamType b = 0; b < DSPPreset::kMaxBands; ++b)
+        {
+            multiband.bandAmount[b] = preset.bandAmount[b];
+            multiband.bandBypass[b] = (preset.bandBypass >> b) & 1;
+        }
+
+        for (TIntegerParamType k = 1; k < DSPPreset::kMaxSplits; ++k)
+        {
+            if (! bDesigned)
+            {
+                SetBandCrossoverFrequency(k, preset.splitFrequency_Hz[k]);
+                continue;
+            }
+
+            double m[2][2];
+            Filter::_lrStateMap(multiband.splits[k].apfCoeff, s.splits[k].apfCoeff, m);
+            multiband.splitFrequency[k] = preset.splitFrequency_Hz[k];
+            multiband.splits[k] = s.splits[k];
+            multiband.MapSplitStates(k, m);
+        }
+
+        SetNumBands(preset.nBands);
+
+        if (bDesigned)
+        {
+            // Nothing to fade from while idle (every state is zero), on the tree, or with the FIR split (its kernel crossfades itself)
+            if (! _bIdle && ! _bMultiband && ! _bLinearPhase && filters[0].apfCoeff != s.splits[0].apfCoeff)
+            {
+                const size_t nGroups = (size_t) ((_nMaxChannels + 3) >> 2);
+
+                _fadeFilter = filters[0];
+                memcpy(fadeStates, crossoverStates, nGroups * kStateGroup * sizeof(TAudioSampleType));
+                memcpy(fadeAllpass, allpass_states, nGroups * 4 * sizeof(TAudioSampleType));
+
+                _nFadeLength = (TIntegerParamType) (kPresetFade_ms * 0.001f * fs);
+                _nFadeLength = _nFadeLength > 0 ? _nFadeLength : 1;
+                _nFadeRemaining = _nFadeLength;
+            }
+
+            f_crossover = preset.splitFrequency_Hz[0];
+            multiband.splitFrequency[0] = f_crossover;
+            linearPhase.SetWantedFrequency(f_crossover);
+
+            _SetCrossoverPole(s.splits[0].apfCoeff, &s.splits[0]);
+            _crossover.Reset(crossoverCache.Position(f_crossover));
+        }
+        else
+        {
+            // Designed for another sample rate: the crossover glides there from the cache instead
+            SetCrossoverFrequency(preset.splitFrequency_Hz[0]);
+        }
+
+        _nPresetAdopted.store(p, std::memory_order_release);
+    }
+
+    // Second half of the block-wise path, after either split: saturate a_pLow and add it to the delay-compensated high band a_pData
+    void _SaturateLowBand(TIntegerParamType channel, TAudioSampleType* __restrict data, TAudioSampleType* __restrict low, TIntegerParamType a_nSampleCount, SaturationRamp r)
+    {
+        if (_pMeters != NULL)
+        {
+            MeterSums* sums = meterSums + (channel >> 2) * BandMeterFrame::kMaxBands;
+            meter_block(low, a_nSampleCount, _MeterKnee(r.drive + r.driveInc * (TFloatParamType) (a_nSampleCount / 2)), sums[0], _nSimdLevel);
+            meter_block(data, a_nSampleCount, std::numeric_limits<TAudioSampleType>::infinity(), sums[1], _nSimdLevel);
+        }
+
+        if (_nOversampling > 1)
+        {
+            Oversampler& os = oversamplers[channel];
+            TAudioSampleType* top = os.Upsample(low, a_nSampleCount);
+            SaturationRamp topRamp = r;
+            topRamp.driveInc /= os.GetFactor();
+            topRamp.mixInc /= os.GetFactor();
+
+            _SaturateBlock(top, a_nSampleCount * os.GetFactor(), adaaStates[channel], topRamp);
+
+            os.Downsample(low, a_nSampleCount);
+        }
+        else
+        {
+            _SaturateBlock(low, a_nSampleCount, adaaStates[channel], r);
+        }
+
+        if (_nLatency > 0)
+        {
+            TAudioSampleType* delay = highDelay + channel * _nLatency;
+            TIntegerParamType pos = highDelayPos[channel];
+
+            for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+            {
+                TAudioSampleType high = delay[pos];
+                delay[pos] = data[i];
+                pos = pos + 1 < _nLatency ? pos + 1 : 0;
+                data[i] = low[i] + high;
+            }
+
+            highDelayPos[channel] = pos;
+        }
+        else
+        {
+            for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+                data[i] += low[i];
+        }
+    }
+
+    //RRS: Multiband path: per sub-block, split all channels into bands, saturate each band that is not bypassed, sum back.
+    //RRS: Saturation runs at the base rate in naive mode; oversampling and ADAA apply to the 2-band path only
+    void _ProcessMultiband(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType a_nChannels, TIntegerParamType a_nSampleCount, SaturationRamp r)
+    {
+        MultibandCrossover& mb = multiband;
+        const TIntegerParamType nStride = mb.nStride;
+        const TIntegerParamType bandStride = MultibandCrossover::kSubBlock * nStride;
+        TAudioSampleType* __restrict frame = mb.frame;
+
+        for (TIntegerParamType offset = 0; offset < a_nSampleCount; offset += MultibandCrossover::kSubBlock)
+        {
+            TIntegerParamType m = a_nSampleCount - offset < MultibandCrossover::kSubBlock ? a_nSampleCount - offset : (TIntegerParamType) MultibandCrossover::kSubBlock;
+
+            for (TIntegerParamType i = 0; i < m; ++i)
+            {
+                for (TIntegerParamType c = 0; c < nStride; ++c)
+                    frame[c] = c < a_nChannels ? a_vAudioBlocksInPlace[c][offset + i] : 0.f;
+
+                mb._SplitFrame(frame, i);
+            }
+
+            // Padding channels are zero, so they add nothing to the sums
+            for (TIntegerParamType b = 0; _pMeters != NULL && b < mb.nBands; ++b)
+            {
+                TAudioSampleType knee = mb.bandBypass[b] ? std::numeric_limits<TAudioSampleType>::infinity()
+                                                         : _MeterKnee((r.drive + r.driveInc * (offset + m / 2)) * mb.bandAmount[b]);
+                meter_block(mb.bandBuffer + b * bandStride, m * nStride, knee, meterSums[b], _nSimdLevel);
+            }
+
+            // The band buffers are channel-interleaved, so one sample's ramp step is spread over nStride values
+            for (TIntegerParamType b = 0; b < mb.nBands; ++b)
+            {
+                if (mb.bandBypass[b])
+                    continue;
+
+                TFloatParamType amount = mb.bandAmount[b];
+                SaturationRamp bandRamp = { (r.drive + r.driveInc * offset) * amount, r.driveInc * amount / nStride,
+                                            r.mix + r.mixInc * offset, r.mixInc / nStride };
+
+                _SaturateRamp(mb.bandBuffer + b * bandStride, m * nStride, bandRamp);
+            }
+
+            for (TIntegerParamType i = 0; i < m; ++i)
+            {
+                const TAudioSampleType* __restrict band = mb.bandBuffer + i * nStride;
+
+                for (TIntegerParamType c = 0; c < nStride; ++c)
+                    frame[c] = band[c];
+
+                for (TIntegerParamType b = 1; b < mb.nBands; ++b)
+                    for (TIntegerParamType c = 0; c < nStride; ++c)
+                        frame[c] += band[b * bandStride + c];
+
+                for (TIntegerParamType c = 0; c < a_nChannels; ++c)
+                    a_vAudioBlocksInPlace[c][offset + i] = frame[c];
+            }
+        }
+    }
+
+    // Band level at which a_fDrive takes the saturator past its linear segment (|x| = 1/3)
+    static TAudioSampleType _MeterKnee(TFloatParamType a_fDrive)
+    {
+        return a_fDrive > 0.f ? (TAudioSampleType) (1.0 / (3.0 * a_fDrive)) : std::numeric_limits<TAudioSampleType>::infinity();
+    }
+
+    // End of Process(): the band sums of every group into the meter ballistics and one published frame, the output to the analyzer.
+    // A fixed amount of work per block
+    void _PublishTelemetry(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType a_nChannels, TIntegerParamType a_nSampleCount)
+    {
+        if (_pAnalyzer != NULL)
+            _pAnalyzer->Push(a_vAudioBlocksInPlace, a_nChannels, a_nSampleCount);
+
+        if (_pMeters == NULL || fs <= 0 || a_nSampleCount <= 0)
+            return;
+
+        const TIntegerParamType nGroups = (_nMaxChannels + 3) >> 2;
+        const TIntegerParamType nBands = _bMultiband ? multiband.nBands : 2;
+        const double nSamples = (double) a_nChannels * (double) a_nSampleCount;
+        const double release = exp(-a_nSampleCount / (BandMeterFrame::kPeakRelease_s * fs));
+        const double average = exp(-a_nSampleCount / (BandMeterFrame::kAverage_s * fs));
+
+        BandMeterFrame& frame = _pMeters->WriteSlot();
+        frame.nBands = (uint32_t) nBands;
+
+        for (TIntegerParamType b = 0; b < BandMeterFrame::kMaxBands; ++b)
+        {
+            MeterSums block = { 0, 0, 0 };
+
+            for (TIntegerParamType g = 0; g < nGroups; ++g)
+            {
+                MeterSums& s = meterSums[g * BandMeterFrame::kMaxBands + b];
+                block.peak = s.peak > block.peak ? s.peak : block.peak;
+                block.sumSquares += s.sumSquares;
+                block.nActive += s.nActive;
+                s = { 0, 0, 0 };
+            }
+
+            // Bands that are not there fall back like silent ones
+            _meterPeak[b] = block.peak > _meterPeak[b] * release ? block.peak : _meterPeak[b] * release;
+            _meterMeanSquare[b] = block.sumSquares / nSamples + average * (_meterMeanSquare[b] - block.sumSquares / nSamples);
+            _meterActivity[b] = block.nActive / nSamples + average * (_meterActivity[b] - block.nActive / nSamples);
+
+            frame.peak[b] = (float) _meterPeak[b];
+            frame.rms[b] = (float) sqrt(_meterMeanSquare[b]);
+            frame.activity[b] = (float) _meterActivity[b];
+        }
+
+        frame.nBlocks = ++_nMeterBlocks;
+        _pMeters->Publish();
+    }
+
+    //RRS: Saturates a whole block at SIMD width with constant drive and mix. Assertion: No memory allocations are allowed inside!
+    void saturateBlock(TAudioSampleType* a_pData, TIntegerParamType a_nSampleCount, TFloatParamType a_fDrive, TFloatParamType a_fMix)
+    {
+        SaturationRamp r = { a_fDrive, 0.f, a_fMix, 0.f };
+        _SaturateRamp(a_pData, a_nSampleCount, r);
+    }
+
+    void _SaturateRamp(TAudioSampleType* a_pData, TIntegerParamType a_nSampleCount, SaturationRamp r)
+    {
+#if RRS_SIMD_X86
+        if (_nSimdLevel >= kSimdAVX2)
+            saturate_block_avx2(a_pData, a_nSampleCount, r);
+        else if (_nSimdLevel >= kSimdSSE2)
+            saturate_block_sse2(a_pData, a_nSampleCount, r);
+        else
+#endif
+            saturate_block_scalar(a_pData, a_nSampleCount, r);
+    }
+
+    SaturationRamp _NextSaturationRamp(TIntegerParamType a_nSampleCount)
+    {
+        SaturationRamp r;
+        _drive.Next(a_nSampleCount, r.drive, r.driveInc);
+        _mix.Next(a_nSampleCount, r.mix, r.mixInc);
+        return r;
+    }
+
+    void _SaturateBlock(TAudioSampleType* a_pData, TIntegerParamType a_nSampleCount, AdaaState& a_state, SaturationRamp r)
+    {
+        if (_nSaturationMode == kSaturationNaive)
+        {
+            _SaturateRamp(a_pData, a_nSampleCount, r);
+            return;
+        }
+
+        // The ADAA output lags its input (by half a sample for ADAA1, one for ADAA2), so the dry signal is lined up before mixing
+        for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+        {
+            double x = a_pData[i];
+            double drive = r.drive + r.driveInc * i;
+            double mix = r.mix + r.mixInc * i;
+            double wet, dry;
+
+            if (_nSaturationMode == kSaturationADAA2)
+            {
+                wet = _SaturateADAA2(drive * x, a_state);
+                dry = a_state.dry1;
+            }
+            else
+            {
+                wet = _SaturateADAA1(drive * x, a_state);
+                dry = 0.5 * (x + a_state.dry1);
+            }
+
+            a_state.dry1 = x;
+            a_pData[i] = (TAudioSampleType) (dry + mix * (wet - dry));
+        }
+    }
+
+    //RRS: Lane of a_nChannel in its CrossoverStateLayout group: [kStateLow1], [kStateHigh1], [kStateLow2], [kStateHigh2]
+    TAudioSampleType* _CrossoverStates(TIntegerParamType a_nChannel) const
+    {
+        return crossoverStates + (a_nChannel >> 2) * kStateGroup + (a_nChannel & 3);
+    }
+
+    // Every buffer of the instance, sized from the max channels and block size, the oversampling and the saturation mode (the
+    // multiband tree always has room for kMaxBands, and the block-wise path always has its buffers, so a preset crossfade can move
+    // the 2-band path to it in any block). Only takes pointers from a_arena and sets sizes: see MemoryArena.
+    void _CarveArena(MemoryArena& a_arena)
+    {
+        // Rounded up to whole channel groups, so the kernels can always load 4 channels of state
+        const size_t nGroups = (size_t) ((_nMaxChannels + 3) >> 2);
+
+        crossoverStates = a_arena.Take<TAudioSampleType>(nGroups * kStateGroup);
+        allpass_states = a_arena.Take<TAudioSampleType>(nGroups * 4);
+        filters = a_arena.Take<Filter>(nGroups * 4);
+        _vSubBlocks = a_arena.Take<TAudioSampleType*>((size_t) _nMaxChannels);
+
+        _nInterleavedChunk = _nMaxBlockSize < _kInterleavedChunk ? _nMaxBlockSize : _kInterleavedChunk;
+        interleavedBlocks = a_arena.Take<TAudioSampleType>((size_t) (_nMaxChannels * _nInterleavedChunk));
+        interleavedScratch = a_arena.Take<TAudioSampleType>((size_t) (_nMaxChannels * _nInterleavedChunk));
+        _vInterleavedBlocks = a_arena.Take<TAudioSampleType*>((size_t) _nMaxChannels);
+
+        fadeStates = a_arena.Take<TAudioSampleType>(nGroups * kStateGroup);
+        fadeAllpass = a_arena.Take<TAudioSampleType>(nGroups * 4);
+        _nFadeRemaining = 0;
+
+        multiband.Prepare(a_arena, _nMaxChannels);
+        linearPhase.Prepare(a_arena, _nMaxChannels);
+        meterSums = a_arena.Take<MeterSums>(nGroups * BandMeterFrame::kMaxBands);
+
+        oversamplers = NULL;
+        adaaStates = NULL;
+        lowBand = NULL;
+        highDelay = NULL;
+        highDelayPos = NULL;
+        _nOversampledChannels = 0;
+        _nLatency = 0;
+
+        // ADAA delays by half (first order) or one (second order) sample at the rate it runs at
+        double adaaDelay = _nSaturationMode == kSaturationADAA2 ? 1.0 : (_nSaturationMode == kSaturationADAA1 ? 0.5 : 0.0);
+
+        if (_nOversampling > 1)
+        {
+            oversamplers = a_arena.Take<Oversampler>((size_t) _nMaxChannels);
+
+            // While measuring there is nothing to prepare into, but the sizes (and the latency) come from the same code
+            Oversampler probe;
+
+            for (TIntegerParamType n = 0; n < _nMaxChannels; ++n)
+            {
+                Oversampler& os = a_arena.IsMeasuring() ? probe : oversamplers[n];
+                os.Prepare(a_arena, _nOversampling, _nOversamplingMode, _nMaxBlockSize, adaaDelay);
+                _nLatency = os.nLatency;
+            }
+
+            _nOversampledChannels = _nMaxChannels;
+        }
+        else
+        {
+            _nLatency = (TIntegerParamType) adaaDelay; // the half sample of ADAA1 is left uncompensated
+        }
+
+        adaaStates = a_arena.Take<AdaaState>((size_t) _nMaxChannels);
+
+        lowBand = a_arena.Take<TAudioSampleType>(nGroups * (size_t) _nMaxBlockSize);
+        highDelay = a_arena.Take<TAudioSampleType>((size_t) (_nMaxChannels * (_nLatency > 0 ? _nLatency : 1)));
+        highDelayPos = a_arena.Take<TIntegerParamType>((size_t) _nMaxChannels);
+    }
+
+    // Measures the layout, makes room (reusing the block when it is big enough) and carves it. A new layout starts from silence:
+    // states and delay lines are zeroed, while the coefficients of the current crossover are carried over
+    void _ReBuildArena()
+    {
+        MemoryArena measure;
+        measure.Init();
+        _CarveArena(measure);
+
+        _arena.Reserve(measure.used);
+        _CarveArena(_arena);
+
+        // Split 0 of the multiband tree always holds the 2-band coefficients, see _SetCrossoverPole()
+        if (fs > 0)
+            for (TIntegerParamType channel = 0; channel < ((_nMaxChannels + 3) & ~3); channel++)
+            {
+                filters[channel] = multiband.splits[0];
+                filters[channel].blockLRCoeffs();
+            }
+
+        if (fs > 0)
+            linearPhase.BuildKernelNow(f_crossover, fs);
+    }
+
+    // The most any configuration within the Preallocate() bounds (and the current one) takes. Measuring points every arena pointer at
+    // NULL, so the caller rebuilds afterwards
+    size_t _MeasureLargestLayout()
+    {
+        const TIntegerParamType nOversampling = _nOversampling, nOversamplingMode = _nOversamplingMode, nSaturationMode = _nSaturationMode;
+        const TIntegerParamType nLinearPhaseMode = linearPhase.nMode, nKernelLength = linearPhase.nKernelLength;
+
+        MemoryArena measure;
+        measure.Init();
+        _CarveArena(measure);
+        size_t nLargest = measure.used;
+
+        for (TIntegerParamType nFactor = 1; nFactor <= _nPreallocatedOversampling && nFactor <= 8; nFactor *= 2)
+            for (TIntegerParamType nMode : { kOversamplingQuality, kOversamplingLowLatency })
+                for (TIntegerParamType nSaturation : { kSaturationNaive, kSaturationADAA1, kSaturationADAA2 })
+                    for (TIntegerParamType nLinearPhase : { kLinearPhaseOff, kLinearPhaseUniform, kLinearPhaseLowLatency })
+                    {
+                        _nOversampling = nFactor;
+                        _nOversamplingMode = nMode;
+                        _nSaturationMode = nSaturation;
+                        linearPhase.Configure(_nPreallocatedKernel > 0 ? nLinearPhase : kLinearPhaseOff, _nPreallocatedKernel);
+
+                        measure.Init();
+                        _CarveArena(measure);
+                        nLargest = measure.used > nLargest ? measure.used : nLargest;
+                    }
+
+        _nOversampling = nOversampling;
+        _nOversamplingMode = nOversamplingMode;
+        _nSaturationMode = nSaturationMode;
+        linearPhase.Configure(nLinearPhaseMode, nKernelLength);
+
+        return nLargest;
+    }
+
+    bool _IsCarved() const { return _arena.base != NULL; }
+
+    // Every pointer into the arena back to NULL, after it has been released
+    void _ForgetArena()
+    {
+        crossoverStates = NULL;
+        allpass_states = NULL;
+        filters = NULL;
+        _vSubBlocks = NULL;
+        interleavedBlocks = NULL;
+        interleavedScratch = NULL;
+        _vInterleavedBlocks = NULL;
+        oversamplers = NULL;
+        adaaStates = NULL;
+        lowBand = NULL;
+        highDelay = NULL;
+        highDelayPos = NULL;
+        _nOversampledChannels = 0;
+        _nLatency = 0;
+
+        multiband.Release();
+        linearPhase.Release();
+        meterSums = NULL;
+        fadeStates = NULL;
+        fadeAllpass = NULL;
+        _nFadeRemaining = 0;
+    }
+        
+    //RRS: Soft clipping based on quadratic function, blended with x by mixAmount (0 = dry, 1 = fully saturated).
+    //RRS: Branchless: the five segments (2x below 1/3, a quadratic knee up to 2/3, +-1 above, mirrored) are one clamp and one polynomial,
+    //RRS: see tube_saturation_branchless() in DSPSimd.h
+    TAudioSampleType tubeSaturation(TAudioSampleType x, TFloatParamType mixAmount)
+    {
+        return mixAmount * tube_saturation_branchless(x) + (1.0f - mixAmount) * x;
+    }
+
+    //RRS: Same with the saturator fed a driven copy of the dry signal
+    TAudioSampleType tubeSaturation(TAudioSampleType drivenX, TFloatParamType mixAmount, TAudioSampleType dryX)
+    {
+        return dryX + mixAmount * (tube_saturation_branchless(drivenX) - dryX);
+    }
+
+    //RRS: First antiderivative of tubeSaturation() (even), continuous across the five segments
+    static double tubeSaturationAD1(double x)
+    {
+        const double threshold1 = 1.0/3.0;
+        const double threshold2 = 2.0/3.0;
+
+        if(x > threshold2)
+            return x - 7.0/27.0;
+        else if(x > threshold1)
+            return x*x - (x - threshold1)*(x - threshold1)*(x - threshold1);
+        else if(x < -threshold2)
+            return -x - 7.0/27.0;
+        else if(x < -threshold1)
+            return x*x + (x + threshold1)*(x + threshold1)*(x + threshold1);
+        else
+            return x*x;
+    }
+
+    //RRS: Second antiderivative of tubeSaturation() (odd)
+    static double tubeSaturationAD2(double x)
+    {
+        const double threshold1 = 1.0/3.0;
+        const double threshold2 = 2.0/3.0;
+
+        if(x > threshold2)
+            return x*x/2.0 - 7.0*x/27.0 + 5.0/108.0;
+        else if(x > threshold1)
+            return x*x*x/3.0 - (x - threshold1)*(x - threshold1)*(x - threshold1)*(x - threshold1)/4.0;
+        else if(x < -threshold2)
+            return -x*x/2.0 - 7.0*x/27.0 - 5.0/108.0;
+        else if(x < -threshold1)
+            return x*x*x/3.0 + (x + threshold1)*(x + threshold1)*(x + threshold1)*(x + threshold1)/4.0;
+        else
+            return x*x*x/3.0;
+    }
+
+    // Below this input difference the divided differences are replaced by their midpoint limits
+    static constexpr double _kAdaaTolerance = 1e-5;
+
+    double _SaturateADAA1(double x, AdaaState& s)
+    {
+        double ad1 = tubeSaturationAD1(x);
+        double dx = x - s.x1;
+        double y = fabs(dx) < _kAdaaTolerance ? tubeSaturation((TAudioSampleType) (0.5 * (x + s.x1)), 1.f)
+                                              : (ad1 - s.ad1) / dx;
+        s.x1 = x;
+        s.ad1 = ad1;
+        return y;
+    }
+
+    double _SaturateADAA2(double x, AdaaState& s)
+    {
+        double dx = x - s.x1;
+        double d0 = fabs(dx) < _kAdaaTolerance ? tubeSaturationAD1(0.5 * (x + s.x1))
+                                               : (tubeSaturationAD2(x) - tubeSaturationAD2(s.x1)) / dx;
+        double y;
+
+        if (fabs(x - s.x2) < _kAdaaTolerance)
+        {
+            // x[n] ~ x[n-2]: evaluate around their mean instead of dividing by their difference
+            double xBar = 0.5 * (x + s.x2);
+            double delta = xBar - s.x1;
+
+            y = fabs(delta) < _kAdaaTolerance ? tubeSaturation((TAudioSampleType) (0.5 * (xBar + s.x1)), 1.f)
+                                              : (2.0 / delta) * (tubeSaturationAD1(xBar) + (tubeSaturationAD2(s.x1) - tubeSaturationAD2(xBar)) / delta);
+        }
+        else
+        {
+            y = 2.0 * (d0 - s.ad1) / (x - s.x2);
+        }
+
+        s.ad1 = d0;
+        s.x2 = s.x1;
+        s.x1 = x;
+        return y;
+    }
+};
+
+typedef DSPT<TAudioSampleType> DSP;
 
@@ -0,0 +1,534 @@
+
+// Red Rock Sound (RRS):
+// Batch engine for server-side use: many independent mono saturator voices processed together, in place of one DSP per stream.
+// Include after DSP.h. Each voice is the default 2-band path of DSP::Process() (LR2 split, low band through the tube curve and
+// blended with its dry copy, high band clean, output gain), with its own crossover, drive, mix and gain.
+
+// Everything per voice is structure-of-arrays, [voice] with voices padded to kGroup, carved from one MemoryArena. Process() runs
+// the voices a lane group at a time: kSubBlock samples of the group's kGroup streams are interleaved into a [sample][lane] frame, and
+// one pass then advances all kGroup voices by a sample, each with its own coefficients.
+
+// The LP and HP sections of an LR2 pair share their denominator (see Filter), so fed the same input their DF2 states w are the
+// same sequence; a voice keeps one pair of them, and both outputs come from it: LP = a0 (w + 2 w1 + w2), HP = a0 (w - 2 w1 + w2).
+
+// AddVoice() and RemoveVoice() only flip slots inside the arena, and the per-voice setters touch nothing else, so all of them are
+// safe on the audio thread; only SetMaxVoices() (re)allocates.
+
+#pragma once
+
+struct SaturatorBatch
+{
+    enum { kGroup = 8, kSubBlock = 64 };
+
+    // Everything below that points to memory points into _arena
+    MemoryArena _arena = { NULL, NULL, 0, 0 };
+
+    TIntegerParamType _nMaxVoices;
+    TIntegerParamType _nStride;         // _nMaxVoices rounded up to kGroup
+    TIntegerParamType _nSimdLevel;
+    TIntegerParamType nVoices;          // slots in use
+    TFloatParamType fs;
+    CrossoverCoefficientCache crossoverCache;
+
+    // [voice]
+    unsigned char* active;
+    TFloatParamType* crossover;         // Hz, as set
+    TFloatParamType* pole;              // the LR2 pole a of that crossover
+    TFloatParamType* lpA0;
+    TFloatParamType* hpA0;
+    TFloatParamType* b1;
+    TFloatParamType* b2;
+    TFloatParamType* w1;                // DF2 state w[n-1], shared by LP and HP
+    TFloatParamType* w2;                // w[n-2]
+
+    // [voice]: the value at the start of the next block and the one it ramps to across that block, then the increment per sample
+    TFloatParamType* drive;
+    TFloatParamType* driveTarget;
+    TFloatParamType* driveInc;
+    TFloatParamType* mix;
+    TFloatParamType* mixTarget;
+    TFloatParamType* mixInc;
+    TFloatParamType* gain;
+    TFloatParamType* gainTarget;
+    TFloatParamType* gainInc;
+
+    void Init()
+    {
+        _arena.Release();
+
+        _nMaxVoices = 0;
+        _nStride = 0;
+        _nSimdLevel = simd_detect_level();
+        nVoices = 0;
+        fs = 0;
+        crossoverCache.fs = 0;
+
+        _ForgetArena();
+    } //RRS: Memory allocations are allowed inside
+
+    //RRS: Number of voice slots. Removes every voice. Memory allocations are allowed inside
+    void SetMaxVoices(TIntegerParamType a_nMaxVoices)
+    {
+        _nMaxVoices = a_nMaxVoices > 0 ? a_nMaxVoices : 0;
+        _nStride = (_nMaxVoices + kGroup - 1) / kGroup * kGroup;
+        nVoices = 0;
+
+        MemoryArena measure;
+        measure.Init();
+        _CarveArena(measure);
+
+        _arena.Reserve(measure.used);
+        _CarveArena(_arena);
+    }
+
+    //RRS: Builds the crossover cache and recomputes every voice's coefficients exactly. Memory allocations are allowed inside
+    void SetSampleRate(TFloatParamType a_fSampleRate_Hz)
+    {
+        fs = a_fSampleRate_Hz;
+        crossoverCache.Build(fs);
+
+        for (TIntegerParamType v = 0; v < _nMaxVoices; ++v)
+            if (active[v])
+                _SetPole(v, (TFloatParamType) Filter::_lrPole(crossover[v], fs));
+    }
+
+    //RRS: Caps the kernel used by Process() (kSimdScalar/kSimdSSE2/kSimdAVX2); requests above what the CPU supports are clamped
+    void SetSimdLevel(TIntegerParamType a_nSimdLevel)
+    {
+        TIntegerParamType nSupported = simd_detect_level();
+        _nSimdLevel = a_nSimdLevel < nSupported ? a_nSimdLevel : nSupported;
+    }
+
+    //RRS: Takes the lowest free slot and starts it from silence at these settings (no glide); returns the slot, or -1 when all are taken.
+    //RRS: Assertion: No memory allocations are allowed inside!
+    TIntegerParamType AddVoice(TFloatParamType a_fCrossover_Hz, TFloatParamType a_fDrive, TFloatParamType a_fMix_01, TFloatParamType a_fGain_01)
+    {
+        TIntegerParamType v = 0;
+        while (v < _nMaxVoices && active[v])
+            ++v;
+
+        if (v == _nMaxVoices)
+            return -1;
+
+        active[v] = 1;
+        ++nVoices;
+
+        crossover[v] = a_fCrossover_Hz;
+        w1[v] = w2[v] = 0.f;
+        drive[v] = driveTarget[v] = a_fDrive;
+        mix[v] = mixTarget[v] = a_fMix_01;
+        gain[v] = gainTarget[v] = a_fGain_01;
+
+        // One tan() per voice; the cache serves the crossover changes after that
+        if (fs > 0)
+            _SetPole(v, (TFloatParamType) Filter::_lrPole(a_fCrossover_Hz, fs));
+
+        return v;
+    }
+
+    //RRS: Frees the slot; Process() skips it from now on. Assertion: No memory allocations are allowed inside!
+    void RemoveVoice(TIntegerParamType a_nVoice)
+    {
+        if (a_nVoice < 0 || a_nVoice >= _nMaxVoices || ! active[a_nVoice])
+            return;
+
+        active[a_nVoice] = 0;
+        --nVoices;
+
+        // A half-filled lane group still runs this lane on silence, which must stay silent
+        w1[a_nVoice] = w2[a_nVoice] = 0.f;
+    }
+
+    bool IsVoiceActive(TIntegerParamType a_nVoice) const { return a_nVoice >= 0 && a_nVoice < _nMaxVoices && active[a_nVoice] != 0; }
+
+    //RRS: Takes effect at the next block, with the states remapped to the new pole (see DSP::_SetCrossoverPole()); no glide.
+    //RRS: Assertion: No memory allocations are allowed inside!
+    void SetVoiceCrossoverFrequency(TIntegerParamType a_nVoice, TFloatParamType a_fCrossover_Hz)
+    {
+        crossover[a_nVoice] = a_fCrossover_Hz;
+
+        if (crossoverCache.fs <= 0)
+            return;
+
+        TFloatParamType a = crossoverCache.Pole(a_fCrossover_Hz);
+        double m[2][2];
+        Filter::_lrStateMap(pole[a_nVoice], a, m);
+
+        double s1 = w1[a_nVoice], s2 = w2[a_nVoice];
+        w1[a_nVoice] = (TFloatParamType) (m[0][0] * s1 + m[0][1] * s2);
+        w2[a_nVoice] = (TFloatParamType) (m[1][0] * s1 + m[1][1] * s2);
+
+        _SetPole(a_nVoice, a);
+    }
+
+    // Drive, mix and gain ramp linearly to the new value across the next block. Assertion: No memory allocations are allowed inside!
+    void SetVoiceDrive(TIntegerParamType a_nVoice, TFloatParamType a_fDrive) { driveTarget[a_nVoice] = a_fDrive; }
+    void SetVoiceMix(TIntegerParamType a_nVoice, TFloatParamType a_fMix_01) { mixTarget[a_nVoice] = a_fMix_01; }
+    void SetVoiceGain(TIntegerParamType a_nVoice, TFloatParamType a_fGain_01) { gainTarget[a_nVoice] = a_fGain_01; }
+
+    void Release()
+    {
+        _arena.Release();
+        _ForgetArena();
+        _nMaxVoices = _nStride = nVoices = 0;
+    }
+
+    //RRS: a_vVoices[v] is voice v's block, processed in place; a_nVoices is how many entries there are (at most the max voices).
+    //RRS: Free slots and NULL entries are skipped; an active voice left out this way keeps its filter state, and its drive, mix and gain
+    //RRS: ramp to their targets across the next block it is processed in. Assertion: No memory allocations are allowed inside!
+    void Process(TAudioSampleType* const* a_vVoices, TIntegerParamType a_nVoices, TIntegerParamType a_nSampleCount)
+    {
+        RealtimeScope realtimeScope;
+
+        if (a_nSampleCount <= 0)
+            return;
+
+        a_nVoices = a_nVoices < _nMaxVoices ? a_nVoices : _nMaxVoices;
+
+        const TFloatParamType step = 1.f / (TFloatParamType) a_nSampleCount;
+        const TIntegerParamType nLanes = (a_nVoices + kGroup - 1) / kGroup * kGroup;
+
+        for (TIntegerParamType v = 0; v < nLanes; ++v)
+        {
+            driveInc[v] = (driveTarget[v] - drive[v]) * step;
+            mixInc[v] = (mixTarget[v] - mix[v]) * step;
+            gainInc[v] = (gainTarget[v] - gain[v]) * step;
+        }
+
+        alignas(MemoryArena::kAlignment) TAudioSampleType frame[kSubBlock * kGroup];
+        alignas(MemoryArena::kAlignment) TAudioSampleType silence[kSubBlock] = {}, scratch[kSubBlock];
+        TAudioSampleType* lanes[kGroup];
+        TFloatParamType held1[kGroup], held2[kGroup], heldDrive[kGroup], heldMix[kGroup], heldGain[kGroup];
+
+        for (TIntegerParamType v0 = 0; v0 < a_nVoices; v0 += kGroup)
+        {
+            TIntegerParamType nUsed = 0;
+
+            for (TIntegerParamType l = 0; l < kGroup; ++l)
+            {
+                TIntegerParamType v = v0 + l;
+                lanes[l] = v < a_nVoices && active[v] ? a_vVoices[v] : NULL;
+                nUsed += lanes[l] != NULL;
+                held1[l] = w1[v];
+                held2[l] = w2[v];
+                heldDrive[l] = drive[v];
+                heldMix[l] = mix[v];
+                heldGain[l] = gain[v];
+            }
+
+            if (nUsed == 0)
+                continue;
+
+            for (TIntegerParamType offset = 0; offset < a_nSampleCount; offset += kSubBlock)
+            {
+                TIntegerParamType n = a_nSampleCount - offset < kSubBlock ? a_nSampleCount - offset : kSubBlock;
+
+                // Lanes without a block read silence and write into scratch
+                const TAudioSampleType* in[kGroup];
+                TAudioSampleType* out[kGroup];
+                for (TIntegerParamType l = 0; l < kGroup; ++l)
+                {
+                    in[l] = lanes[l] != NULL ? lanes[l] + offset : silence;
+                    out[l] = lanes[l] != NULL ? lanes[l] + offset : scratch;
+                }
+
+                _Interleave(in, frame, n);
+
+#if RRS_SIMD_X86
+                if (_nSimdLevel >= kSimdAVX2)
+                    _ProcessGroupAVX2(frame, n, v0);
+                else if (_nSimdLevel >= kSimdSSE2)
+                    _ProcessGroupSSE2(frame, n, v0);
+                else
+#endif
+                _ProcessGroupScalar(frame, n, v0);
+
+
+                _Deinterleave(frame, out, n);
+            }
+
+            // A lane without a block ran on silence: a voice left out keeps its state and its ramps' start. The ramps of the others
+            // end exactly on their targets, whatever the rounding of the steps.
+            for (TIntegerParamType v = v0; v < v0 + kGroup; ++v)
+            {
+                if (lanes[v - v0] == NULL)
+                {
+                    w1[v] = held1[v - v0];
+                    w2[v] = held2[v - v0];
+                    drive[v] = heldDrive[v - v0];
+                    mix[v] = heldMix[v - v0];
+                    gain[v] = heldGain[v - v0];
+                    continue;
+                }
+
+                drive[v] = driveTarget[v];
+                mix[v] = mixTarget[v];
+                gain[v] = gainTarget[v];
+            }
+        }
+    }
+
+    // kGroup blocks of a_nSampleCount samples into a [sample][lane] frame, and back; 4x4 tiles transposed in registers, as lr_process_avx2()
+    static void _Interleave(const TAudioSampleType* const* a_vIn, TAudioSampleType* __restrict a_pFrame, TIntegerParamType a_nSampleCount)
+    {
+        TIntegerParamType i = 0;
+
+#if RRS_SIMD_X86
+        for (; i + 4 <= a_nSampleCount; i += 4)
+            for (TIntegerParamType l = 0; l < kGroup; l += 4)
+            {
+                __m128 r0 = _mm_loadu_ps(a_vIn[l] + i), r1 = _mm_loadu_ps(a_vIn[l + 1] + i);
+                __m128 r2 = _mm_loadu_ps(a_vIn[l + 2] + i), r3 = _mm_loadu_ps(a_vIn[l + 3] + i);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+                TAudioSampleType* x = a_pFrame + i * kGroup + l;
+                _mm_store_ps(x, r0);
+                _mm_store_ps(x + kGroup, r1);
+                _mm_store_ps(x + 2 * kGroup, r2);
+                _mm_store_ps(x + 3 * kGroup, r3);
+            }
+#endif
+
+        for (; i < a_nSampleCount; ++i)
+            for (TIntegerParamType l = 0; l < kGroup; ++l)
+                a_pFrame[(size_t) i * kGroup + l] = a_vIn[l][i];
+    }
+
+    static void _Deinterleave(const TAudioSampleType* __restrict a_pFrame, TAudioSampleType* const* a_vOut, TIntegerParamType a_nSampleCount)
+    {
+        TIntegerParamType i = 0;
+
+#if RRS_SIMD_X86
+        for (; i + 4 <= a_nSampleCount; i += 4)
+            for (TIntegerParamType l = 0; l < kGroup; l += 4)
+            {
+                const TAudioSampleType* x = a_pFrame + i * kGroup + l;
+                __m128 r0 = _mm_load_ps(x), r1 = _mm_load_ps(x + kGroup), r2 = _mm_load_ps(x + 2 * kGroup), r3 = _mm_load_ps(x + 3 * kGroup);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+                _mm_storeu_ps(a_vOut[l] + i, r0);
+                _mm_storeu_ps(a_vOut[l + 1] + i, r1);
+                _mm_storeu_ps(a_vOut[l + 2] + i, r2);
+                _mm_storeu_ps(a_vOut[l + 3] + i, r3);
+            }
+#endif
+
+        for (; i < a_nSampleCount; ++i)
+            for (TIntegerParamType l = 0; l < kGroup; ++l)
+                a_vOut[l][i] = a_pFrame[(size_t) i * kGroup + l];
+    }
+
+    //RRS: One sub-block of the kGroup voices from a_nVoice on, lanes of a_pFrame interleaved [sample][lane]; plain loops over the lanes
+    void _ProcessGroupScalar(TAudioSampleType* __restrict a_pFrame, TIntegerParamType a_nSampleCount, TIntegerParamType a_nVoice)
+    {
+        TFloatParamType s1[kGroup], s2[kGroup], d[kGroup], m[kGroup], g[kGroup];
+
+        for (TIntegerParamType l = 0; l < kGroup; ++l)
+        {
+            s1[l] = w1[a_nVoice + l];
+            s2[l] = w2[a_nVoice + l];
+            d[l] = drive[a_nVoice + l];
+            m[l] = mix[a_nVoice + l];
+            g[l] = gain[a_nVoice + l];
+        }
+
+        const TFloatParamType* __restrict lpa = lpA0 + a_nVoice;
+        const TFloatParamType* __restrict hpa = hpA0 + a_nVoice;
+        const TFloatParamType* __restrict c1 = b1 + a_nVoice;
+        const TFloatParamType* __restrict c2 = b2 + a_nVoice;
+        const TFloatParamType* __restrict di = driveInc + a_nVoice;
+        const TFloatParamType* __restrict mi = mixInc + a_nVoice;
+        const TFloatParamType* __restrict gi = gainInc + a_nVoice;
+
+        for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+        {
+            TAudioSampleType* __restrict x = a_pFrame + i * kGroup;
+
+            for (TIntegerParamType l = 0; l < kGroup; ++l)
+            {
+                TFloatParamType w = x[l] - c1[l] * s1[l] - c2[l] * s2[l];
+                TFloatParamType sum = w + s2[l], twice = s1[l] + s1[l];
+                TFloatParamType low = lpa[l] * (sum + twice);
+                TFloatParamType high = hpa[l] * (twice - sum);
+                s2[l] = s1[l];
+                s1[l] = w;
+
+                // tube_saturation_branchless(), spelled out with selects the vectorizer takes
+                TFloatParamType driven = d[l] * low, ax = fabsf(driven);
+                TFloatParamType a = ax < 2.0f/3.0f ? ax : 2.0f/3.0f;
+                TFloatParamType u = a - 1.0f/3.0f > 0.0f ? a - 1.0f/3.0f : 0.0f;
+                TFloatParamType sat = copysignf(2.0f * a - 3.0f * u * u, driven);
+
+                x[l] = g[l] * (low + m[l] * (sat - low) + high);
+                d[l] += di[l];
+                m[l] += mi[l];
+                g[l] += gi[l];
+            }
+        }
+
+        for (TIntegerParamType l = 0; l < kGroup; ++l)
+        {
+            w1[a_nVoice + l] = s1[l];
+            w2[a_nVoice + l] = s2[l];
+            drive[a_nVoice + l] = d[l];
+            mix[a_nVoice + l] = m[l];
+            gain[a_nVoice + l] = g[l];
+        }
+    }
+
+#if RRS_SIMD_X86
+    //RRS: As _ProcessGroupScalar(); the group's vectors are independent chains, interleaved so one's latency hides behind the others
+    void _ProcessGroupSSE2(TAudioSampleType* a_pFrame, TIntegerParamType a_nSampleCount, TIntegerParamType a_nVoice)
+    {
+        enum { kVectors = kGroup / 4 };
+        __m128 s1[kVectors], s2[kVectors], d[kVectors], m[kVectors], g[kVectors];
+        __m128 lpa[kVectors], hpa[kVectors], c1[kVectors], c2[kVectors], di[kVectors], mi[kVectors], gi[kVectors];
+
+        // Into locals for the whole sub-block: the frame stores could otherwise alias the members, and every pointer would be reloaded
+        for (int k = 0; k < kVectors; ++k)
+        {
+            TIntegerParamType v = a_nVoice + 4 * k;
+            s1[k] = _mm_load_ps(w1 + v);
+            s2[k] = _mm_load_ps(w2 + v);
+            d[k] = _mm_load_ps(drive + v);
+            m[k] = _mm_load_ps(mix + v);
+            g[k] = _mm_load_ps(gain + v);
+            lpa[k] = _mm_load_ps(lpA0 + v);
+            hpa[k] = _mm_load_ps(hpA0 + v);
+            c1[k] = _mm_load_ps(b1 + v);
+            c2[k] = _mm_load_ps(b2 + v);
+            di[k] = _mm_load_ps(driveInc + v);
+            mi[k] = _mm_load_ps(mixInc + v);
+            gi[k] = _mm_load_ps(gainInc + v);
+        }
+
+        for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+            for (int k = 0; k < kVectors; ++k)
+            {
+                TAudioSampleType* x = a_pFrame + i * kGroup + 4 * k;
+
+                __m128 w = _mm_sub_ps(_mm_sub_ps(_mm_load_ps(x), _mm_mul_ps(c2[k], s2[k])), _mm_mul_ps(c1[k], s1[k]));
+                __m128 sum = _mm_add_ps(w, s2[k]), twice = _mm_add_ps(s1[k], s1[k]);
+                __m128 low = _mm_mul_ps(lpa[k], _mm_add_ps(sum, twice));
+                __m128 high = _mm_mul_ps(hpa[k], _mm_sub_ps(twice, sum));
+                s2[k] = s1[k];
+                s1[k] = w;
+
+                _mm_store_ps(x, _mm_mul_ps(g[k], _mm_add_ps(simd_drive_mix_sse2(low, d[k], m[k]), high)));
+                d[k] = _mm_add_ps(d[k], di[k]);
+                m[k] = _mm_add_ps(m[k], mi[k]);
+                g[k] = _mm_add_ps(g[k], gi[k]);
+            }
+
+        for (int k = 0; k < kVectors; ++k)
+        {
+            TIntegerParamType v = a_nVoice + 4 * k;
+            _mm_store_ps(w1 + v, s1[k]);
+            _mm_store_ps(w2 + v, s2[k]);
+            _mm_store_ps(drive + v, d[k]);
+            _mm_store_ps(mix + v, m[k]);
+            _mm_store_ps(gain + v, g[k]);
+        }
+    }
+
+    RRS_TARGET_AVX2 void _ProcessGroupAVX2(TAudioSampleType* a_pFrame, TIntegerParamType a_nSampleCount, TIntegerParamType a_nVoice)
+    {
+        enum { kVectors = kGroup / 8 };
+        __m256 s1[kVectors], s2[kVectors], d[kVectors], m[kVectors], g[kVectors];
+        __m256 lpa[kVectors], hpa[kVectors], c1[kVectors], c2[kVectors], di[kVectors], mi[kVectors], gi[kVectors];
+
+        // Into locals for the whole sub-block: the frame stores could otherwise alias the members, and every pointer would be reloaded
+        for (int k = 0; k < kVectors; ++k)
+        {
+            TIntegerParamType v = a_nVoice + 8 * k;
+            s1[k] = _mm256_load_ps(w1 + v);
+            s2[k] = _mm256_load_ps(w2 + v);
+            d[k] = _mm256_load_ps(drive + v);
+            m[k] = _mm256_load_ps(mix + v);
+            g[k] = _mm256_load_ps(gain + v);
+            lpa[k] = _mm256_load_ps(lpA0 + v);
+            hpa[k] = _mm256_load_ps(hpA0 + v);
+            c1[k] = _mm256_load_ps(b1 + v);
+            c2[k] = _mm256_load_ps(b2 + v);
+            di[k] = _mm256_load_ps(driveInc + v);
+            mi[k] = _mm256_load_ps(mixInc + v);
+            gi[k] = _mm256_load_ps(gainInc + v);
+        }
+
+        for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+            for (int k = 0; k < kVectors; ++k)
+            {
+                TAudioSampleType* x = a_pFrame + i * kGroup + 8 * k;
+
+                __m256 w = _mm256_fnmadd_ps(c1[k], s1[k], _mm256_fnmadd_ps(c2[k], s2[k], _mm256_load_ps(x)));
+                __m256 sum = _mm256_add_ps(w, s2[k]), twice = _mm256_add_ps(s1[k], s1[k]);
+                __m256 low = _mm256_mul_ps(lpa[k], _mm256_add_ps(sum, twice));
+                __m256 high = _mm256_mul_ps(hpa[k], _mm256_sub_ps(twice, sum));
+                s2[k] = s1[k];
+                s1[k] = w;
+
+                __m256 sat = simd_tube_saturation_avx2(_mm256_mul_ps(d[k], low));
+                _mm256_store_ps(x, _mm256_mul_ps(g[k], _mm256_add_ps(_mm256_fmadd_ps(m[k], _mm256_sub_ps(sat, low), low), high)));
+                d[k] = _mm256_add_ps(d[k], di[k]);
+                m[k] = _mm256_add_ps(m[k], mi[k]);
+                g[k] = _mm256_add_ps(g[k], gi[k]);
+            }
+
+        for (int k = 0; k < kVectors; ++k)
+        {
+            TIntegerParamType v = a_nVoice + 8 * k;
+            _mm256_store_ps(w1 + v, s1[k]);
+            _mm256_store_ps(w2 + v, s2[k]);
+            _mm256_store_ps(drive + v, d[k]);
+            _mm256_store_ps(mix + v, m[k]);
+            _mm256_store_ps(gain + v, g[k]);
+        }
+    }
+#endif
+
+    // Coefficients from a pole, as Filter::setLRPole() computes them
+    void _SetPole(TIntegerParamType a_nVoice, TFloatParamType a)
+    {
+        Filter f;
+        f._lpfFromPole(a);
+        f._hpfFromPole(a);
+
+        pole[a_nVoice] = a;
+        lpA0[a_nVoice] = f.lpfCoeffs.a0;
+        hpA0[a_nVoice] = f.hpfCoeffs.a0;
+        b1[a_nVoice] = f.lpfCoeffs.b1;
+        b2[a_nVoice] = f.lpfCoeffs.b2;
+    }
+
+    // Same measure-then-carve scheme as DSP::_CarveArena(); every array is a whole number of lane groups, so the kernels load aligned
+    void _CarveArena(MemoryArena& a_arena)
+    {
+        const size_t n = (size_t) _nStride;
+
+        active = a_arena.Take<unsigned char>(n);
+        crossover = a_arena.Take<TFloatParamType>(n);
+        pole = a_arena.Take<TFloatParamType>(n);
+        lpA0 = a_arena.Take<TFloatParamType>(n);
+        hpA0 = a_arena.Take<TFloatParamType>(n);
+        b1 = a_arena.Take<TFloatParamType>(n);
+        b2 = a_arena.Take<TFloatParamType>(n);
+        w1 = a_arena.Take<TFloatParamType>(n);
+        w2 = a_arena.Take<TFloatParamType>(n);
+        drive = a_arena.Take<TFloatParamType>(n);
+        driveTarget = a_arena.Take<TFloatParamType>(n);
+        driveInc = a_arena.Take<TFloatParamType>(n);
+        mix = a_arena.Take<TFloatParamType>(n);
+        mixTarget = a_arena.Take<TFloatParamType>(n);
+        mixInc = a_arena.Take<TFloatParamType>(n);
+        gain = a_arena.Take<TFloatParamType>(n);
+        gainTarget = a_arena.Take<TFloatParamType>(n);
+        gainInc = a_arena.Take<TFloatParamType>(n);
+    }
+
+    void _ForgetArena()
+    {
+        active = NULL;
+        crossover = pole = lpA0 = hpA0 = b1 = b2 = w1 = w2 = NULL;
+        drive = driveTarget = driveInc = mix = mixTarget = mixInc = gain = gainTarget = gainInc = NULL;
+    }
+};
@@ -0,0 +1,271 @@
+
+// Red Rock Sound (RRS):
+// Sample format kernels behind DSP::ProcessInterleaved(): 16-bit and packed 24-bit integer samples to and from TAudioSampleType,
+// full scale +-1 (-32768 and -8388608 map to exactly -1), with optional TPDF dither and saturation on the way back.
+
+// The kernels run over contiguous runs of interleaved samples, so they neither know nor care about the channel count; the
+// (de)interleaving is a separate pass over a chunk that stays in cache, see DSP::_ProcessInterleaved().
+// Int16 goes 8 samples per SSE2 step. Int24 needs the byte shuffle of SSSE3, which every AVX2 CPU has, so it runs at kSimdAVX2.
+// The scalar kernels are templates and serve DSPT<double> as well, and the SIMD ones give the same bits as the scalar ones in float.
+
+// Dither: 4 xorshift32 generators, one per SIMD lane (sample i of a run draws from generator i & 3), each draw the sum of the two
+// 16-bit halves of its state: triangular over [-1, 1) LSB, flat spectrum, no multiplies, so SSE2 can step 4 at a time.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//RRS: One packed little-endian 24-bit sample, as in 24-bit WAV data and most streaming formats
+struct Int24
+{
+    uint8_t bytes[3];
+};
+
+static_assert(sizeof(Int24) == 3, "Int24 must pack to 3 bytes");
+
+static const float kInt16Scale = 32768.f;
+static const float kInt24Scale = 8388608.f;
+
+static inline uint32_t dither_step(uint32_t& a_state)
+{
+    a_state ^= a_state << 13;
+    a_state ^= a_state >> 17;
+    a_state ^= a_state << 5;
+    return a_state;
+}
+
+//RRS: One TPDF draw in LSB, in [-1, 1)
+template <typename TSample>
+static inline TSample dither_draw(uint32_t& a_state)
+{
+    uint32_t x = dither_step(a_state);
+    return (TSample) (int32_t) ((x & 0xffff) + (x >> 16)) * (TSample) (1.0 / 65536.0) - (TSample) 1;
+}
+
+static inline void dither_seed(uint32_t* a_pDither, uint32_t a_nSeed)
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        // Any non-zero state will do; spread them so the lanes do not start in step
+        a_pDither[k] = (a_nSeed + (uint32_t) k) * 0x9E3779B9u;
+        a_pDither[k] = a_pDither[k] != 0 ? a_pDither[k] : 1;
+    }
+}
+
+// Scaled to LSB, dithered when a_pDither is set, clamped to the integer range and rounded to nearest even (as cvtps2dq does)
+template <typename TSample>
+static inline int32_t quantize_sample(TSample x, TSample a_fScale, uint32_t* a_pDither, size_t a_nIndex)
+{
+    TSample y = x * a_fScale;
+    if (a_pDither != NULL)
+        y = y + dither_draw<TSample>(a_pDither[a_nIndex & 3]);
+
+    y = y > -a_fScale ? y : -a_fScale;
+    y = y < a_fScale - 1 ? y : a_fScale - 1;
+    return (int32_t) std::lrint(y);
+}
+
+template <typename TSample>
+static inline void int16_to_samples_scalar(const int16_t* a_pIn, TSample* a_pOut, size_t a_nCount, size_t a_nStart = 0)
+{
+    for (size_t i = a_nStart; i < a_nCount; ++i)
+        a_pOut[i] = (TSample) a_pIn[i] * (TSample) (1.0 / 32768.0);
+}
+
+template <typename TSample>
+static inline void samples_to_int16_scalar(const TSample* a_pIn, int16_t* a_pOut, size_t a_nCount, uint32_t* a_pDither, size_t a_nStart = 0)
+{
+    for (size_t i = a_nStart; i < a_nCount; ++i)
+        a_pOut[i] = (int16_t) quantize_sample(a_pIn[i], (TSample) kInt16Scale, a_pDither, i);
+}
+
+template <typename TSample>
+static inline void int24_to_samples_scalar(const Int24* a_pIn, TSample* a_pOut, size_t a_nCount, size_t a_nStart = 0)
+{
+    for (size_t i = a_nStart; i < a_nCount; ++i)
+    {
+        const uint8_t* b = a_pIn[i].bytes;
+        int32_t v = (int32_t) ((uint32_t) b[0] << 8 | (uint32_t) b[1] << 16 | (uint32_t) b[2] << 24) >> 8;
+        a_pOut[i] = (TSample) v * (TSample) (1.0 / 8388608.0);
+    }
+}
+
+template <typename TSample>
+static inline void samples_to_int24_scalar(const TSample* a_pIn, Int24* a_pOut, size_t a_nCount, uint32_t* a_pDither, size_t a_nStart = 0)
+{
+    for (size_t i = a_nStart; i < a_nCount; ++i)
+    {
+        uint32_t v = (uint32_t) quantize_sample(a_pIn[i], (TSample) kInt24Scale, a_pDither, i);
+        a_pOut[i].bytes[0] = (uint8_t) v;
+        a_pOut[i].bytes[1] = (uint8_t) (v >> 8);
+        a_pOut[i].bytes[2] = (uint8_t) (v >> 16);
+    }
+}
+
+#if RRS_SIMD_X86
+
+// Next draw of all 4 generators, as dither_draw() lane by lane
+static inline __m128 dither_draw_sse2(__m128i& a_state)
+{
+    a_state = _mm_xor_si128(a_state, _mm_slli_epi32(a_state, 13));
+    a_state = _mm_xor_si128(a_state, _mm_srli_epi32(a_state, 17));
+    a_state = _mm_xor_si128(a_state, _mm_slli_epi32(a_state, 5));
+
+    __m128i sum = _mm_add_epi32(_mm_and_si128(a_state, _mm_set1_epi32(0xffff)), _mm_srli_epi32(a_state, 16));
+    return _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps((float) (1.0 / 65536.0))), _mm_set1_ps(1.f));
+}
+
+// As quantize_sample(), 4 lanes; the caller packs
+static inline __m128i quantize_sse2(__m128 x, __m128 a_scale, __m128i* a_pDither)
+{
+    __m128 y = _mm_mul_ps(x, a_scale);
+    if (a_pDither != NULL)
+        y = _mm_add_ps(y, dither_draw_sse2(*a_pDither));
+
+    y = _mm_max_ps(y, _mm_sub_ps(_mm_setzero_ps(), a_scale));
+    y = _mm_min_ps(y, _mm_sub_ps(a_scale, _mm_set1_ps(1.f)));
+    return _mm_cvtps_epi32(y);
+}
+
+static inline void int16_to_float_sse2(const int16_t* a_pIn, float* a_pOut, size_t a_nCount)
+{
+    const __m128 scale = _mm_set1_ps((float) (1.0 / 32768.0));
+    size_t i = 0;
+
+    for (; i + 8 <= a_nCount; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) (a_pIn + i));
+
+        // Sign-extended by moving each sample to the top half of its lane and shifting it back down
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps(a_pOut + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(a_pOut + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+
+    int16_to_samples_scalar(a_pIn, a_pOut, a_nCount, i);
+}
+
+static inline void float_to_int16_sse2(const float* a_pIn, int16_t* a_pOut, size_t a_nCount, uint32_t* a_pDither)
+{
+    const __m128 scale = _mm_set1_ps(kInt16Scale);
+    __m128i dither = a_pDither != NULL ? _mm_loadu_si128((const __m128i*) a_pDither) : _mm_setzero_si128();
+    __m128i* pDither = a_pDither != NULL ? &dither : NULL;
+    size_t i = 0;
+
+    for (; i + 8 <= a_nCount; i += 8)
+    {
+        __m128i lo = quantize_sse2(_mm_loadu_ps(a_pIn + i), scale, pDither);
+        __m128i hi = quantize_sse2(_mm_loadu_ps(a_pIn + i + 4), scale, pDither);
+        _mm_storeu_si128((__m128i*) (a_pOut + i), _mm_packs_epi32(lo, hi));
+    }
+
+    if (a_pDither != NULL)
+        _mm_storeu_si128((__m128i*) a_pDither, dither);
+
+    samples_to_int16_scalar(a_pIn, a_pOut, a_nCount, a_pDither, i);
+}
+
+// 4 samples per step: 12 bytes spread over the top 3 bytes of each lane (pshufb) and shifted down with their sign. Each load reads
+// 16 bytes, so the vector loop stops while 4 bytes past the 4 samples are still inside the run.
+RRS_TARGET_AVX2 static inline void int24_to_float_avx2(const Int24* a_pIn, float* a_pOut, size_t a_nCount)
+{
+    const __m128i spread = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m128 scale = _mm_set1_ps((float) (1.0 / 8388608.0));
+    size_t i = 0;
+
+    for (; i + 6 <= a_nCount; i += 4)
+    {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (a_pIn + i)), spread);
+        _mm_storeu_ps(a_pOut + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(v, 8)), scale));
+    }
+
+    int24_to_samples_scalar(a_pIn, a_pOut, a_nCount, i);
+}
+
+RRS_TARGET_AVX2 static inline void float_to_int24_avx2(const float* a_pIn, Int24* a_pOut, size_t a_nCount, uint32_t* a_pDither)
+{
+    const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m128 scale = _mm_set1_ps(kInt24Scale);
+    __m128i dither = a_pDither != NULL ? _mm_loadu_si128((const __m128i*) a_pDither) : _mm_setzero_si128();
+    __m128i* pDither = a_pDither != NULL ? &dither : NULL;
+    size_t i = 0;
+
+    for (; i + 4 <= a_nCount; i += 4)
+    {
+        __m128i v = _mm_shuffle_epi8(quantize_sse2(_mm_loadu_ps(a_pIn + i), scale, pDither), pack);
+
+        // 12 bytes out, nothing past them
+        _mm_storel_epi64((__m128i*) (a_pOut + i), v);
+        int32_t top = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+        memcpy((uint8_t*) (a_pOut + i) + 8, &top, 4);
+    }
+
+    if (a_pDither != NULL)
+        _mm_storeu_si128((__m128i*) a_pDither, dither);
+
+    samples_to_int24_scalar(a_pIn, a_pOut, a_nCount, a_pDither, i);
+}
+
+#endif
+
+//RRS: a_nCount integer samples to a_pOut, with the widest kernel a_nSimdLevel allows
+template <typename TSample>
+static inline void convert_from_int(const int16_t* a_pIn, TSample* a_pOut, size_t a_nCount, TIntegerParamType a_nSimdLevel)
+{
+#if RRS_SIMD_X86
+    if constexpr (std::is_same<TSample, float>::value)
+        if (a_nSimdLevel >= kSimdSSE2)
+        {
+            int16_to_float_sse2(a_pIn, a_pOut, a_nCount);
+            return;
+        }
+#endif
+    int16_to_samples_scalar(a_pIn, a_pOut, a_nCount);
+}
+
+template <typename TSample>
+static inline void convert_from_int(const Int24* a_pIn, TSample* a_pOut, size_t a_nCount, TIntegerParamType a_nSimdLevel)
+{
+#if RRS_SIMD_X86
+    if constexpr (std::is_same<TSample, float>::value)
+        if (a_nSimdLevel >= kSimdAVX2)
+        {
+            int24_to_float_avx2(a_pIn, a_pOut, a_nCount);
+            return;
+        }
+#endif
+    int24_to_samples_scalar(a_pIn, a_pOut, a_nCount);
+}
+
+//RRS: a_nCount samples to integers; a_pDither (4 generator states, see dither_seed()) is NULL for plain rounding
+template <typename TSample>
+static inline void convert_to_int(const TSample* a_pIn, int16_t* a_pOut, size_t a_nCount, uint32_t* a_pDither, TIntegerParamType a_nSimdLevel)
+{
+#if RRS_SIMD_X86
+    if constexpr (std::is_same<TSample, float>::value)
+        if (a_nSimdLevel >= kSimdSSE2)
+        {
+            float_to_int16_sse2(a_pIn, a_pOut, a_nCount, a_pDither);
+            return;
+        }
+#endif
+    samples_to_int16_scalar(a_pIn, a_pOut, a_nCount, a_pDither);
+}
+
+template <typename TSample>
+static inline void convert_to_int(const TSample* a_pIn, Int24* a_pOut, size_t a_nCount, uint32_t* a_pDither, TIntegerParamType a_nSimdLevel)
+{
+#if RRS_SIMD_X86
+    if constexpr (std::is_same<TSample, float>::value)
+        if (a_nSimdLevel >= kSimdAVX2)
+        {
+            float_to_int24_avx2(a_pIn, a_pOut, a_nCount, a_pDither);
+            return;
+        }
+#endif
+    samples_to_int24_scalar(a_pIn, a_pOut, a_nCount, a_pDither);
+}
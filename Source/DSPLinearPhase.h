@@ -0,0 +1,969 @@
+
+// Red Rock Sound (RRS):
+// Linear-phase split for the 2-band path of DSP::Process(), in place of the LR2 filters (SetLinearPhase()). The low band is an FIR
+// with the magnitude of the LR2 low-pass and no phase shift; the high band is the input, delayed by the same amount, minus the low
+// band. So the bands keep the slopes of the minimum-phase crossover, line up in time around the split, and sum to the delayed input.
+
+// The zero-phase LR2 low-pass |LP(w)| = B(z) B(1/z), B the first-order Butterworth section the pair is built from, is the
+// autocorrelation of B's impulse response: with p = -a (a the LR2 pole), r[0] = (1 - p) / 2 and r[m] = (1 - p^2) p^(|m| - 1) / 4.
+// The kernel is r around its centre, Blackman-windowed to nKernelLength taps and renormalized to unit gain at DC; it is exact
+// once the tail p^(N/2) is negligible, i.e. down to a crossover of a few times fs / N.
+
+// The convolution is uniformly partitioned overlap-save: blocks of B samples, a real FFT of 2B per block, and the spectra of the
+// last K input blocks (the frequency-domain delay line) multiplied with the K partitions of the kernel. A segment with its first
+// partition at 0 outputs a block once it has been read (latency B); one whose first partition is at 1 or later has all it needs at
+// the start of the block, so it adds in ahead of time. kLinearPhaseUniform is one segment with B ~ N / 8, computed whole once every
+// B samples. kLinearPhaseLowLatency is a chain: B = 64 for taps [0, 512), then B = 256 for [512, 2048), and so on, each 4 times
+// longer and starting 2 of its blocks in (Gardner's partitioning with a block of slack): the latency of 64-sample blocks at about
+// the cost of the long ones.
+
+// The slack is what keeps the long segments from computing in bursts. Their output is due a block after their input window is
+// complete, so each block's transforms and products are cut into slices (see RealFftT's passes) and run a share at every
+// 64-sample boundary in between: every callback does about the same work, rather than one in B doing a 2B-point FFT pair per
+// channel, and instances no longer spike together at the common multiples of their blocks.
+
+// Kernels are double-buffered. A crossover change only stores the wanted frequency; BuildPendingKernel() designs the other set off
+// the audio thread and publishes it, and Process() crossfades each segment's next output block from the old kernel to the new one.
+
+#pragma once
+
+#include <atomic>
+
+enum LinearPhaseMode
+{
+    kLinearPhaseOff = 0,        // LR2 filters, minimum phase, no latency
+    kLinearPhaseUniform,        // one partition size ~ kernel / 8: cheapest, latency (kernel - 1) / 2 + partition
+    kLinearPhaseLowLatency      // 64-sample first partition, growing by 4: latency (kernel - 1) / 2 + 64
+};
+
+//RRS: Real FFT of nSize points through a complex FFT of nSize / 2 (radix 2, split real and imaginary arrays), tables from the arena.
+//RRS: Forward() gives bins 0 .. nSize / 2; Inverse() of those gives nSize / 2 times the signal
+template <typename TSample>
+struct RealFftT
+{
+    TIntegerParamType nSize, nHalf;
+    TIntegerParamType* bitReverse;
+    TSample* twRe;          // stage with half-span h: [h + j] = exp(-i pi j / h), j < h
+    TSample* twIm;
+    TSample* postRe;        // exp(-2 pi i k / nSize), k < nHalf: splits the half-size transform into even and odd samples
+    TSample* postIm;
+
+    void Prepare(MemoryArena& a_arena, TIntegerParamType a_nSize)
+    {
+        nSize = a_nSize;
+        nHalf = a_nSize / 2;
+
+        bitReverse = a_arena.Take<TIntegerParamType>((size_t) nHalf);
+        twRe = a_arena.Take<TSample>((size_t) nHalf);
+        twIm = a_arena.Take<TSample>((size_t) nHalf);
+        postRe = a_arena.Take<TSample>((size_t) nHalf);
+        postIm = a_arena.Take<TSample>((size_t) nHalf);
+
+        if (a_arena.IsMeasuring())
+            return;
+
+        TIntegerParamType nBits = 0;
+        while ((1 << nBits) < nHalf)
+            ++nBits;
+
+        for (TIntegerParamType n = 0; n < nHalf; ++n)
+        {
+            TIntegerParamType r = 0;
+            for (TIntegerParamType b = 0; b < nBits; ++b)
+                r |= ((n >> b) & 1) << (nBits - 1 - b);
+            bitReverse[n] = r;
+        }
+
+        for (TIntegerParamType h = 1; h < nHalf; h <<= 1)
+            for (TIntegerParamType j = 0; j < h; ++j)
+            {
+                twRe[h + j] = (TSample) cos(M_PI * j / h);
+                twIm[h + j] = (TSample) -sin(M_PI * j / h);
+            }
+
+        for (TIntegerParamType k = 0; k < nHalf; ++k)
+        {
+            postRe[k] = (TSample) cos(2.0 * M_PI * k / nSize);
+            postIm[k] = (TSample) -sin(2.0 * M_PI * k / nSize);
+        }
+    }
+
+    //RRS: The butterflies as passes that can run in slices, for work spread over several calls: with nHalf >= 4 pass 0 is the radix-4
+    //RRS: one (nHalf / 4 groups), then one pass per radix-2 stage (nHalf / 2 butterflies each). Every element of every pass in order
+    //RRS: is _Butterflies(), and any slicing of them gives the same result
+    TIntegerParamType NumPasses() const
+    {
+        TIntegerParamType n = nHalf >= 4 ? 1 : 0;
+        for (TIntegerParamType h = nHalf >= 4 ? 4 : 1; h < nHalf; h <<= 1)
+            ++n;
+        return n;
+    }
+
+    TIntegerParamType PassLength(TIntegerParamType a_nPass) const { return nHalf >= 4 && a_nPass == 0 ? nHalf / 4 : nHalf / 2; }
+
+    // Elements [a_nFrom, a_nTo) of pass a_nPass, in place. The first two stages (twiddles 1 and -i) go as one radix-4 pass
+    void RunPass(TSample* __restrict re, TSample* __restrict im, TIntegerParamType a_nPass, TIntegerParamType a_nFrom, TIntegerParamType a_nTo) const
+    {
+        if (nHalf >= 4 && a_nPass == 0)
+        {
+            for (TIntegerParamType i = 4 * a_nFrom; i < 4 * a_nTo; i += 4)
+            {
+                TSample r0 = re[i] + re[i + 1], i0 = im[i] + im[i + 1];
+                TSample r1 = re[i] - re[i + 1], i1 = im[i] - im[i + 1];
+                TSample r2 = re[i + 2] + re[i + 3], i2 = im[i + 2] + im[i + 3];
+                TSample r3 = re[i + 2] - re[i + 3], i3 = im[i + 2] - im[i + 3];
+
+                re[i] = r0 + r2;        im[i] = i0 + i2;
+                re[i + 2] = r0 - r2;    im[i + 2] = i0 - i2;
+                re[i + 1] = r1 + i3;    im[i + 1] = i1 - r3;
+                re[i + 3] = r1 - i3;    im[i + 3] = i1 + r3;
+            }
+
+            return;
+        }
+
+        const TIntegerParamType h = (nHalf >= 4 ? 4 : 1) << (a_nPass - (nHalf >= 4 ? 1 : 0));
+
+        // Butterfly u pairs a = 2 (u - j) + j with a + h, j = u mod h; a run of them up to the end of its group at a time
+        for (TIntegerParamType u = a_nFrom; u < a_nTo; )
+        {
+            const TIntegerParamType j0 = u & (h - 1), i = 2 * (u - j0);
+            const TIntegerParamType j1 = a_nTo - u < h - j0 ? j0 + a_nTo - u : h;
+
+            for (TIntegerParamType j = j0; j < j1; ++j)
+            {
+                TIntegerParamType a = i + j, b = a + h;
+                TSample tr = re[b] * twRe[h + j] - im[b] * twIm[h + j];
+                TSample ti = re[b] * twIm[h + j] + im[b] * twRe[h + j];
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+
+            u += j1 - j0;
+        }
+    }
+
+    // In place, input in bit-reversed order
+    void _Butterflies(TSample* __restrict re, TSample* __restrict im) const
+    {
+        for (TIntegerParamType p = 0, nPasses = NumPasses(); p < nPasses; ++p)
+            RunPass(re, im, p, 0, PassLength(p));
+    }
+
+    //RRS: Samples 2n and 2n + 1 for n in [a_nFrom, a_nTo) of nHalf into the work arrays, bit-reversed: the first half of the input from
+    //RRS: a_pFirst, the second from a_pSecond (which need not follow it)
+    void ForwardLoad(const TSample* a_pFirst, const TSample* a_pSecond, TSample* a_pWorkRe, TSample* a_pWorkIm, TIntegerParamType a_nFrom, TIntegerParamType a_nTo) const
+    {
+        // Even samples as the real part, odd ones as the imaginary part
+        for (TIntegerParamType n = a_nFrom; n < a_nTo; ++n)
+        {
+            const TSample* x = 2 * n < nHalf ? a_pFirst + 2 * n : a_pSecond + 2 * n - nHalf;
+            a_pWorkRe[bitReverse[n]] = x[0];
+            a_pWorkIm[bitReverse[n]] = x[1];
+        }
+    }
+
+    //RRS: Bins k in [a_nFrom, a_nTo) of nHalf from the butterflies' output; k = 0 gives bin nHalf too
+    void ForwardPost(const TSample* a_pWorkRe, const TSample* a_pWorkIm, TSample* a_pRe, TSample* a_pIm, TIntegerParamType a_nFrom, TIntegerParamType a_nTo) const
+    {
+        if (a_nFrom == 0 && a_nTo > 0)
+        {
+            a_pRe[0] = a_pWorkRe[0] + a_pWorkIm[0];
+            a_pIm[0] = 0;
+            a_pRe[nHalf] = a_pWorkRe[0] - a_pWorkIm[0];
+            a_pIm[nHalf] = 0;
+        }
+
+        for (TIntegerParamType k = a_nFrom > 1 ? a_nFrom : 1; k < a_nTo; ++k)
+        {
+            TSample zr = a_pWorkRe[k], zi = a_pWorkIm[k];
+            TSample cr = a_pWorkRe[nHalf - k], ci = -a_pWorkIm[nHalf - k];
+
+            // E = (Z[k] + Z*[N/2 - k]) / 2 and O = -i (Z[k] - Z*[N/2 - k]) / 2 are the spectra of the even and odd samples
+            TSample er = (TSample) 0.5 * (zr + cr), ei = (TSample) 0.5 * (zi + ci);
+            TSample orr = (TSample) 0.5 * (zi - ci), oi = (TSample) -0.5 * (zr - cr);
+
+            a_pRe[k] = er + postRe[k] * orr - postIm[k] * oi;
+            a_pIm[k] = ei + postRe[k] * oi + postIm[k] * orr;
+        }
+    }
+
+    //RRS: a_pX (nSize samples) to a_pRe/a_pIm (nHalf + 1 bins); a_pWorkRe/a_pWorkIm hold nHalf each
+    void Forward(const TSample* a_pX, TSample* a_pRe, TSample* a_pIm, TSample* a_pWorkRe, TSample* a_pWorkIm) const
+    {
+        ForwardLoad(a_pX, a_pX + nHalf, a_pWorkRe, a_pWorkIm, 0, nHalf);
+        _Butterflies(a_pWorkRe, a_pWorkIm);
+        ForwardPost(a_pWorkRe, a_pWorkIm, a_pRe, a_pIm, 0, nHalf);
+    }
+
+    //RRS: Bins k in [a_nFrom, a_nTo) of nHalf (each with bin nHalf - k) into the work arrays, bit-reversed, for the inverse butterflies
+    void InversePre(const TSample* a_pRe, const TSample* a_pIm, TSample* a_pWorkRe, TSample* a_pWorkIm, TIntegerParamType a_nFrom, TIntegerParamType a_nTo) const
+    {
+        for (TIntegerParamType k = a_nFrom; k < a_nTo; ++k)
+        {
+            TSample xr = a_pRe[k], xi = a_pIm[k];
+            TSample cr = a_pRe[nHalf - k], ci = -a_pIm[nHalf - k];
+
+            TSample er = (TSample) 0.5 * (xr + cr), ei = (TSample) 0.5 * (xi + ci);
+            TSample dr = (TSample) 0.5 * (xr - cr), di = (TSample) 0.5 * (xi - ci);
+            TSample orr = dr * postRe[k] + di * postIm[k], oi = di * postRe[k] - dr * postIm[k];
+
+            // Z = E + i O, transformed backwards as swap(FFT(swap(Z)))
+            a_pWorkRe[bitReverse[k]] = ei + orr;
+            a_pWorkIm[bitReverse[k]] = er - oi;
+        }
+    }
+
+    //RRS: nHalf + 1 bins back to nSize samples, times nHalf; after the butterflies sample 2n is a_pWorkIm[n] and 2n + 1 a_pWorkRe[n]
+    void Inverse(const TSample* a_pRe, const TSample* a_pIm, TSample* a_pX, TSample* a_pWorkRe, TSample* a_pWorkIm) const
+    {
+        InversePre(a_pRe, a_pIm, a_pWorkRe, a_pWorkIm, 0, nHalf);
+        _Butterflies(a_pWorkRe, a_pWorkIm);
+
+        for (TIntegerParamType n = 0; n < nHalf; ++n)
+        {
+            a_pX[2 * n] = a_pWorkIm[n];
+            a_pX[2 * n + 1] = a_pWorkRe[n];
+        }
+    }
+};
+
+template <typename TSample>
+struct LinearPhaseCrossoverT
+{
+    typedef TSample TAudioSampleType;
+    typedef RealFftT<TSample> RealFft;
+
+    enum { kMaxSegments = 6, kFirstBlock = 64, kGrowth = 4, kMinKernel = 63, kMaxKernel = 32767 };
+
+    //RRS: A spread segment's block in progress on one channel: stage nStage of _JobStage()'s list, nDone elements into it
+    struct Job
+    {
+        int64_t nTime;                  // the window ending here is transformed; the output block starts B later
+        TIntegerParamType nHead;        // delay line slot of its spectrum
+        TIntegerParamType nSet;         // kernel set; a crossfade runs the same products again with nFadeSet
+        TIntegerParamType nFadeSet;
+        bool bFade;
+        TIntegerParamType nStage, nStages, nDone;
+        TIntegerParamType nUnitsLeft;   // cost of what is left, in _JobStage()'s units
+    };
+
+    enum JobStageKind { kStageLoad, kStageForward, kStagePost, kStageAccumulate, kStagePre, kStageInverse, kStageOutput };
+
+    struct JobStage
+    {
+        TIntegerParamType nKind, nPass, nChain, nLength, nWeight;
+    };
+
+    struct Segment
+    {
+        TIntegerParamType nBlock;       // B: FFTs of 2B, nBlock + 1 bins
+        TIntegerParamType nFirst;       // first kernel partition (of B taps) it covers
+        TIntegerParamType nPartitions;  // K
+        RealFft fft;
+        TAudioSampleType* kernelRe[2];  // [set][partition][bin], scaled by 1 / B for the inverse FFT
+        TAudioSampleType* kernelIm[2];
+        TIntegerParamType nWindow;      // input blocks kept per channel: 2, or 3 when spread (a job reads two while the next fills)
+        bool bSpread;                   // starts 2 or more blocks in, and computes over the block before its output, see _StepJob()
+        TAudioSampleType* windows;      // [channel][nWindow B]: the last input blocks; when spread, block n at (n mod 3) B
+        TAudioSampleType* fdlRe;        // [channel][partition][bin]: spectra of the last K windows, newest at fdlHead
+        TAudioSampleType* fdlIm;
+        int64_t switchAt;               // block at which it crossfades to the new kernel, see BeginBlock()
+        Job* jobs;                      // [channel], when spread
+        TAudioSampleType* jobWork;      // [channel][5B + 2]: FFT work, accumulated spectrum, the new kernel's output in a crossfade
+    };
+
+    TIntegerParamType nMode;
+    TIntegerParamType nKernelLength;    // odd; the centre tap sits (nKernelLength - 1) / 2 in
+    TIntegerParamType nLatency;         // centre tap + the first segment's block
+    TIntegerParamType nSegments;
+    TIntegerParamType nChannels;
+    TIntegerParamType nRing;            // per channel, a power of 2 >= the furthest any segment writes ahead + first block
+    Segment segments[kMaxSegments];
+
+    TIntegerParamType* fdlHead;         // [channel][segment]
+    int64_t* positions;                 // [channel]: samples run through; the same for every channel between calls
+    TAudioSampleType* rings;            // [channel][nRing]: low band by output time, segments add into it ahead of its reading
+    TAudioSampleType* dry;              // [channel][nLatency]: the input, delayed for the high band
+    TIntegerParamType* dryPos;
+
+    // Per group of 4 channels (groups can run on different workers)
+    TAudioSampleType* scratch;
+    size_t nScratch;
+
+    // BuildPendingKernel() only, next to the audio thread
+    TAudioSampleType* designScratch;
+    double* taps;
+
+    // Kernel handover: the builder publishes set published & 1 once the audio thread has adopted the previous one
+    std::atomic<TFloatParamType> wantedFrequency;
+    std::atomic<uint32_t> published;
+    std::atomic<uint32_t> adopted;
+    TFloatParamType builtFrequency;     // builder side: what the last published set was designed for
+    uint32_t nCurrent;                  // audio thread side: newest set it switches to
+    TIntegerParamType nOldSet, nNewSet;
+    bool bTransition;
+    int64_t switchEnd;
+
+    void Init()
+    {
+        nMode = kLinearPhaseOff;
+        nKernelLength = 4095;
+        nLatency = 0;
+        nSegments = 0;
+        nChannels = 0;
+        nRing = 0;
+        wantedFrequency.store(0.f);
+        published.store(0);
+        adopted.store(0);
+        builtFrequency = 0;
+        Release();
+    }
+
+    //RRS: The kernel length Configure() makes of a_nKernelLength: clamped to kMinKernel .. kMaxKernel, and odd
+    static TIntegerParamType KernelLength(TIntegerParamType a_nKernelLength)
+    {
+        return (a_nKernelLength < kMinKernel ? (TIntegerParamType) kMinKernel : (a_nKernelLength > kMaxKernel ? (TIntegerParamType) kMaxKernel : a_nKernelLength)) | 1;
+    }
+
+    //RRS: Mode and kernel length (see KernelLength()), and the partitions they give. Takes effect at the next Prepare()
+    void Configure(TIntegerParamType a_nMode, TIntegerParamType a_nKernelLength)
+    {
+        nMode = a_nMode;
+        nKernelLength = KernelLength(a_nKernelLength);
+
+        nSegments = 0;
+
+        if (nMode == kLinearPhaseUniform)
+        {
+            TIntegerParamType b = kFirstBlock;
+            while (b * 8 < nKernelLength)
+                b *= 2;
+
+            segments[0].nBlock = b;
+            segments[0].nFirst = 0;
+            segments[0].nPartitions = (nKernelLength + b - 1) / b;
+            nSegments = 1;
+        }
+        else if (nMode == kLinearPhaseLowLatency)
+        {
+            // Segment s covers taps [2B, 2 kGrowth B) with blocks of B (the first one from tap 0), until the kernel is covered; each
+            // starts where the previous one ends, 2 of its own blocks in
+            TIntegerParamType b = kFirstBlock, covered = 0;
+
+            while (covered < nKernelLength)
+            {
+                Segment& seg = segments[nSegments];
+                seg.nBlock = b;
+                seg.nFirst = nSegments == 0 ? 0 : 2;
+
+                TIntegerParamType end = 2 * kGrowth * b < nKernelLength ? 2 * kGrowth * b : nKernelLength;
+                seg.nPartitions = (end - covered + b - 1) / b;
+
+                covered = (seg.nFirst + seg.nPartitions) * b;
+                ++nSegments;
+                b *= kGrowth;
+            }
+        }
+
+        for (TIntegerParamType s = 0; s < nSegments; ++s)
+        {
+            segments[s].bSpread = segments[s].nFirst >= 2;
+            segments[s].nWindow = segments[s].bSpread ? 3 : 2;
+        }
+
+        nLatency = nSegments > 0 ? (nKernelLength - 1) / 2 + segments[0].nBlock : 0;
+    }
+
+    //RRS: Takes its tables, kernels, state and scratch from the DSP's arena (see MemoryArena); nothing when off
+    void Prepare(MemoryArena& a_arena, TIntegerParamType a_nMaxChannels)
+    {
+        Release();
+
+        if (nSegments == 0)
+            return;
+
+        nChannels = a_nMaxChannels;
+        const size_t nGroups = (size_t) ((a_nMaxChannels + 3) >> 2);
+        const TIntegerParamType bMax = segments[nSegments - 1].nBlock;
+
+        // A segment writes up to nFirst blocks ahead (a block, for the first one); _ComputeBlock() runs for the unspread ones only
+        TIntegerParamType nAhead = 0, bComputed = 0;
+        for (TIntegerParamType s = 0; s < nSegments; ++s)
+        {
+            const Segment& seg = segments[s];
+            const TIntegerParamType ahead = (seg.nFirst > 1 ? seg.nFirst : 1) * seg.nBlock;
+            nAhead = ahead > nAhead ? ahead : nAhead;
+            bComputed = ! seg.bSpread && seg.nBlock > bComputed ? seg.nBlock : bComputed;
+        }
+
+        nRing = 1;
+        while (nRing < nAhead + segments[0].nBlock)
+            nRing <<= 1;
+
+        for (TIntegerParamType s = 0; s < nSegments; ++s)
+        {
+            Segment& seg = segments[s];
+            const size_t nSpectra = (size_t) seg.nPartitions * (size_t) (seg.nBlock + 1);
+
+            seg.fft.Prepare(a_arena, 2 * seg.nBlock);
+            for (int set = 0; set < 2; ++set)
+            {
+                seg.kernelRe[set] = a_arena.Take<TAudioSampleType>(nSpectra);
+                seg.kernelIm[set] = a_arena.Take<TAudioSampleType>(nSpectra);
+            }
+            seg.windows = a_arena.Take<TAudioSampleType>((size_t) nChannels * (size_t) (seg.nWindow * seg.nBlock));
+            seg.fdlRe = a_arena.Take<TAudioSampleType>((size_t) nChannels * nSpectra);
+            seg.fdlIm = a_arena.Take<TAudioSampleType>((size_t) nChannels * nSpectra);
+
+            if (seg.bSpread)
+            {
+                seg.jobs = a_arena.Take<Job>((size_t) nChannels);
+                seg.jobWork = a_arena.Take<TAudioSampleType>((size_t) nChannels * (size_t) (5 * seg.nBlock + 2));
+            }
+        }
+
+        fdlHead = a_arena.Take<TIntegerParamType>((size_t) (nChannels * kMaxSegments));
+        positions = a_arena.Take<int64_t>((size_t) nChannels);
+        rings = a_arena.Take<TAudioSampleType>((size_t) (nChannels * nRing));
+        dry = a_arena.Take<TAudioSampleType>((size_t) nChannels * (size_t) nLatency);
+        dryPos = a_arena.Take<TIntegerParamType>((size_t) nChannels);
+
+        // Two time buffers of 2B (the second for crossfades), accumulated spectrum, FFT work; the design needs the first and the last
+        nScratch = (size_t) (4 * bComputed + 2 * (bComputed + 1) + 2 * bComputed);
+        scratch = a_arena.Take<TAudioSampleType>(nGroups * nScratch);
+        designScratch = a_arena.Take<TAudioSampleType>((size_t) (4 * bMax));
+        taps = a_arena.Take<double>((size_t) nKernelLength);
+    }
+
+    // The memory belongs to the arena; this only forgets it
+    void Release()
+    {
+        for (Segment& seg : segments)
+        {
+            seg.kernelRe[0] = seg.kernelRe[1] = seg.kernelIm[0] = seg.kernelIm[1] = NULL;
+            seg.windows = seg.fdlRe = seg.fdlIm = NULL;
+            seg.switchAt = 0;
+            seg.jobs = NULL;
+            seg.jobWork = NULL;
+        }
+
+        nChannels = 0;
+        fdlHead = NULL;
+        positions = NULL;
+        rings = dry = NULL;
+        dryPos = NULL;
+        scratch = designScratch = NULL;
+        nScratch = 0;
+        taps = NULL;
+        nCurrent = 0;
+        nOldSet = nNewSet = 0;
+        bTransition = false;
+        switchEnd = 0;
+    }
+
+    //RRS: Input history, delay lines and output ring back to silence, at position 0 for every channel. The kernels stay; a crossfade
+    //RRS: in flight completes at once
+    void Reset()
+    {
+        for (TIntegerParamType s = 0; s < nSegments; ++s)
+        {
+            Segment& seg = segments[s];
+            const size_t nSpectra = (size_t) seg.nPartitions * (size_t) (seg.nBlock + 1);
+
+            memset(seg.windows, 0, (size_t) nChannels * (size_t) (seg.nWindow * seg.nBlock) * sizeof(TAudioSampleType));
+            memset(seg.fdlRe, 0, (size_t) nChannels * nSpectra * sizeof(TAudioSampleType));
+            memset(seg.fdlIm, 0, (size_t) nChannels * nSpectra * sizeof(TAudioSampleType));
+
+            if (seg.bSpread)
+                memset(seg.jobs, 0, (size_t) nChannels * sizeof(Job));
+        }
+
+        memset(fdlHead, 0, (size_t) (nChannels * kMaxSegments) * sizeof(TIntegerParamType));
+        memset(positions, 0, (size_t) nChannels * sizeof(int64_t));
+        memset(rings, 0, (size_t) (nChannels * nRing) * sizeof(TAudioSampleType));
+        memset(dry, 0, (size_t) nChannels * (size_t) nLatency * sizeof(TAudioSampleType));
+        memset(dryPos, 0, (size_t) nChannels * sizeof(TIntegerParamType));
+
+        if (bTransition)
+        {
+            bTransition = false;
+            nOldSet = nNewSet;
+            adopted.store(nCurrent, std::memory_order_release);
+        }
+    }
+
+    //RRS: Largest magnitude held in the input history and the delay lines, for DSP's silence detection
+    TAudioSampleType StatePeak() const
+    {
+        TAudioSampleType peak = 0;
+
+        auto scan = [&peak](const TAudioSampleType* a_pData, size_t a_nCount)
+        {
+            for (size_t i = 0; i < a_nCount; ++i)
+                peak = std::fabs(a_pData[i]) > peak ? std::fabs(a_pData[i]) : peak;
+        };
+
+        for (TIntegerParamType s = 0; s < nSegments; ++s)
+        {
+            const Segment& seg = segments[s];
+            const size_t nSpectra = (size_t) seg.nPartitions * (size_t) (seg.nBlock + 1);
+
+            scan(seg.windows, (size_t) nChannels * (size_t) (seg.nWindow * seg.nBlock));
+            scan(seg.fdlRe, (size_t) nChannels * nSpectra);
+            scan(seg.fdlIm, (size_t) nChannels * nSpectra);
+        }
+
+        scan(rings, (size_t) (nChannels * nRing));
+        scan(dry, (size_t) nChannels * (size_t) nLatency);
+        return peak;
+    }
+
+    //RRS: The kernel for a_fCrossover_Hz, in place at once (no crossfade). Not on the audio thread, nor next to Process()
+    void BuildKernelNow(TFloatParamType a_fCrossover_Hz, TFloatParamType a_fSampleRate_Hz)
+    {
+        if (nSegments == 0 || taps == NULL)
+            return;
+
+        _Design(0, a_fCrossover_Hz, a_fSampleRate_Hz);
+
+        builtFrequency = a_fCrossover_Hz;
+        wantedFrequency.store(a_fCrossover_Hz, std::memory_order_relaxed);
+        published.store(0, std::memory_order_relaxed);
+        adopted.store(0, std::memory_order_relaxed);
+        nCurrent = 0;
+        nOldSet = nNewSet = 0;
+        bTransition = false;
+    }
+
+    //RRS: Designs the kernel for the last SetWantedFrequency() into the spare set and publishes it; false when there was nothing to do
+    //RRS: or the audio thread is still crossfading to the previous one (call again later). Any thread but the audio thread, one at a time
+    bool BuildPendingKernel(TFloatParamType a_fSampleRate_Hz)
+    {
+        TFloatParamType f = wantedFrequency.load(std::memory_order_relaxed);
+        uint32_t p = published.load(std::memory_order_relaxed);
+
+        if (nSegments == 0 || taps == NULL || f == builtFrequency || adopted.load(std::memory_order_acquire) != p)
+            return false;
+
+        _Design((TIntegerParamType) ((p + 1) & 1), f, a_fSampleRate_Hz);
+        builtFrequency = f;
+
+        published.store(p + 1, std::memory_order_release);
+        return true;
+    }
+
+    //RRS: Assertion: No memory allocations are allowed inside!
+    void SetWantedFrequency(TFloatParamType a_fCrossover_Hz) { wantedFrequency.store(a_fCrossover_Hz, std::memory_order_relaxed); }
+
+    //RRS: Once per Process(), before any channel: picks up a newly published kernel, and schedules each segment's crossfade for its
+    //RRS: next output block. Assertion: No memory allocations are allowed inside!
+    void BeginBlock()
+    {
+        if (bTransition || nSegments == 0)
+            return;
+
+        uint32_t p = published.load(std::memory_order_acquire);
+        if (p == nCurrent)
+            return;
+
+        nCurrent = p;
+        nOldSet = nNewSet;
+        nNewSet = (TIntegerParamType) (p & 1);
+
+        // Blocks are computed at multiples of B (none at 0), a spread one until B later; every channel is at positions[0] between calls
+        const int64_t t = positions[0];
+        switchEnd = 0;
+
+        for (TIntegerParamType s = 0; s < nSegments; ++s)
+        {
+            const int64_t b = segments[s].nBlock;
+            int64_t at = (t + b - 1) / b * b;
+            segments[s].switchAt = at > 0 ? at : b;
+
+            const int64_t end = segments[s].switchAt + (segments[s].bSpread ? b : 0);
+            switchEnd = end > switchEnd ? end : switchEnd;
+        }
+
+        bTransition = true;
+    }
+
+    //RRS: Once per Process(), after every channel. Assertion: No memory allocations are allowed inside!
+    void EndBlock()
+    {
+        if (bTransition && positions[0] > switchEnd)
+        {
+            bTransition = false;
+            nOldSet = nNewSet;
+            adopted.store(nCurrent, std::memory_order_release);
+        }
+    }
+
+    //RRS: a_pData (a_nSampleCount samples of a_nChannel) becomes the high band, a_pLow the low band, both nLatency late.
+    //RRS: Channels of one group share scratch, so they run in turn. Assertion: No memory allocations are allowed inside!
+    void Split(TIntegerParamType a_nChannel, TAudioSampleType* __restrict a_pData, TAudioSampleType* __restrict a_pLow, TIntegerParamType a_nSampleCount)
+    {
+        int64_t& t = positions[a_nChannel];
+        const TIntegerParamType b0 = segments[0].nBlock;
+        TAudioSampleType* __restrict ring = rings + (size_t) (a_nChannel * nRing);
+        TAudioSampleType* __restrict delay = dry + (size_t) a_nChannel * (size_t) nLatency;
+        TIntegerParamType dp = dryPos[a_nChannel];
+        TAudioSampleType* work = scratch + (size_t) (a_nChannel >> 2) * nScratch;
+
+        for (TIntegerParamType offset = 0; offset < a_nSampleCount; )
+        {
+            TIntegerParamType phase = (TIntegerParamType) (t & (b0 - 1));
+
+            if (phase == 0 && t > 0)
+                for (TIntegerParamType s = 0; s < nSegments; ++s)
+                {
+                    Segment& seg = segments[s];
+                    if (seg.bSpread)
+                        _StepJob(seg, a_nChannel, t, ring);
+                    else if ((t & (seg.nBlock - 1)) == 0)
+                        _ComputeBlock(seg, a_nChannel, t, work, ring);
+                }
+
+            // Up to the next boundary of the first block, which is one of every segment's as well
+            TIntegerParamType m = a_nSampleCount - offset < b0 - phase ? a_nSampleCount - offset : b0 - phase;
+
+            for (TIntegerParamType s = 0; s < nSegments; ++s)
+            {
+                const Segment& seg = segments[s];
+                const int64_t block = seg.bSpread ? (t / seg.nBlock) % 3 : 1;
+                memcpy(seg.windows + (size_t) (a_nChannel * seg.nWindow * seg.nBlock) + (size_t) (block * seg.nBlock + (t & (seg.nBlock - 1))),
+                       a_pData + offset, (size_t) m * sizeof(TAudioSampleType));
+            }
+
+            for (TIntegerParamType i = 0; i < m; ++i)
+            {
+                size_t r = (size_t) ((t - b0 + i) & (nRing - 1));
+                TAudioSampleType low = ring[r];
+                ring[r] = 0;
+
+                TAudioSampleType delayed = delay[dp];
+                delay[dp] = a_pData[offset + i];
+                dp = dp + 1 < nLatency ? dp + 1 : 0;
+
+                a_pLow[offset + i] = low;
+                a_pData[offset + i] = delayed - low;
+            }
+
+            t += m;
+            offset += m;
+        }
+
+        dryPos[a_nChannel] = dp;
+    }
+
+    // The window ending at a_nTime goes into the delay line, and the output block it completes is added into the ring: the block
+    // just read for the first segment, the one starting now for the later ones
+    void _ComputeBlock(Segment& seg, TIntegerParamType a_nChannel, int64_t a_nTime, TAudioSampleType* a_pWork, TAudioSampleType* __restrict a_pRing)
+    {
+        const TIntegerParamType b = seg.nBlock, nBins = b + 1, k = seg.nPartitions;
+        TAudioSampleType* time = a_pWork;
+        TAudioSampleType* fade = time + 2 * b;
+        TAudioSampleType* accRe = fade + 2 * b;
+        TAudioSampleType* accIm = accRe + nBins;
+        TAudioSampleType* workRe = accIm + nBins;
+        TAudioSampleType* workIm = workRe + b;
+
+        TAudioSampleType* window = seg.windows + (size_t) a_nChannel * 2 * b;
+        TIntegerParamType& head = fdlHead[a_nChannel * kMaxSegments + (TIntegerParamType) (&seg - segments)];
+        head = head > 0 ? head - 1 : k - 1;
+
+        TAudioSampleType* fdlRe = seg.fdlRe + (size_t) a_nChannel * k * nBins;
+        TAudioSampleType* fdlIm = seg.fdlIm + (size_t) a_nChannel * k * nBins;
+
+        seg.fft.Forward(window, fdlRe + (size_t) head * nBins, fdlIm + (size_t) head * nBins, workRe, workIm);
+        memcpy(window, window + b, (size_t) b * sizeof(TAudioSampleType));
+
+        bool bFade = bTransition && a_nTime == seg.switchAt;
+        TIntegerParamType set = bTransition && a_nTime < seg.switchAt ? nOldSet : nNewSet;
+
+        _Accumulate(seg, set, fdlRe, fdlIm, head, accRe, accIm, 0, k * nBins);
+        seg.fft.Inverse(accRe, accIm, time, workRe, workIm);
+
+        if (bFade)
+        {
+            _Accumulate(seg, nOldSet, fdlRe, fdlIm, head, accRe, accIm, 0, k * nBins);
+            seg.fft.Inverse(accRe, accIm, fade, workRe, workIm);
+
+            const TAudioSampleType step = (TAudioSampleType) 1 / (TAudioSampleType) b;
+            for (TIntegerParamType i = 0; i < b; ++i)
+                time[b + i] = fade[b + i] + (TAudioSampleType) (i + 1) * step * (time[b + i] - fade[b + i]);
+        }
+
+        // Overlap-save: the second half is the valid one
+        const int64_t start = seg.nFirst == 0 ? a_nTime - b : a_nTime;
+        for (TIntegerParamType i = 0; i < b; ++i)
+            a_pRing[(size_t) ((start + i) & (nRing - 1))] += time[b + i];
+    }
+
+    // A spread segment at a_nTime (a multiple of the first block): at a multiple of its own block it starts the next one, then it
+    // runs a share of the one in progress, what is left over the boundaries left until B after its start, so that the last boundary
+    // before its output is read finishes it
+    void _StepJob(Segment& seg, TIntegerParamType a_nChannel, int64_t a_nTime, TAudioSampleType* __restrict a_pRing)
+    {
+        const TIntegerParamType b = seg.nBlock, b0 = segments[0].nBlock;
+        Job& job = seg.jobs[a_nChannel];
+
+        if ((a_nTime & (b - 1)) == 0)
+        {
+            TIntegerParamType& head = fdlHead[a_nChannel * kMaxSegments + (TIntegerParamType) (&seg - segments)];
+            head = head > 0 ? head - 1 : seg.nPartitions - 1;
+
+            job.nTime = a_nTime;
+            job.nHead = head;
+            job.nSet = bTransition && a_nTime < seg.switchAt ? nOldSet : nNewSet;
+            job.nFadeSet = nOldSet;
+            job.bFade = bTransition && a_nTime == seg.switchAt;
+            job.nStage = job.nDone = 0;
+            job.nStages = seg.fft.NumPasses() + 2 + (job.bFade ? 2 : 1) * (seg.fft.NumPasses() + 3);
+            job.nUnitsLeft = 0;
+
+            for (TIntegerParamType n = 0; n < job.nStages; ++n)
+            {
+                JobStage stage = _JobStage(seg, n);
+                job.nUnitsLeft += stage.nLength * stage.nWeight;
+            }
+        }
+
+        if (job.nStage >= job.nStages)
+            return;
+
+        const TIntegerParamType nSteps = (TIntegerParamType) ((job.nTime + b - a_nTime) / b0);
+        TIntegerParamType budget = (job.nUnitsLeft + nSteps - 1) / nSteps;
+
+        while (budget > 0 && job.nStage < job.nStages)
+        {
+            JobStage stage = _JobStage(seg, job.nStage);
+            TIntegerParamType n = stage.nLength - job.nDone, nAffordable = (budget + stage.nWeight - 1) / stage.nWeight;
+            n = n < nAffordable ? n : nAffordable;
+
+            _RunJobStage(seg, a_nChannel, job, stage, job.nDone, job.nDone + n, a_pRing);
+
+            budget -= n * stage.nWeight;
+            job.nUnitsLeft -= n * stage.nWeight;
+            job.nDone += n;
+
+            if (job.nDone == stage.nLength)
+            {
+                ++job.nStage;
+                job.nDone = 0;
+            }
+        }
+    }
+
+    // Stage a_nStage of a spread block, with its element count and the rough cost of one: loading the window, the forward butterflies
+    // and the spectrum into the delay line; then per chain (the kernel, and the old one in a crossfade) the products with the delay
+    // line, the inverse's pre-pass, its butterflies and the output block
+    JobStage _JobStage(const Segment& seg, TIntegerParamType a_nStage) const
+    {
+        const TIntegerParamType nHalf = seg.fft.nHalf, nPasses = seg.fft.NumPasses();
+        JobStage stage = { kStageLoad, 0, 0, nHalf, 1 };
+
+        if (a_nStage >= 1 && a_nStage <= nPasses)
+        {
+            stage.nKind = kStageForward;
+            stage.nPass = a_nStage - 1;
+        }
+        else if (a_nStage == nPasses + 1)
+        {
+            stage.nKind = kStagePost;
+            stage.nWeight = 3;
+        }
+        else if (a_nStage > nPasses + 1)
+        {
+            const TIntegerParamType r = a_nStage - (nPasses + 2), m = r % (nPasses + 3);
+            stage.nChain = r / (nPasses + 3);
+
+            if (m == 0)
+            {
+                stage.nKind = kStageAccumulate;
+                stage.nLength = seg.nPartitions * (seg.nBlock + 1);
+                stage.nWeight = 2;
+            }
+            else if (m == 1)
+            {
+                stage.nKind = kStagePre;
+                stage.nWeight = 3;
+            }
+            else if (m < nPasses + 2)
+            {
+                stage.nKind = kStageInverse;
+                stage.nPass = m - 2;
+            }
+            else
+                stage.nKind = kStageOutput;
+        }
+
+        if (stage.nKind == kStageForward || stage.nKind == kStageInverse)
+        {
+            stage.nLength = seg.fft.PassLength(stage.nPass);
+            stage.nWeight = nHalf >= 4 && stage.nPass == 0 ? 4 : 2;
+        }
+
+        return stage;
+    }
+
+    // Elements [a_nFrom, a_nTo) of a_stage; in that order, everything _ComputeBlock() does for a block, with the same arithmetic
+    void _RunJobStage(Segment& seg, TIntegerParamType a_nChannel, const Job& a_job, const JobStage& a_stage, TIntegerParamType a_nFrom, TIntegerParamType a_nTo,
+                      TAudioSampleType* __restrict a_pRing)
+    {
+        const TIntegerParamType b = seg.nBlock, nBins = b + 1, k = seg.nPartitions;
+        TAudioSampleType* workRe = seg.jobWork + (size_t) a_nChannel * (size_t) (5 * b + 2);
+        TAudioSampleType* workIm = workRe + b;
+        TAudioSampleType* accRe = workIm + b;
+        TAudioSampleType* accIm = accRe + nBins;
+        TAudioSampleType* held = accIm + nBins;
+
+        TAudioSampleType* fdlRe = seg.fdlRe + (size_t) a_nChannel * k * nBins;
+        TAudioSampleType* fdlIm = seg.fdlIm + (size_t) a_nChannel * k * nBins;
+
+        switch (a_stage.nKind)
+        {
+            case kStageLoad:
+            {
+                // The window is the two blocks before the one being written
+                const TAudioSampleType* window = seg.windows + (size_t) (a_nChannel * 3 * b);
+                const int64_t n = a_job.nTime / b;
+                seg.fft.ForwardLoad(window + (size_t) ((n + 1) % 3 * b), window + (size_t) ((n + 2) % 3 * b), workRe, workIm, a_nFrom, a_nTo);
+                break;
+            }
+
+            case kStageForward:
+            case kStageInverse:
+                seg.fft.RunPass(workRe, workIm, a_stage.nPass, a_nFrom, a_nTo);
+                break;
+
+            case kStagePost:
+                seg.fft.ForwardPost(workRe, workIm, fdlRe + (size_t) a_job.nHead * nBins, fdlIm + (size_t) a_job.nHead * nBins, a_nFrom, a_nTo);
+                break;
+
+            case kStageAccumulate:
+                _Accumulate(seg, a_stage.nChain == 0 ? a_job.nSet : a_job.nFadeSet, fdlRe, fdlIm, a_job.nHead, accRe, accIm, a_nFrom, a_nTo);
+                break;
+
+            case kStagePre:
+                seg.fft.InversePre(accRe, accIm, workRe, workIm, a_nFrom, a_nTo);
+                break;
+
+            case kStageOutput:
+            {
+                // Overlap-save: the second half is the valid one, sample 2n of it in workIm[n] and 2n + 1 in workRe[n]
+                const int64_t start = a_job.nTime + (seg.nFirst - 1) * b;
+                const TAudioSampleType step = (TAudioSampleType) 1 / (TAudioSampleType) b;
+
+                for (TIntegerParamType i = a_nFrom; i < a_nTo; ++i)
+                {
+                    const TIntegerParamType j = b + i;
+                    const TAudioSampleType y = (j & 1) ? workRe[j >> 1] : workIm[j >> 1];
+                    TAudioSampleType& out = a_pRing[(size_t) ((start + i) & (nRing - 1))];
+
+                    if (! a_job.bFade)
+                        out += y;
+                    else if (a_stage.nChain == 0)
+                        held[i] = y;
+                    else
+                        out += y + (TAudioSampleType) (i + 1) * step * (held[i] - y);
+                }
+                break;
+            }
+        }
+    }
+
+    // Sum over partitions of input spectrum (newest first) times kernel partition: elements [a_nFrom, a_nTo) of [partition][bin], the
+    // first partition assigning
+    void _Accumulate(const Segment& seg, TIntegerParamType a_nSet, const TAudioSampleType* a_pFdlRe, const TAudioSampleType* a_pFdlIm,
+                     TIntegerParamType a_nHead, TAudioSampleType* __restrict a_pAccRe, TAudioSampleType* __restrict a_pAccIm,
+                     TIntegerParamType a_nFrom, TIntegerParamType a_nTo) const
+    {
+        const TIntegerParamType nBins = seg.nBlock + 1;
+
+        for (TIntegerParamType e = a_nFrom; e < a_nTo; )
+        {
+            const TIntegerParamType q = e / nBins, n0 = e - q * nBins, n1 = a_nTo - e < nBins - n0 ? n0 + a_nTo - e : nBins;
+
+            TIntegerParamType slot = a_nHead + q < seg.nPartitions ? a_nHead + q : a_nHead + q - seg.nPartitions;
+            const TAudioSampleType* __restrict xr = a_pFdlRe + (size_t) slot * nBins;
+            const TAudioSampleType* __restrict xi = a_pFdlIm + (size_t) slot * nBins;
+            const TAudioSampleType* __restrict hr = seg.kernelRe[a_nSet] + (size_t) q * nBins;
+            const TAudioSampleType* __restrict hi = seg.kernelIm[a_nSet] + (size_t) q * nBins;
+
+            if (q == 0)
+                for (TIntegerParamType n = n0; n < n1; ++n)
+                {
+                    a_pAccRe[n] = xr[n] * hr[n] - xi[n] * hi[n];
+                    a_pAccIm[n] = xr[n] * hi[n] + xi[n] * hr[n];
+                }
+            else
+                for (TIntegerParamType n = n0; n < n1; ++n)
+                {
+                    a_pAccRe[n] += xr[n] * hr[n] - xi[n] * hi[n];
+                    a_pAccIm[n] += xr[n] * hi[n] + xi[n] * hr[n];
+                }
+
+            e += n1 - n0;
+        }
+    }
+
+    //RRS: The windowed zero-phase LR2 low-pass for a_fCrossover_Hz, centred, in double
+    static void DesignTaps(double* a_pTaps, TIntegerParamType a_nLength, TFloatParamType a_fCrossover_Hz, TFloatParamType a_fSampleRate_Hz)
+    {
+        const double p = -FilterT<double>::_lrPole(a_fCrossover_Hz, a_fSampleRate_Hz);
+        const TIntegerParamType centre = (a_nLength - 1) / 2;
+
+        double r = (1.0 - p * p) / 4.0, sum = 0;
+        a_pTaps[centre] = (1.0 - p) / 2.0;
+
+        for (TIntegerParamType m = 1; m <= centre; ++m)
+        {
+            a_pTaps[centre - m] = a_pTaps[centre + m] = r;
+            r *= p;
+        }
+
+        // Blackman, mirrored so the taps stay exactly symmetric
+        for (TIntegerParamType n = 0; n <= centre; ++n)
+        {
+            double x = 2.0 * M_PI * n / (a_nLength - 1);
+            double w = 0.42 - 0.5 * cos(x) + 0.08 * cos(2.0 * x);
+            a_pTaps[n] *= w;
+            a_pTaps[a_nLength - 1 - n] = a_pTaps[n];
+        }
+
+        for (TIntegerParamType n = 0; n < a_nLength; ++n)
+            sum += a_pTaps[n];
+
+        for (TIntegerParamType n = 0; n < a_nLength; ++n)
+            a_pTaps[n] /= sum;
+    }
+
+    // Partition spectra of the kernel into a_nSet of every segment
+    void _Design(TIntegerParamType a_nSet, TFloatParamType a_fCrossover_Hz, TFloatParamType a_fSampleRate_Hz)
+    {
+        DesignTaps(taps, nKernelLength, a_fCrossover_Hz, a_fSampleRate_Hz);
+
+        for (TIntegerParamType s = 0; s < nSegments; ++s)
+        {
+            Segment& seg = segments[s];
+            const TIntegerParamType b = seg.nBlock, nBins = b + 1;
+            TAudioSampleType* time = designScratch;
+            TAudioSampleType* workRe = time + 2 * b;
+            TAudioSampleType* workIm = workRe + b;
+
+            for (TIntegerParamType q = 0; q < seg.nPartitions; ++q)
+            {
+                const TIntegerParamType first = (seg.nFirst + q) * b;
+
+                for (TIntegerParamType i = 0; i < 2 * b; ++i)
+                    time[i] = i < b && first + i < nKernelLength ? (TAudioSampleType) (taps[first + i] / b) : (TAudioSampleType) 0;
+
+                seg.fft.Forward(time, seg.kernelRe[a_nSet] + (size_t) q * nBins, seg.kernelIm[a_nSet] + (size_t) q * nBins, workRe, workIm);
+            }
+        }
+    }
+};
+typedef LinearPhaseCrossoverT<TAudioSampleType> LinearPhaseCrossover;
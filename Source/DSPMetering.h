@@ -0,0 +1,413 @@
+
+// Red Rock Sound (RRS):
+// Telemetry from DSP::Process() for the editor: per-band level and saturation meters, and a spectrum analyzer of the output.
+// Both are off until the processor hands the DSP somewhere to put them (DSP::SetTelemetry()), i.e. while an editor is open.
+
+// Meters: each band is measured as it enters the saturator (peak, sum of squares, and the count of samples driven past the
+// saturator's knee at 1/3), per group of channels so worker threads never share a counter. The fused 2-band kernels of DSPSimd.h
+// sum them in their own lanes and the scalar 2-band loop beside its samples, so metering never moves Process() off either; the
+// block-wise and multiband paths run meter_block() over their band buffers. At the end of the block the calling thread folds the
+// groups into decaying peaks and 300 ms averages and publishes one BandMeterFrame through a TripleBufferT: a fixed amount of work
+// per block, however many editors read it.
+
+// Analyzer: Process() pushes the mono sum of its output into a single-producer single-consumer FIFO, dropping samples rather than
+// waiting when it is full. SpectrumAnalyzer's own thread pulls it in hops of kFftSize / 4, runs a Hann-windowed real FFT (RealFftT
+// of DSPLinearPhase.h) and publishes the smoothed magnitudes through another TripleBufferT.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+//RRS: Wait-free handover of the latest T from one writer thread to one reader thread. Three slots: the writer fills its own and
+//RRS: swaps it with the middle one, the reader swaps its own with the middle one when that holds something new. Neither waits,
+//RRS: and a frame the reader was too slow for is simply replaced
+template <typename T>
+struct TripleBufferT
+{
+    enum { kIndexMask = 3, kFresh = 4 };
+
+    T slots[3] = {};
+    std::atomic<uint32_t> middle { 1 };     // slot index | kFresh once written and not yet taken
+    uint32_t back = 0;                      // writer's
+    uint32_t front = 2;                     // reader's
+
+    //RRS: Writer: the slot to fill, then Publish(). Its contents are whatever was handed over two publishes ago
+    T& WriteSlot() { return slots[back]; }
+    void Publish() { back = middle.exchange(back | kFresh, std::memory_order_acq_rel) & kIndexMask; }
+
+    //RRS: Reader: takes the newest published frame, if there is one since the last call; Read() stays valid until the next Update()
+    bool Update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & kFresh) == 0)
+            return false;
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    const T& Read() const { return slots[front]; }
+};
+
+struct BandMeterFrame
+{
+    enum { kMaxBands = 8 };
+
+    uint32_t nBands;                // 2, or the multiband count
+    float peak[kMaxBands];          // linear; holds the largest sample and falls back with kPeakRelease_s
+    float rms[kMaxBands];           // linear, averaged over kAverage_s
+    float activity[kMaxBands];      // share of samples driven past the saturator's knee (0 .. 1), averaged over kAverage_s
+    uint64_t nBlocks;               // published so far
+
+    static constexpr double kPeakRelease_s = 0.5;
+    static constexpr double kAverage_s = 0.3;
+};
+
+typedef TripleBufferT<BandMeterFrame> BandMeterBuffer;
+
+// Peak, sum of squares and number of samples above a_fKnee (in magnitude) of a_pData, added to a_sums
+template <typename TSample>
+static inline void meter_block_scalar(const TSample* a_pData, TIntegerParamType a_nCount, TSample a_fKnee, MeterSums& a_sums)
+{
+    TSample peak = 0, sum = 0, active = 0;
+
+    for (TIntegerParamType i = 0; i < a_nCount; ++i)
+    {
+        TSample a = std::fabs(a_pData[i]);
+        peak = a > peak ? a : peak;
+        sum += a_pData[i] * a_pData[i];
+        active += a > a_fKnee ? (TSample) 1 : (TSample) 0;
+    }
+
+    a_sums.peak = peak > a_sums.peak ? peak : a_sums.peak;
+    a_sums.sumSquares += sum;
+    a_sums.nActive += active;
+}
+
+#if RRS_SIMD_X86
+
+static inline void meter_block_sse2(const float* a_pData, TIntegerParamType a_nCount, float a_fKnee, MeterSums& a_sums)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f), knee = _mm_set1_ps(a_fKnee), one = _mm_set1_ps(1.f);
+    __m128 peak = _mm_setzero_ps(), sum = _mm_setzero_ps(), active = _mm_setzero_ps();
+
+    TIntegerParamType i = 0;
+
+    for (; i + 4 <= a_nCount; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(a_pData + i);
+        __m128 a = _mm_andnot_ps(signMask, x);
+        peak = _mm_max_ps(peak, a);
+        sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+        active = _mm_add_ps(active, _mm_and_ps(_mm_cmpgt_ps(a, knee), one));
+    }
+
+    float p[4], s[4], n[4];
+    _mm_storeu_ps(p, peak);
+    _mm_storeu_ps(s, sum);
+    _mm_storeu_ps(n, active);
+
+    for (int k = 0; k < 4; ++k)
+    {
+        a_sums.peak = p[k] > a_sums.peak ? p[k] : a_sums.peak;
+        a_sums.sumSquares += s[k];
+        a_sums.nActive += n[k];
+    }
+
+    meter_block_scalar(a_pData + i, a_nCount - i, a_fKnee, a_sums);
+}
+
+static inline void meter_block_sse2(const double* a_pData, TIntegerParamType a_nCount, double a_fKnee, MeterSums& a_sums)
+{
+    const __m128d signMask = _mm_set1_pd(-0.0), knee = _mm_set1_pd(a_fKnee), one = _mm_set1_pd(1.0);
+    __m128d peak = _mm_setzero_pd(), sum = _mm_setzero_pd(), active = _mm_setzero_pd();
+
+    TIntegerParamType i = 0;
+
+    for (; i + 2 <= a_nCount; i += 2)
+    {
+        __m128d x = _mm_loadu_pd(a_pData + i);
+        __m128d a = _mm_andnot_pd(signMask, x);
+        peak = _mm_max_pd(peak, a);
+        sum = _mm_add_pd(sum, _mm_mul_pd(x, x));
+        active = _mm_add_pd(active, _mm_and_pd(_mm_cmpgt_pd(a, knee), one));
+    }
+
+    double p[2], s[2], n[2];
+    _mm_storeu_pd(p, peak);
+    _mm_storeu_pd(s, sum);
+    _mm_storeu_pd(n, active);
+
+    for (int k = 0; k < 2; ++k)
+    {
+        a_sums.peak = p[k] > a_sums.peak ? p[k] : a_sums.peak;
+        a_sums.sumSquares += s[k];
+        a_sums.nActive += n[k];
+    }
+
+    meter_block_scalar(a_pData + i, a_nCount - i, a_fKnee, a_sums);
+}
+
+RRS_TARGET_AVX2 static inline void meter_block_avx2(const float* a_pData, TIntegerParamType a_nCount, float a_fKnee, MeterSums& a_sums)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f), knee = _mm256_set1_ps(a_fKnee), one = _mm256_set1_ps(1.f);
+    __m256 peak = _mm256_setzero_ps(), sum = _mm256_setzero_ps(), active = _mm256_setzero_ps();
+
+    TIntegerParamType i = 0;
+
+    for (; i + 8 <= a_nCount; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(a_pData + i);
+        __m256 a = _mm256_andnot_ps(signMask, x);
+        peak = _mm256_max_ps(peak, a);
+        sum = _mm256_fmadd_ps(x, x, sum);
+        active = _mm256_add_ps(active, _mm256_and_ps(_mm256_cmp_ps(a, knee, _CMP_GT_OQ), one));
+    }
+
+    float p[8], s[8], n[8];
+    _mm256_storeu_ps(p, peak);
+    _mm256_storeu_ps(s, sum);
+    _mm256_storeu_ps(n, active);
+
+    for (int k = 0; k < 8; ++k)
+    {
+        a_sums.peak = p[k] > a_sums.peak ? p[k] : a_sums.peak;
+        a_sums.sumSquares += s[k];
+        a_sums.nActive += n[k];
+    }
+
+    meter_block_sse2(a_pData + i, a_nCount - i, a_fKnee, a_sums);
+}
+
+#endif
+
+//RRS: meter_block_*() for the SimdLevel a_nLevel
+template <typename TSample>
+static inline void meter_block(const TSample* a_pData, TIntegerParamType a_nCount, TSample a_fKnee, MeterSums& a_sums, TIntegerParamType a_nLevel)
+{
+#if RRS_SIMD_X86
+    if constexpr (std::is_same<TSample, float>::value)
+    {
+        if (a_nLevel >= kSimdAVX2)
+        {
+            meter_block_avx2(a_pData, a_nCount, a_fKnee, a_sums);
+            return;
+        }
+    }
+
+    if (a_nLevel >= kSimdSSE2)
+    {
+        meter_block_sse2(a_pData, a_nCount, a_fKnee, a_sums);
+        return;
+    }
+#endif
+
+    meter_block_scalar(a_pData, a_nCount, a_fKnee, a_sums);
+}
+
+struct SpectrumFrame
+{
+    enum { kFftSize = 2048, kBins = kFftSize / 2 + 1 };
+
+    float magnitude_dB[kBins];      // a full-scale sine on a bin reads 0 dB; rises at once, falls at SpectrumAnalyzer::kFall_dBPerSecond
+    float fSampleRate;              // bin k is at k * fSampleRate / kFftSize
+    uint64_t nFrames;               // published so far
+};
+
+//RRS: Spectrum of what Process() outputs, on a thread of its own while at least one viewer has it open (Open()/Close(), from the
+//RRS: message thread). Push() is the audio thread's side, spectra.Update()/Read() the viewers' (one reader thread)
+struct SpectrumAnalyzer
+{
+    enum { kFftSize = SpectrumFrame::kFftSize, kBins = SpectrumFrame::kBins, kHop = kFftSize / 4, kFifoSize = 1 << 15, kIdleSleep_ms = 5 };
+
+    static constexpr float kFloor_dB = -120.f;
+    static constexpr float kFall_dBPerSecond = 60.f;
+
+    // Audio thread to worker
+    std::vector<float> fifo;
+    std::atomic<uint32_t> writePos { 0 };
+    std::atomic<uint32_t> readPos { 0 };
+    std::atomic<float> sampleRate { 48000.f };
+    std::atomic<bool> bRunning { false };
+
+    // Worker to viewers
+    TripleBufferT<SpectrumFrame> spectra;
+
+    // Worker only: the FFT, its tables and buffers in one arena
+    std::thread thread;
+    int nViewers = 0;
+    MemoryArena arena;
+    RealFftT<float> fft;
+    float* window;
+    float* history;                 // the last kFftSize samples
+    float* frame;
+    float* re;
+    float* im;
+    float* workRe;
+    float* workIm;
+    float* smoothed;
+    float fWindowGain;
+    uint64_t nFrames = 0;
+
+    SpectrumAnalyzer()
+    {
+        fifo.assign(kFifoSize, 0.f);
+
+        MemoryArena measure;
+        measure.Init();
+        _Carve(measure);
+
+        arena.Init();
+        arena.Reserve(measure.used);
+        _Carve(arena);
+
+        // Hann; its coherent gain is 1/2, and one-sided bins count half the sine's amplitude
+        double sum = 0;
+        for (TIntegerParamType n = 0; n < kFftSize; ++n)
+        {
+            window[n] = (float) (0.5 - 0.5 * cos(2.0 * M_PI * n / kFftSize));
+            sum += window[n];
+        }
+        fWindowGain = (float) (2.0 / sum);
+
+        for (TIntegerParamType k = 0; k < kBins; ++k)
+            smoothed[k] = kFloor_dB;
+    }
+
+    ~SpectrumAnalyzer()
+    {
+        _Stop();
+        arena.Release();
+    }
+
+    SpectrumAnalyzer(const SpectrumAnalyzer&) = delete;
+    SpectrumAnalyzer& operator=(const SpectrumAnalyzer&) = delete;
+
+    void _Carve(MemoryArena& a_arena)
+    {
+        fft.Prepare(a_arena, kFftSize);
+        window = a_arena.Take<float>(kFftSize);
+        history = a_arena.Take<float>(kFftSize);
+        frame = a_arena.Take<float>(kFftSize);
+        re = a_arena.Take<float>(kBins);
+        im = a_arena.Take<float>(kBins);
+        workRe = a_arena.Take<float>(kFftSize / 2);
+        workIm = a_arena.Take<float>(kFftSize / 2);
+        smoothed = a_arena.Take<float>(kBins);
+    }
+
+    //RRS: For the bin frequencies and the fall rate; any thread
+    void SetSampleRate(float a_fSampleRate_Hz) { sampleRate.store(a_fSampleRate_Hz, std::memory_order_relaxed); }
+
+    //RRS: Message thread. The first viewer starts the thread, the last one stops it
+    void Open()
+    {
+        if (nViewers++ > 0)
+            return;
+
+        // Whatever was left in the FIFO is stale; the worker is the reader, and it is not running
+        readPos.store(writePos.load(std::memory_order_acquire), std::memory_order_release);
+        bRunning.store(true, std::memory_order_release);
+        thread = std::thread([this] { _Run(); });
+    }
+
+    void Close()
+    {
+        if (nViewers > 0 && --nViewers == 0)
+            _Stop();
+    }
+
+    void _Stop()
+    {
+        bRunning.store(false, std::memory_order_release);
+        if (thread.joinable())
+            thread.join();
+    }
+
+    //RRS: Audio thread: the mono sum of a_nChannels planar channels; nothing while no viewer is open, and whatever does not fit is
+    //RRS: dropped. Assertion: No memory allocations are allowed inside!
+    template <typename TSample>
+    void Push(TSample* const* a_vChannels, TIntegerParamType a_nChannels, TIntegerParamType a_nSampleCount)
+    {
+        if (! bRunning.load(std::memory_order_relaxed) || a_nChannels <= 0)
+            return;
+
+        const uint32_t w = writePos.load(std::memory_order_relaxed);
+        const uint32_t nFree = kFifoSize - (w - readPos.load(std::memory_order_acquire));
+        const uint32_t n = (uint32_t) a_nSampleCount < nFree ? (uint32_t) a_nSampleCount : nFree;
+        const float scale = 1.f / (float) a_nChannels;
+
+        // Up to the end of the ring, then from its start
+        for (uint32_t done = 0; done < n; )
+        {
+            float* __restrict out = fifo.data() + ((w + done) & (kFifoSize - 1));
+            uint32_t m = kFifoSize - ((w + done) & (kFifoSize - 1));
+            m = m < n - done ? m : n - done;
+
+            for (uint32_t i = 0; i < m; ++i)
+                out[i] = (float) a_vChannels[0][done + i];
+            for (TIntegerParamType c = 1; c < a_nChannels; ++c)
+                for (uint32_t i = 0; i < m; ++i)
+                    out[i] += (float) a_vChannels[c][done + i];
+            for (uint32_t i = 0; i < m; ++i)
+                out[i] *= scale;
+
+            done += m;
+        }
+
+        writePos.store(w + n, std::memory_order_release);
+    }
+
+    void _Run()
+    {
+        while (bRunning.load(std::memory_order_acquire))
+        {
+            const uint32_t r = readPos.load(std::memory_order_relaxed);
+
+            if (writePos.load(std::memory_order_acquire) - r < (uint32_t) kHop)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(kIdleSleep_ms));
+                continue;
+            }
+
+            memmove(history, history + kHop, (kFftSize - kHop) * sizeof(float));
+            for (TIntegerParamType i = 0; i < kHop; ++i)
+                history[kFftSize - kHop + i] = fifo[(r + (uint32_t) i) & (kFifoSize - 1)];
+            readPos.store(r + kHop, std::memory_order_release);
+
+            _Analyze();
+        }
+    }
+
+    // One hop: windowed FFT, magnitudes in dB, peak-falling smoothing, published
+    void _Analyze()
+    {
+        const float fs = sampleRate.load(std::memory_order_relaxed);
+        const float fall = kFall_dBPerSecond * kHop / (fs > 0.f ? fs : 48000.f);
+
+        for (TIntegerParamType n = 0; n < kFftSize; ++n)
+            frame[n] = history[n] * window[n];
+
+        fft.Forward(frame, re, im, workRe, workIm);
+
+        SpectrumFrame& out = spectra.WriteSlot();
+
+        for (TIntegerParamType k = 0; k < kBins; ++k)
+        {
+            float power = (re[k] * re[k] + im[k] * im[k]) * fWindowGain * fWindowGain;
+            float level = power > 1e-12f ? 10.f * log10f(power) : kFloor_dB;
+            level = level > kFloor_dB ? level : kFloor_dB;
+
+            smoothed[k] = level > smoothed[k] - fall ? level : smoothed[k] - fall;
+            out.magnitude_dB[k] = smoothed[k];
+        }
+
+        out.fSampleRate = fs;
+        out.nFrames = ++nFrames;
+        spectra.Publish();
+    }
+};
@@ -0,0 +1,242 @@
+
+// Red Rock Sound (RRS):
+// N-band (up to 8) Linkwitz-Riley crossover tree with per-band saturation, used by DSP::Process() when more than
+// the default low/high split is configured.
+
+// Split k takes what is left above split k-1 and separates it into band k (LP) and the rest (inverted HP).
+// Every LR2 pair sums to the first-order allpass of its split, so band k is passed through the allpasses of all
+// the splits above it; the bands then sum to the product of those allpasses, i.e. flat magnitude.
+
+// State is structure-of-arrays, [stage][channel] with channels padded to kLanes, and audio is handled in
+// channel-interleaved sub-blocks, so each inner loop runs over contiguous channels of one stage and vectorizes.
+
+#pragma once
+
+template <typename TSample>
+struct MultibandCrossoverT
+{
+    typedef TSample TAudioSampleType;
+    typedef FilterT<TSample> Filter;
+    typedef LRCoefficientsT<TSample> LRCoefficients;
+
+    enum { kMaxBands = 8, kMaxSplits = kMaxBands - 1, kLanes = 8, kSubBlock = 64 };
+
+    TIntegerParamType nBands;
+    TIntegerParamType nStride;                      // channels rounded up to kLanes
+    TIntegerParamType topology;                     // CrossoverTopology of every split
+    TFloatParamType splitFrequency[kMaxSplits];
+    Filter splits[kMaxSplits];
+
+    TFloatParamType bandAmount[kMaxBands];          // drive into the band's saturator
+    bool bandBypass[kMaxBands];
+
+    // [split][channel]
+    TAudioSampleType* lowStates1;
+    TAudioSampleType* lowStates2;
+    TAudioSampleType* highStates1;
+    TAudioSampleType* highStates2;
+    TAudioSampleType* splitAllpassStates;           // complementary topology only
+
+    // [split j][band k < j][channel], first-order allpass history
+    TAudioSampleType* allpassX1;
+    TAudioSampleType* allpassY1;
+
+    TAudioSampleType* bandBuffer;                   // [band][sample][channel] for one sub-block
+    TAudioSampleType* frame;                        // one sample of every channel
+
+    void Init()
+    {
+        nBands = 2;
+        nStride = 0;
+        topology = kCrossoverTwoFilter;
+
+        for (TIntegerParamType k = 0; k < kMaxSplits; ++k)
+            splitFrequency[k] = 1000.f * (TFloatParamType) (k + 1);
+
+        // Same as the 2-band default: low band saturated, everything above clean
+        for (TIntegerParamType b = 0; b < kMaxBands; ++b)
+        {
+            bandAmount[b] = 1.f;
+            bandBypass[b] = b > 0;
+        }
+
+        lowStates1 = lowStates2 = highStates1 = highStates2 = NULL;
+        splitAllpassStates = NULL;
+        allpassX1 = allpassY1 = NULL;
+        bandBuffer = NULL;
+        frame = NULL;
+    }
+
+    //RRS: Takes its state and scratch from the DSP's arena (see MemoryArena), room for kMaxBands whatever nBands is
+    void Prepare(MemoryArena& a_arena, TIntegerParamType a_nMaxChannels)
+    {
+        nStride = (a_nMaxChannels + kLanes - 1) / kLanes * kLanes;
+
+        size_t nSplitStates = (size_t) (kMaxSplits * nStride);
+        size_t nAllpassStates = (size_t) (kMaxSplits * kMaxBands * nStride);
+
+        lowStates1 = a_arena.Take<TAudioSampleType>(nSplitStates);
+        lowStates2 = a_arena.Take<TAudioSampleType>(nSplitStates);
+        highStates1 = a_arena.Take<TAudioSampleType>(nSplitStates);
+        highStates2 = a_arena.Take<TAudioSampleType>(nSplitStates);
+        splitAllpassStates = a_arena.Take<TAudioSampleType>(nSplitStates);
+        allpassX1 = a_arena.Take<TAudioSampleType>(nAllpassStates);
+        allpassY1 = a_arena.Take<TAudioSampleType>(nAllpassStates);
+        bandBuffer = a_arena.Take<TAudioSampleType>((size_t) (kMaxBands * kSubBlock * nStride));
+        frame = a_arena.Take<TAudioSampleType>((size_t) nStride);
+    }
+
+    // The memory belongs to the arena; this only forgets it
+    void Release()
+    {
+        nStride = 0;
+        lowStates1 = lowStates2 = highStates1 = highStates2 = NULL;
+        splitAllpassStates = NULL;
+        allpassX1 = allpassY1 = NULL;
+        bandBuffer = NULL;
+        frame = NULL;
+    }
+
+    void Reset()
+    {
+        size_t nSplitStates = (size_t) (kMaxSplits * nStride);
+        size_t nAllpassStates = (size_t) (kMaxSplits * kMaxBands * nStride);
+
+        memset(lowStates1, 0, nSplitStates * sizeof(TAudioSampleType));
+        memset(lowStates2, 0, nSplitStates * sizeof(TAudioSampleType));
+        memset(highStates1, 0, nSplitStates * sizeof(TAudioSampleType));
+        memset(highStates2, 0, nSplitStates * sizeof(TAudioSampleType));
+        memset(splitAllpassStates, 0, nSplitStates * sizeof(TAudioSampleType));
+        memset(allpassX1, 0, nAllpassStates * sizeof(TAudioSampleType));
+        memset(allpassY1, 0, nAllpassStates * sizeof(TAudioSampleType));
+    }
+
+    //RRS: Largest magnitude among the states, for DSP's silence detection
+    TAudioSampleType StatePeak() const
+    {
+        size_t nSplitStates = (size_t) (kMaxSplits * nStride);
+        size_t nAllpassStates = (size_t) (kMaxSplits * kMaxBands * nStride);
+        const TAudioSampleType* arrays[] = { lowStates1, lowStates2, highStates1, highStates2, splitAllpassStates, allpassX1, allpassY1 };
+        TAudioSampleType peak = 0;
+
+        for (int k = 0; k < 7; ++k)
+            for (size_t i = 0; i < (k < 5 ? nSplitStates : nAllpassStates); ++i)
+            {
+                TAudioSampleType a = std::fabs(arrays[k][i]);
+                peak = a > peak ? a : peak;
+            }
+
+        return peak;
+    }
+
+    // All splits, so SetNumBands() can add bands without a sample rate change
+    void UpdateCoefficients(TFloatParamType fs)
+    {
+        for (TIntegerParamType k = 0; k < kMaxSplits; ++k)
+        {
+            splits[k].lpfLRCoeffs(splitFrequency[k], fs);
+            splits[k].hpfLRCoeffs(splitFrequency[k], fs);
+            splits[k].apfLRCoeffs(splitFrequency[k], fs);
+        }
+    }
+
+    // Applies a Filter::_lrStateMap() to the DF2 states of one split after its pole has changed
+    void MapSplitStates(TIntegerParamType a_nSplit, const double m[2][2])
+    {
+        TAudioSampleType* states[2][2] = { { lowStates1, lowStates2 }, { highStates1, highStates2 } };
+
+        for (int band = 0; band < 2; ++band)
+            for (TIntegerParamType c = a_nSplit * nStride; c < (a_nSplit + 1) * nStride; ++c)
+            {
+                double w1 = states[band][0][c], w2 = states[band][1][c];
+                states[band][0][c] = (TAudioSampleType) (m[0][0] * w1 + m[0][1] * w2);
+                states[band][1][c] = (TAudioSampleType) (m[1][0] * w1 + m[1][1] * w2);
+            }
+    }
+
+    //RRS: Splits one channel-interleaved sample frame (nStride values) into bandBuffer at sample index i
+    void _SplitFrame(TAudioSampleType* __restrict rest, TIntegerParamType i)
+    {
+        const TIntegerParamType nSplits = nBands - 1;
+        const TIntegerParamType bandStride = kSubBlock * nStride;
+
+        for (TIntegerParamType k = 0; k < nSplits; ++k)
+        {
+            const LRCoefficients lp = splits[k].lpfCoeffs;
+            const LRCoefficients hp = splits[k].hpfCoeffs;
+            TAudioSampleType* __restrict ls1 = lowStates1 + k * nStride;
+            TAudioSampleType* __restrict ls2 = lowStates2 + k * nStride;
+            TAudioSampleType* __restrict hs1 = highStates1 + k * nStride;
+            TAudioSampleType* __restrict hs2 = highStates2 + k * nStride;
+            TAudioSampleType* __restrict band = bandBuffer + k * bandStride + i * nStride;
+
+            if (topology == kCrossoverComplementary)
+            {
+                const TAudioSampleType a = splits[k].apfCoeff;
+                TAudioSampleType* __restrict as = splitAllpassStates + k * nStride;
+
+                for (TIntegerParamType c = 0; c < nStride; ++c)
+                {
+                    TAudioSampleType x = rest[c];
+
+                    TAudioSampleType wl = x - lp.b1 * ls1[c] - lp.b2 * ls2[c];
+                    TAudioSampleType low = lp.a0 * wl + lp.a1 * ls1[c] + lp.a2 * ls2[c];
+                    ls2[c] = ls1[c];
+                    ls1[c] = wl;
+
+                    TAudioSampleType all = a * x + as[c];
+                    as[c] = x - a * all;
+
+                    band[c] = low;
+                    rest[c] = all - low;
+                }
+
+                continue;
+            }
+
+            for (TIntegerParamType c = 0; c < nStride; ++c)
+            {
+                TAudioSampleType x = rest[c];
+
+                TAudioSampleType wl = x - lp.b1 * ls1[c] - lp.b2 * ls2[c];
+                band[c] = lp.a0 * wl + lp.a1 * ls1[c] + lp.a2 * ls2[c];
+                ls2[c] = ls1[c];
+                ls1[c] = wl;
+
+                TAudioSampleType wh = x - hp.b1 * hs1[c] - hp.b2 * hs2[c];
+                rest[c] = -(hp.a0 * wh + hp.a1 * hs1[c] + hp.a2 * hs2[c]);
+                hs2[c] = hs1[c];
+                hs1[c] = wh;
+            }
+        }
+
+        TAudioSampleType* __restrict last = bandBuffer + nSplits * bandStride + i * nStride;
+
+        for (TIntegerParamType c = 0; c < nStride; ++c)
+            last[c] = rest[c];
+
+        // Phase compensation: the allpass of split j on every band below it
+        for (TIntegerParamType j = 1; j < nSplits; ++j)
+        {
+            const TAudioSampleType a = splits[j].apfCoeff;
+
+            for (TIntegerParamType k = 0; k < j; ++k)
+            {
+                TAudioSampleType* __restrict band = bandBuffer + k * bandStride + i * nStride;
+                TAudioSampleType* __restrict x1 = allpassX1 + (j * kMaxBands + k) * nStride;
+                TAudioSampleType* __restrict y1 = allpassY1 + (j * kMaxBands + k) * nStride;
+
+                for (TIntegerParamType c = 0; c < nStride; ++c)
+                {
+                    TAudioSampleType x = band[c];
+                    TAudioSampleType y = a * (x - y1[c]) + x1[c];
+                    x1[c] = x;
+                    y1[c] = y;
+                    band[c] = y;
+                }
+            }
+        }
+    }
+};
+
+typedef MultibandCrossoverT<TAudioSampleType> MultibandCrossover;
@@ -0,0 +1,169 @@
+
+// Red Rock Sound (RRS):
+// Offline counterpart of DSP::Process() for long signals: the signal is cut into one chunk per thread, and each chunk runs on its
+// own DSP instance, configured the same way. Not for the plugin; it starts threads and allocates. Include after DSP.h.
+
+// A chunk first runs DSP::GetSettlingSamples() of the input before it, with the output discarded, so its filter states have
+// converged on the serial ones by the time its own output starts. After its own range, each chunk also runs a short overlap into
+// the next one; the largest difference there to the next chunk's output is the measured seam error, checked against a bound
+// derived from the tolerance.
+
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+struct OfflineProcessResult
+{
+    TIntegerParamType nChunks;
+    TIntegerParamType nPreRoll;     // samples run before every chunk but the first
+    double seamError;               // largest difference to serial processing measured over the overlaps
+    double errorBound;              // what the tolerance allows for, at the peak input level
+    bool bVerified;                 // seamError <= errorBound
+};
+
+enum { kOfflineVerifySamples = 512, kOfflineMinPreRollsPerChunk = 4, kOfflineRoundingFactor = 4 };
+
+//RRS: Same output as running a_vIn through one DSP's Process() from the start, in blocks of its max block size, to within the
+//RRS: reported seam error. a_fnConfigure(DSP&) must fully set up a fresh DSP (Init() ... SetSampleRate() and any other setters,
+//RRS: with parameters set before SetSampleRate() so nothing glides); it is called once per chunk, from that chunk's thread.
+//RRS: a_vOut must not overlap a_vIn: pre-rolls read input that belongs to the chunk before.
+template <typename Configure>
+static inline OfflineProcessResult process_offline_parallel(Configure a_fnConfigure, const TAudioSampleType* const* a_vIn, TAudioSampleType** a_vOut,
+                                                            TIntegerParamType a_nChannels, int64_t a_nSampleCount, TIntegerParamType a_nThreads,
+                                                            TFloatParamType a_fTolerance = 1e-6f)
+{
+    OfflineProcessResult result = { 1, 0, 0.0, 0.0, true };
+
+    // The first chunk starts at the beginning of the signal, so its DSP needs no pre-roll and can size everyone else's
+    DSP first;
+    a_fnConfigure(first);
+
+    const TIntegerParamType preRoll = first.GetSettlingSamples(a_fTolerance);
+    const TIntegerParamType block = first._nMaxBlockSize;
+
+    // Largest pole radius, for the error bound at the end (first is released by then)
+    double radius = fabs(first.filters[0].apfCoeff);
+    if (first._bMultiband)
+        for (TIntegerParamType k = 0; k < first.multiband.nBands - 1; ++k)
+            radius = fabs(first.multiband.splits[k].apfCoeff) > radius ? fabs(first.multiband.splits[k].apfCoeff) : radius;
+
+    // Chunks much shorter than their pre-roll would spend most of their time warming up
+    int64_t nChunks = a_nSampleCount / ((int64_t) kOfflineMinPreRollsPerChunk * (preRoll > 0 ? preRoll : 1));
+    nChunks = nChunks < 1 ? 1 : (nChunks > a_nThreads ? a_nThreads : nChunks);
+
+    result.nChunks = (TIntegerParamType) nChunks;
+    result.nPreRoll = nChunks > 1 ? preRoll : 0;
+
+    std::vector<int64_t> bounds((size_t) nChunks + 1);
+    for (int64_t k = 0; k <= nChunks; ++k)
+        bounds[(size_t) k] = a_nSampleCount * k / nChunks;
+
+    const int64_t nVerify = preRoll < kOfflineVerifySamples ? preRoll : kOfflineVerifySamples;
+    std::vector<std::vector<TAudioSampleType>> overlap((size_t) nChunks);
+    std::vector<double> peaks((size_t) nChunks, 0.0);
+
+    auto chunk = [&](int64_t k)
+    {
+        DSP other;
+        DSP& dsp = k == 0 ? first : other;
+        if (k > 0)
+            a_fnConfigure(dsp);
+
+        const int64_t start = bounds[(size_t) k], end = bounds[(size_t) k + 1];
+        std::vector<TAudioSampleType> scratch((size_t) (a_nChannels * block));
+        std::vector<TAudioSampleType*> ptrs((size_t) a_nChannels);
+
+        // Runs [from, to) of the input through dsp into scratch; the output is handed to a_fnOutput(offset, n) block by block
+        auto run = [&](int64_t from, int64_t to, auto a_fnOutput)
+        {
+            for (int64_t pos = from; pos < to; pos += block)
+            {
+                TIntegerParamType n = (TIntegerParamType) (to - pos < block ? to - pos : block);
+
+                for (TIntegerParamType c = 0; c < a_nChannels; ++c)
+                {
+                    ptrs[(size_t) c] = scratch.data() + c * block;
+                    memcpy(ptrs[(size_t) c], a_vIn[c] + pos, (size_t) n * sizeof(TAudioSampleType));
+                }
+
+                dsp.Process(ptrs.data(), a_nChannels, n);
+                a_fnOutput(pos, n);
+            }
+        };
+
+        // Pre-roll; starting at the signal's own start instead is exact
+        int64_t from = start - preRoll > 0 ? start - preRoll : 0;
+        run(from, start, [](int64_t, TIntegerParamType) {});
+
+        double peak = 0.0;
+        run(start, end, [&](int64_t pos, TIntegerParamType n)
+        {
+            for (TIntegerParamType c = 0; c < a_nChannels; ++c)
+            {
+                memcpy(a_vOut[c] + pos, ptrs[(size_t) c], (size_t) n * sizeof(TAudioSampleType));
+
+                for (TIntegerParamType i = 0; i < n; ++i)
+                    peak = fabs(a_vIn[c][pos + i]) > peak ? fabs(a_vIn[c][pos + i]) : peak;
+            }
+        });
+        peaks[(size_t) k] = peak;
+
+        if (k + 1 < nChunks)
+        {
+            const int64_t to = end + nVerify < a_nSampleCount ? end + nVerify : a_nSampleCount;
+            std::vector<TAudioSampleType>& o = overlap[(size_t) k];
+            o.resize((size_t) (a_nChannels * (to - end)));
+
+            run(end, to, [&](int64_t pos, TIntegerParamType n)
+            {
+                for (TIntegerParamType c = 0; c < a_nChannels; ++c)
+                    memcpy(o.data() + c * (to - end) + (pos - end), ptrs[(size_t) c], (size_t) n * sizeof(TAudioSampleType));
+            });
+        }
+
+        dsp.Release();
+    };
+
+    std::vector<std::thread> threads;
+    for (int64_t k = 1; k < nChunks; ++k)
+        threads.emplace_back(chunk, k);
+
+    chunk(0);
+
+    for (std::thread& t : threads)
+        t.join();
+
+    // The chunk before has been running for its whole length by the seam, so its overlap stands in for the serial output
+    double peak = 0.0;
+    for (int64_t k = 0; k < nChunks; ++k)
+    {
+        peak = peaks[(size_t) k] > peak ? peaks[(size_t) k] : peak;
+
+        if (k + 1 == nChunks)
+            continue;
+
+        const int64_t end = bounds[(size_t) k + 1];
+        const int64_t n = (int64_t) overlap[(size_t) k].size() / a_nChannels;
+
+        for (TIntegerParamType c = 0; c < a_nChannels; ++c)
+            for (int64_t i = 0; i < n; ++i)
+            {
+                double d = fabs((double) overlap[(size_t) k][(size_t) (c * n + i)] - (double) a_vOut[c][end + i]);
+                result.seamError = d > result.seamError ? d : result.seamError;
+            }
+    }
+
+    // Two terms reach the output through the linear crossover and then a saturator whose slope is at most 2 * drive: the state
+    // left over after the pre-roll (the tolerance), and float rounding of the DF2 states. Those hold x / A(z), up to
+    // peak / (1 - |a|)^2, and the HP section sums four of them with gain ~1, so two runs can settle a few ulps of that apart for
+    // good; the serial run carries the same rounding against exact arithmetic. At low crossovers this term dominates.
+    const double drive = first._drive.target > 1.f ? first._drive.target : 1.f;
+    const double rounding = kOfflineRoundingFactor * FLT_EPSILON / ((1.0 - radius) * (1.0 - radius));
+    result.errorBound = (a_fTolerance + rounding) * (1.0 + 2.0 * drive) * peak * first._gain.target;
+    result.bVerified = result.seamError <= result.errorBound;
+
+    return result;
+}
@@ -0,0 +1,461 @@
+
+// Red Rock Sound (RRS):
+// 2x/4x/8x oversampling for the saturated low band, built from cascaded polyphase half-band stages.
+
+// kOversamplingQuality:    linear-phase Kaiser-windowed half-band FIRs, constant integer latency.
+// kOversamplingLowLatency: polyphase allpass (elliptic) half-band IIRs; the reported latency is their group delay at DC.
+
+// Either way the cascade is padded at the top rate so the total latency is a whole number of base-rate samples,
+// which lets DSP delay the dry high band by the same integer amount and keep the crossover phase-aligned.
+
+// Prepare() takes its buffers from the DSP's MemoryArena and is the only part that is not safe on the audio thread.
+
+#pragma once
+
+enum OversamplingMode
+{
+    kOversamplingQuality = 0,
+    kOversamplingLowLatency
+};
+
+//RRS: Kaiser-windowed half-band FIR, stored as its non-trivial (even) taps only
+template <typename TSample>
+struct HalfbandFirT
+{
+    typedef TSample TAudioSampleType;
+
+    TIntegerParamType nTaps;        // even taps h[2j], j < nTaps; the odd phase is a pure delay of q samples
+    TIntegerParamType q;            // (M - 1) / 2 where M = (L - 1) / 2 is the filter delay
+    TAudioSampleType* coeffs;
+    TAudioSampleType* upHistory;    // [nTaps - 1 history | block]
+    TAudioSampleType* evenHistory;  // [nTaps - 1 history | block]
+    TAudioSampleType* oddHistory;   // [q + 1 history | block]
+
+    void Prepare(MemoryArena& a_arena, TFloatParamType a_fTransition, TFloatParamType a_fAttenuation_dB, TIntegerParamType a_nMaxInput)
+    {
+        // Kaiser estimate, rounded up to a half-band length L = 4q + 3
+        double nEstimate = (a_fAttenuation_dB - 7.95) / (14.36 * a_fTransition) + 1.0;
+        q = (TIntegerParamType) ceil((nEstimate - 3.0) / 4.0);
+        if (q < 1)
+            q = 1;
+
+        TIntegerParamType M = 2 * q + 1;
+        nTaps = M + 1;
+
+        double beta = a_fAttenuation_dB > 50.0 ? 0.1102 * (a_fAttenuation_dB - 8.7)
+                                               : 0.5842 * pow(a_fAttenuation_dB - 21.0, 0.4) + 0.07886 * (a_fAttenuation_dB - 21.0);
+
+        coeffs = a_arena.Take<TAudioSampleType>((size_t) nTaps);
+        upHistory = a_arena.Take<TAudioSampleType>((size_t) (nTaps - 1 + a_nMaxInput));
+        evenHistory = a_arena.Take<TAudioSampleType>((size_t) (nTaps - 1 + a_nMaxInput));
+        oddHistory = a_arena.Take<TAudioSampleType>((size_t) (q + 1 + a_nMaxInput));
+
+        if (a_arena.IsMeasuring())
+            return;
+
+        for (TIntegerParamType j = 0; j < nTaps; ++j)
+        {
+            double n = 2 * j - M; // odd offset from the centre tap
+            double r = n / M;
+            double window = _BesselI0(beta * sqrt(1.0 - r * r)) / _BesselI0(beta);
+            coeffs[j] = (TAudioSampleType) (sin(0.5 * M_PI * n) / (M_PI * n) * window);
+        }
+    }
+
+    // Delay of one up + down pair, in samples at the stage's low rate
+    TIntegerParamType GetLatency() const { return 2 * q + 1; }
+
+    //RRS: out[2m] = 2 * sum h[2j] x[m - j], out[2m + 1] = x[m - q]
+    void Upsample(const TAudioSampleType* a_pIn, TAudioSampleType* a_pOut, TIntegerParamType a_nSampleCount)
+    {
+        const TIntegerParamType H = nTaps - 1;
+        memcpy(upHistory + H, a_pIn, a_nSampleCount * sizeof(TAudioSampleType));
+
+        for (TIntegerParamType m = 0; m < a_nSampleCount; ++m)
+        {
+            const TAudioSampleType* x = upHistory + H + m;
+            TAudioSampleType acc = 0.f;
+
+            for (TIntegerParamType j = 0; j < nTaps; ++j)
+                acc += coeffs[j] * x[-j];
+
+            a_pOut[2 * m] = 2.f * acc;
+            a_pOut[2 * m + 1] = x[-q];
+        }
+
+        memmove(upHistory, upHistory + a_nSampleCount, H * sizeof(TAudioSampleType));
+    }
+
+    //RRS: out[m] = sum h[2j] in[2(m - j)] + 0.5 * in[2(m - q - 1) + 1]
+    void Downsample(const TAudioSampleType* a_pIn, TAudioSampleType* a_pOut, TIntegerParamType a_nSampleCount)
+    {
+        const TIntegerParamType H = nTaps - 1;
+        const TIntegerParamType Ho = q + 1;
+
+        for (TIntegerParamType m = 0; m < a_nSampleCount; ++m)
+        {
+            evenHistory[H + m] = a_pIn[2 * m];
+            oddHistory[Ho + m] = a_pIn[2 * m + 1];
+        }
+
+        for (TIntegerParamType m = 0; m < a_nSampleCount; ++m)
+        {
+            const TAudioSampleType* e = evenHistory + H + m;
+            TAudioSampleType acc = 0.5f * oddHistory[m];
+
+            for (TIntegerParamType j = 0; j < nTaps; ++j)
+                acc += coeffs[j] * e[-j];
+
+            a_pOut[m] = acc;
+        }
+
+        memmove(evenHistory, evenHistory + a_nSampleCount, H * sizeof(TAudioSampleType));
+        memmove(oddHistory, oddHistory + a_nSampleCount, Ho * sizeof(TAudioSampleType));
+    }
+
+    void Reset()
+    {
+        memset(upHistory, 0, (nTaps - 1) * sizeof(TAudioSampleType));
+        memset(evenHistory, 0, (nTaps - 1) * sizeof(TAudioSampleType));
+        memset(oddHistory, 0, (q + 1) * sizeof(TAudioSampleType));
+    }
+
+    TAudioSampleType StatePeak() const
+    {
+        TAudioSampleType peak = 0;
+
+        for (TIntegerParamType j = 0; j < nTaps - 1; ++j)
+        {
+            TAudioSampleType a = std::fabs(upHistory[j]), e = std::fabs(evenHistory[j]);
+            peak = a > peak ? a : peak;
+            peak = e > peak ? e : peak;
+        }
+
+        for (TIntegerParamType j = 0; j <= q; ++j)
+        {
+            TAudioSampleType a = std::fabs(oddHistory[j]);
+            peak = a > peak ? a : peak;
+        }
+
+        return peak;
+    }
+
+    static double _BesselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 50 && term > 1e-12 * sum; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+};
+
+typedef HalfbandFirT<TAudioSampleType> HalfbandFir;
+
+//RRS: Two-path polyphase allpass half-band: H(z) = 0.5 * (A0(z^2) + z^-1 * A1(z^2)),
+//RRS: coefficients from the elliptic design of Valenzuela & Constantinides (as in de Soras' HIIR)
+template <typename TSample>
+struct HalfbandIirT
+{
+    typedef TSample TAudioSampleType;
+
+    enum { kMaxCoeffs = 12 };
+
+    TIntegerParamType nCoeffs;
+    TAudioSampleType coeffs[kMaxCoeffs];    // even indices: path 0, odd indices: path 1
+    TAudioSampleType upX[kMaxCoeffs], upY[kMaxCoeffs];
+    TAudioSampleType downX[kMaxCoeffs], downY[kMaxCoeffs];
+    double dcDelay;                         // group delay of one up + down pair at DC, in low-rate samples
+
+    void Prepare(TIntegerParamType a_nCoeffs, double a_fTransition)
+    {
+        nCoeffs = a_nCoeffs < kMaxCoeffs ? a_nCoeffs : (TIntegerParamType) kMaxCoeffs;
+
+        double k = tan((1.0 - 2.0 * a_fTransition) * M_PI / 4.0);
+        k *= k;
+        double kksqrt = pow(1.0 - k * k, 0.25);
+        double e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+        double e4 = e * e * e * e;
+        double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+        int order = nCoeffs * 2 + 1;
+
+        double pathDelay[2] = { 0.0, 0.0 };
+
+        for (TIntegerParamType index = 0; index < nCoeffs; ++index)
+        {
+            int c = index + 1;
+            double num = 0.0, den = 0.0, t;
+            int i = 0, sign = 1;
+
+            do
+            {
+                t = pow(q, i * (i + 1)) * sin((2 * i + 1) * c * M_PI / order) * sign;
+                num += t;
+                sign = -sign;
+                ++i;
+            } while (fabs(t) > 1e-100);
+
+            i = 1;
+            sign = -1;
+
+            do
+            {
+                t = pow(q, i * i) * cos(2 * i * c * M_PI / order) * sign;
+                den += t;
+                sign = -sign;
+                ++i;
+            } while (fabs(t) > 1e-100);
+
+            double ww = num * pow(q, 0.25) / (den + 0.5);
+            double wwsq = ww * ww;
+            double x = sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+            double a = (1.0 - x) / (1.0 + x);
+
+            coeffs[index] = (TAudioSampleType) a;
+            pathDelay[index & 1] += (1.0 - a) / (1.0 + a);
+        }
+
+        // In high-rate samples the paths delay by 2 * d0 and 2 * d1 + 1; the pair (up, then down aligned to the odd phase)
+        // adds up to D - 1/2 low-rate samples, with D their mean
+        double D = (2.0 * pathDelay[0] + 2.0 * pathDelay[1] + 1.0) / 2.0;
+        dcDelay = D - 0.5;
+
+        Reset();
+    }
+
+    //RRS: First-order allpass (a + z^-1) / (1 + a z^-1) at the low rate
+    static TAudioSampleType _Allpass(TAudioSampleType x, TAudioSampleType a, TAudioSampleType& x1, TAudioSampleType& y1)
+    {
+        TAudioSampleType y = a * (x - y1) + x1;
+        x1 = x;
+        y1 = y;
+        return y;
+    }
+
+    void Upsample(const TAudioSampleType* a_pIn, TAudioSampleType* a_pOut, TIntegerParamType a_nSampleCount)
+    {
+        for (TIntegerParamType m = 0; m < a_nSampleCount; ++m)
+        {
+            TAudioSampleType p0 = a_pIn[m], p1 = a_pIn[m];
+
+            for (TIntegerParamType i = 0; i < nCoeffs; i += 2)
+                p0 = _Allpass(p0, coeffs[i], upX[i], upY[i]);
+
+            for (TIntegerParamType i = 1; i < nCoeffs; i += 2)
+                p1 = _Allpass(p1, coeffs[i], upX[i], upY[i]);
+
+            a_pOut[2 * m] = p0;
+            a_pOut[2 * m + 1] = p1;
+        }
+    }
+
+    void Downsample(const TAudioSampleType* a_pIn, TAudioSampleType* a_pOut, TIntegerParamType a_nSampleCount)
+    {
+        for (TIntegerParamType m = 0; m < a_nSampleCount; ++m)
+        {
+            TAudioSampleType p0 = a_pIn[2 * m + 1], p1 = a_pIn[2 * m];
+
+            for (TIntegerParamType i = 0; i < nCoeffs; i += 2)
+                p0 = _Allpass(p0, coeffs[i], downX[i], downY[i]);
+
+            for (TIntegerParamType i = 1; i < nCoeffs; i += 2)
+                p1 = _Allpass(p1, coeffs[i], downX[i], downY[i]);
+
+            a_pOut[m] = 0.5f * (p0 + p1);
+        }
+    }
+
+    void Reset()
+    {
+        for (int i = 0; i < kMaxCoeffs; ++i)
+            upX[i] = upY[i] = downX[i] = downY[i] = 0.f;
+    }
+
+    TAudioSampleType StatePeak() const
+    {
+        TAudioSampleType peak = 0;
+
+        for (int i = 0; i < kMaxCoeffs; ++i)
+            for (TAudioSampleType v : { upX[i], upY[i], downX[i], downY[i] })
+                peak = std::fabs(v) > peak ? std::fabs(v) : peak;
+
+        return peak;
+    }
+};
+
+typedef HalfbandIirT<TAudioSampleType> HalfbandIir;
+
+//RRS: Per-channel cascade of up to three half-band stages (2x, 4x, 8x)
+template <typename TSample>
+struct OversamplerT
+{
+    typedef TSample TAudioSampleType;
+
+    enum { kMaxStages = 3, kMaxFactor = 1 << kMaxStages };
+
+    TIntegerParamType nStages;
+    TIntegerParamType nMode;
+    TIntegerParamType nLatency;         // base-rate samples, integer after padding
+    TIntegerParamType nPad;             // top-rate samples of padding
+    HalfbandFirT<TSample> fir[kMaxStages];
+    HalfbandIirT<TSample> iir[kMaxStages];
+    TAudioSampleType* buffers[kMaxStages]; // buffers[s] holds the signal at 2^(s + 1) x
+    TAudioSampleType padHistory[kMaxFactor];
+
+    //RRS: a_fExtraTopLatency is the delay (in top-rate samples) of whatever runs at the top rate, e.g. an ADAA saturator;
+    //RRS: it is folded into the padding. Buffers come from a_arena (see MemoryArena); while it measures, only the sizes and the
+    //RRS: latency are set up. Memory allocations are allowed inside
+    void Prepare(MemoryArena& a_arena, TIntegerParamType a_nFactor, TIntegerParamType a_nMode, TIntegerParamType a_nMaxBlockSize, double a_fExtraTopLatency)
+    {
+        nStages = 0;
+        while ((1 << (nStages + 1)) <= a_nFactor && nStages < kMaxStages)
+            ++nStages;
+
+        nMode = a_nMode;
+
+        // Top-rate samples per base-rate sample
+        const TIntegerParamType F = 1 << nStages;
+        double topLatency = a_fExtraTopLatency;
+
+        for (TIntegerParamType s = 0; s < nStages; ++s)
+        {
+            TIntegerParamType nInput = a_nMaxBlockSize << s;
+            TIntegerParamType topPerLow = F >> s;
+
+            buffers[s] = a_arena.Take<TAudioSampleType>((size_t) (nInput * 2));
+
+            if (nMode == kOversamplingQuality)
+            {
+                // First stage carries the steep transition; later stages only have to reject images far above the audio band
+                fir[s].Prepare(a_arena, s == 0 ? 0.06f : (s == 1 ? 0.25f : 0.36f), 100.f, nInput);
+                topLatency += fir[s].GetLatency() * topPerLow;
+            }
+            else
+            {
+                iir[s].Prepare(s == 0 ? 8 : 4, s == 0 ? 0.04 : 0.25);
+                topLatency += iir[s].dcDelay * topPerLow;
+            }
+        }
+
+        nLatency = (TIntegerParamType) ceil(topLatency / F - 1e-9);
+        nPad = nStages > 0 ? (TIntegerParamType) (nLatency * F - topLatency + 0.5) : 0;
+
+        if (!a_arena.IsMeasuring())
+            Reset();
+    }
+
+    void Reset()
+    {
+        for (TIntegerParamType s = 0; s < nStages; ++s)
+        {
+            if (nMode == kOversamplingQuality)
+                fir[s].Reset();
+            else
+                iir[s].Reset();
+        }
+
+        memset(padHistory, 0, sizeof(padHistory));
+    }
+
+    TIntegerParamType GetFactor() const { return 1 << nStages; }
+
+    //RRS: Largest magnitude in the filter histories and the padding, for DSP's silence detection
+    TAudioSampleType StatePeak() const
+    {
+        TAudioSampleType peak = 0;
+
+        for (TIntegerParamType s = 0; s < nStages; ++s)
+        {
+            TAudioSampleType a = nMode == kOversamplingQuality ? fir[s].StatePeak() : iir[s].StatePeak();
+            peak = a > peak ? a : peak;
+        }
+
+        for (TIntegerParamType i = 0; i < nPad; ++i)
+            peak = std::fabs(padHistory[i]) > peak ? std::fabs(padHistory[i]) : peak;
+
+        return peak;
+    }
+
+    //RRS: Base-rate samples of history the cascade depends on, to within a_fTolerance; see pole_settling_samples()
+    TIntegerParamType GetSettlingSamples(double a_fTolerance) const
+    {
+        TIntegerParamType n = 1;    // padHistory
+
+        for (TIntegerParamType s = 0; s < nStages; ++s)
+        {
+            // Both directions of stage s run at 2^s times the base rate
+            if (nMode == kOversamplingQuality)
+                n += ((2 * fir[s].nTaps + fir[s].q) >> s) + 1;
+            else
+            {
+                TAudioSampleType aMax = 0.f;
+                for (TIntegerParamType i = 0; i < iir[s].nCoeffs; ++i)
+                    aMax = iir[s].coeffs[i] > aMax ? iir[s].coeffs[i] : aMax;
+
+                n += 2 * (pole_settling_samples(aMax, (iir[s].nCoeffs + 1) / 2, a_fTolerance) >> s) + 1;
+            }
+        }
+
+        return n;
+    }
+
+    //RRS: Returns the top-rate buffer holding a_nSampleCount * GetFactor() samples; an empty block leaves every state alone
+    TAudioSampleType* Upsample(const TAudioSampleType* a_pIn, TIntegerParamType a_nSampleCount)
+    {
+        if (a_nSampleCount <= 0)
+            return buffers[nStages - 1];
+
+        const TAudioSampleType* in = a_pIn;
+
+        for (TIntegerParamType s = 0; s < nStages; ++s)
+        {
+            TIntegerParamType n = a_nSampleCount << s;
+
+            if (nMode == kOversamplingQuality)
+                fir[s].Upsample(in, buffers[s], n);
+            else
+                iir[s].Upsample(in, buffers[s], n);
+
+            in = buffers[s];
+        }
+
+        TAudioSampleType* top = buffers[nStages - 1];
+        TIntegerParamType nTop = a_nSampleCount << nStages;
+
+        // Pad to a whole base-rate latency; a pure delay commutes with the memoryless saturator
+        if (nPad > 0)
+        {
+            TAudioSampleType tail[kMaxFactor];
+            memcpy(tail, top + nTop - nPad, nPad * sizeof(TAudioSampleType));
+            memmove(top + nPad, top, (nTop - nPad) * sizeof(TAudioSampleType));
+            memcpy(top, padHistory, nPad * sizeof(TAudioSampleType));
+            memcpy(padHistory, tail, nPad * sizeof(TAudioSampleType));
+        }
+
+        return top;
+    }
+
+    //RRS: Decimates the top-rate buffer returned by Upsample() back into a_pOut
+    void Downsample(TAudioSampleType* a_pOut, TIntegerParamType a_nSampleCount)
+    {
+        if (a_nSampleCount <= 0)
+            return;
+
+        for (TIntegerParamType s = nStages - 1; s >= 0; --s)
+        {
+            TIntegerParamType n = a_nSampleCount << s;
+            TAudioSampleType* out = s > 0 ? buffers[s - 1] : a_pOut;
+
+            if (nMode == kOversamplingQuality)
+                fir[s].Downsample(buffers[s], out, n);
+            else
+                iir[s].Downsample(buffers[s], out, n);
+        }
+    }
+};
+
+typedef OversamplerT<TAudioSampleType> Oversampler;
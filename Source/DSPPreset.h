@@ -0,0 +1,194 @@
+
+// Red Rock Sound (RRS):
+// Presets: every setting of a DSP as one DSPPreset, its compact versioned binary form for the host's session state, and the
+// precomputed coefficient snapshot a preset switch hands to the audio thread.
+
+// Binary form, little-endian whatever the platform: "RRSP", u16 version, u16 payload size, then the payload fields in the order of
+// preset_write(). A newer version only appends fields, so a reader takes the ones it knows and skips the rest; fields an older
+// writer did not have keep their DSPPreset defaults.
+
+// Switching: DSP::SubmitPreset() designs the preset's filters into the spare one of two PresetSnapshotT on the calling (non-audio)
+// thread and publishes it; Process() adopts it at the start of its next block, crossfading the 2-band split from the old filter
+// states to the new ones over kPresetFade_ms. The structural settings (oversampling, saturation mode, topology, linear phase)
+// change the latency and the memory layout, so they only take effect through DSP::ApplyPreset() or the setters.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+struct DSPPreset
+{
+    enum { kMaxBands = 8, kMaxSplits = kMaxBands - 1, kVersion = 1 };
+
+    float gain = 1.f;                               // linear
+    float drive = 1.f;
+    float mix = 1.f;
+    float smoothing_ms = 20.f;
+    int32_t nBands = 2;
+    float splitFrequency_Hz[kMaxSplits] = { 1000.f, 2000.f, 3000.f, 4000.f, 5000.f, 6000.f, 7000.f };   // [0] is the 2-band crossover
+    float bandAmount[kMaxBands] = { 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f };
+    uint8_t bandBypass = 0xfe;                      // bit per band; the 2-band default saturates the low band only
+
+    // Structural
+    int32_t oversampling = 1;
+    int32_t oversamplingMode = 0;                   // kOversamplingQuality
+    int32_t saturationMode = 0;                     // kSaturationNaive
+    int32_t topology = 0;                           // kCrossoverTwoFilter
+    int32_t linearPhaseMode = 0;                    // kLinearPhaseOff
+    int32_t linearPhaseKernel = 4095;
+
+    // Header, then the version 1 payload
+    static constexpr size_t kHeaderBytes = 8;
+    static constexpr size_t kPayloadBytesV1 = 4 * 4 + 1 + kMaxSplits * 4 + kMaxBands * 4 + 1 + 5 + 2;
+    static constexpr size_t kBytes = kHeaderBytes + kPayloadBytesV1;
+};
+
+// Byte-wise, so the layout does not depend on the host's endianness or on struct padding
+static inline uint8_t* _preset_put_u16(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+    return p + 2;
+}
+
+static inline uint8_t* _preset_put_f32(uint8_t* p, float f)
+{
+    uint32_t v;
+    memcpy(&v, &f, 4);
+    for (int k = 0; k < 4; ++k)
+        p[k] = (uint8_t) (v >> (8 * k));
+    return p + 4;
+}
+
+static inline uint32_t _preset_get_u16(const uint8_t*& p)
+{
+    uint32_t v = (uint32_t) p[0] | ((uint32_t) p[1] << 8);
+    p += 2;
+    return v;
+}
+
+static inline float _preset_get_f32(const uint8_t*& p)
+{
+    uint32_t v = 0;
+    for (int k = 0; k < 4; ++k)
+        v |= (uint32_t) p[k] << (8 * k);
+    p += 4;
+
+    float f;
+    memcpy(&f, &v, 4);
+    return f;
+}
+
+//RRS: Writes a_preset into a_pOut (DSPPreset::kBytes of room); returns the number of bytes written
+static inline size_t preset_write(const DSPPreset& a_preset, uint8_t* a_pOut)
+{
+    uint8_t* p = a_pOut;
+    memcpy(p, "RRSP", 4);
+    p = _preset_put_u16(p + 4, DSPPreset::kVersion);
+    p = _preset_put_u16(p, (uint32_t) DSPPreset::kPayloadBytesV1);
+
+    p = _preset_put_f32(p, a_preset.gain);
+    p = _preset_put_f32(p, a_preset.drive);
+    p = _preset_put_f32(p, a_preset.mix);
+    p = _preset_put_f32(p, a_preset.smoothing_ms);
+    *p++ = (uint8_t) a_preset.nBands;
+
+    for (int k = 0; k < DSPPreset::kMaxSplits; ++k)
+        p = _preset_put_f32(p, a_preset.splitFrequency_Hz[k]);
+    for (int b = 0; b < DSPPreset::kMaxBands; ++b)
+        p = _preset_put_f32(p, a_preset.bandAmount[b]);
+    *p++ = a_preset.bandBypass;
+
+    *p++ = (uint8_t) a_preset.oversampling;
+    *p++ = (uint8_t) a_preset.oversamplingMode;
+    *p++ = (uint8_t) a_preset.saturationMode;
+    *p++ = (uint8_t) a_preset.topology;
+    *p++ = (uint8_t) a_preset.linearPhaseMode;
+    p = _preset_put_u16(p, (uint32_t) a_preset.linearPhaseKernel);
+
+    return (size_t) (p - a_pOut);
+}
+
+//RRS: Reads what preset_write() wrote, of this or any later version, into a_preset. False, with a_preset untouched, for anything
+//RRS: else: too short, another magic, version 0, or values no DSP setting can take (non-finite, out of range, outside the enums)
+static inline bool preset_read(const void* a_pData, size_t a_nBytes, DSPPreset& a_preset)
+{
+    const uint8_t* p = (const uint8_t*) a_pData;
+
+    if (a_pData == NULL || a_nBytes < DSPPreset::kHeaderBytes || memcmp(p, "RRSP", 4) != 0)
+        return false;
+
+    p += 4;
+    const uint32_t version = _preset_get_u16(p);
+    const uint32_t payload = _preset_get_u16(p);
+
+    if (version < 1 || payload < DSPPreset::kPayloadBytesV1 || a_nBytes < DSPPreset::kHeaderBytes + payload)
+        return false;
+
+    DSPPreset preset;
+    preset.gain = _preset_get_f32(p);
+    preset.drive = _preset_get_f32(p);
+    preset.mix = _preset_get_f32(p);
+    preset.smoothing_ms = _preset_get_f32(p);
+    preset.nBands = *p++;
+
+    for (int k = 0; k < DSPPreset::kMaxSplits; ++k)
+        preset.splitFrequency_Hz[k] = _preset_get_f32(p);
+    for (int b = 0; b < DSPPreset::kMaxBands; ++b)
+        preset.bandAmount[b] = _preset_get_f32(p);
+    preset.bandBypass = *p++;
+
+    preset.oversampling = *p++;
+    preset.oversamplingMode = *p++;
+    preset.saturationMode = *p++;
+    preset.topology = *p++;
+    preset.linearPhaseMode = *p++;
+    preset.linearPhaseKernel = (int32_t) _preset_get_u16(p);
+
+    bool bValid = std::isfinite(preset.gain) && std::isfinite(preset.drive) && std::isfinite(preset.mix) && preset.smoothing_ms >= 0.f &&
+                  std::isfinite(preset.smoothing_ms) && preset.nBands >= 1 && preset.nBands <= DSPPreset::kMaxBands;
+
+    for (int k = 0; k < DSPPreset::kMaxSplits; ++k)
+        bValid = bValid && preset.splitFrequency_Hz[k] > 0.f && std::isfinite(preset.splitFrequency_Hz[k]);
+    for (int b = 0; b < DSPPreset::kMaxBands; ++b)
+        bValid = bValid && std::isfinite(preset.bandAmount[b]);
+
+    // The structural settings change the latency and the layout, so they must be ones the DSP knows; the setters would not catch them
+    bValid = bValid && (preset.oversampling == 1 || preset.oversampling == 2 || preset.oversampling == 4 || preset.oversampling == 8) &&
+             preset.oversamplingMode <= kOversamplingLowLatency && preset.saturationMode <= kSaturationADAA2 &&
+             preset.topology <= kCrossoverComplementary && preset.linearPhaseMode <= kLinearPhaseLowLatency &&
+             preset.linearPhaseKernel >= LinearPhaseCrossover::kMinKernel && preset.linearPhaseKernel <= LinearPhaseCrossover::kMaxKernel;
+
+    if (!bValid)
+        return false;
+
+    a_preset = preset;
+    return true;
+}
+
+//RRS: A preset with its filters designed for one sample rate, ready for the audio thread to copy in: split 0 is the 2-band crossover
+//RRS: (and split 0 of the multiband tree), the others the rest of the tree
+template <typename TSample>
+struct PresetSnapshotT
+{
+    DSPPreset preset;
+    TFloatParamType fs = 0;
+    FilterT<TSample> splits[DSPPreset::kMaxSplits];
+
+    //RRS: Exact coefficients, as SetSampleRate() designs them. Not realtime-safe (tan(), and the block forms)
+    void Design(const DSPPreset& a_preset, TFloatParamType a_fSampleRate_Hz)
+    {
+        preset = a_preset;
+        fs = a_fSampleRate_Hz;
+
+        for (int k = 0; k < DSPPreset::kMaxSplits; ++k)
+        {
+            splits[k].hpfLRCoeffs(a_preset.splitFrequency_Hz[k], fs);
+            splits[k].lpfLRCoeffs(a_preset.splitFrequency_Hz[k], fs);
+            splits[k].apfLRCoeffs(a_preset.splitFrequency_Hz[k], fs);
+            splits[k].blockLRCoeffs();
+        }
+    }
+};
@@ -0,0 +1,192 @@
+
+// Red Rock Sound (RRS):
+// Allocation and lock hooks behind RRS_RT_INSTRUMENTATION (see DSPRealtime.h). Each one reports a violation when called inside a
+// RealtimeScope and otherwise just forwards; with the instrumentation off this file is empty.
+
+#include "DSPRealtime.h"
+
+#if RRS_RT_INSTRUMENTATION
+
+#include <new>
+#include <cstddef>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+ #define RRS_RT_HOOK_LIBC 1
+ #include <dlfcn.h>
+ #include <pthread.h>
+#else
+ #define RRS_RT_HOOK_LIBC 0
+#endif
+
+#if defined(__APPLE__)
+ #include <malloc/malloc.h>
+#endif
+
+// glibc declares its functions nothrow in C++, and a redefinition has to say the same
+#if defined(__GLIBC__)
+ #define RRS_RT_LIBC_NOEXCEPT noexcept
+#else
+ #define RRS_RT_LIBC_NOEXCEPT
+#endif
+
+//RRS: The allocator underneath the hooks, reached without going through them
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void* __libc_memalign(size_t, size_t);
+extern "C" void __libc_free(void*);
+
+static void* rt_raw_malloc(size_t n) { return __libc_malloc(n); }
+static void* rt_raw_calloc(size_t count, size_t n) { return __libc_calloc(count, n); }
+static void* rt_raw_realloc(void* p, size_t n) { return __libc_realloc(p, n); }
+static void* rt_raw_aligned(size_t alignment, size_t n) { return __libc_memalign(alignment, n); }
+static void rt_raw_free(void* p) { __libc_free(p); }
+#elif defined(__APPLE__)
+static void* rt_raw_malloc(size_t n) { return malloc_zone_malloc(malloc_default_zone(), n); }
+static void* rt_raw_calloc(size_t count, size_t n) { return malloc_zone_calloc(malloc_default_zone(), count, n); }
+static void* rt_raw_realloc(void* p, size_t n) { return p == NULL ? rt_raw_malloc(n) : malloc_zone_realloc(malloc_zone_from_ptr(p), p, n); }
+static void* rt_raw_aligned(size_t alignment, size_t n) { return malloc_zone_memalign(malloc_default_zone(), alignment, n); }
+static void rt_raw_free(void* p) { if (p != NULL) malloc_zone_free(malloc_zone_from_ptr(p), p); }
+#else
+static void* rt_raw_malloc(size_t n) { return malloc(n); }
+static void* rt_raw_aligned(size_t alignment, size_t n) { return _aligned_malloc(n, alignment); }
+static void rt_raw_free(void* p) { free(p); }
+static void rt_raw_aligned_free(void* p) { _aligned_free(p); }
+#endif
+
+#if RRS_RT_HOOK_LIBC
+static void rt_raw_aligned_free(void* p) { rt_raw_free(p); }
+#endif
+
+static void* rt_new(size_t n)
+{
+    if (rt_in_realtime_scope())
+        rt_report_violation(kRealtimeAllocation);
+
+    void* p = rt_raw_malloc(n > 0 ? n : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+static void* rt_new_aligned(size_t n, std::align_val_t alignment)
+{
+    if (rt_in_realtime_scope())
+        rt_report_violation(kRealtimeAllocation);
+
+    void* p = rt_raw_aligned((size_t) alignment, n > 0 ? n : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+static void rt_delete(void* p)
+{
+    if (p != NULL && rt_in_realtime_scope())
+        rt_report_violation(kRealtimeFree);
+    rt_raw_free(p);
+}
+
+static void rt_delete_aligned(void* p)
+{
+    if (p != NULL && rt_in_realtime_scope())
+        rt_report_violation(kRealtimeFree);
+    rt_raw_aligned_free(p);
+}
+
+void* operator new(size_t n) { return rt_new(n); }
+void* operator new[](size_t n) { return rt_new(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { try { return rt_new(n); } catch (...) { return NULL; } }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { try { return rt_new(n); } catch (...) { return NULL; } }
+void* operator new(size_t n, std::align_val_t a) { return rt_new_aligned(n, a); }
+void* operator new[](size_t n, std::align_val_t a) { return rt_new_aligned(n, a); }
+void* operator new(size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { try { return rt_new_aligned(n, a); } catch (...) { return NULL; } }
+void* operator new[](size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { try { return rt_new_aligned(n, a); } catch (...) { return NULL; } }
+
+void operator delete(void* p) noexcept { rt_delete(p); }
+void operator delete[](void* p) noexcept { rt_delete(p); }
+void operator delete(void* p, size_t) noexcept { rt_delete(p); }
+void operator delete[](void* p, size_t) noexcept { rt_delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { rt_delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { rt_delete(p); }
+void operator delete(void* p, std::align_val_t) noexcept { rt_delete_aligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { rt_delete_aligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { rt_delete_aligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { rt_delete_aligned(p); }
+
+#if RRS_RT_HOOK_LIBC
+
+// The C allocator, for DSP.h's own calloc()/free() and anything else in this binary that bypasses operator new
+extern "C" void* malloc(size_t n) RRS_RT_LIBC_NOEXCEPT
+{
+    if (rt_in_realtime_scope())
+        rt_report_violation(kRealtimeAllocation);
+    return rt_raw_malloc(n);
+}
+
+extern "C" void* calloc(size_t count, size_t n) RRS_RT_LIBC_NOEXCEPT
+{
+    if (rt_in_realtime_scope())
+        rt_report_violation(kRealtimeAllocation);
+    return rt_raw_calloc(count, n);
+}
+
+extern "C" void* realloc(void* p, size_t n) RRS_RT_LIBC_NOEXCEPT
+{
+    if (rt_in_realtime_scope())
+        rt_report_violation(kRealtimeAllocation);
+    return rt_raw_realloc(p, n);
+}
+
+extern "C" void free(void* p) RRS_RT_LIBC_NOEXCEPT
+{
+    if (p != NULL && rt_in_realtime_scope())
+        rt_report_violation(kRealtimeFree);
+    rt_raw_free(p);
+}
+
+// Blocking locks; the try- variants never wait and are left alone. The next definition is looked up on first use, since another
+// static initializer may lock before this file's have run.
+template <typename Fn>
+static Fn rt_next(const char* a_pName, Fn& a_fnCached)
+{
+    if (a_fnCached == NULL)
+        a_fnCached = (Fn) dlsym(RTLD_NEXT, a_pName);
+    return a_fnCached;
+}
+
+typedef int (*MutexFn)(pthread_mutex_t*);
+typedef int (*RwLockFn)(pthread_rwlock_t*);
+static MutexFn g_fnMutexLock = NULL;
+static RwLockFn g_fnRdLock = NULL, g_fnWrLock = NULL;
+
+// Resolved up front as well, so the first lock on the audio thread does not count dlsym()'s own allocations
+static const bool g_bLocksResolved = rt_next("pthread_mutex_lock", g_fnMutexLock) != NULL
+                                   && rt_next("pthread_rwlock_rdlock", g_fnRdLock) != NULL
+                                   && rt_next("pthread_rwlock_wrlock", g_fnWrLock) != NULL;
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* m) RRS_RT_LIBC_NOEXCEPT
+{
+    if (rt_in_realtime_scope())
+        rt_report_violation(kRealtimeLock);
+    return rt_next("pthread_mutex_lock", g_fnMutexLock)(m);
+}
+
+extern "C" int pthread_rwlock_rdlock(pthread_rwlock_t* l) RRS_RT_LIBC_NOEXCEPT
+{
+    if (rt_in_realtime_scope())
+        rt_report_violation(kRealtimeLock);
+    return rt_next("pthread_rwlock_rdlock", g_fnRdLock)(l);
+}
+
+extern "C" int pthread_rwlock_wrlock(pthread_rwlock_t* l) RRS_RT_LIBC_NOEXCEPT
+{
+    if (rt_in_realtime_scope())
+        rt_report_violation(kRealtimeLock);
+    return rt_next("pthread_rwlock_wrlock", g_fnWrLock)(l);
+}
+
+#endif
+
+#endif
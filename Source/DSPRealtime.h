@@ -0,0 +1,208 @@
+
+// Red Rock Sound (RRS):
+// Opt-in real-time safety instrumentation. Off by default, and then everything here compiles to nothing.
+// Build with RRS_RT_INSTRUMENTATION=1 (the Instrumented configuration in LR_Saturator.jucer) to count heap allocations,
+// frees and blocking locks made while a RealtimeScope is open on the calling thread; DSP::Process() and processBlock() open one.
+// RRS_RT_INSTRUMENTATION=2 aborts on the first one instead, so a debugger stops at the offending call.
+
+// The hooks themselves (operator new/delete, malloc and friends, pthread mutex and rwlock locks) live in DSPRealtime.cpp, which
+// has to be compiled into the same binary. They only see calls made from that binary: on macOS std::mutex locks inside libc++,
+// and on Windows only operator new/delete are hooked.
+
+// BlockTimingHistogram records how long each block took against its real-time budget (samples / sample rate), lock-free, for the
+// editor to show or for a dump at shutdown.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef RRS_RT_INSTRUMENTATION
+ #define RRS_RT_INSTRUMENTATION 0
+#endif
+
+enum RealtimeViolation
+{
+    kRealtimeAllocation = 0,    // malloc/calloc/realloc/operator new
+    kRealtimeFree,              // free/operator delete
+    kRealtimeLock,              // a blocking mutex or rwlock acquisition
+    kNumRealtimeViolations
+};
+
+static const char* const kRealtimeViolationNames[kNumRealtimeViolations] = { "allocations", "frees", "locks" };
+
+// Process-wide, since the hooks cannot tell instances apart
+inline std::atomic<uint64_t> g_nRealtimeViolations[kNumRealtimeViolations];
+
+// Nesting depth of RealtimeScope on this thread; inline, not static, so the hooks and every includer share one. Initial-exec TLS:
+// the first access from a dlopen()ed plugin must not itself call malloc(), which the hooks would then re-enter.
+inline int& rt_scope_depth()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    static thread_local int depth __attribute__((tls_model("initial-exec"))) = 0;
+#else
+    static thread_local int depth = 0;
+#endif
+    return depth;
+}
+
+static inline bool rt_in_realtime_scope() { return RRS_RT_INSTRUMENTATION && rt_scope_depth() > 0; }
+
+//RRS: Called by the hooks in DSPRealtime.cpp
+static inline void rt_report_violation(RealtimeViolation a_nKind)
+{
+    g_nRealtimeViolations[a_nKind].fetch_add(1, std::memory_order_relaxed);
+
+#if RRS_RT_INSTRUMENTATION >= 2
+    // Out of the scope first: fprintf() and abort() may allocate and lock on their own
+    rt_scope_depth() = 0;
+    fprintf(stderr, "RRS: real-time violation on the audio thread: %s\n", kRealtimeViolationNames[a_nKind]);
+    abort();
+#endif
+}
+
+static inline uint64_t rt_violation_count(RealtimeViolation a_nKind) { return g_nRealtimeViolations[a_nKind].load(std::memory_order_relaxed); }
+
+//RRS: Marks the current thread as real-time for the lifetime of the object; nests
+struct RealtimeScope
+{
+#if RRS_RT_INSTRUMENTATION
+    // The fences keep the compiler from moving the depth change across malloc(), which it assumes reads no program state
+    RealtimeScope() { ++rt_scope_depth(); std::atomic_signal_fence(std::memory_order_seq_cst); }
+    ~RealtimeScope() { std::atomic_signal_fence(std::memory_order_seq_cst); --rt_scope_depth(); }
+#else
+    RealtimeScope() {}
+#endif
+    RealtimeScope(const RealtimeScope&) = delete;
+    RealtimeScope& operator=(const RealtimeScope&) = delete;
+};
+
+//RRS: Per-block processing time as a fraction of the block's duration (the load), in kBucketPercent steps.
+//RRS: One writer (the audio thread, Record()), any number of readers (GetSnapshot(), Format()); all lock-free.
+struct BlockTimingHistogram
+{
+    enum { kBucketPercent = 5, kBuckets = 31 };     // the last bucket collects everything from 150% up
+
+    struct Snapshot
+    {
+        uint64_t nBlocks, nOverruns;    // overruns: blocks that took longer than they last
+        uint64_t nTotal_ns, nMax_ns;
+        uint32_t nMaxLoad_permille;
+        uint32_t buckets[kBuckets];
+    };
+
+    std::atomic<uint64_t> nBlocks { 0 }, nOverruns { 0 }, nTotal_ns { 0 }, nMax_ns { 0 };
+    std::atomic<uint32_t> nMaxLoad_permille { 0 };
+    std::atomic<uint32_t> buckets[kBuckets] = {};
+    std::atomic<bool> bResetRequested { false };
+
+    // Audio thread
+    void Record(uint64_t a_nElapsed_ns, int a_nSampleCount, double a_fSampleRate)
+    {
+        // Readers may ask for a reset at any time; only the writer clears, so no count is lost halfway
+        if (bResetRequested.exchange(false, std::memory_order_acquire))
+        {
+            nBlocks.store(0, std::memory_order_relaxed);
+            nOverruns.store(0, std::memory_order_relaxed);
+            nTotal_ns.store(0, std::memory_order_relaxed);
+            nMax_ns.store(0, std::memory_order_relaxed);
+            nMaxLoad_permille.store(0, std::memory_order_relaxed);
+            for (std::atomic<uint32_t>& b : buckets)
+                b.store(0, std::memory_order_relaxed);
+        }
+
+        if (a_nSampleCount <= 0 || a_fSampleRate <= 0.0)
+            return;
+
+        const double budget_ns = 1e9 * a_nSampleCount / a_fSampleRate;
+        const uint32_t load = (uint32_t) (1000.0 * (double) a_nElapsed_ns / budget_ns);
+        const uint32_t bucket = load / (10 * kBucketPercent);
+
+        buckets[bucket < (uint32_t) kBuckets ? bucket : (uint32_t) kBuckets - 1].fetch_add(1, std::memory_order_relaxed);
+        nTotal_ns.fetch_add(a_nElapsed_ns, std::memory_order_relaxed);
+        if (load > 1000)
+            nOverruns.fetch_add(1, std::memory_order_relaxed);
+        if (a_nElapsed_ns > nMax_ns.load(std::memory_order_relaxed))
+            nMax_ns.store(a_nElapsed_ns, std::memory_order_relaxed);
+        if (load > nMaxLoad_permille.load(std::memory_order_relaxed))
+            nMaxLoad_permille.store(load, std::memory_order_relaxed);
+
+        // Last, so a reader that sees the count also sees the block in the buckets
+        nBlocks.fetch_add(1, std::memory_order_release);
+    }
+
+    // Any thread
+    void RequestReset() { bResetRequested.store(true, std::memory_order_release); }
+
+    Snapshot GetSnapshot() const
+    {
+        Snapshot s;
+        s.nBlocks = nBlocks.load(std::memory_order_acquire);
+        s.nOverruns = nOverruns.load(std::memory_order_relaxed);
+        s.nTotal_ns = nTotal_ns.load(std::memory_order_relaxed);
+        s.nMax_ns = nMax_ns.load(std::memory_order_relaxed);
+        s.nMaxLoad_permille = nMaxLoad_permille.load(std::memory_order_relaxed);
+        for (int k = 0; k < kBuckets; ++k)
+            s.buckets[k] = buckets[k].load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Human-readable summary, the violation counts and the non-empty buckets; returns the length written
+    size_t Format(char* a_pText, size_t a_nSize) const
+    {
+        Snapshot s = GetSnapshot();
+        size_t n = 0;
+
+        auto append = [&](int a_nWritten) { if (a_nWritten > 0) n = n + (size_t) a_nWritten < a_nSize ? n + (size_t) a_nWritten : a_nSize - 1; };
+
+        if (a_nSize == 0)
+            return 0;
+        a_pText[0] = 0;
+
+        append(snprintf(a_pText + n, a_nSize - n, "blocks %llu, overruns %llu, max %.3f ms (%.1f%% load), mean %.3f ms\n",
+                        (unsigned long long) s.nBlocks, (unsigned long long) s.nOverruns, 1e-6 * (double) s.nMax_ns,
+                        0.1 * s.nMaxLoad_permille, s.nBlocks > 0 ? 1e-6 * (double) s.nTotal_ns / (double) s.nBlocks : 0.0));
+        append(snprintf(a_pText + n, a_nSize - n, "audio thread: %llu allocations, %llu frees, %llu locks\n",
+                        (unsigned long long) rt_violation_count(kRealtimeAllocation), (unsigned long long) rt_violation_count(kRealtimeFree),
+                        (unsigned long long) rt_violation_count(kRealtimeLock)));
+
+        for (int k = 0; k < kBuckets; ++k)
+            if (s.buckets[k] > 0)
+            {
+                if (k + 1 < kBuckets)
+                    append(snprintf(a_pText + n, a_nSize - n, "  %3d-%3d%%  %u\n", k * kBucketPercent, (k + 1) * kBucketPercent, s.buckets[k]));
+                else
+                    append(snprintf(a_pText + n, a_nSize - n, "  %3d%%+    %u\n", k * kBucketPercent, s.buckets[k]));
+            }
+
+        return n;
+    }
+
+    void Dump(FILE* a_pFile) const
+    {
+        char text[2048];
+        Format(text, sizeof(text));
+        fputs(text, a_pFile);
+    }
+};
+
+//RRS: Times its own lifetime into a BlockTimingHistogram; open it first thing in the audio callback
+struct BlockTimer
+{
+    BlockTimingHistogram& histogram;
+    int nSampleCount;
+    double fSampleRate;
+    std::chrono::steady_clock::time_point start;
+
+    BlockTimer(BlockTimingHistogram& a_histogram, int a_nSampleCount, double a_fSampleRate)
+        : histogram(a_histogram), nSampleCount(a_nSampleCount), fSampleRate(a_fSampleRate), start(std::chrono::steady_clock::now()) {}
+
+    ~BlockTimer()
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        histogram.Record((uint64_t) elapsed.count(), nSampleCount, fSampleRate);
+    }
+};
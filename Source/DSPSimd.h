@@ -0,0 +1,797 @@
+
+// Red Rock Sound (RRS):
+// SIMD kernels for the 2-band LR crossover + saturation used by DSP::Process(), and the block saturator behind DSP::saturateBlock().
+
+// Channels are packed into vector lanes together with their band: one vector holds the low-pass and the high-pass
+// section of a group of channels, e.g. [LP c0, LP c1, HP c0, HP c1] for SSE2 and [LP c0..c3 | HP c0..c3] for AVX2,
+// so a stereo bus fills an SSE2 register exactly. Samples are moved in 4x4 tiles and transposed in registers.
+// A channel left over after that (a mono bus) runs time-parallel instead: 4 samples per step, see lr_process_block_sse2().
+
+// With band meters attached (DSP::SetTelemetry()) the same kernels also sum each band's peak, energy and saturated samples in their
+// lanes (kMeter = true), so an open editor keeps the audio thread on them; the sums are folded into MeterSums once per block.
+
+// The ISA is picked at runtime (simd_detect_level()), so one binary runs everywhere and uses AVX2 when available.
+// The kernels take float (DSP); DSPT<double> has its own at half the lanes per vector, at the end of this file.
+// The scalar ones are templates and serve both.
+
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define RRS_SIMD_X86 1
+ #include <immintrin.h>
+ #if defined(_MSC_VER) && ! defined(__clang__)
+  #include <intrin.h>
+ #endif
+#else
+ #define RRS_SIMD_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+ #define RRS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+ #define RRS_TARGET_AVX2
+#endif
+
+enum SimdLevel
+{
+    kSimdScalar = 0,
+    kSimdSSE2,
+    kSimdAVX2
+};
+
+//RRS: Drive and mix of the saturator, ramped linearly per sample across a block
+struct SaturationRamp
+{
+    TFloatParamType drive, driveInc;
+    TFloatParamType mix, mixInc;
+};
+
+//RRS: One band of one channel group over one block (DSPMetering.h)
+struct MeterSums
+{
+    double peak;
+    double sumSquares;
+    double nActive;             // samples driven past the saturator's knee at 1/3
+};
+
+// Per-lane meter sums of a kernel into a_pBands: lanes below a_nLowLanes are the low band ([0]), the others the high band ([1]).
+// Only the low band is saturated, so only its lanes of a_pActive count
+template <typename T, typename TCount>
+static inline void meter_fold_lanes(const T* a_pPeak, const T* a_pSum, const TCount* a_pActive, int a_nLanes, int a_nLowLanes, MeterSums* a_pBands)
+{
+    for (int k = 0; k < a_nLanes; ++k)
+    {
+        MeterSums& b = a_pBands[k < a_nLowLanes ? 0 : 1];
+        b.peak = a_pPeak[k] > b.peak ? a_pPeak[k] : b.peak;
+        b.sumSquares += a_pSum[k];
+        b.nActive += k < a_nLowLanes ? (double) a_pActive[k] : 0.0;
+    }
+}
+
+// One sample of both bands, for the kernels' scalar tails; a_driven is the low band times the drive
+template <typename TSample>
+static inline void meter_sample(MeterSums* a_pBands, TSample a_low, TSample a_driven, TSample a_high)
+{
+    double l = std::fabs(a_low), h = std::fabs(a_high);
+    a_pBands[0].peak = l > a_pBands[0].peak ? l : a_pBands[0].peak;
+    a_pBands[0].sumSquares += l * l;
+    a_pBands[0].nActive += std::fabs(a_driven) > (TSample) 1 / (TSample) 3 ? 1.0 : 0.0;
+    a_pBands[1].peak = h > a_pBands[1].peak ? h : a_pBands[1].peak;
+    a_pBands[1].sumSquares += h * h;
+}
+
+// Branchless form of DSP::tubeSaturation(): with a = min(|x|, 2/3) and u = max(a - 1/3, 0)
+// the five segments collapse to sign(x) * (2a - 3u^2).
+template <typename TSample>
+static inline TSample tube_saturation_branchless(TSample x)
+{
+    TSample ax = std::fabs(x);
+    TSample a = ax < (TSample) 2 / (TSample) 3 ? ax : (TSample) 2 / (TSample) 3;
+    TSample u = a > (TSample) 1 / (TSample) 3 ? a - (TSample) 1 / (TSample) 3 : (TSample) 0;
+    return std::copysign((TSample) 2 * a - (TSample) 3 * u * u, x);
+}
+
+template <typename TSample>
+static inline void saturate_block_scalar(TSample* a_pData, TIntegerParamType a_nSampleCount, SaturationRamp r)
+{
+    for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+    {
+        TFloatParamType drive = r.drive + r.driveInc * i;
+        TFloatParamType mix = r.mix + r.mixInc * i;
+        TSample x = a_pData[i];
+        a_pData[i] = x + mix * (tube_saturation_branchless(drive * x) - x);
+    }
+}
+
+//RRS: Widest kernel the CPU (and OS) supports, detected once
+static inline TIntegerParamType simd_detect_level()
+{
+#if RRS_SIMD_X86
+ #if defined(_MSC_VER) && ! defined(__clang__)
+    static const TIntegerParamType level = []
+    {
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0, fma = (info[2] & (1 << 12)) != 0;
+        bool ymmEnabled = osxsave && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        return (TIntegerParamType) ((avx && avx2 && fma && ymmEnabled) ? kSimdAVX2 : kSimdSSE2);
+    }();
+ #else
+    static const TIntegerParamType level = []
+    {
+        __builtin_cpu_init();
+        return (TIntegerParamType) ((__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? kSimdAVX2 : kSimdSSE2);
+    }();
+ #endif
+    return level;
+#else
+    return kSimdScalar;
+#endif
+}
+
+#if RRS_SIMD_X86
+
+static inline __m128 simd_tube_saturation_sse2(__m128 x)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 sign = _mm_and_ps(x, signMask);
+    __m128 a = _mm_min_ps(_mm_andnot_ps(signMask, x), _mm_set1_ps(2.0f / 3.0f));
+    __m128 u = _mm_max_ps(_mm_sub_ps(a, _mm_set1_ps(1.0f / 3.0f)), _mm_setzero_ps());
+    __m128 y = _mm_sub_ps(_mm_add_ps(a, a), _mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(u, u)));
+    return _mm_or_ps(y, sign);
+}
+
+static inline __m128 simd_drive_mix_sse2(__m128 x, __m128 drive, __m128 mix)
+{
+    return _mm_add_ps(x, _mm_mul_ps(mix, _mm_sub_ps(simd_tube_saturation_sse2(_mm_mul_ps(drive, x)), x)));
+}
+
+static inline void saturate_block_sse2(TAudioSampleType* a_pData, TIntegerParamType a_nSampleCount, SaturationRamp r)
+{
+    const __m128 ramp = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+    __m128 drive = _mm_add_ps(_mm_set1_ps(r.drive), _mm_mul_ps(ramp, _mm_set1_ps(r.driveInc)));
+    __m128 mix = _mm_add_ps(_mm_set1_ps(r.mix), _mm_mul_ps(ramp, _mm_set1_ps(r.mixInc)));
+    const __m128 driveStep = _mm_set1_ps(4.f * r.driveInc);
+    const __m128 mixStep = _mm_set1_ps(4.f * r.mixInc);
+
+    TIntegerParamType i = 0;
+
+    for (; i + 4 <= a_nSampleCount; i += 4)
+    {
+        _mm_storeu_ps(a_pData + i, simd_drive_mix_sse2(_mm_loadu_ps(a_pData + i), drive, mix));
+        drive = _mm_add_ps(drive, driveStep);
+        mix = _mm_add_ps(mix, mixStep);
+    }
+
+    r.drive += r.driveInc * i;
+    r.mix += r.mixInc * i;
+    saturate_block_scalar(a_pData + i, a_nSampleCount - i, r);
+}
+
+// One DF2 step on all lanes; high-pass lanes carry negated feed-forward coefficients.
+static inline __m128 simd_biquad_sse2(__m128 x, __m128& s1, __m128& s2, __m128 a0, __m128 a1, __m128 a2, __m128 b1, __m128 b2)
+{
+    __m128 w = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(b1, s1)), _mm_mul_ps(b2, s2));
+    __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, w), _mm_mul_ps(a1, s1)), _mm_mul_ps(a2, s2));
+    s2 = s1;
+    s1 = w;
+    return y;
+}
+
+//RRS: Per-lane band meter sums of a kernel over one block, in the kernel's own vector type: peak and sum of squares of every lane,
+//RRS: and the integer count of samples the saturator took past its knee in the lanes it saturates (the low half for AVX2)
+struct SimdMeterSse2 { __m128 peak {}, sum {}; __m128i active {}; };
+struct SimdMeterSse2d { __m128d peak {}, sum {}; __m128i active {}; };
+struct SimdMeterAvx2 { __m256 peak {}, sum {}; __m128i active {}; };
+struct SimdMeterAvx2d { __m256d peak {}, sum {}; __m128i active {}; };
+
+// Peak and sum of squares of a_y, the band outputs of one step
+static inline void simd_meter_sse2(SimdMeterSse2& m, __m128 a_y)
+{
+    m.peak = _mm_max_ps(m.peak, _mm_andnot_ps(_mm_set1_ps(-0.0f), a_y));
+    m.sum = _mm_add_ps(m.sum, _mm_mul_ps(a_y, a_y));
+}
+
+// a_count plus one in the lanes where a_driven, the saturator's input, is past the knee at 1/3 (the compare mask is -1 there).
+// |a_driven| is taken as simd_tube_saturation_sse2() takes it, so the compiler computes it once for both
+static inline __m128i simd_count_saturated_sse2(__m128i a_count, __m128 a_driven)
+{
+    __m128 past = _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), a_driven), _mm_set1_ps(1.0f / 3.0f));
+    return _mm_sub_epi32(a_count, _mm_castps_si128(past));
+}
+
+static inline void simd_meter_fold(const SimdMeterSse2& m, int a_nLowLanes, MeterSums* a_pBands)
+{
+    float p[4], s[4];
+    int32_t n[4];
+    _mm_storeu_ps(p, m.peak);
+    _mm_storeu_ps(s, m.sum);
+    _mm_storeu_si128((__m128i*) n, m.active);
+    meter_fold_lanes(p, s, n, 4, a_nLowLanes, a_pBands);
+}
+
+//RRS: Two channels per call: lanes [LP c, LP c+1, HP c, HP c+1]; a_pStates is channel c's lane of its CrossoverStateLayout group.
+//RRS: With kMeter, both channels' bands are added to a_pBands (low, high)
+template <bool kMeter>
+static inline void lr_process_sse2(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType channel, TIntegerParamType a_nSampleCount, const Filter* filters,
+                                   TFloatParamType* a_pStates, SaturationRamp r, MeterSums* a_pBands)
+{
+    const Filter& f0 = filters[channel];
+    const Filter& f1 = filters[channel + 1];
+
+    __m128 a0 = _mm_setr_ps(f0.lpfCoeffs.a0, f1.lpfCoeffs.a0, -f0.hpfCoeffs.a0, -f1.hpfCoeffs.a0);
+    __m128 a1 = _mm_setr_ps(f0.lpfCoeffs.a1, f1.lpfCoeffs.a1, -f0.hpfCoeffs.a1, -f1.hpfCoeffs.a1);
+    __m128 a2 = _mm_setr_ps(f0.lpfCoeffs.a2, f1.lpfCoeffs.a2, -f0.hpfCoeffs.a2, -f1.hpfCoeffs.a2);
+    __m128 b1 = _mm_setr_ps(f0.lpfCoeffs.b1, f1.lpfCoeffs.b1, f0.hpfCoeffs.b1, f1.hpfCoeffs.b1);
+    __m128 b2 = _mm_setr_ps(f0.lpfCoeffs.b2, f1.lpfCoeffs.b2, f0.hpfCoeffs.b2, f1.hpfCoeffs.b2);
+
+    __m128 s1 = _mm_setr_ps(a_pStates[kStateLow1], a_pStates[kStateLow1 + 1], a_pStates[kStateHigh1], a_pStates[kStateHigh1 + 1]);
+    __m128 s2 = _mm_setr_ps(a_pStates[kStateLow2], a_pStates[kStateLow2 + 1], a_pStates[kStateHigh2], a_pStates[kStateHigh2 + 1]);
+
+    TAudioSampleType* ch0 = a_vAudioBlocksInPlace[channel];
+    TAudioSampleType* ch1 = a_vAudioBlocksInPlace[channel + 1];
+
+    SimdMeterSse2 meter;
+
+    TIntegerParamType i = 0;
+
+    for (; i + 4 <= a_nSampleCount; i += 4)
+    {
+        __m128 in0 = _mm_loadu_ps(ch0 + i);
+        __m128 in1 = _mm_loadu_ps(ch1 + i);
+        __m128 lo = _mm_unpacklo_ps(in0, in1);   // c0[0] c1[0] c0[1] c1[1]
+        __m128 hi = _mm_unpackhi_ps(in0, in1);   // c0[2] c1[2] c0[3] c1[3]
+
+        __m128 x[4] = { _mm_movelh_ps(lo, lo), _mm_movehl_ps(lo, lo), _mm_movelh_ps(hi, hi), _mm_movehl_ps(hi, hi) };
+        __m128 out[4];
+
+        for (int j = 0; j < 4; ++j)
+        {
+            __m128 y = simd_biquad_sse2(x[j], s1, s2, a0, a1, a2, b1, b2);
+            TFloatParamType n = (TFloatParamType) (i + j);
+            __m128 drive = _mm_set1_ps(r.drive + r.driveInc * n);
+            __m128 sat = simd_drive_mix_sse2(y, drive, _mm_set1_ps(r.mix + r.mixInc * n));
+            out[j] = _mm_add_ps(sat, _mm_movehl_ps(y, y)); // lanes 0,1: sat(LP) + HP
+
+            if constexpr (kMeter)
+            {
+                simd_meter_sse2(meter, y);
+                meter.active = simd_count_saturated_sse2(meter.active, _mm_mul_ps(drive, y));
+            }
+        }
+
+        __m128 o01 = _mm_movelh_ps(out[0], out[1]); // c0[0] c1[0] c0[1] c1[1]
+        __m128 o23 = _mm_movelh_ps(out[2], out[3]);
+        _mm_storeu_ps(ch0 + i, _mm_shuffle_ps(o01, o23, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(ch1 + i, _mm_shuffle_ps(o01, o23, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    for (; i < a_nSampleCount; ++i)
+    {
+        __m128 y = simd_biquad_sse2(_mm_setr_ps(ch0[i], ch1[i], ch0[i], ch1[i]), s1, s2, a0, a1, a2, b1, b2);
+        __m128 drive = _mm_set1_ps(r.drive + r.driveInc * i);
+        __m128 sat = simd_drive_mix_sse2(y, drive, _mm_set1_ps(r.mix + r.mixInc * i));
+        __m128 o = _mm_add_ps(sat, _mm_movehl_ps(y, y));
+        ch0[i] = _mm_cvtss_f32(o);
+        ch1[i] = _mm_cvtss_f32(_mm_shuffle_ps(o, o, _MM_SHUFFLE(1, 1, 1, 1)));
+
+        if constexpr (kMeter)
+        {
+            simd_meter_sse2(meter, y);
+            meter.active = simd_count_saturated_sse2(meter.active, _mm_mul_ps(drive, y));
+        }
+    }
+
+    if constexpr (kMeter)
+        simd_meter_fold(meter, 2, a_pBands);
+
+    float st[4];
+    _mm_storeu_ps(st, s1);
+    a_pStates[kStateLow1] = st[0]; a_pStates[kStateLow1 + 1] = st[1]; a_pStates[kStateHigh1] = st[2]; a_pStates[kStateHigh1 + 1] = st[3];
+    _mm_storeu_ps(st, s2);
+    a_pStates[kStateLow2] = st[0]; a_pStates[kStateLow2 + 1] = st[1]; a_pStates[kStateHigh2] = st[2]; a_pStates[kStateHigh2 + 1] = st[3];
+}
+
+static inline __m128 simd_negate_sse2(__m128 x)
+{
+    return _mm_xor_ps(x, _mm_set1_ps(-0.0f));
+}
+
+#define RRS_SPLAT_SSE2(v, lane) _mm_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane))
+
+//RRS: Time-parallel kernel for a single channel (mono buses, the odd channel out): both sections advance 4 samples per step
+//RRS: in the state-space form of BlockLRCoefficients. The states are the DF2 w[n-1]/w[n-2], so kernels can be switched between blocks.
+//RRS: With kMeter, the bands are added to a_pBands (low, high)
+template <bool kMeter>
+static inline void lr_process_block_sse2(TAudioSampleType* a_pData, TIntegerParamType a_nSampleCount, const Filter& filter,
+                                         TFloatParamType* low_state_1, TFloatParamType* low_state_2, TFloatParamType* high_state_1, TFloatParamType* high_state_2, SaturationRamp r,
+                                         MeterSums* a_pBands)
+{
+    const BlockLRCoefficients& lb = filter.lpfBlock;
+    const BlockLRCoefficients& hb = filter.hpfBlock;
+
+    // Outputs: one vector = 4 consecutive samples; the high band is inverted as in the other kernels
+    const __m128 lo0 = _mm_loadu_ps(lb.os0), lo1 = _mm_loadu_ps(lb.os1);
+    const __m128 ho0 = simd_negate_sse2(_mm_loadu_ps(hb.os0)), ho1 = simd_negate_sse2(_mm_loadu_ps(hb.os1));
+    __m128 lt[4], ht[4], k[4];
+
+    for (int j = 0; j < 4; ++j)
+    {
+        lt[j] = _mm_loadu_ps(lb.t[j]);
+        ht[j] = simd_negate_sse2(_mm_loadu_ps(hb.t[j]));
+        k[j] = _mm_setr_ps(lb.k[j][0], lb.k[j][1], hb.k[j][0], hb.k[j][1]);
+    }
+
+    // State: lanes [LP w1, LP w2, HP w1, HP w2]
+    const __m128 pl0 = _mm_setr_ps(lb.ps0[0], lb.ps0[1], 0.f, 0.f), pl1 = _mm_setr_ps(lb.ps1[0], lb.ps1[1], 0.f, 0.f);
+    const __m128 ph0 = _mm_setr_ps(0.f, 0.f, hb.ps0[0], hb.ps0[1]), ph1 = _mm_setr_ps(0.f, 0.f, hb.ps1[0], hb.ps1[1]);
+    __m128 st = _mm_setr_ps(*low_state_1, *low_state_2, *high_state_1, *high_state_2);
+
+    const __m128 ramp = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+    __m128 drive = _mm_add_ps(_mm_set1_ps(r.drive), _mm_mul_ps(ramp, _mm_set1_ps(r.driveInc)));
+    __m128 mix = _mm_add_ps(_mm_set1_ps(r.mix), _mm_mul_ps(ramp, _mm_set1_ps(r.mixInc)));
+    const __m128 driveStep = _mm_set1_ps(4.f * r.driveInc);
+    const __m128 mixStep = _mm_set1_ps(4.f * r.mixInc);
+
+    // Lanes are samples here: one meter per band
+    SimdMeterSse2 lowMeter, highMeter;
+
+    TIntegerParamType i = 0;
+
+    for (; i + 4 <= a_nSampleCount; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(a_pData + i);
+        __m128 x0 = RRS_SPLAT_SSE2(x, 0), x1 = RRS_SPLAT_SSE2(x, 1), x2 = RRS_SPLAT_SSE2(x, 2), x3 = RRS_SPLAT_SSE2(x, 3);
+        __m128 sl0 = RRS_SPLAT_SSE2(st, 0), sl1 = RRS_SPLAT_SSE2(st, 1), sh0 = RRS_SPLAT_SSE2(st, 2), sh1 = RRS_SPLAT_SSE2(st, 3);
+
+        __m128 xl = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lt[0], x0), _mm_mul_ps(lt[1], x1)), _mm_add_ps(_mm_mul_ps(lt[2], x2), _mm_mul_ps(lt[3], x3)));
+        __m128 xh = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ht[0], x0), _mm_mul_ps(ht[1], x1)), _mm_add_ps(_mm_mul_ps(ht[2], x2), _mm_mul_ps(ht[3], x3)));
+        __m128 xs = _mm_add_ps(_mm_add_ps(_mm_mul_ps(k[0], x0), _mm_mul_ps(k[1], x1)), _mm_add_ps(_mm_mul_ps(k[2], x2), _mm_mul_ps(k[3], x3)));
+
+        __m128 low = _mm_add_ps(xl, _mm_add_ps(_mm_mul_ps(lo0, sl0), _mm_mul_ps(lo1, sl1)));
+        __m128 high = _mm_add_ps(xh, _mm_add_ps(_mm_mul_ps(ho0, sh0), _mm_mul_ps(ho1, sh1)));
+        st = _mm_add_ps(xs, _mm_add_ps(_mm_add_ps(_mm_mul_ps(pl0, sl0), _mm_mul_ps(pl1, sl1)), _mm_add_ps(_mm_mul_ps(ph0, sh0), _mm_mul_ps(ph1, sh1))));
+
+        _mm_storeu_ps(a_pData + i, _mm_add_ps(simd_drive_mix_sse2(low, drive, mix), high));
+
+        if constexpr (kMeter)
+        {
+            simd_meter_sse2(lowMeter, low);
+            simd_meter_sse2(highMeter, high);
+            lowMeter.active = simd_count_saturated_sse2(lowMeter.active, _mm_mul_ps(drive, low));
+        }
+
+        drive = _mm_add_ps(drive, driveStep);
+        mix = _mm_add_ps(mix, mixStep);
+    }
+
+    if constexpr (kMeter)
+    {
+        simd_meter_fold(lowMeter, 4, a_pBands);
+        simd_meter_fold(highMeter, 0, a_pBands);
+    }
+
+    float w[4];
+    _mm_storeu_ps(w, st);
+    TFloatParamType ls1 = w[0], ls2 = w[1], hs1 = w[2], hs2 = w[3];
+    const LRCoefficients lp = filter.lpfCoeffs, hp = filter.hpfCoeffs;
+
+    for (; i < a_nSampleCount; ++i)
+    {
+        TFloatParamType x = a_pData[i];
+        TFloatParamType low = filter.lowpass_filter(x, &ls1, &ls2, lp.a0, lp.a1, lp.a2, lp.b1, lp.b2);
+        TFloatParamType high = filter.highpass_filter(x, &hs1, &hs2, hp.a0, hp.a1, hp.a2, hp.b1, hp.b2);
+        TFloatParamType driven = (r.drive + r.driveInc * i) * low;
+        a_pData[i] = low + (r.mix + r.mixInc * i) * (tube_saturation_branchless(driven) - low) + high;
+
+        if constexpr (kMeter)
+            meter_sample(a_pBands, low, driven, high);
+    }
+
+    *low_state_1 = ls1;  *low_state_2 = ls2;
+    *high_state_1 = hs1; *high_state_2 = hs2;
+}
+
+RRS_TARGET_AVX2 static inline __m256 simd_biquad_avx2(__m256 x, __m256& s1, __m256& s2, __m256 a0, __m256 a1, __m256 a2, __m256 b1, __m256 b2)
+{
+    __m256 w = _mm256_fnmadd_ps(b2, s2, _mm256_fnmadd_ps(b1, s1, x));
+    __m256 y = _mm256_fmadd_ps(a2, s2, _mm256_fmadd_ps(a1, s1, _mm256_mul_ps(a0, w)));
+    s2 = s1;
+    s1 = w;
+    return y;
+}
+
+RRS_TARGET_AVX2 static inline void simd_meter_avx2(SimdMeterAvx2& m, __m256 a_y)
+{
+    m.peak = _mm256_max_ps(m.peak, _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a_y));
+    m.sum = _mm256_fmadd_ps(a_y, a_y, m.sum);
+}
+
+RRS_TARGET_AVX2 static inline void simd_meter_fold(const SimdMeterAvx2& m, int a_nLowLanes, MeterSums* a_pBands)
+{
+    float p[8], s[8];
+    int32_t n[8] = {};
+    _mm256_storeu_ps(p, m.peak);
+    _mm256_storeu_ps(s, m.sum);
+    _mm_storeu_si128((__m128i*) n, m.active);
+    meter_fold_lanes(p, s, n, 8, a_nLowLanes, a_pBands);
+}
+
+RRS_TARGET_AVX2 static inline __m256 simd_tube_saturation_avx2(__m256 x)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 sign = _mm256_and_ps(x, signMask);
+    __m256 a = _mm256_min_ps(_mm256_andnot_ps(signMask, x), _mm256_set1_ps(2.0f / 3.0f));
+    __m256 u = _mm256_max_ps(_mm256_sub_ps(a, _mm256_set1_ps(1.0f / 3.0f)), _mm256_setzero_ps());
+    __m256 y = _mm256_fnmadd_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(u, u), _mm256_add_ps(a, a));
+    return _mm256_or_ps(y, sign);
+}
+
+RRS_TARGET_AVX2 static inline void saturate_block_avx2(TAudioSampleType* a_pData, TIntegerParamType a_nSampleCount, SaturationRamp r)
+{
+    const __m256 ramp = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+    __m256 drive = _mm256_fmadd_ps(ramp, _mm256_set1_ps(r.driveInc), _mm256_set1_ps(r.drive));
+    __m256 mix = _mm256_fmadd_ps(ramp, _mm256_set1_ps(r.mixInc), _mm256_set1_ps(r.mix));
+    const __m256 driveStep = _mm256_set1_ps(8.f * r.driveInc);
+    const __m256 mixStep = _mm256_set1_ps(8.f * r.mixInc);
+
+    TIntegerParamType i = 0;
+
+    for (; i + 8 <= a_nSampleCount; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(a_pData + i);
+        __m256 sat = simd_tube_saturation_avx2(_mm256_mul_ps(drive, x));
+        _mm256_storeu_ps(a_pData + i, _mm256_fmadd_ps(mix, _mm256_sub_ps(sat, x), x));
+        drive = _mm256_add_ps(drive, driveStep);
+        mix = _mm256_add_ps(mix, mixStep);
+    }
+
+    r.drive += r.driveInc * i;
+    r.mix += r.mixInc * i;
+    saturate_block_sse2(a_pData + i, a_nSampleCount - i, r);
+}
+
+RRS_TARGET_AVX2 static inline __m256 simd_lanes_avx2(const TFloatParamType* lp, const TFloatParamType* hp)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lp)), _mm_loadu_ps(hp), 1);
+}
+
+//RRS: Four channels per call: lanes [LP c..c+3 | HP c..c+3]; a_pStates is channel c's CrossoverStateLayout group, where w1 and w2
+//RRS: are already in that lane order. With kMeter, the four channels' bands are added to a_pBands (low, high)
+template <bool kMeter>
+RRS_TARGET_AVX2 static inline void lr_process_avx2(TAudioSampleType** a_vAudioBlocksInPlace, TIntegerParamType channel, TIntegerParamType a_nSampleCount, const Filter* filters,
+                                                   TFloatParamType* a_pStates, SaturationRamp r, MeterSums* a_pBands)
+{
+    float lp[5][4], hp[5][4];
+
+    for (int c = 0; c < 4; ++c)
+    {
+        const Filter& f = filters[channel + c];
+        lp[0][c] = f.lpfCoeffs.a0;  hp[0][c] = -f.hpfCoeffs.a0;
+        lp[1][c] = f.lpfCoeffs.a1;  hp[1][c] = -f.hpfCoeffs.a1;
+        lp[2][c] = f.lpfCoeffs.a2;  hp[2][c] = -f.hpfCoeffs.a2;
+        lp[3][c] = f.lpfCoeffs.b1;  hp[3][c] = f.hpfCoeffs.b1;
+        lp[4][c] = f.lpfCoeffs.b2;  hp[4][c] = f.hpfCoeffs.b2;
+    }
+
+    __m256 a0 = simd_lanes_avx2(lp[0], hp[0]), a1 = simd_lanes_avx2(lp[1], hp[1]), a2 = simd_lanes_avx2(lp[2], hp[2]);
+    __m256 b1 = simd_lanes_avx2(lp[3], hp[3]), b2 = simd_lanes_avx2(lp[4], hp[4]);
+
+    __m256 s1 = _mm256_loadu_ps(a_pStates + kStateLow1);
+    __m256 s2 = _mm256_loadu_ps(a_pStates + kStateLow2);
+
+    TAudioSampleType* ch[4] = { a_vAudioBlocksInPlace[channel],     a_vAudioBlocksInPlace[channel + 1],
+                                a_vAudioBlocksInPlace[channel + 2], a_vAudioBlocksInPlace[channel + 3] };
+
+    SimdMeterAvx2 meter;
+
+    TIntegerParamType i = 0;
+
+    for (; i + 4 <= a_nSampleCount; i += 4)
+    {
+        __m128 r0 = _mm_loadu_ps(ch[0] + i), r1 = _mm_loadu_ps(ch[1] + i), r2 = _mm_loadu_ps(ch[2] + i), r3 = _mm_loadu_ps(ch[3] + i);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3); // r_j = sample j of c..c+3
+
+        __m128 rows[4] = { r0, r1, r2, r3 };
+
+        for (int j = 0; j < 4; ++j)
+        {
+            __m256 x = _mm256_insertf128_ps(_mm256_castps128_ps256(rows[j]), rows[j], 1);
+            __m256 y = simd_biquad_avx2(x, s1, s2, a0, a1, a2, b1, b2);
+            TFloatParamType n = (TFloatParamType) (i + j);
+            __m128 drive = _mm_set1_ps(r.drive + r.driveInc * n);
+            __m128 sat = simd_drive_mix_sse2(_mm256_castps256_ps128(y), drive, _mm_set1_ps(r.mix + r.mixInc * n));
+            rows[j] = _mm_add_ps(sat, _mm256_extractf128_ps(y, 1));
+
+            if constexpr (kMeter)
+            {
+                simd_meter_avx2(meter, y);
+                meter.active = simd_count_saturated_sse2(meter.active, _mm_mul_ps(drive, _mm256_castps256_ps128(y)));
+            }
+        }
+
+        _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+        _mm_storeu_ps(ch[0] + i, rows[0]);
+        _mm_storeu_ps(ch[1] + i, rows[1]);
+        _mm_storeu_ps(ch[2] + i, rows[2]);
+        _mm_storeu_ps(ch[3] + i, rows[3]);
+    }
+
+    for (; i < a_nSampleCount; ++i)
+    {
+        __m128 in = _mm_setr_ps(ch[0][i], ch[1][i], ch[2][i], ch[3][i]);
+        __m256 y = simd_biquad_avx2(_mm256_insertf128_ps(_mm256_castps128_ps256(in), in, 1), s1, s2, a0, a1, a2, b1, b2);
+        __m128 drive = _mm_set1_ps(r.drive + r.driveInc * i);
+        __m128 sat = simd_drive_mix_sse2(_mm256_castps256_ps128(y), drive, _mm_set1_ps(r.mix + r.mixInc * i));
+        float o[4];
+        _mm_storeu_ps(o, _mm_add_ps(sat, _mm256_extractf128_ps(y, 1)));
+        ch[0][i] = o[0]; ch[1][i] = o[1]; ch[2][i] = o[2]; ch[3][i] = o[3];
+
+        if constexpr (kMeter)
+        {
+            simd_meter_avx2(meter, y);
+            meter.active = simd_count_saturated_sse2(meter.active, _mm_mul_ps(drive, _mm256_castps256_ps128(y)));
+        }
+    }
+
+    if constexpr (kMeter)
+        simd_meter_fold(meter, 4, a_pBands);
+
+    _mm256_storeu_ps(a_pStates + kStateLow1, s1);
+    _mm256_storeu_ps(a_pStates + kStateLow2, s2);
+}
+
+// Double precision (DSPT<double>): the same arithmetic on __m128d/__m256d. Two lanes hold [LP, HP] of one channel, four hold
+// [LP c, LP c+1 | HP c, HP c+1], so the SSE2 kernel leaves no channel over and there is no time-parallel form.
+
+static inline __m128d simd_tube_saturation_sse2(__m128d x)
+{
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    __m128d sign = _mm_and_pd(x, signMask);
+    __m128d a = _mm_min_pd(_mm_andnot_pd(signMask, x), _mm_set1_pd(2.0 / 3.0));
+    __m128d u = _mm_max_pd(_mm_sub_pd(a, _mm_set1_pd(1.0 / 3.0)), _mm_setzero_pd());
+    __m128d y = _mm_sub_pd(_mm_add_pd(a, a), _mm_mul_pd(_mm_set1_pd(3.0), _mm_mul_pd(u, u)));
+    return _mm_or_pd(y, sign);
+}
+
+static inline __m128d simd_drive_mix_sse2(__m128d x, __m128d drive, __m128d mix)
+{
+    return _mm_add_pd(x, _mm_mul_pd(mix, _mm_sub_pd(simd_tube_saturation_sse2(_mm_mul_pd(drive, x)), x)));
+}
+
+static inline void saturate_block_sse2(double* a_pData, TIntegerParamType a_nSampleCount, SaturationRamp r)
+{
+    const __m128d ramp = _mm_setr_pd(0.0, 1.0);
+    __m128d drive = _mm_add_pd(_mm_set1_pd(r.drive), _mm_mul_pd(ramp, _mm_set1_pd(r.driveInc)));
+    __m128d mix = _mm_add_pd(_mm_set1_pd(r.mix), _mm_mul_pd(ramp, _mm_set1_pd(r.mixInc)));
+    const __m128d driveStep = _mm_set1_pd(2.0 * r.driveInc);
+    const __m128d mixStep = _mm_set1_pd(2.0 * r.mixInc);
+
+    TIntegerParamType i = 0;
+
+    for (; i + 2 <= a_nSampleCount; i += 2)
+    {
+        _mm_storeu_pd(a_pData + i, simd_drive_mix_sse2(_mm_loadu_pd(a_pData + i), drive, mix));
+        drive = _mm_add_pd(drive, driveStep);
+        mix = _mm_add_pd(mix, mixStep);
+    }
+
+    r.drive += r.driveInc * i;
+    r.mix += r.mixInc * i;
+    saturate_block_scalar(a_pData + i, a_nSampleCount - i, r);
+}
+
+static inline __m128d simd_biquad_sse2(__m128d x, __m128d& s1, __m128d& s2, __m128d a0, __m128d a1, __m128d a2, __m128d b1, __m128d b2)
+{
+    __m128d w = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(b1, s1)), _mm_mul_pd(b2, s2));
+    __m128d y = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a0, w), _mm_mul_pd(a1, s1)), _mm_mul_pd(a2, s2));
+    s2 = s1;
+    s1 = w;
+    return y;
+}
+
+static inline void simd_meter_sse2(SimdMeterSse2d& m, __m128d a_y)
+{
+    m.peak = _mm_max_pd(m.peak, _mm_andnot_pd(_mm_set1_pd(-0.0), a_y));
+    m.sum = _mm_add_pd(m.sum, _mm_mul_pd(a_y, a_y));
+}
+
+static inline __m128i simd_count_saturated_sse2(__m128i a_count, __m128d a_driven)
+{
+    __m128d past = _mm_cmpgt_pd(_mm_andnot_pd(_mm_set1_pd(-0.0), a_driven), _mm_set1_pd(1.0 / 3.0));
+    return _mm_sub_epi64(a_count, _mm_castpd_si128(past));
+}
+
+static inline void simd_meter_fold(const SimdMeterSse2d& m, int a_nLowLanes, MeterSums* a_pBands)
+{
+    double p[2], s[2];
+    int64_t n[2];
+    _mm_storeu_pd(p, m.peak);
+    _mm_storeu_pd(s, m.sum);
+    _mm_storeu_si128((__m128i*) n, m.active);
+    meter_fold_lanes(p, s, n, 2, a_nLowLanes, a_pBands);
+}
+
+//RRS: One channel per call: lanes [LP, HP]; a_pStates is the channel's lane of its CrossoverStateLayout group.
+//RRS: Same operations in the same order as the scalar path. With kMeter, the bands are added to a_pBands (low, high)
+template <bool kMeter>
+static inline void lr_process_sse2_pd(double* a_pData, TIntegerParamType a_nSampleCount, const FilterT<double>& filter, double* a_pStates, SaturationRamp r,
+                                      MeterSums* a_pBands)
+{
+    const LRCoefficientsT<double>& lp = filter.lpfCoeffs;
+    const LRCoefficientsT<double>& hp = filter.hpfCoeffs;
+
+    const __m128d a0 = _mm_setr_pd(lp.a0, -hp.a0), a1 = _mm_setr_pd(lp.a1, -hp.a1), a2 = _mm_setr_pd(lp.a2, -hp.a2);
+    const __m128d b1 = _mm_setr_pd(lp.b1, hp.b1), b2 = _mm_setr_pd(lp.b2, hp.b2);
+
+    __m128d s1 = _mm_setr_pd(a_pStates[kStateLow1], a_pStates[kStateHigh1]);
+    __m128d s2 = _mm_setr_pd(a_pStates[kStateLow2], a_pStates[kStateHigh2]);
+
+    SimdMeterSse2d meter;
+    int64_t nSaturated = 0;
+
+    for (TIntegerParamType i = 0; i < a_nSampleCount; ++i)
+    {
+        __m128d y = simd_biquad_sse2(_mm_set1_pd(a_pData[i]), s1, s2, a0, a1, a2, b1, b2);
+        double low = _mm_cvtsd_f64(y), high = _mm_cvtsd_f64(_mm_unpackhi_pd(y, y));
+        TFloatParamType drive = r.drive + r.driveInc * i;
+
+        a_pData[i] = low + (r.mix + r.mixInc * i) * (tube_saturation_branchless(drive * low) - low) + high;
+
+        // The saturator's |drive * low| again, shared with it
+        if constexpr (kMeter)
+        {
+            simd_meter_sse2(meter, y);
+            nSaturated += std::fabs(drive * low) > 1.0 / 3.0 ? 1 : 0;
+        }
+    }
+
+    if constexpr (kMeter)
+    {
+        meter.active = _mm_cvtsi64_si128(nSaturated);
+        simd_meter_fold(meter, 1, a_pBands);
+    }
+
+    _mm_storel_pd(a_pStates + kStateLow1, s1);  _mm_storeh_pd(a_pStates + kStateHigh1, s1);
+    _mm_storel_pd(a_pStates + kStateLow2, s2);  _mm_storeh_pd(a_pStates + kStateHigh2, s2);
+}
+
+RRS_TARGET_AVX2 static inline __m256d simd_biquad_avx2(__m256d x, __m256d& s1, __m256d& s2, __m256d a0, __m256d a1, __m256d a2, __m256d b1, __m256d b2)
+{
+    __m256d w = _mm256_fnmadd_pd(b2, s2, _mm256_fnmadd_pd(b1, s1, x));
+    __m256d y = _mm256_fmadd_pd(a2, s2, _mm256_fmadd_pd(a1, s1, _mm256_mul_pd(a0, w)));
+    s2 = s1;
+    s1 = w;
+    return y;
+}
+
+RRS_TARGET_AVX2 static inline void simd_meter_avx2(SimdMeterAvx2d& m, __m256d a_y)
+{
+    m.peak = _mm256_max_pd(m.peak, _mm256_andnot_pd(_mm256_set1_pd(-0.0), a_y));
+    m.sum = _mm256_fmadd_pd(a_y, a_y, m.sum);
+}
+
+RRS_TARGET_AVX2 static inline void simd_meter_fold(const SimdMeterAvx2d& m, int a_nLowLanes, MeterSums* a_pBands)
+{
+    double p[4], s[4];
+    int64_t n[4] = {};
+    _mm256_storeu_pd(p, m.peak);
+    _mm256_storeu_pd(s, m.sum);
+    _mm_storeu_si128((__m128i*) n, m.active);
+    meter_fold_lanes(p, s, n, 4, a_nLowLanes, a_pBands);
+}
+
+RRS_TARGET_AVX2 static inline __m256d simd_tube_saturation_avx2(__m256d x)
+{
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    __m256d sign = _mm256_and_pd(x, signMask);
+    __m256d a = _mm256_min_pd(_mm256_andnot_pd(signMask, x), _mm256_set1_pd(2.0 / 3.0));
+    __m256d u = _mm256_max_pd(_mm256_sub_pd(a, _mm256_set1_pd(1.0 / 3.0)), _mm256_setzero_pd());
+    __m256d y = _mm256_fnmadd_pd(_mm256_set1_pd(3.0), _mm256_mul_pd(u, u), _mm256_add_pd(a, a));
+    return _mm256_or_pd(y, sign);
+}
+
+RRS_TARGET_AVX2 static inline void saturate_block_avx2(double* a_pData, TIntegerParamType a_nSampleCount, SaturationRamp r)
+{
+    const __m256d ramp = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+    __m256d drive = _mm256_fmadd_pd(ramp, _mm256_set1_pd(r.driveInc), _mm256_set1_pd(r.drive));
+    __m256d mix = _mm256_fmadd_pd(ramp, _mm256_set1_pd(r.mixInc), _mm256_set1_pd(r.mix));
+    const __m256d driveStep = _mm256_set1_pd(4.0 * r.driveInc);
+    const __m256d mixStep = _mm256_set1_pd(4.0 * r.mixInc);
+
+    TIntegerParamType i = 0;
+
+    for (; i + 4 <= a_nSampleCount; i += 4)
+    {
+        __m256d x = _mm256_loadu_pd(a_pData + i);
+        __m256d sat = simd_tube_saturation_avx2(_mm256_mul_pd(drive, x));
+        _mm256_storeu_pd(a_pData + i, _mm256_fmadd_pd(mix, _mm256_sub_pd(sat, x), x));
+        drive = _mm256_add_pd(drive, driveStep);
+        mix = _mm256_add_pd(mix, mixStep);
+    }
+
+    r.drive += r.driveInc * i;
+    r.mix += r.mixInc * i;
+    saturate_block_sse2(a_pData + i, a_nSampleCount - i, r);
+}
+
+//RRS: Two channels per call: lanes [LP c, LP c+1 | HP c, HP c+1]; a_pStates is channel c's lane of its CrossoverStateLayout group.
+//RRS: With kMeter, both channels' bands are added to a_pBands (low, high)
+template <bool kMeter>
+RRS_TARGET_AVX2 static inline void lr_process_avx2_pd(double** a_vAudioBlocksInPlace, TIntegerParamType channel, TIntegerParamType a_nSampleCount, const FilterT<double>* filters,
+                                                      double* a_pStates, SaturationRamp r, MeterSums* a_pBands)
+{
+    const FilterT<double>& f0 = filters[channel];
+    const FilterT<double>& f1 = filters[channel + 1];
+
+    __m256d a0 = _mm256_setr_pd(f0.lpfCoeffs.a0, f1.lpfCoeffs.a0, -f0.hpfCoeffs.a0, -f1.hpfCoeffs.a0);
+    __m256d a1 = _mm256_setr_pd(f0.lpfCoeffs.a1, f1.lpfCoeffs.a1, -f0.hpfCoeffs.a1, -f1.hpfCoeffs.a1);
+    __m256d a2 = _mm256_setr_pd(f0.lpfCoeffs.a2, f1.lpfCoeffs.a2, -f0.hpfCoeffs.a2, -f1.hpfCoeffs.a2);
+    __m256d b1 = _mm256_setr_pd(f0.lpfCoeffs.b1, f1.lpfCoeffs.b1, f0.hpfCoeffs.b1, f1.hpfCoeffs.b1);
+    __m256d b2 = _mm256_setr_pd(f0.lpfCoeffs.b2, f1.lpfCoeffs.b2, f0.hpfCoeffs.b2, f1.hpfCoeffs.b2);
+
+    __m256d s1 = _mm256_setr_pd(a_pStates[kStateLow1], a_pStates[kStateLow1 + 1], a_pStates[kStateHigh1], a_pStates[kStateHigh1 + 1]);
+    __m256d s2 = _mm256_setr_pd(a_pStates[kStateLow2], a_pStates[kStateLow2 + 1], a_pStates[kStateHigh2], a_pStates[kStateHigh2 + 1]);
+
+    double* ch0 = a_vAudioBlocksInPlace[channel];
+    double* ch1 = a_vAudioBlocksInPlace[channel + 1];
+
+    SimdMeterAvx2d meter;
+
+    TIntegerParamType i = 0;
+
+    for (; i + 2 <= a_nSampleCount; i += 2)
+    {
+        __m128d in0 = _mm_loadu_pd(ch0 + i);
+        __m128d in1 = _mm_loadu_pd(ch1 + i);
+        __m128d rows[2] = { _mm_unpacklo_pd(in0, in1), _mm_unpackhi_pd(in0, in1) }; // rows[j] = sample j of c, c+1
+
+        for (int j = 0; j < 2; ++j)
+        {
+            __m256d y = simd_biquad_avx2(_mm256_insertf128_pd(_mm256_castpd128_pd256(rows[j]), rows[j], 1), s1, s2, a0, a1, a2, b1, b2);
+            TFloatParamType n = (TFloatParamType) (i + j);
+            __m128d drive = _mm_set1_pd(r.drive + r.driveInc * n);
+            __m128d sat = simd_drive_mix_sse2(_mm256_castpd256_pd128(y), drive, _mm_set1_pd(r.mix + r.mixInc * n));
+            rows[j] = _mm_add_pd(sat, _mm256_extractf128_pd(y, 1));
+
+            if constexpr (kMeter)
+            {
+                simd_meter_avx2(meter, y);
+                meter.active = simd_count_saturated_sse2(meter.active, _mm_mul_pd(drive, _mm256_castpd256_pd128(y)));
+            }
+        }
+
+        _mm_storeu_pd(ch0 + i, _mm_unpacklo_pd(rows[0], rows[1]));
+        _mm_storeu_pd(ch1 + i, _mm_unpackhi_pd(rows[0], rows[1]));
+    }
+
+    for (; i < a_nSampleCount; ++i)
+    {
+        __m128d in = _mm_setr_pd(ch0[i], ch1[i]);
+        __m256d y = simd_biquad_avx2(_mm256_insertf128_pd(_mm256_castpd128_pd256(in), in, 1), s1, s2, a0, a1, a2, b1, b2);
+        __m128d drive = _mm_set1_pd(r.drive + r.driveInc * i);
+        __m128d sat = simd_drive_mix_sse2(_mm256_castpd256_pd128(y), drive, _mm_set1_pd(r.mix + r.mixInc * i));
+        __m128d o = _mm_add_pd(sat, _mm256_extractf128_pd(y, 1));
+        ch0[i] = _mm_cvtsd_f64(o);
+        ch1[i] = _mm_cvtsd_f64(_mm_unpackhi_pd(o, o));
+
+        if constexpr (kMeter)
+        {
+            simd_meter_avx2(meter, y);
+            meter.active = simd_count_saturated_sse2(meter.active, _mm_mul_pd(drive, _mm256_castpd256_pd128(y)));
+        }
+    }
+
+    if constexpr (kMeter)
+        simd_meter_fold(meter, 2, a_pBands);
+
+    double st[4];
+    _mm256_storeu_pd(st, s1);
+    a_pStates[kStateLow1] = st[0]; a_pStates[kStateLow1 + 1] = st[1]; a_pStates[kStateHigh1] = st[2]; a_pStates[kStateHigh1 + 1] = st[3];
+    _mm256_storeu_pd(st, s2);
+    a_pStates[kStateLow2] = st[0]; a_pStates[kStateLow2 + 1] = st[1]; a_pStates[kStateHigh2] = st[2]; a_pStates[kStateHigh2 + 1] = st[3];
+}
+
+#endif
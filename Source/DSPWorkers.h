@@ -0,0 +1,307 @@
+// Red Rock Sound (RRS):
+// A pool of worker threads that audio threads hand jobs to: a function and a number of independent tasks (for DSP::Process(),
+// one per group of 4 channels). The caller runs tasks itself alongside the workers and returns when all of them are done.
+
+// One pool serves the whole process (WorkerPool::AcquireShared()), so a session of wide buses has one set of workers rather than
+// a set per plugin instance. Any number of audio threads may call Run() at once: each takes one of kMaxCallers job slots with an
+// exchange, and when every slot is taken it runs its job itself, as it does on a pool without workers.
+
+// Run() neither locks nor allocates. The job is published with one atomic store into its slot, and every task is claimed with a
+// compare-and-swap on a word that holds the job number, the task count and the next task, so a worker still waking up for an
+// earlier job can never claim one of a later job. The barrier at the end is a spin on the count of unfinished tasks. Tasks are
+// claimed, not assigned: a worker that is asleep or preempted simply gets none, and the caller only ever waits for tasks that are
+// already running.
+
+// Workers spin for kSpinTime_us after their last job, which covers jobs that follow each other within one callback, then sleep on
+// a semaphore. A sleeping worker registers itself in nSleeping before it checks for work one last time; Run() bumps nEpoch before
+// it reads nSleeping, so one of the two always sees the other, and the caller posts the semaphore once per sleeper it takes: an
+// exchange and, only when someone sleeps, one post, with no lock. Start(), Reserve() and Stop() create and join the threads (not
+// on the audio thread).
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif defined(__APPLE__)
+ #include <dispatch/dispatch.h>
+#else
+ #include <semaphore.h>
+#endif
+
+static inline void cpu_relax()
+{
+#if RRS_SIMD_X86
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+//RRS: Counting semaphore of the platform; Post() is lock-free in user space (a system call only when a thread waits on it)
+struct WorkerSemaphore
+{
+#if defined(_WIN32)
+    HANDLE handle = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+    ~WorkerSemaphore() { CloseHandle(handle); }
+    void Post(int a_nCount) { ReleaseSemaphore(handle, a_nCount, NULL); }
+    void Wait() { WaitForSingleObject(handle, INFINITE); }
+#elif defined(__APPLE__)
+    dispatch_semaphore_t handle = dispatch_semaphore_create(0);
+    ~WorkerSemaphore() { dispatch_release(handle); }
+    void Post(int a_nCount) { while (a_nCount-- > 0) dispatch_semaphore_signal(handle); }
+    void Wait() { dispatch_semaphore_wait(handle, DISPATCH_TIME_FOREVER); }
+#else
+    sem_t handle;
+    WorkerSemaphore() { sem_init(&handle, 0, 0); }
+    ~WorkerSemaphore() { sem_destroy(&handle); }
+    void Post(int a_nCount) { while (a_nCount-- > 0) sem_post(&handle); }
+    void Wait() { while (sem_wait(&handle) != 0) {} }
+#endif
+};
+
+struct WorkerPool
+{
+    enum { kMaxWorkers = 15, kMaxCallers = 16, kSpinTime_us = 10 };
+
+    typedef void (*TaskFunction)(void* a_pContext, TIntegerParamType a_nTask);
+
+    //RRS: One caller's job; a cache line each, so callers on different cores do not share one
+    struct alignas(64) Slot
+    {
+        // [job: 32 | task count: 16 | next task: 16]; a new job is published by storing it with release
+        std::atomic<uint64_t> ticket { 0 };
+        std::atomic<TIntegerParamType> nUnfinished { 0 };
+        std::atomic<bool> bBusy { false };
+        TaskFunction fnTask = NULL;
+        void* pContext = NULL;
+    };
+
+    Slot slots[kMaxCallers];
+
+    std::vector<std::thread> threads;
+    std::atomic<TIntegerParamType> nWorkers { 0 };
+    std::atomic<bool> bStop { false };
+
+    // Bumped by every Run() that publishes a job; workers look at the slots when it has moved
+    std::atomic<uint32_t> nEpoch { 0 };
+    std::atomic<int> nSleeping { 0 };
+    WorkerSemaphore wake;
+
+    // Start(), Reserve(), Stop() and the users of the shared pool
+    std::mutex lifecycle;
+    int nUsers = 0;
+
+    //RRS: The pool of the process, with one more user; its threads are added by Reserve() and joined when the last user releases it.
+    //RRS: Memory allocations are allowed inside
+    static WorkerPool* AcquireShared()
+    {
+        WorkerPool& pool = _Shared();
+        std::lock_guard<std::mutex> lock(pool.lifecycle);
+        ++pool.nUsers;
+        return &pool;
+    }
+
+    static void ReleaseShared()
+    {
+        WorkerPool& pool = _Shared();
+        std::lock_guard<std::mutex> lock(pool.lifecycle);
+
+        if (pool.nUsers > 0 && --pool.nUsers == 0)
+            pool._StopLocked();
+    }
+
+    //RRS: Starts a_nWorkers threads (at most kMaxWorkers; 0 runs every job on the caller). Stops the previous ones first.
+    //RRS: Memory allocations are allowed inside
+    void Start(TIntegerParamType a_nWorkers)
+    {
+        std::lock_guard<std::mutex> lock(lifecycle);
+        _StopLocked();
+        _GrowLocked(a_nWorkers);
+    }
+
+    //RRS: At least a_nWorkers threads (at most kMaxWorkers), adding to the running ones without stopping them; jobs may be running
+    void Reserve(TIntegerParamType a_nWorkers)
+    {
+        std::lock_guard<std::mutex> lock(lifecycle);
+        _GrowLocked(a_nWorkers);
+    }
+
+    ~WorkerPool() { Stop(); }
+
+    void Stop()
+    {
+        std::lock_guard<std::mutex> lock(lifecycle);
+        _StopLocked();
+    }
+
+    TIntegerParamType GetNumWorkers() const { return nWorkers.load(std::memory_order_relaxed); }
+
+    //RRS: Runs a_fnTask(a_pContext, 0 .. a_nTasks - 1) on the workers and the calling thread, in any order, and returns when all are done.
+    //RRS: Any number of callers at once. Assertion: No memory allocations are allowed inside!
+    void Run(TaskFunction a_fnTask, void* a_pContext, TIntegerParamType a_nTasks)
+    {
+        Slot* pSlot = nWorkers.load(std::memory_order_relaxed) > 0 && a_nTasks > 1 ? _AcquireSlot() : NULL;
+
+        if (pSlot == NULL)
+        {
+            for (TIntegerParamType n = 0; n < a_nTasks; ++n)
+                a_fnTask(a_pContext, n);
+            return;
+        }
+
+        Slot& s = *pSlot;
+
+        // Every task of the slot's previous job has finished, so nobody reads these until the ticket below publishes them
+        s.fnTask = a_fnTask;
+        s.pContext = a_pContext;
+        s.nUnfinished.store(a_nTasks, std::memory_order_relaxed);
+
+        uint64_t job = (s.ticket.load(std::memory_order_relaxed) >> 32) + 1;
+        s.ticket.store(job << 32 | (uint64_t) a_nTasks << 16, std::memory_order_release);
+
+        // Sequentially consistent against the registration in _Sleep(): either the sleeper sees the new epoch or this sees the sleeper
+        nEpoch.fetch_add(1, std::memory_order_seq_cst);
+
+        if (nSleeping.load(std::memory_order_seq_cst) > 0)
+        {
+            int nWoken = nSleeping.exchange(0, std::memory_order_seq_cst);
+            if (nWoken > 0)
+                wake.Post(nWoken);
+        }
+
+        _RunTasks(s, (uint32_t) job);
+
+        while (s.nUnfinished.load(std::memory_order_acquire) > 0)
+            cpu_relax();
+
+        s.bBusy.store(false, std::memory_order_release);
+    }
+
+    static WorkerPool& _Shared()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    // A free job slot, or NULL when every one is taken; a bounded scan, so the caller never waits for another
+    Slot* _AcquireSlot()
+    {
+        for (Slot& s : slots)
+            if (! s.bBusy.load(std::memory_order_relaxed) && ! s.bBusy.exchange(true, std::memory_order_acquire))
+                return &s;
+
+        return NULL;
+    }
+
+    void _GrowLocked(TIntegerParamType a_nWorkers)
+    {
+        a_nWorkers = a_nWorkers < 0 ? 0 : (a_nWorkers > kMaxWorkers ? (TIntegerParamType) kMaxWorkers : a_nWorkers);
+        bStop.store(false, std::memory_order_relaxed);
+
+        while ((TIntegerParamType) threads.size() < a_nWorkers)
+            threads.emplace_back([this]() { _WorkerLoop(); });
+
+        nWorkers.store((TIntegerParamType) threads.size(), std::memory_order_relaxed);
+    }
+
+    void _StopLocked()
+    {
+        // Callers that still find workers finish their jobs themselves; the workers finish the tasks they hold
+        nWorkers.store(0, std::memory_order_relaxed);
+        bStop.store(true, std::memory_order_seq_cst);
+        wake.Post((int) threads.size());
+
+        for (std::thread& t : threads)
+            t.join();
+
+        // Stop()'s posts woke the sleepers without taking their registrations
+        threads.clear();
+        nSleeping.store(0, std::memory_order_relaxed);
+    }
+
+    // Claims and runs tasks of a_nJob in a_slot until there are none left (or a later job has replaced it)
+    void _RunTasks(Slot& a_slot, uint32_t a_nJob)
+    {
+        uint64_t t = a_slot.ticket.load(std::memory_order_acquire);
+
+        for (;;)
+        {
+            if ((uint32_t) (t >> 32) != a_nJob || (t & 0xffff) >= ((t >> 16) & 0xffff))
+                return;
+
+            if (! a_slot.ticket.compare_exchange_weak(t, t + 1, std::memory_order_acquire, std::memory_order_acquire))
+                continue;
+
+            a_slot.fnTask(a_slot.pContext, (TIntegerParamType) (t & 0xffff));
+            a_slot.nUnfinished.fetch_sub(1, std::memory_order_release);
+            t = a_slot.ticket.load(std::memory_order_acquire);
+        }
+    }
+
+    // Blocks until a Run() after a_nEpoch (or Stop()) posts the semaphore; returns at once when one has already come
+    void _Sleep(uint32_t a_nEpoch)
+    {
+        nSleeping.fetch_add(1, std::memory_order_seq_cst);
+
+        if (nEpoch.load(std::memory_order_seq_cst) == a_nEpoch && ! bStop.load(std::memory_order_seq_cst))
+        {
+            wake.Wait();
+            return;
+        }
+
+        // Work came in meanwhile: take the registration back, or, when a caller has already taken it, the post it made for it
+        int n = nSleeping.load(std::memory_order_seq_cst);
+        while (n > 0 && ! nSleeping.compare_exchange_weak(n, n - 1, std::memory_order_seq_cst))
+        {
+        }
+
+        if (n == 0)
+            wake.Wait();
+    }
+
+    void _WorkerLoop()
+    {
+        uint32_t nSeen = nEpoch.load(std::memory_order_acquire) - 1;   // look at the slots once on start
+        auto lastWork = std::chrono::steady_clock::now();
+
+        while (! bStop.load(std::memory_order_relaxed))
+        {
+            uint32_t epoch = nEpoch.load(std::memory_order_acquire);
+
+            if (epoch != nSeen)
+            {
+                nSeen = epoch;
+
+                // Whatever the tasks do on a worker counts against real-time safety as it would on the audio thread
+                RealtimeScope realtimeScope;
+
+                for (Slot& s : slots)
+                    _RunTasks(s, (uint32_t) (s.ticket.load(std::memory_order_acquire) >> 32));
+
+                lastWork = std::chrono::steady_clock::now();
+                continue;
+            }
+
+            if (std::chrono::steady_clock::now() - lastWork < std::chrono::microseconds(kSpinTime_us))
+                cpu_relax();
+            else
+            {
+                _Sleep(epoch);
+                lastWork = std::chrono::steady_clock::now();
+            }
+        }
+    }
+};
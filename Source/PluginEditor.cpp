@@ -15,11 +15,24 @@ RRS_Header_integrationAudioProcessorEditor::RRS_Header_integrationAudioProcessor
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (600, 400);
+
+    audioProcessor.openTelemetry();
+    startTimerHz (30);
 }
 
 RRS_Header_integrationAudioProcessorEditor::~RRS_Header_integrationAudioProcessorEditor()
 {
+    stopTimer();
+    audioProcessor.closeTelemetry();
+}
+
+void RRS_Header_integrationAudioProcessorEditor::timerCallback()
+{
+    // Every editor reads on the message thread, so they can share the buffers: whichever updates first, all of them Read() the same
+    audioProcessor.getBandMeters().Update();
+    audioProcessor.getSpectrumAnalyzer().spectra.Update();
+    repaint();
 }
 
 //==============================================================================
@@ -28,9 +41,86 @@ void RRS_Header_integrationAudioProcessorEditor::paint (juce::Graphics& g)
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
 
+    auto area = getLocalBounds().toFloat().reduced (10.0f);
+    auto meterArea = area.removeFromBottom (area.getHeight() * 0.3f);
+    area.removeFromBottom (10.0f);
+
+    paintSpectrum (g, area);
+    paintBandMeters (g, meterArea);
+
+   #if RRS_RT_INSTRUMENTATION
+    char report[2048];
+    audioProcessor.getBlockTiming().Format (report, sizeof (report));
+
     g.setColour (juce::Colours::white);
-    g.setFont (juce::FontOptions (15.0f));
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+    g.setFont (juce::FontOptions (juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+    g.drawMultiLineText (report, 20, 30, getWidth() - 40);
+   #endif
+}
+
+// Output spectrum, 20 Hz .. 20 kHz on a log axis, -96 .. 0 dB
+void RRS_Header_integrationAudioProcessorEditor::paintSpectrum (juce::Graphics& g, juce::Rectangle<float> area)
+{
+    const SpectrumFrame& frame = audioProcessor.getSpectrumAnalyzer().spectra.Read();
+
+    g.setColour (juce::Colours::white.withAlpha (0.2f));
+    g.drawRect (area);
+
+    if (frame.nFrames == 0 || frame.fSampleRate <= 0.0f)
+        return;
+
+    const float minFrequency = 20.0f, maxFrequency = juce::jmin (20000.0f, frame.fSampleRate / 2.0f);
+    const float floor_dB = -96.0f;
+    const float binWidth = frame.fSampleRate / (float) SpectrumFrame::kFftSize;
+
+    juce::Path path;
+    for (int k = juce::jmax (1, (int) (minFrequency / binWidth)); k < SpectrumFrame::kBins && k * binWidth <= maxFrequency; ++k)
+    {
+        const float x = area.getX() + area.getWidth() * std::log (k * binWidth / minFrequency) / std::log (maxFrequency / minFrequency);
+        const float y = juce::jmap (juce::jlimit (floor_dB, 0.0f, frame.magnitude_dB[k]), floor_dB, 0.0f, area.getBottom(), area.getY());
+
+        if (path.isEmpty())
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+    }
+
+    g.setColour (juce::Colours::lightblue);
+    g.strokePath (path, juce::PathStrokeType (1.5f));
+}
+
+// One column per band, low to high: RMS bar, peak line, and the saturator's activity as a strip along the bottom
+void RRS_Header_integrationAudioProcessorEditor::paintBandMeters (juce::Graphics& g, juce::Rectangle<float> area)
+{
+    const BandMeterFrame& frame = audioProcessor.getBandMeters().Read();
+    const int numBands = juce::jlimit (1, (int) BandMeterFrame::kMaxBands, (int) frame.nBands);
+    const float floor_dB = -60.0f;
+    const float columnWidth = area.getWidth() / (float) numBands;
+
+    auto levelToY = [&] (float level, juce::Rectangle<float> column)
+    {
+        const float dB = juce::jlimit (floor_dB, 0.0f, juce::Decibels::gainToDecibels (level, floor_dB));
+        return juce::jmap (dB, floor_dB, 0.0f, column.getBottom(), column.getY());
+    };
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        auto column = juce::Rectangle<float> (area.getX() + band * columnWidth, area.getY(), columnWidth, area.getHeight()).reduced (4.0f, 0.0f);
+        auto activity = column.removeFromBottom (4.0f);
+        column.removeFromBottom (2.0f);
+
+        g.setColour (juce::Colours::white.withAlpha (0.2f));
+        g.drawRect (column);
+
+        g.setColour (juce::Colours::limegreen);
+        g.fillRect (column.withTop (levelToY (frame.rms[band], column)));
+
+        g.setColour (juce::Colours::white);
+        g.drawHorizontalLine ((int) levelToY (frame.peak[band], column), column.getX(), column.getRight());
+
+        g.setColour (juce::Colours::orange);
+        g.fillRect (activity.withWidth (activity.getWidth() * juce::jlimit (0.0f, 1.0f, frame.activity[band])));
+    }
 }
 
 void RRS_Header_integrationAudioProcessorEditor::resized()
@@ -14,7 +14,8 @@
 //==============================================================================
 /**
 */
-class RRS_Header_integrationAudioProcessorEditor  : public juce::AudioProcessorEditor
+class RRS_Header_integrationAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                                    private juce::Timer
 {
 public:
     RRS_Header_integrationAudioProcessorEditor (RRS_Header_integrationAudioProcessor&);
@@ -29,5 +30,11 @@ private:
     // access the processor object that created it.
     RRS_Header_integrationAudioProcessor& audioProcessor;
 
+    // Takes the newest meter and spectrum frames (and, with RRS_RT_INSTRUMENTATION, the block timing) and repaints
+    void timerCallback() override;
+
+    void paintSpectrum (juce::Graphics&, juce::Rectangle<float> area);
+    void paintBandMeters (juce::Graphics&, juce::Rectangle<float> area);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RRS_Header_integrationAudioProcessorEditor)
 };
@@ -19,13 +19,84 @@ RRS_Header_integrationAudioProcessor::RRS_Header_integrationAudioProcessor()
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
-                       )
+                       ),
+#else
+     :
 #endif
+       parameters (*this, nullptr, "PARAMETERS", createParameterLayout())
 {
+    gainParameter = parameters.getRawParameterValue ("gain");
+    driveParameter = parameters.getRawParameterValue ("drive");
+    mixParameter = parameters.getRawParameterValue ("mix");
+    crossoverParameter = parameters.getRawParameterValue ("crossover");
+
+    // Once per instance: from here on prepareToPlay() only reconfigures, reusing the memory (see DSP::Preallocate())
+    saturator.Init();
+    saturatorDouble.Init();
 }
 
 RRS_Header_integrationAudioProcessor::~RRS_Header_integrationAudioProcessor()
 {
+   #if RRS_RT_INSTRUMENTATION
+    // Appended to <temp>/LR_Saturator_realtime.txt, one report per instance
+    char report[2048];
+    blockTiming.Format (report, sizeof (report));
+
+    juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile ("LR_Saturator_realtime.txt")
+        .appendText (juce::Time::getCurrentTime().toString (true, true) + "\n" + report + "\n");
+    DBG (report);
+   #endif
+
+    releaseWorkers();
+    saturator.Release();
+    saturatorDouble.Release();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout RRS_Header_integrationAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "gain", 1 }, "Gain",
+                                                             juce::NormalisableRange<float> (-24.f, 24.f, 0.1f), 0.f,
+                                                             juce::AudioParameterFloatAttributes().withLabel ("dB")));
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "drive", 1 }, "Drive",
+                                                             juce::NormalisableRange<float> (1.f, 10.f, 0.01f), 1.f));
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "mix", 1 }, "Mix",
+                                                             juce::NormalisableRange<float> (0.f, 1.f, 0.01f), 1.f));
+
+    juce::NormalisableRange<float> crossoverRange (20.f, 20000.f, 1.f);
+    crossoverRange.setSkewForCentre (1000.f);
+
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "crossover", 1 }, "Crossover",
+                                                             crossoverRange, 5000.f,
+                                                             juce::AudioParameterFloatAttributes().withLabel ("Hz")));
+
+    return layout;
+}
+
+// Lock-free: plain atomic loads, and the DSP setters only retarget their smoothers
+template <typename TSample>
+void RRS_Header_integrationAudioProcessor::pushParameters (DSPT<TSample>& dsp)
+{
+    dsp.SetGain (juce::Decibels::decibelsToGain (gainParameter->load (std::memory_order_relaxed)));
+    dsp.SetDrive (driveParameter->load (std::memory_order_relaxed));
+    dsp.SetMix (mixParameter->load (std::memory_order_relaxed));
+    dsp.SetCrossoverFrequency (crossoverParameter->load (std::memory_order_relaxed));
+
+    const bool telemetry = telemetryViewers.load (std::memory_order_relaxed) > 0;
+    dsp.SetTelemetry (telemetry ? &bandMeters : nullptr, telemetry ? &spectrumAnalyzer : nullptr);
+}
+
+void RRS_Header_integrationAudioProcessor::openTelemetry()
+{
+    spectrumAnalyzer.Open();
+    telemetryViewers.fetch_add (1, std::memory_order_relaxed);
+}
+
+void RRS_Header_integrationAudioProcessor::closeTelemetry()
+{
+    telemetryViewers.fetch_sub (1, std::memory_order_relaxed);
+    spectrumAnalyzer.Close();
 }
 
 //==============================================================================
@@ -63,7 +134,7 @@ bool RRS_Header_integrationAudioProcessor::isMidiEffect() const
 
 double RRS_Header_integrationAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds;
 }
 
 int RRS_Header_integrationAudioProcessor::getNumPrograms()
@@ -95,19 +166,93 @@ void RRS_Header_integrationAudioProcessor::prepareToPlay (double sampleRate, int
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    saturator.Init();
-    saturator.SetMaxChannels(2);
-    saturator.SetMaxBlockSize(samplesPerBlock);
-    saturator.SetCrossoverFrequency(5000.f);
-    saturator.SetSampleRate(sampleRate);
-    saturator.SetGain(1.2f);
+    const juce::ScopedLock lock (presetLock);
+    presetPending = false;                  // the parameters are pushed below, and the settings are the ones prepared here
+
+    const int numChannels = juce::jmax (1, getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+    // One task per group of 4 channels; processBlock() runs one of them itself, so a stereo bus needs no workers. The pool is the
+    // process's, shared with every other instance: it grows to the widest bus prepared and keeps its threads while any uses it
+    const int numWorkers = juce::jmin ((numChannels + 3) / 4 - 1, (int) std::thread::hardware_concurrency() - 1);
+
+    if (workers == nullptr)
+        workers = WorkerPool::AcquireShared();
+
+    workers->Reserve (numWorkers);
+
+    // The host picks the precision before preparing; the other DSP gives its memory back
+    if (isUsingDoublePrecision())
+    {
+        saturator.Release();
+        prepareSaturator (saturatorDouble, sampleRate, samplesPerBlock, numChannels);
+    }
+    else
+    {
+        saturatorDouble.Release();
+        prepareSaturator (saturator, sampleRate, samplesPerBlock, numChannels);
+    }
+
+    spectrumAnalyzer.SetSampleRate ((float) sampleRate);
+
+    startTimerHz (30);
+}
+
+template <typename TSample>
+void RRS_Header_integrationAudioProcessor::prepareSaturator (DSPT<TSample>& dsp, double sampleRate, int samplesPerBlock, int numChannels)
+{
+    // Idempotent: the same settings again keep the memory and the filter states, a new sample rate only recomputes coefficients, and
+    // a block size up to kPreparedBlockSize (hosts often switch between their realtime and bounce sizes) needs no new memory either.
+    // Neither does any oversampling factor or kernel length a preset can set
+    dsp.Preallocate(numChannels, juce::jmax (samplesPerBlock, kPreparedBlockSize), kMaxOversampling, kMaxLinearPhaseKernel);
+    dsp.SetMaxChannels(numChannels);
+    dsp.SetMaxBlockSize(samplesPerBlock);
+    pushParameters (dsp);                   // before SetSampleRate(), which snaps the smoothers to their targets
+    dsp.SetSampleRate(sampleRate);
+    dsp.SetOversampling(oversamplingFactor, oversamplingMode);
+    dsp.SetSaturationMode(saturationMode);
+    dsp.SetLinearPhase(linearPhaseMode, linearPhaseKernelLength);
+    dsp.SetWorkerPool(workers);
+
+    setLatencySamples(dsp.GetLatencySamples());
+
+    // For the lowest crossover the parameter allows, so the host keeps rendering long enough whatever it is automated to
+    tailLengthSeconds = dsp.GetTailSamples(parameters.getParameterRange ("crossover").start) / sampleRate;
 }
 
 void RRS_Header_integrationAudioProcessor::releaseResources()
 {
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-    saturator.Release();
+    // The DSP keeps its memory: hosts release and prepare again around transport changes, bounces and sample-rate switches, and the
+    // next prepareToPlay() reuses it. The destructor frees it
+    stopTimer();
+    releaseWorkers();
+}
+
+void RRS_Header_integrationAudioProcessor::releaseWorkers()
+{
+    // The last instance to let go of the shared pool joins its threads; DSP::Process() runs a job on the caller when a pool has none
+    if (workers != nullptr)
+        WorkerPool::ReleaseShared();
+
+    workers = nullptr;
+}
+
+void RRS_Header_integrationAudioProcessor::timerCallback()
+{
+    // Picked up by the next processBlock(), which crossfades to it; a no-op while the crossover stays put or linear phase is off
+    if (isUsingDoublePrecision())
+        saturatorDouble.UpdateLinearPhaseKernel();
+    else
+        saturator.UpdateLinearPhaseKernel();
+
+    submitPendingPreset();
+}
+
+void RRS_Header_integrationAudioProcessor::submitPendingPreset()
+{
+    const juce::ScopedLock lock (presetLock);
+
+    if (presetPending)
+        presetPending = ! (isUsingDoublePrecision() ? saturatorDouble.SubmitPreset (pendingPreset) : saturator.SubmitPreset (pendingPreset));
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -117,12 +262,11 @@ bool RRS_Header_integrationAudioProcessor::isBusesLayoutSupported (const BusesLa
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel is processed on its own, so any layout goes, from mono up to kMaxBusChannels: 7.1.4 (12),
+    // 3rd-order ambisonics (16) and discrete buses in between
+    const auto& mainOutput = layouts.getMainOutputChannelSet();
+
+    if (mainOutput.isDisabled() || mainOutput.size() > kMaxBusChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -136,8 +280,31 @@ bool RRS_Header_integrationAudioProcessor::isBusesLayoutSupported (const BusesLa
 }
 #endif
 
-void RRS_Header_integrationAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+bool RRS_Header_integrationAudioProcessor::supportsDoublePrecisionProcessing() const
 {
+    return true;
+}
+
+void RRS_Header_integrationAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processSamples (buffer, saturator);
+}
+
+void RRS_Header_integrationAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processSamples (buffer, saturatorDouble);
+}
+
+// Both precisions: the same code on the DSP of that sample type, each with its own kernels
+template <typename TSample>
+void RRS_Header_integrationAudioProcessor::processSamples (juce::AudioBuffer<TSample>& buffer, DSPT<TSample>& dsp)
+{
+   #if RRS_RT_INSTRUMENTATION
+    // The whole callback counts: allocations and locks anywhere below, and its time against the block's duration
+    RealtimeScope realtimeScope;
+    BlockTimer blockTimer (blockTiming, buffer.getNumSamples(), getSampleRate());
+   #endif
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -159,8 +326,10 @@ void RRS_Header_integrationAudioProcessor::processBlock (juce::AudioBuffer<float
     // Alternatively, you can process the samples with the channels
     // interleaved by keeping the same state.
     
-    auto writeData = const_cast<TFloatParamType **>(buffer.getArrayOfWritePointers());
-    saturator.Process(writeData, totalNumInputChannels, numSamples);
+    pushParameters (dsp);
+
+    auto writeData = const_cast<TSample **>(buffer.getArrayOfWritePointers());
+    dsp.Process(writeData, totalNumInputChannels, numSamples);
     
 //    auto writeData = const_cast<TAudioSampleType **>(buffer.getArrayOfWritePointers());
 //    auto readData = const_cast<TAudioSampleType **>(buffer.getArrayOfReadPointers());
@@ -183,17 +352,80 @@ juce::AudioProcessorEditor* RRS_Header_integrationAudioProcessor::createEditor()
 }
 
 //==============================================================================
+DSPPreset RRS_Header_integrationAudioProcessor::currentPreset() const
+{
+    DSPPreset preset;
+    preset.gain = juce::Decibels::decibelsToGain (gainParameter->load());
+    preset.drive = driveParameter->load();
+    preset.mix = mixParameter->load();
+    preset.splitFrequency_Hz[0] = crossoverParameter->load();
+    preset.oversampling = oversamplingFactor;
+    preset.oversamplingMode = oversamplingMode;
+    preset.saturationMode = saturationMode;
+    preset.linearPhaseMode = linearPhaseMode;
+    preset.linearPhaseKernel = linearPhaseKernelLength;
+    return preset;
+}
+
 void RRS_Header_integrationAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // DSPPreset's binary form: a few dozen bytes, versioned, and the same on every platform
+    uint8_t bytes[DSPPreset::kBytes];
+    const size_t numBytes = preset_write (currentPreset(), bytes);
+    destData.replaceAll (bytes, numBytes);
 }
 
 void RRS_Header_integrationAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    DSPPreset preset;
+
+    // Not ours, or damaged: the current settings stay
+    if (sizeInBytes <= 0 || ! preset_read (data, (size_t) sizeInBytes, preset))
+        return;
+
+    // The parameters first: processBlock() pushes them every block, so they must already be the preset's when the DSP takes it
+    auto setParameter = [this] (const char* parameterID, float value)
+    {
+        auto* parameter = parameters.getParameter (parameterID);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    };
+
+    setParameter ("gain", juce::Decibels::gainToDecibels (preset.gain));
+    setParameter ("drive", preset.drive);
+    setParameter ("mix", preset.mix);
+    setParameter ("crossover", preset.splitFrequency_Hz[0]);
+
+    // The structural settings change the latency and the memory layout: they take effect by preparing again, with processing
+    // suspended. Between songs, where live rigs switch, a preset normally keeps them and this is skipped
+    if (preset.oversampling != oversamplingFactor || preset.oversamplingMode != oversamplingMode || preset.saturationMode != saturationMode
+        || preset.linearPhaseMode != linearPhaseMode || preset.linearPhaseKernel != linearPhaseKernelLength)
+    {
+        oversamplingFactor = preset.oversampling;
+        oversamplingMode = preset.oversamplingMode;
+        saturationMode = preset.saturationMode;
+        linearPhaseMode = preset.linearPhaseMode;
+        linearPhaseKernelLength = preset.linearPhaseKernel;
+
+        if (getSampleRate() > 0)
+        {
+            suspendProcessing (true);
+            prepareToPlay (getSampleRate(), getBlockSize());
+            suspendProcessing (false);
+        }
+    }
+
+    // Not prepared yet: prepareToPlay() takes the parameters as they are
+    if (getSampleRate() <= 0)
+        return;
+
+    // The rest as a switch, with the parameters as their ranges rounded them; the filters are designed here, not on the audio thread
+    {
+        const juce::ScopedLock lock (presetLock);
+        pendingPreset = currentPreset();
+        presetPending = true;
+    }
+
+    submitPendingPreset();
 }
 
 //==============================================================================
@@ -14,7 +14,8 @@
 //==============================================================================
 /**
 */
-class RRS_Header_integrationAudioProcessor  : public juce::AudioProcessor
+class RRS_Header_integrationAudioProcessor  : public juce::AudioProcessor,
+                                              private juce::Timer
 {
 public:
     //==============================================================================
@@ -30,6 +31,10 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    // 64-bit hosts get the double DSP directly, with no float conversion copies
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -54,9 +59,91 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    // Host automation and the editor write these from their own threads; processBlock() only reads the atomics
+    juce::AudioProcessorValueTreeState parameters;
+
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    // Largest main bus isBusesLayoutSupported() accepts: 3rd-order ambisonics
+    static constexpr int kMaxBusChannels = 16;
+
+    // Block size the DSP is always prepared for, whatever smaller size the host announces
+    static constexpr int kPreparedBlockSize = 2048;
+
+    // The most a session or preset can ask of the DSP: memory for these is taken once, so switching up to them never allocates
+    static constexpr int kMaxOversampling = 8;
+    static constexpr int kMaxLinearPhaseKernel = LinearPhaseCrossover::kMaxKernel;
+
+    // Editor telemetry (DSPMetering.h). Each open editor calls openTelemetry() once and closeTelemetry() when it goes; while none is
+    // open processBlock() neither meters nor feeds the analyzer. The editor reads the frames from its timer, on the message thread
+    void openTelemetry();
+    void closeTelemetry();
+    BandMeterBuffer& getBandMeters() { return bandMeters; }
+    SpectrumAnalyzer& getSpectrumAnalyzer() { return spectrumAnalyzer; }
+
+   #if RRS_RT_INSTRUMENTATION
+    // Per-block processing time of processBlock(); the editor reads it, the destructor dumps it
+    const BlockTimingHistogram& getBlockTiming() const { return blockTiming; }
+   #endif
+
 private:
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RRS_Header_integrationAudioProcessor)
     
     DSP saturator;
+
+    // Used instead of saturator when the host renders in double (isUsingDoublePrecision()); only the one in use is prepared
+    DSPT<double> saturatorDouble;
+
+    // Channel groups beyond the first, on buses wider than 4 channels: the process's shared pool, acquired in prepareToPlay and
+    // released in releaseResources (or the destructor)
+    WorkerPool* workers = nullptr;
+
+    // Cached from parameters, loaded once per block and smoothed inside DSP
+    std::atomic<float>* gainParameter = nullptr;
+    std::atomic<float>* driveParameter = nullptr;
+    std::atomic<float>* mixParameter = nullptr;
+    std::atomic<float>* crossoverParameter = nullptr;
+
+    template <typename TSample> void prepareSaturator (DSPT<TSample>&, double sampleRate, int samplesPerBlock, int numChannels);
+    void releaseWorkers();
+    template <typename TSample> void pushParameters (DSPT<TSample>&);
+    template <typename TSample> void processSamples (juce::AudioBuffer<TSample>&, DSPT<TSample>&);
+
+    // Message thread, at 30 Hz while prepared: designs the linear-phase kernel after a crossover change, and hands the DSP a preset it
+    // could not take yet; both off the audio thread
+    void timerCallback() override;
+
+    // Session state (DSPPreset.h): the parameters and the structural settings below as one preset
+    DSPPreset currentPreset() const;
+
+    // setStateInformation() designs the preset's filters on its own thread and the next processBlock() swaps them in with a crossfade
+    // (DSP::SubmitPreset()). When the DSP has not taken the previous one yet, the preset waits here for the timer. presetLock keeps the
+    // submissions one at a time, and away from prepareToPlay()
+    void submitPendingPreset();
+    juce::CriticalSection presetLock;
+    DSPPreset pendingPreset;
+    bool presetPending = false;
+
+    // Ring-out of the crossover after the input stops, set in prepareToPlay (the DSP skips the silence once it has decayed)
+    double tailLengthSeconds = 0.0;
+
+    // Low-band oversampling and anti-aliasing, applied in prepareToPlay (both change the reported latency); saved with the session
+    int oversamplingFactor = 2;
+    int oversamplingMode = kOversamplingQuality;
+    int saturationMode = kSaturationNaive;
+
+    // Linear-phase crossover (DSPLinearPhase.h), applied in prepareToPlay; adds the kernel's latency
+    int linearPhaseMode = kLinearPhaseOff;
+    int linearPhaseKernelLength = 4095;
+
+    // Published once per block while telemetryViewers > 0
+    BandMeterBuffer bandMeters;
+    SpectrumAnalyzer spectrumAnalyzer;
+    std::atomic<int> telemetryViewers { 0 };
+
+   #if RRS_RT_INSTRUMENTATION
+    BlockTimingHistogram blockTiming;
+   #endif
 };
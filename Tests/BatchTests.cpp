@@ -0,0 +1,192 @@
+
+// Red Rock Sound (RRS):
+// SaturatorBatch (Source/DSPBatch.h): every voice against the frozen scalar reference with its own settings, on every kernel;
+// voices added and removed inside the arena; per-voice changes leaving the other voices alone.
+
+#include "TestHarness.h"
+#include "GoldenReference.h"
+#include "../Source/DSPBatch.h"
+
+static const TIntegerParamType kVoices = 13;   // a full lane group and a partial one
+static const TIntegerParamType kSamples = 1 << 14;
+static const TIntegerParamType kBlock = 509;
+static const TFloatParamType kFs = 48000.f;
+
+// Worst measured: 8.6e-5 / -92.8 dB, AVX2 on the 150 Hz voice, whose DF2 states run far above the signal (the golden tests stay
+// at 1 kHz). The shared-state form and FMA round a little differently from two separate sections.
+static const double kMaxError = 2e-4, kMaxResidual_dB = -90.0;
+
+static TFloatParamType voice_crossover(TIntegerParamType v) { return 150.f * powf(1.3f, (TFloatParamType) v); }
+static TFloatParamType voice_drive(TIntegerParamType v) { return 1.f + 0.4f * (TFloatParamType) v; }
+static TFloatParamType voice_mix(TIntegerParamType v) { return 1.f - 0.05f * (TFloatParamType) v; }
+static TFloatParamType voice_gain(TIntegerParamType v) { return 0.6f + 0.03f * (TFloatParamType) v; }
+
+static void prepare_batch(SaturatorBatch& b, TIntegerParamType nVoices, TIntegerParamType simd)
+{
+    b.Init();
+    b.SetMaxVoices(nVoices);
+    for (TIntegerParamType v = 0; v < nVoices; ++v)
+        b.AddVoice(voice_crossover(v), voice_drive(v), voice_mix(v), voice_gain(v));
+    b.SetSampleRate(kFs);
+    b.SetSimdLevel(simd);
+}
+
+// Planar, a voice per kSamples
+static void process_batch(SaturatorBatch& b, std::vector<float>& x, TIntegerParamType nVoices, TIntegerParamType nSamples, TIntegerParamType nBlock)
+{
+    std::vector<TAudioSampleType*> ptrs((size_t) nVoices);
+
+    for (TIntegerParamType pos = 0; pos < nSamples; pos += nBlock)
+    {
+        TIntegerParamType n = nSamples - pos < nBlock ? nSamples - pos : nBlock;
+        for (TIntegerParamType v = 0; v < nVoices; ++v)
+            ptrs[(size_t) v] = x.data() + v * nSamples + pos;
+        b.Process(ptrs.data(), nVoices, n);
+    }
+}
+
+TEST(voices_match_golden_reference)
+{
+    std::vector<float> in = white_noise((size_t) (kVoices * kSamples), 0.9f, 11);
+
+    std::vector<float> ref = in;
+    for (TIntegerParamType v = 0; v < kVoices; ++v)
+    {
+        GoldenReference g;
+        g.Prepare(1, voice_crossover(v), kFs, voice_drive(v), voice_mix(v), voice_gain(v));
+        g.Process(ref.data() + v * kSamples, 0, kSamples);
+    }
+
+    for (TIntegerParamType simd : { (TIntegerParamType) kSimdScalar, (TIntegerParamType) kSimdSSE2, (TIntegerParamType) kSimdAVX2 })
+    {
+        SaturatorBatch b;
+        prepare_batch(b, kVoices, simd);
+
+        std::vector<float> out = in;
+        process_batch(b, out, kVoices, kSamples, kBlock);
+        b.Release();
+
+        for (TIntegerParamType v = 0; v < kVoices; ++v)
+        {
+            std::vector<float> r(ref.begin() + v * kSamples, ref.begin() + (v + 1) * kSamples);
+            std::vector<float> y(out.begin() + v * kSamples, out.begin() + (v + 1) * kSamples);
+            double error = max_abs_diff(r, y), residual = residual_db(r, y);
+
+            if (error > kMaxError || residual > kMaxResidual_dB)
+                printf("  simd %d, voice %d: max error %g, residual %.1f dB\n", simd, v, error, residual);
+            CHECK_LE(error, kMaxError);
+            CHECK_LE(residual, kMaxResidual_dB);
+        }
+    }
+}
+
+TEST(voices_come_and_go_inside_the_arena)
+{
+    SaturatorBatch b;
+    prepare_batch(b, 12, kSimdAVX2);
+
+    const void* raw = b._arena.raw;
+    CHECK(b.nVoices == 12);
+    CHECK(b.AddVoice(1000.f, 1.f, 1.f, 1.f) == -1);
+
+    // The lowest free slot is reused, from silence and at its new settings
+    std::vector<float> x = white_noise((size_t) (12 * kBlock), 0.5f, 3);
+    process_batch(b, x, 12, kBlock, kBlock);
+
+    b.RemoveVoice(3);
+    b.RemoveVoice(9);
+    CHECK(b.nVoices == 10);
+    CHECK(! b.IsVoiceActive(3));
+    CHECK(b.AddVoice(voice_crossover(3), voice_drive(3), voice_mix(3), voice_gain(3)) == 3);
+    CHECK(b.w1[3] == 0.f && b.w2[3] == 0.f);
+    CHECK(b._arena.raw == raw);
+
+    // The freed slot is left alone: its buffer is not touched
+    std::vector<float> y = white_noise((size_t) (12 * kBlock), 0.5f, 4), before = y;
+    process_batch(b, y, 12, kBlock, kBlock);
+    CHECK(memcmp(y.data() + 9 * kBlock, before.data() + 9 * kBlock, (size_t) kBlock * sizeof(float)) == 0);
+
+    // ... and the new voice 3 starts exactly like a fresh one
+    SaturatorBatch fresh;
+    prepare_batch(fresh, 12, kSimdAVX2);
+    std::vector<float> z = before;
+    process_batch(fresh, z, 12, kBlock, kBlock);
+    CHECK(memcmp(y.data() + 3 * kBlock, z.data() + 3 * kBlock, (size_t) kBlock * sizeof(float)) == 0);
+
+    fresh.Release();
+    b.Release();
+}
+
+// Moving one voice's crossover and drive changes nothing for its lane neighbours, and leaving a voice out of a block keeps its state
+// and its ramps
+TEST(voices_are_independent)
+{
+    for (TIntegerParamType simd : { (TIntegerParamType) kSimdScalar, (TIntegerParamType) kSimdSSE2, (TIntegerParamType) kSimdAVX2 })
+    {
+        SaturatorBatch a, b;
+        prepare_batch(a, 8, simd);
+        prepare_batch(b, 8, simd);
+
+        std::vector<float> x = white_noise((size_t) (8 * kSamples), 0.7f, 9), y = x;
+        std::vector<TAudioSampleType*> ptrs(8);
+
+        for (TIntegerParamType pos = 0; pos < kSamples; pos += 256)
+        {
+            if (pos == 256 * 8)
+            {
+                b.SetVoiceCrossoverFrequency(5, 4000.f);
+                b.SetVoiceDrive(5, 6.f);
+                b.SetVoiceGain(2, 0.1f);
+            }
+
+            for (TIntegerParamType v = 0; v < 8; ++v)
+                ptrs[(size_t) v] = x.data() + v * kSamples + pos;
+            a.Process(ptrs.data(), 8, 256);
+
+            for (TIntegerParamType v = 0; v < 8; ++v)
+                ptrs[(size_t) v] = y.data() + v * kSamples + pos;
+            b.Process(ptrs.data(), 8, 256);
+        }
+
+        for (TIntegerParamType v : { 0, 1, 3, 4, 6, 7 })
+            CHECK(memcmp(x.data() + v * kSamples, y.data() + v * kSamples, (size_t) kSamples * sizeof(float)) == 0);
+
+        bool bFinite = true;
+        for (float s : y)
+            bFinite = bFinite && std::isfinite(s);
+        CHECK(bFinite);
+        CHECK(max_abs_diff(x, y) > 0.0);
+
+        // A NULL entry skips the voice without advancing it
+        TFloatParamType s1 = b.w1[4], s2 = b.w2[4];
+        std::vector<float> block = white_noise((size_t) (8 * 64), 0.5f, 2);
+        for (TIntegerParamType v = 0; v < 8; ++v)
+            ptrs[(size_t) v] = v == 4 ? NULL : block.data() + v * 64;
+        b.Process(ptrs.data(), 8, 64);
+        CHECK(b.w1[4] == s1 && b.w2[4] == s2);
+
+        // ... nor its ramps: a gain change made before a skip ramps across the next block the voice is in, like one made after it
+        b.SetVoiceGain(4, 0.2f);
+        b.Process(ptrs.data(), 8, 64);
+        a.Process(ptrs.data(), 8, 64);
+        a.SetVoiceGain(4, 0.2f);
+
+        std::vector<float> next = white_noise((size_t) (8 * 64), 0.5f, 6), nextA = next;
+        for (TIntegerParamType v = 0; v < 8; ++v)
+            ptrs[(size_t) v] = next.data() + v * 64;
+        b.Process(ptrs.data(), 8, 64);
+        for (TIntegerParamType v = 0; v < 8; ++v)
+            ptrs[(size_t) v] = nextA.data() + v * 64;
+        a.Process(ptrs.data(), 8, 64);
+        CHECK(memcmp(next.data() + 4 * 64, nextA.data() + 4 * 64, 64 * sizeof(float)) == 0);
+        CHECK(b.gain[4] == 0.2f);
+
+        a.Release();
+        b.Release();
+    }
+}
+
+int main()
+{
+    return run_all_tests();
+}
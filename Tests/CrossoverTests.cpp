@@ -0,0 +1,271 @@
+
+// Red Rock Sound (RRS):
+// Crossover topology tests: the complementary split (high = allpass - low) against the two-filter structure, and the coefficient
+// and state updates when a split moves.
+
+#include "TestHarness.h"
+
+static const float kSampleRates[] = { 44100.f, 48000.f, 96000.f };
+static const float kCrossovers[] = { 40.f, 250.f, 1000.f, 5000.f, 15000.f };
+
+// Low and (inverted) high band of x through one split, in either topology
+static void split(const Filter& f, TIntegerParamType topology, const std::vector<float>& x, std::vector<float>& low, std::vector<float>& high)
+{
+    TFloatParamType ls1 = 0, ls2 = 0, hs1 = 0, hs2 = 0, as = 0;
+    const LRCoefficients lp = f.lpfCoeffs, hp = f.hpfCoeffs;
+
+    low.resize(x.size());
+    high.resize(x.size());
+
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+        low[i] = f.lowpass_filter(x[i], &ls1, &ls2, lp.a0, lp.a1, lp.a2, lp.b1, lp.b2);
+        high[i] = topology == kCrossoverComplementary ? f.allpass_filter(x[i], &as, f.apfCoeff) - low[i]
+                                                      : f.highpass_filter(x[i], &hs1, &hs2, hp.a0, hp.a1, hp.a2, hp.b1, hp.b2);
+    }
+}
+
+TEST(complementary_high_band_matches_magnitude_and_phase)
+{
+    const size_t n = 1 << 15;
+
+    for (float fs : kSampleRates)
+        for (float fc : kCrossovers)
+        {
+            Filter f;
+            f.lpfLRCoeffs(fc, fs);
+            f.hpfLRCoeffs(fc, fs);
+            f.apfLRCoeffs(fc, fs);
+
+            std::vector<float> impulse(n, 0.f), low, highRef, highComp;
+            impulse[0] = 1.f;
+            split(f, kCrossoverTwoFilter, impulse, low, highRef);
+            split(f, kCrossoverComplementary, impulse, low, highComp);
+
+            double maxDb = 0.0, maxPhase = 0.0;
+
+            for (double freq = 10.0; freq < 0.49 * fs; freq *= 1.1)
+            {
+                std::complex<double> ref = response_at(highRef, freq, fs), comp = response_at(highComp, freq, fs);
+
+                // Below -60 dB AP - LP is the difference of two values close to 1 and float cancellation dominates
+                if (abs(ref) < 1e-3)
+                    continue;
+
+                maxDb = std::max(maxDb, fabs(20.0 * log10(abs(comp) / abs(ref))));
+                maxPhase = std::max(maxPhase, fabs(arg(comp / ref)));
+            }
+
+            CHECK_LE(maxDb, 0.1);
+            CHECK_LE(maxPhase, 0.02);
+        }
+}
+
+TEST(complementary_high_band_matches_on_noise)
+{
+    std::vector<float> x = white_noise(1 << 16, 1.f, 1), low, highRef, highComp;
+
+    for (float fs : kSampleRates)
+        for (float fc : kCrossovers)
+        {
+            Filter f;
+            f.lpfLRCoeffs(fc, fs);
+            f.hpfLRCoeffs(fc, fs);
+            f.apfLRCoeffs(fc, fs);
+
+            split(f, kCrossoverTwoFilter, x, low, highRef);
+            split(f, kCrossoverComplementary, x, low, highComp);
+
+            CHECK_LE(residual_db(highRef, highComp), -60.0);
+        }
+}
+
+TEST(complementary_bands_sum_to_allpass)
+{
+    const float fs = 48000.f;
+    const size_t n = 1 << 14;
+
+    for (float fc : kCrossovers)
+    {
+        Filter f;
+        f.lpfLRCoeffs(fc, fs);
+        f.hpfLRCoeffs(fc, fs);
+        f.apfLRCoeffs(fc, fs);
+
+        std::vector<float> impulse(n, 0.f), low, high, sum(n);
+        impulse[0] = 1.f;
+        split(f, kCrossoverComplementary, impulse, low, high);
+
+        for (size_t i = 0; i < n; ++i)
+            sum[i] = low[i] + high[i];
+
+        double maxDev = 0.0;
+        for (double freq = 20.0; freq < 20000.0; freq *= 1.1)
+            maxDev = std::max(maxDev, fabs(abs(response_at(sum, freq, fs)) - 1.0));
+
+        CHECK_LE(maxDev, 1e-3);
+    }
+}
+
+// Whole Process() path with the saturator in the loop, scalar kernels so the topology setting applies
+TEST(process_topologies_agree)
+{
+    const TIntegerParamType nChannels = 2, nSamples = 1 << 14;
+
+    for (TIntegerParamType mode : { kSaturationNaive, kSaturationADAA1 })
+    {
+        std::vector<float> out[2];
+
+        for (TIntegerParamType topology : { kCrossoverTwoFilter, kCrossoverComplementary })
+        {
+            DSP d;
+            prepare_dsp(d, nChannels, 256, 48000.f, 800.f);
+            d.SetSimdLevel(kSimdScalar);
+            d.SetSaturationMode(mode);
+            d.SetCrossoverTopology(topology);
+            d.SetDrive(3.f);
+
+            out[topology] = white_noise((size_t) (nChannels * nSamples), 0.8f, 7);
+            process_planar(d, out[topology], nChannels, nSamples, 256);
+            d.Release();
+        }
+
+        CHECK_LE(residual_db(out[0], out[1]), -80.0);
+    }
+}
+
+TEST(multiband_topologies_agree)
+{
+    const TIntegerParamType nChannels = 2, nSamples = 1 << 14;
+    std::vector<float> out[2];
+
+    for (TIntegerParamType topology : { kCrossoverTwoFilter, kCrossoverComplementary })
+    {
+        DSP d;
+        d.Init();
+        d.SetMaxChannels(nChannels);
+        d.SetMaxBlockSize(512);
+        d.SetCrossoverFrequency(150.f);
+        d.SetBandCrossoverFrequency(1, 900.f);
+        d.SetBandCrossoverFrequency(2, 4000.f);
+        d.SetSampleRate(48000.f);
+        d.SetNumBands(4);
+        d.SetBandBypass(2, false);
+        d.SetCrossoverTopology(topology);
+        d.SetDrive(2.f);
+
+        out[topology] = white_noise((size_t) (nChannels * nSamples), 0.8f, 11);
+        process_planar(d, out[topology], nChannels, nSamples, 512);
+        d.Release();
+    }
+
+    CHECK_LE(residual_db(out[0], out[1]), -80.0);
+}
+
+// Moving a split above 0 remaps its states like split 0 and the preset path do: what the split would output with no more input stays
+TEST(moving_a_band_split_keeps_its_states_output)
+{
+    const TIntegerParamType nChannels = 2, nSamples = 4096;
+
+    DSP d;
+    d.Init();
+    d.SetMaxChannels(nChannels);
+    d.SetMaxBlockSize(512);
+    d.SetCrossoverFrequency(150.f);
+    d.SetBandCrossoverFrequency(1, 900.f);
+    d.SetBandCrossoverFrequency(2, 4000.f);
+    d.SetSampleRate(48000.f);
+    d.SetNumBands(4);
+    d.SetCrossoverTopology(kCrossoverTwoFilter);
+
+    std::vector<float> x = white_noise((size_t) (nChannels * nSamples), 0.8f, 19);
+    process_planar(d, x, nChannels, nSamples, 512);
+
+    const MultibandCrossover& mb = d.multiband;
+    auto zero_input = [](const LRCoefficients& c, double w1, double w2) { return (c.a1 - c.a0 * c.b1) * w1 + (c.a2 - c.a0 * c.b2) * w2; };
+
+    double before[2][2], scale[2];
+    for (TIntegerParamType c = 0; c < nChannels; ++c)
+    {
+        const TIntegerParamType i = mb.nStride + c;
+        before[c][0] = zero_input(mb.splits[1].lpfCoeffs, mb.lowStates1[i], mb.lowStates2[i]);
+        before[c][1] = zero_input(mb.splits[1].hpfCoeffs, mb.highStates1[i], mb.highStates2[i]);
+        scale[c] = fabs(mb.lowStates1[i]) + fabs(mb.lowStates2[i]) + fabs(mb.highStates1[i]) + fabs(mb.highStates2[i]);
+    }
+
+    const TAudioSampleType aOld = mb.splits[1].apfCoeff;
+    d.SetBandCrossoverFrequency(1, 2500.f);
+    CHECK(mb.splits[1].apfCoeff != aOld);
+
+    for (TIntegerParamType c = 0; c < nChannels; ++c)
+    {
+        const TIntegerParamType i = mb.nStride + c;
+        CHECK(scale[c] > 0);
+        CHECK_LE(fabs(zero_input(mb.splits[1].lpfCoeffs, mb.lowStates1[i], mb.lowStates2[i]) - before[c][0]), 1e-5 * scale[c]);
+        CHECK_LE(fabs(zero_input(mb.splits[1].hpfCoeffs, mb.highStates1[i], mb.highStates2[i]) - before[c][1]), 1e-5 * scale[c]);
+    }
+
+    d.Release();
+}
+
+// Cutoff implied by a pole: t = (1 + a) / (1 - a) = tan(pi f / fs)
+static double cutoff_of_pole(double a, double fs)
+{
+    return atan((1.0 + a) / (1.0 - a)) * fs / M_PI;
+}
+
+TEST(coefficient_cache_matches_exact_pole)
+{
+    for (float fs : { 22050.f, 44100.f, 48000.f, 96000.f, 192000.f })
+    {
+        CrossoverCoefficientCache cache;
+        cache.Build(fs);
+
+        double worst = 0.0;
+        for (double f = CrossoverCoefficientCache::kMinFrequency; f < 0.49 * fs; f *= 1.001)
+            worst = std::max(worst, fabs(cutoff_of_pole(cache.Pole((TFloatParamType) f), fs) / f - 1.0));
+
+        CHECK_LE(worst, 1e-3);
+    }
+}
+
+// Crossover changes between blocks take effect without a sample rate change, and land on the exact coefficients
+TEST(set_crossover_frequency_updates_coefficients)
+{
+    DSP d;
+    prepare_dsp(d, 2, 256, 48000.f, 5000.f);
+    d.SetSmoothingTime(0.f);
+
+    std::vector<float> x = white_noise(2 * 256, 0.5f, 13);
+
+    for (float fc : { 80.f, 700.f, 2500.f, 12000.f })
+    {
+        d.SetCrossoverFrequency(fc);
+        process_planar(d, x, 2, 256, 256);
+
+        Filter exact;
+        exact.lpfLRCoeffs(fc, 48000.f);
+        exact.hpfLRCoeffs(fc, 48000.f);
+        exact.apfLRCoeffs(fc, 48000.f);
+        exact.blockLRCoeffs();
+
+        for (TIntegerParamType c = 0; c < 2; ++c)
+        {
+            const Filter& f = d.filters[c];
+            CHECK_LE(fabs(cutoff_of_pole(f.apfCoeff, 48000.0) / fc - 1.0), 1e-3);
+            CHECK_LE(fabs(f.lpfCoeffs.b1 - exact.lpfCoeffs.b1), 1e-4);
+            CHECK_LE(fabs(f.lpfCoeffs.a0 - exact.lpfCoeffs.a0) / exact.lpfCoeffs.a0, 1e-3);
+            CHECK_LE(fabs(f.hpfCoeffs.a0 - exact.hpfCoeffs.a0) / exact.hpfCoeffs.a0, 1e-3);
+            CHECK_LE(fabs(f.lpfBlock.t[0][3] - exact.lpfBlock.t[0][3]), 1e-3);
+        }
+
+        CHECK_LE(fabs(cutoff_of_pole(d.multiband.splits[0].apfCoeff, 48000.0) / fc - 1.0), 1e-3);
+    }
+
+    d.Release();
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,149 @@
+
+// Red Rock Sound (RRS):
+// DSPT<double>: against the float DSP on the same settings (the two must agree to float precision), its SIMD kernels against its
+// scalar path, and the case it is there for: a low crossover at a high sample rate, where the float sections are noisy.
+
+#include "TestHarness.h"
+
+static const DspSetup kPrecisionSetups[] =
+{
+    { "mono",                     1, 1, kOversamplingQuality, kSaturationNaive, 2, kCrossoverTwoFilter },
+    { "stereo",                   2, 1, kOversamplingQuality, kSaturationNaive, 2, kCrossoverTwoFilter },
+    { "5 channels",               5, 1, kOversamplingQuality, kSaturationNaive, 2, kCrossoverTwoFilter },
+    { "stereo complementary",     2, 1, kOversamplingQuality, kSaturationNaive, 2, kCrossoverComplementary },
+    { "stereo os4 ADAA1",         2, 4, kOversamplingQuality, kSaturationADAA1, 2, kCrossoverTwoFilter },
+    { "3 channels 4 bands",       3, 1, kOversamplingQuality, kSaturationNaive, 4, kCrossoverTwoFilter },
+};
+
+static const TIntegerParamType kSamples = 1 << 15;
+static const TIntegerParamType kBlock = 509;
+
+// Planar x through d.Process() in odd-sized blocks, with a crossover glide from block 20 on
+template <typename TSample>
+static std::vector<double> run_precision(DSPT<TSample>& d, const std::vector<float>& x, TIntegerParamType nChannels, bool bGlide)
+{
+    std::vector<TSample> buf(x.begin(), x.end());
+    std::vector<TSample*> ptrs((size_t) nChannels);
+    TIntegerParamType offset = 0;
+
+    for (TIntegerParamType b = 0; offset < kSamples; ++b)
+    {
+        TIntegerParamType n = kSamples - offset < kBlock ? kSamples - offset : kBlock;
+
+        if (bGlide && b == 20)
+            d.SetCrossoverFrequency(2000.f);
+
+        for (TIntegerParamType c = 0; c < nChannels; ++c)
+            ptrs[(size_t) c] = buf.data() + (size_t) c * kSamples + offset;
+
+        d.Process(ptrs.data(), nChannels, n);
+        offset += n;
+    }
+
+    return std::vector<double>(buf.begin(), buf.end());
+}
+
+static double max_abs_diff(const std::vector<double>& a, const std::vector<double>& b)
+{
+    double m = 0.0;
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i)
+        m = std::max(m, fabs(a[i] - b[i]));
+    return m;
+}
+
+TEST(double_matches_float)
+{
+    for (const DspSetup& s : kPrecisionSetups)
+    {
+        std::vector<float> x = white_noise((size_t) (s.nChannels * kSamples), 0.7f, 5);
+
+        DSP f;
+        DSPT<double> d;
+        prepare_setup(f, s, kBlock, 48000.f, 300.f, 3.f, 0.8f);
+        prepare_setup(d, s, kBlock, 48000.f, 300.f, 3.f, 0.8f);
+
+        double diff = max_abs_diff(run_precision(f, x, s.nChannels, true), run_precision(d, x, s.nChannels, true));
+        if (diff > 1e-4)
+            printf("  %s: max difference %g\n", s.name, diff);
+        CHECK_LE(diff, 1e-4);
+
+        f.Release();
+        d.Release();
+    }
+}
+
+TEST(double_kernels_match_scalar)
+{
+    for (const DspSetup& s : kPrecisionSetups)
+    {
+        std::vector<float> x = white_noise((size_t) (s.nChannels * kSamples), 0.7f, 6);
+        std::vector<double> ref;
+
+        for (TIntegerParamType simd : { kSimdScalar, kSimdSSE2, kSimdAVX2 })
+        {
+            DSPT<double> d;
+            prepare_setup(d, s, kBlock, 48000.f, 300.f, 3.f, 0.8f);
+            d.SetSimdLevel(simd);
+
+            std::vector<double> y = run_precision(d, x, s.nChannels, true);
+            d.Release();
+
+            if (simd == kSimdScalar)
+            {
+                ref = y;
+                continue;
+            }
+
+            double diff = max_abs_diff(ref, y);
+            if (diff > 1e-12)
+                printf("  %s, SIMD level %d: max difference %g\n", s.name, simd, diff);
+            CHECK_LE(diff, 1e-12);
+        }
+    }
+}
+
+// With the saturator mixed out, LP + inverted HP is the first-order allpass of the crossover. At 192 kHz a 20 Hz pole sits within
+// 1e-3 of the unit circle and the DF2 states carry the signal with a gain of ~1e6, which float rounding shows and double does not
+TEST(double_flat_sum_at_low_crossover)
+{
+    const DspSetup& s = kPrecisionSetups[1];
+    const TFloatParamType fs = 192000.f, fc = 20.f;
+
+    std::vector<float> x = white_noise((size_t) (s.nChannels * kSamples), 0.5f, 7);
+
+    FilterT<double> exact;
+    exact.apfLRCoeffs(fc, fs);
+
+    std::vector<double> ref(x.size());
+    for (TIntegerParamType c = 0; c < s.nChannels; ++c)
+    {
+        double state = 0.0;
+        for (TIntegerParamType i = 0; i < kSamples; ++i)
+            ref[(size_t) (c * kSamples + i)] = exact.allpass_filter(x[(size_t) (c * kSamples + i)], &state, exact.apfCoeff);
+    }
+
+    for (TIntegerParamType simd : { kSimdScalar, kSimdAVX2 })
+    {
+        DSP f;
+        DSPT<double> d;
+        prepare_setup(f, s, kBlock, fs, fc, 3.f, 0.f);
+        prepare_setup(d, s, kBlock, fs, fc, 3.f, 0.f);
+        f.SetSimdLevel(simd);
+        d.SetSimdLevel(simd);
+
+        double floatError = max_abs_diff(ref, run_precision(f, x, s.nChannels, false));
+        double doubleError = max_abs_diff(ref, run_precision(d, x, s.nChannels, false));
+        if (doubleError > 1e-9 || doubleError * 1000.0 > floatError)
+            printf("  SIMD level %d: float %g, double %g\n", simd, floatError, doubleError);
+        CHECK_LE(doubleError, 1e-9);
+        CHECK_LE(doubleError * 1000.0, floatError);
+
+        f.Release();
+        d.Release();
+    }
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,137 @@
+
+// Red Rock Sound (RRS):
+// Filter kernel tests: the time-parallel (4 samples per step) kernel against the sequential lowpass_filter()/highpass_filter().
+
+#include "TestHarness.h"
+
+static const float kSampleRates[] = { 44100.f, 48000.f, 96000.f, 192000.f };
+static const float kCrossovers[] = { 30.f, 200.f, 1000.f, 5000.f, 18000.f };
+
+static const TIntegerParamType kSamples = 1 << 16;
+static const TIntegerParamType kBlock = 509;   // odd, so every block ends on the scalar tail
+static const TFloatParamType kDrive = 2.f, kMix = 0.7f;
+
+static std::vector<float> run_mono(TIntegerParamType kernel, float fs, float fc, const std::vector<float>& in)
+{
+    DSP d;
+    prepare_dsp(d, 1, kBlock, fs, fc);
+    d.SetFilterKernel(kernel);
+    d.SetSmoothingTime(0.f);
+    d.SetDrive(kDrive);
+    d.SetMix(kMix);
+
+    std::vector<float> out = in;
+    process_planar(d, out, 1, kSamples, kBlock);
+    d.Release();
+    return out;
+}
+
+// The same crossover and saturator in double, from the same float coefficients and the same first-block ramp (no smoothing time)
+static std::vector<float> run_mono_double(float fs, float fc, const std::vector<float>& in)
+{
+    Filter f;
+    f.lpfLRCoeffs(fc, fs);
+    f.hpfLRCoeffs(fc, fs);
+    const LRCoefficients lp = f.lpfCoeffs, hp = f.hpfCoeffs;
+
+    double l1 = 0, l2 = 0, h1 = 0, h2 = 0;
+    std::vector<float> out(in.size());
+
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        double x = in[i];
+        double wl = x - lp.b1 * l1 - lp.b2 * l2;
+        double low = lp.a0 * wl + lp.a1 * l1 + lp.a2 * l2;
+        l2 = l1; l1 = wl;
+        double wh = x - hp.b1 * h1 - hp.b2 * h2;
+        double high = -(hp.a0 * wh + hp.a1 * h1 + hp.a2 * h2);
+        h2 = h1; h1 = wh;
+
+        double t = i < (size_t) kBlock ? (double) i / kBlock : 1.0;
+        double drive = 1.0 + (kDrive - 1.0) * t, mix = 1.0 + (kMix - 1.0) * t;
+        out[i] = (float) (low + mix * (tube_saturation_branchless((float) (drive * low)) - low) + high);
+    }
+
+    return out;
+}
+
+TEST(time_parallel_matches_sequential)
+{
+    std::vector<float> in = white_noise((size_t) kSamples, 0.9f, 3);
+
+    for (float fs : kSampleRates)
+        for (float fc : kCrossovers)
+        {
+            std::vector<float> seq = run_mono(kFilterKernelSequential, fs, fc, in);
+            std::vector<float> par = run_mono(kFilterKernelTimeParallel, fs, fc, in);
+
+            // Low crossovers at high rates put both poles near z = 1, where any float biquad loses precision
+            CHECK_LE(residual_db(seq, par), fc / fs < 1e-3f ? -50.0 : -70.0);
+        }
+}
+
+// Both kernels round differently; the time-parallel one must not be the less accurate one
+TEST(time_parallel_rounding_no_worse_than_sequential)
+{
+    std::vector<float> in = white_noise((size_t) kSamples, 0.9f, 5);
+
+    for (float fs : kSampleRates)
+        for (float fc : kCrossovers)
+        {
+            std::vector<float> ref = run_mono_double(fs, fc, in);
+            double seqDb = residual_db(ref, run_mono(kFilterKernelSequential, fs, fc, in));
+            double parDb = residual_db(ref, run_mono(kFilterKernelTimeParallel, fs, fc, in));
+
+            CHECK_LE(parDb, seqDb + 10.0);
+        }
+}
+
+// Both kernels keep the DF2 states, so switching between blocks is seamless
+TEST(kernels_switch_between_blocks)
+{
+    std::vector<float> in = white_noise((size_t) kSamples, 0.9f, 9);
+    std::vector<float> seq = run_mono(kFilterKernelSequential, 48000.f, 1000.f, in);
+
+    DSP d;
+    prepare_dsp(d, 1, kBlock, 48000.f, 1000.f);
+    d.SetSmoothingTime(0.f);
+    d.SetDrive(kDrive);
+    d.SetMix(kMix);
+
+    std::vector<float> out = in;
+    TIntegerParamType nBlock = 0;
+
+    for (TIntegerParamType offset = 0; offset < kSamples; offset += kBlock, ++nBlock)
+    {
+        TAudioSampleType* p = out.data() + offset;
+        d.SetFilterKernel(nBlock % 2 ? kFilterKernelTimeParallel : kFilterKernelSequential);
+        d.Process(&p, 1, kSamples - offset < kBlock ? kSamples - offset : kBlock);
+    }
+
+    d.Release();
+    CHECK_LE(residual_db(seq, out), -100.0);
+}
+
+// DC through a low crossover drives the DF2 states far above the signal level, so compare each kernel with the double reference
+TEST(time_parallel_impulse_and_dc)
+{
+    for (float fc : kCrossovers)
+    {
+        std::vector<float> impulse((size_t) kSamples, 0.f), dc((size_t) kSamples, 0.25f);
+        impulse[0] = 1.f;
+
+        for (const std::vector<float>* in : { &impulse, &dc })
+        {
+            std::vector<float> ref = run_mono_double(48000.f, fc, *in);
+            double seqErr = max_abs_diff(ref, run_mono(kFilterKernelSequential, 48000.f, fc, *in));
+            double parErr = max_abs_diff(ref, run_mono(kFilterKernelTimeParallel, 48000.f, fc, *in));
+
+            CHECK_LE(parErr, 2.0 * seqErr + 1e-5);
+        }
+    }
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,83 @@
+
+// Red Rock Sound (RRS):
+// Frozen scalar reference of the 2-band DSP::Process(), for the golden tests: per channel an LR2 lowpass and an inverted LR2
+// highpass (Direct Form II, float), the low band driven into the five-segment tube curve and blended with its dry copy, the bands
+// summed, then the output gain. Parameters are fixed for the whole run.
+
+// Self-contained on purpose: nothing here may call into Source/, so optimizing DSP.h can never move the reference along with it.
+// Do not optimize or "fix" this file; a change here changes what every kernel is measured against.
+
+#pragma once
+
+struct GoldenReference
+{
+    struct Section { float a0, a1, a2, b1, b2; };
+
+    Section lp, hp;
+    float drive, mix, gain;
+    std::vector<float> ls1, ls2, hs1, hs2;
+
+    void Prepare(int nChannels, float fCrossover, float fs, float fDrive, float fMix, float fGain)
+    {
+        // a = (t - 1) / (t + 1), t = tan(pi f / fs): both sections share the denominator (1 + a z^-1)^2;
+        // gains normalized from the rounded float denominator (unit LP gain at DC, unit HP gain at Nyquist)
+        double t = tan(M_PI * (double) fCrossover / (double) fs);
+        float a = (float) ((t - 1.0) / (t + 1.0));
+
+        lp.b1 = hp.b1 = 2.0f * a;
+        lp.b2 = hp.b2 = a * a;
+        lp.a0 = (float) ((1.0 + (double) lp.b1 + (double) lp.b2) / 4.0);
+        lp.a1 = 2.0f * lp.a0;
+        lp.a2 = lp.a0;
+        hp.a0 = (float) ((1.0 - (double) hp.b1 + (double) hp.b2) / 4.0);
+        hp.a1 = -2.0f * hp.a0;
+        hp.a2 = hp.a0;
+
+        drive = fDrive;
+        mix = fMix;
+        gain = fGain;
+
+        ls1.assign((size_t) nChannels, 0.f);
+        ls2.assign((size_t) nChannels, 0.f);
+        hs1.assign((size_t) nChannels, 0.f);
+        hs2.assign((size_t) nChannels, 0.f);
+    }
+
+    static float Tube(float x)
+    {
+        const float threshold1 = 1.0f / 3.0f, threshold2 = 2.0f / 3.0f;
+
+        if (x > threshold2)
+            return 1.0f;
+        if (x > threshold1)
+            return (3.0f - (2.0f - 3.0f * x) * (2.0f - 3.0f * x)) / 3.0f;
+        if (x < -threshold2)
+            return -1.0f;
+        if (x < -threshold1)
+            return -(3.0f - (2.0f + 3.0f * x) * (2.0f + 3.0f * x)) / 3.0f;
+        return 2.0f * x;
+    }
+
+    static float Biquad(const Section& s, float x, float& s1, float& s2)
+    {
+        float w = x - s.b1 * s1 - s.b2 * s2;
+        float y = s.a0 * w + s.a1 * s1 + s.a2 * s2;
+        s2 = s1;
+        s1 = w;
+        return y;
+    }
+
+    void Process(float* data, int channel, int n)
+    {
+        size_t c = (size_t) channel;
+
+        for (int i = 0; i < n; ++i)
+        {
+            float x = data[i];
+            float low = Biquad(lp, x, ls1[c], ls2[c]);
+            float high = -Biquad(hp, x, hs1[c], hs2[c]);
+
+            data[i] = gain * (low + mix * (Tube(drive * low) - low) + high);
+        }
+    }
+};
@@ -0,0 +1,232 @@
+
+// Red Rock Sound (RRS):
+// Golden-reference tests: every kernel DSP::Process() can pick (scalar, SSE2, AVX2, time-parallel, complementary topology, multiband
+// tree, cached coefficients) against the frozen scalar path in GoldenReference.h, on sweeps, impulses, noise and DC.
+
+#include "TestHarness.h"
+#include "GoldenReference.h"
+
+static const TIntegerParamType kChannels = 7;  // an AVX2 group of 4, an SSE2 pair and a leftover
+static const TIntegerParamType kSamples = 1 << 15;
+static const TIntegerParamType kBlock = 509;
+static const TFloatParamType kFs = 48000.f, kCrossover = 1000.f, kDrive = 3.f, kMix = 0.8f, kGain = 0.7f;
+
+// Worst measured: 1.3e-5 / -111 dB (AVX2 and the complementary form round differently, one ulp of the states at a time)
+static const double kMaxError = 5e-5, kMaxResidual_dB = -100.0;
+
+struct Variant
+{
+    const char* name;
+    TIntegerParamType simd, kernel, topology;
+    bool bMultiband;
+    bool bCached;   // crossover applied through the coefficient cache instead of SetSampleRate()
+};
+
+static const Variant kVariants[] =
+{
+    { "scalar",                    kSimdScalar, kFilterKernelSequential,   kCrossoverTwoFilter,     false, false },
+    { "scalar time-parallel",      kSimdScalar, kFilterKernelTimeParallel, kCrossoverTwoFilter,     false, false },
+    { "sse2",                      kSimdSSE2,   kFilterKernelSequential,   kCrossoverTwoFilter,     false, false },
+    { "sse2 time-parallel",        kSimdSSE2,   kFilterKernelTimeParallel, kCrossoverTwoFilter,     false, false },
+    { "avx2",                      kSimdAVX2,   kFilterKernelSequential,   kCrossoverTwoFilter,     false, false },
+    { "avx2 time-parallel",        kSimdAVX2,   kFilterKernelTimeParallel, kCrossoverTwoFilter,     false, false },
+    { "scalar complementary",      kSimdScalar, kFilterKernelSequential,   kCrossoverComplementary, false, false },
+    { "sse2 complementary",        kSimdSSE2,   kFilterKernelSequential,   kCrossoverComplementary, false, false },
+    { "multiband tree",            kSimdScalar, kFilterKernelSequential,   kCrossoverTwoFilter,     true,  false },
+    { "multiband complementary",   kSimdScalar, kFilterKernelSequential,   kCrossoverComplementary, true,  false },
+    { "cached coefficients",       kSimdAVX2,   kFilterKernelTimeParallel, kCrossoverTwoFilter,     false, true  },
+};
+
+enum { kSignalSweep = 0, kSignalImpulse, kSignalNoise, kSignalDC, kNumSignals };
+static const char* const kSignalNames[] = { "sweep", "impulse", "noise", "dc" };
+
+// Planar test signal, a different phase/seed per channel so no two lanes see the same input
+static std::vector<float> make_signal(int a_nSignal, TIntegerParamType nChannels, TIntegerParamType nSamples)
+{
+    std::vector<float> x((size_t) (nChannels * nSamples), 0.f);
+
+    for (TIntegerParamType c = 0; c < nChannels; ++c)
+    {
+        float* p = x.data() + (size_t) (c * nSamples);
+
+        switch (a_nSignal)
+        {
+        case kSignalSweep:
+        {
+            // 20 Hz .. 20 kHz exponential sweep
+            const double k = log(1000.0), T = (double) nSamples / kFs;
+            for (TIntegerParamType i = 0; i < nSamples; ++i)
+            {
+                double t = (double) i / kFs;
+                p[i] = (float) (0.8 * sin(2.0 * M_PI * 20.0 * T / k * (exp(t / T * k) - 1.0) + 0.3 * c));
+            }
+            break;
+        }
+        case kSignalImpulse:
+            p[c * 17] = 1.f;
+            break;
+        case kSignalNoise:
+        {
+            std::vector<float> n = white_noise((size_t) nSamples, 0.9f, 100 + (unsigned) c);
+            memcpy(p, n.data(), n.size() * sizeof(float));
+            break;
+        }
+        case kSignalDC:
+            for (TIntegerParamType i = c * 3; i < nSamples; ++i)
+                p[i] = 0.25f + 0.05f * (float) c;
+            break;
+        }
+    }
+
+    return x;
+}
+
+static std::vector<float> run_reference(const std::vector<float>& in, TIntegerParamType nChannels, TIntegerParamType nSamples,
+                                        float fc, float drive, float mix, float gain)
+{
+    GoldenReference ref;
+    ref.Prepare(nChannels, fc, kFs, drive, mix, gain);
+
+    std::vector<float> out = in;
+    for (TIntegerParamType c = 0; c < nChannels; ++c)
+        ref.Process(out.data() + (size_t) (c * nSamples), c, nSamples);
+    return out;
+}
+
+// Parameters go in before SetSampleRate(), so nothing glides and the reference sees the same settings from sample 0
+static void prepare_variant(DSP& d, const Variant& v, TIntegerParamType nChannels, float fc, float drive, float mix, float gain)
+{
+    d.Init();
+    d.SetMaxChannels(nChannels);
+    d.SetMaxBlockSize(kBlock);
+    d.SetCrossoverFrequency(v.bCached ? 5000.f : fc);
+    d.SetDrive(drive);
+    d.SetMix(mix);
+    d.SetGain(gain);
+    d.SetSampleRate(kFs);
+    d.SetSimdLevel(v.simd);
+    d.SetFilterKernel(v.kernel);
+    d.SetCrossoverTopology(v.topology);
+
+    if (v.bCached)
+    {
+        d.SetSmoothingTime(0.f);
+        d.SetCrossoverFrequency(fc);
+
+        // Settle the (zero-input) glide before the signal starts
+        std::vector<float> silence((size_t) (nChannels * kBlock), 0.f);
+        process_planar(d, silence, nChannels, kBlock, kBlock);
+    }
+
+    if (v.bMultiband)
+        d._bMultiband = true;
+}
+
+static std::vector<float> run_variant(const Variant& v, const std::vector<float>& in, TIntegerParamType nChannels, TIntegerParamType nSamples,
+                                      float fc, float drive, float mix, float gain)
+{
+    DSP d;
+    prepare_variant(d, v, nChannels, fc, drive, mix, gain);
+
+    std::vector<float> out = in;
+    process_planar(d, out, nChannels, nSamples, kBlock);
+    d.Release();
+    return out;
+}
+
+TEST(kernels_match_golden_reference)
+{
+    for (int s = 0; s < kNumSignals; ++s)
+    {
+        std::vector<float> in = make_signal(s, kChannels, kSamples);
+        std::vector<float> ref = run_reference(in, kChannels, kSamples, kCrossover, kDrive, kMix, kGain);
+
+        for (const Variant& v : kVariants)
+        {
+            std::vector<float> out = run_variant(v, in, kChannels, kSamples, kCrossover, kDrive, kMix, kGain);
+            double error = max_abs_diff(ref, out), residual = residual_db(ref, out);
+
+            if (error > kMaxError || residual > kMaxResidual_dB)
+                printf("  %s / %s: max error %g, residual %.1f dB\n", v.name, kSignalNames[s], error, residual);
+
+            CHECK_LE(error, kMaxError);
+            CHECK_LE(residual, kMaxResidual_dB);
+        }
+    }
+}
+
+// Mix 0 takes the saturator out: the bands must sum to the allpass, |H| = 1 at every frequency
+TEST(kernels_sum_flat_without_saturation)
+{
+    const TIntegerParamType n = 1 << 14;
+    std::vector<float> in((size_t) (kChannels * n), 0.f);
+    for (TIntegerParamType c = 0; c < kChannels; ++c)
+        in[(size_t) (c * n)] = 1.f;
+
+    for (const Variant& v : kVariants)
+    {
+        std::vector<float> out = run_variant(v, in, kChannels, n, kCrossover, 1.f, 0.f, 1.f);
+
+        for (TIntegerParamType c = 0; c < kChannels; ++c)
+        {
+            std::vector<float> h(out.begin() + c * n, out.begin() + (c + 1) * n);
+            double worst = 0.0;
+
+            for (double f = 20.0; f < 20000.0; f *= 1.25)
+            {
+                double db = 20.0 * log10(std::abs(response_at(h, f, kFs)));
+                worst = fabs(db) > worst ? fabs(db) : worst;
+            }
+
+            CHECK_LE(worst, 1e-3);
+        }
+    }
+}
+
+// Noise riding on DC through a 20 Hz crossover for ~11 minutes: the poles sit at |a| ~ 0.997, the states must stay finite and
+// within what the denominator can gain (x / (1 + a z^-1)^2, at most peak / (1 - |a|)^2)
+TEST(filter_states_stay_bounded_over_long_runs)
+{
+    const TIntegerParamType nChannels = 3, nBlock = 4096;
+    const float fc = 20.f, peak = 0.95f;
+    const int64_t nTotal = (int64_t) kFs * 60 * 11;
+
+    for (TIntegerParamType simd : { (TIntegerParamType) kSimdScalar, (TIntegerParamType) kSimdSSE2, (TIntegerParamType) kSimdAVX2 })
+    {
+        Variant v = { "long run", simd, kFilterKernelTimeParallel, kCrossoverTwoFilter, false, false };
+        DSP d;
+        prepare_variant(d, v, nChannels, fc, kDrive, kMix, 1.f);
+
+        const double a = fabs(d.filters[0].apfCoeff), bound = 2.0 * peak / ((1.0 - a) * (1.0 - a));
+        std::vector<float> noise = white_noise((size_t) (nChannels * nBlock), peak - 0.5f, 7), block((size_t) (nChannels * nBlock));
+        bool bFinite = true;
+        double worst = 0.0;
+
+        for (int64_t pos = 0; pos < nTotal; pos += nBlock)
+        {
+            for (size_t i = 0; i < block.size(); ++i)
+                block[i] = 0.5f + noise[(i + (size_t) pos) % noise.size()];
+            process_planar(d, block, nChannels, nBlock, nBlock);
+
+            for (TIntegerParamType c = 0; c < nChannels; ++c)
+                for (int k : { kStateLow1, kStateLow2, kStateHigh1, kStateHigh2 })
+                {
+                    float w = d._CrossoverStates(c)[k];
+                    bFinite = bFinite && std::isfinite(w);
+                    worst = fabs(w) > worst ? fabs(w) : worst;
+                }
+            for (float y : block)
+                bFinite = bFinite && std::isfinite(y);
+        }
+
+        d.Release();
+
+        CHECK(bFinite);
+        CHECK_LE(worst, bound);
+    }
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,292 @@
+
+// Red Rock Sound (RRS):
+// DSP::ProcessInterleaved() and the sample format kernels of Source/DSPFormats.h: interleaved float, 16-bit and packed 24-bit
+// frames against Process() on the same signal deinterleaved by hand, the SIMD conversions against the scalar ones, and the dither.
+
+#include "TestHarness.h"
+
+static const TIntegerParamType kMaxBlock = 1024;
+static const TIntegerParamType kFrames = 12000;
+
+template <typename TSample>
+static void prepare_interleaved(DSPT<TSample>& d, TIntegerParamType nChannels)
+{
+    d.Init();
+    d.SetMaxChannels(nChannels);
+    d.SetMaxBlockSize(kMaxBlock);
+    d.SetCrossoverFrequency(700.f);
+    d.SetDrive(3.f);
+    d.SetSampleRate(48000.f);
+}
+
+// Call lengths of every size, from single frames to several chunks at once
+static TIntegerParamType call_length(TIntegerParamType k)
+{
+    return 1 + (k * 389) % 1500;
+}
+
+// The reference: the frames converted with the scalar kernels, deinterleaved, and run through Process() in the same chunks as
+// ProcessInterleaved() uses, with the same parameter change halfway
+template <typename TSample, typename TFrame>
+static std::vector<TSample> reference_output(const std::vector<TFrame>& frames, TIntegerParamType nChannels)
+{
+    DSPT<TSample> d;
+    prepare_interleaved(d, nChannels);
+
+    std::vector<TSample> x(frames.size());
+    if constexpr (std::is_same<TFrame, int16_t>::value)
+        int16_to_samples_scalar(frames.data(), x.data(), frames.size());
+    else if constexpr (std::is_same<TFrame, Int24>::value)
+        int24_to_samples_scalar(frames.data(), x.data(), frames.size());
+    else
+        x.assign(frames.begin(), frames.end());
+
+    std::vector<TSample> planar((size_t) (nChannels * d._nInterleavedChunk));
+    std::vector<TSample*> ptrs((size_t) nChannels);
+    TIntegerParamType offset = 0;
+
+    for (TIntegerParamType k = 0; offset < kFrames; ++k)
+    {
+        TIntegerParamType nCall = call_length(k) < kFrames - offset ? call_length(k) : kFrames - offset;
+
+        if (offset >= kFrames / 2 && offset - nCall < kFrames / 2)
+            d.SetCrossoverFrequency(3000.f);
+
+        for (TIntegerParamType chunk = 0; chunk < nCall; chunk += d._nInterleavedChunk)
+        {
+            TIntegerParamType n = nCall - chunk < d._nInterleavedChunk ? nCall - chunk : d._nInterleavedChunk;
+            TSample* interleaved = x.data() + (size_t) (offset + chunk) * nChannels;
+
+            for (TIntegerParamType c = 0; c < nChannels; ++c)
+            {
+                ptrs[(size_t) c] = planar.data() + c * d._nInterleavedChunk;
+                for (TIntegerParamType i = 0; i < n; ++i)
+                    ptrs[(size_t) c][i] = interleaved[(size_t) i * nChannels + c];
+            }
+
+            d.Process(ptrs.data(), nChannels, n);
+
+            for (TIntegerParamType c = 0; c < nChannels; ++c)
+                for (TIntegerParamType i = 0; i < n; ++i)
+                    interleaved[(size_t) i * nChannels + c] = ptrs[(size_t) c][i];
+        }
+
+        offset += nCall;
+    }
+
+    d.Release();
+    return x;
+}
+
+template <typename TSample, typename TFrame>
+static std::vector<TFrame> run_interleaved(std::vector<TFrame> frames, TIntegerParamType nChannels)
+{
+    DSPT<TSample> d;
+    prepare_interleaved(d, nChannels);
+
+    TIntegerParamType offset = 0;
+
+    for (TIntegerParamType k = 0; offset < kFrames; ++k)
+    {
+        TIntegerParamType nCall = call_length(k) < kFrames - offset ? call_length(k) : kFrames - offset;
+
+        if (offset >= kFrames / 2 && offset - nCall < kFrames / 2)
+            d.SetCrossoverFrequency(3000.f);
+
+        d.ProcessInterleaved(frames.data() + (size_t) offset * nChannels, nChannels, nCall);
+        offset += nCall;
+    }
+
+    d.Release();
+    return frames;
+}
+
+static std::vector<int16_t> random_int16(size_t n, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(-24000, 24000);
+    std::vector<int16_t> x(n);
+    for (int16_t& v : x)
+        v = (int16_t) dist(rng);
+    return x;
+}
+
+static std::vector<Int24> random_int24(size_t n, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int32_t> dist(-6000000, 6000000);
+    std::vector<Int24> x(n);
+    for (Int24& v : x)
+    {
+        uint32_t u = (uint32_t) dist(rng);
+        v = { { (uint8_t) u, (uint8_t) (u >> 8), (uint8_t) (u >> 16) } };
+    }
+    return x;
+}
+
+TEST(interleaved_float_matches_planar)
+{
+    for (TIntegerParamType nChannels : { 1, 2, 5, 8 })
+    {
+        std::vector<float> x = white_noise((size_t) (kFrames * nChannels), 0.7f, 5 + nChannels);
+
+        std::vector<float> reference = reference_output<float>(x, nChannels);
+        std::vector<float> y = run_interleaved<float>(x, nChannels);
+
+        bool bSame = memcmp(reference.data(), y.data(), y.size() * sizeof(float)) == 0;
+        if (! bSame)
+            printf("  %d channels: max difference %g\n", nChannels, max_abs_diff(reference, y));
+        CHECK(bSame);
+    }
+}
+
+// Without dither the integer outputs are the rounded reference, to the bit
+template <typename TSample, typename TFrame>
+static void check_integer_frames(const std::vector<TFrame>& frames, TIntegerParamType nChannels)
+{
+    std::vector<TSample> reference = reference_output<TSample>(frames, nChannels);
+    std::vector<TFrame> y = run_interleaved<TSample>(frames, nChannels);
+
+    std::vector<TFrame> expected(y.size());
+    if constexpr (std::is_same<TFrame, int16_t>::value)
+        samples_to_int16_scalar(reference.data(), expected.data(), reference.size(), NULL);
+    else
+        samples_to_int24_scalar(reference.data(), expected.data(), reference.size(), NULL);
+
+    bool bSame = memcmp(expected.data(), y.data(), y.size() * sizeof(TFrame)) == 0;
+    if (! bSame)
+        printf("  %d channels, %d-byte frames, %d-byte samples differ\n", nChannels, (int) sizeof(TFrame), (int) sizeof(TSample));
+    CHECK(bSame);
+}
+
+TEST(integer_frames_match_planar)
+{
+    for (TIntegerParamType nChannels : { 1, 2, 6 })
+    {
+        std::vector<int16_t> s16 = random_int16((size_t) (kFrames * nChannels), 7);
+        std::vector<Int24> s24 = random_int24((size_t) (kFrames * nChannels), 8);
+
+        check_integer_frames<float>(s16, nChannels);
+        check_integer_frames<float>(s24, nChannels);
+        check_integer_frames<double>(s16, nChannels);
+        check_integer_frames<double>(s24, nChannels);
+    }
+}
+
+TEST(simd_conversions_match_scalar)
+{
+    TIntegerParamType level = simd_detect_level();
+    const size_t n = 1003;
+
+    // Past full scale both ways, so the saturation is covered too
+    std::vector<float> x = white_noise(n, 1.5f, 9);
+    x[0] = 1.f;
+    x[1] = -1.f;
+
+    for (bool bDither : { false, true })
+    {
+        uint32_t ditherScalar[4], ditherSimd[4];
+        dither_seed(ditherScalar, 3);
+        dither_seed(ditherSimd, 3);
+
+        std::vector<int16_t> s16Scalar(n), s16Simd(n);
+        samples_to_int16_scalar(x.data(), s16Scalar.data(), n, bDither ? ditherScalar : NULL);
+        convert_to_int(x.data(), s16Simd.data(), n, bDither ? ditherSimd : NULL, level);
+        CHECK(s16Scalar == s16Simd);
+
+        std::vector<Int24> s24Scalar(n), s24Simd(n);
+        samples_to_int24_scalar(x.data(), s24Scalar.data(), n, bDither ? ditherScalar : NULL);
+        convert_to_int(x.data(), s24Simd.data(), n, bDither ? ditherSimd : NULL, level);
+        CHECK(memcmp(s24Scalar.data(), s24Simd.data(), n * sizeof(Int24)) == 0);
+        CHECK(memcmp(ditherScalar, ditherSimd, sizeof(ditherScalar)) == 0);
+
+        std::vector<float> yScalar(n), ySimd(n);
+        int16_to_samples_scalar(s16Scalar.data(), yScalar.data(), n);
+        convert_from_int(s16Scalar.data(), ySimd.data(), n, level);
+        CHECK(yScalar == ySimd);
+
+        int24_to_samples_scalar(s24Scalar.data(), yScalar.data(), n);
+        convert_from_int(s24Scalar.data(), ySimd.data(), n, level);
+        CHECK(yScalar == ySimd);
+    }
+}
+
+TEST(integer_round_trip_and_saturation)
+{
+    TIntegerParamType level = simd_detect_level();
+
+    // Every 16-bit value, and a 24-bit value every 127 codes, come back unchanged
+    std::vector<int16_t> s16(65536), s16Back(65536);
+    for (size_t i = 0; i < s16.size(); ++i)
+        s16[i] = (int16_t) (i - 32768);
+
+    std::vector<float> x(s16.size());
+    convert_from_int(s16.data(), x.data(), x.size(), level);
+    convert_to_int(x.data(), s16Back.data(), x.size(), NULL, level);
+    CHECK(s16 == s16Back);
+
+    std::vector<Int24> s24, s24Back;
+    for (int32_t v = -8388608; v < 8388608; v += 127)
+        s24.push_back({ { (uint8_t) v, (uint8_t) (v >> 8), (uint8_t) (v >> 16) } });
+    s24Back.resize(s24.size());
+
+    x.resize(s24.size());
+    convert_from_int(s24.data(), x.data(), x.size(), level);
+    convert_to_int(x.data(), s24Back.data(), x.size(), NULL, level);
+    CHECK(memcmp(s24.data(), s24Back.data(), s24.size() * sizeof(Int24)) == 0);
+
+    const float full[] = { 1.f, -1.f, 2.f, -2.f, 0.5f, -0.5f, 1e-9f, 0.f };
+    int16_t out[8];
+    convert_to_int(full, out, 8, NULL, level);
+    CHECK(out[0] == 32767 && out[1] == -32768 && out[2] == 32767 && out[3] == -32768);
+    CHECK(out[4] == 16384 && out[5] == -16384 && out[6] == 0 && out[7] == 0);
+}
+
+TEST(tpdf_dither_linearizes_below_one_lsb)
+{
+    const size_t n = 1 << 18;
+
+    // 0.3 LSB: plain rounding loses it, dithered it survives on average
+    std::vector<float> x(n, 0.3f / 32768.f);
+    std::vector<int16_t> plain(n), dithered(n);
+
+    convert_to_int(x.data(), plain.data(), n, NULL, simd_detect_level());
+
+    uint32_t dither[4];
+    dither_seed(dither, 11);
+    convert_to_int(x.data(), dithered.data(), n, dither, simd_detect_level());
+
+    double mean = 0, meanSquare = 0;
+    bool bZero = true, bInRange = true;
+    for (size_t i = 0; i < n; ++i)
+    {
+        bZero = bZero && plain[i] == 0;
+        bInRange = bInRange && dithered[i] >= -1 && dithered[i] <= 1;
+        mean += dithered[i];
+    }
+    mean /= (double) n;
+
+    CHECK(bZero);
+    CHECK(bInRange);
+    CHECK_LE(fabs(mean - 0.3), 0.01);
+
+    // The draws themselves: triangular over [-1, 1), so zero mean and a variance of 1/6
+    mean = 0;
+    dither_seed(dither, 12);
+    for (size_t i = 0; i < n; ++i)
+    {
+        double d = dither_draw<double>(dither[i & 3]);
+        mean += d;
+        meanSquare += d * d;
+    }
+    mean /= (double) n;
+    meanSquare /= (double) n;
+
+    CHECK_LE(fabs(mean), 0.005);
+    CHECK_LE(fabs(meanSquare - 1.0 / 6.0), 0.005);
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,326 @@
+
+// Red Rock Sound (RRS):
+// Linear-phase split of Source/DSPLinearPhase.h: the real FFT against a direct DFT, the partitioned convolution (both layouts)
+// against a direct FIR of the designed taps, the kernel's symmetry and LR2 magnitude, the reported latency, the long segments'
+// work spread evenly over their blocks, and the kernel handover after a crossover change.
+
+#include "TestHarness.h"
+
+static const TFloatParamType kFs = 48000.f;
+
+static void check_fft(TIntegerParamType nSize)
+{
+    MemoryArena arena;
+    arena.Init();
+    RealFftT<double> fft;
+    fft.Prepare(arena, nSize);
+    arena.Reserve(arena.used);
+    fft.Prepare(arena, nSize);
+
+    std::mt19937 rng(nSize);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> x((size_t) nSize), re((size_t) nSize / 2 + 1), im((size_t) nSize / 2 + 1), y((size_t) nSize);
+    std::vector<double> workRe((size_t) nSize / 2), workIm((size_t) nSize / 2);
+    for (double& v : x)
+        v = dist(rng);
+
+    fft.Forward(x.data(), re.data(), im.data(), workRe.data(), workIm.data());
+
+    double maxError = 0;
+    for (TIntegerParamType k = 0; k <= nSize / 2; ++k)
+    {
+        std::complex<double> sum = 0;
+        for (TIntegerParamType n = 0; n < nSize; ++n)
+            sum += x[(size_t) n] * std::polar(1.0, -2.0 * M_PI * k * n / nSize);
+
+        maxError = fmax(maxError, std::abs(sum - std::complex<double>(re[(size_t) k], im[(size_t) k])));
+    }
+    CHECK_LE(maxError, 1e-10 * nSize);
+
+    fft.Inverse(re.data(), im.data(), y.data(), workRe.data(), workIm.data());
+
+    maxError = 0;
+    for (TIntegerParamType n = 0; n < nSize; ++n)
+        maxError = fmax(maxError, fabs(y[(size_t) n] / (nSize / 2) - x[(size_t) n]));
+    CHECK_LE(maxError, 1e-12 * nSize);
+
+    arena.Release();
+}
+
+TEST(real_fft_matches_dft_and_inverts)
+{
+    for (TIntegerParamType nSize : { 4, 16, 128, 2048 })
+        check_fft(nSize);
+}
+
+template <typename TSample>
+static void prepare_linear_phase(DSPT<TSample>& d, TIntegerParamType nMode, TIntegerParamType nKernel, TFloatParamType fCrossover)
+{
+    d.Init();
+    d.SetMaxChannels(2);
+    d.SetMaxBlockSize(1024);
+    d.SetCrossoverFrequency(fCrossover);
+    d.SetMix(0.f);
+    d.SetSampleRate(kFs);
+    d.SetLinearPhase(nMode, nKernel);
+}
+
+// Runs x through the split of channel 0 in calls of varying length, the way Process() brackets them
+template <typename TSample>
+static std::vector<TSample> split_low(DSPT<TSample>& d, std::vector<TSample> x, TIntegerParamType nSwitchAt = -1, TFloatParamType fSwitchTo = 0)
+{
+    std::vector<TSample> low(x.size());
+    TIntegerParamType offset = 0;
+
+    for (TIntegerParamType k = 0; offset < (TIntegerParamType) x.size(); ++k)
+    {
+        TIntegerParamType n = 1 + (k * 613) % 1024;
+        n = n < (TIntegerParamType) x.size() - offset ? n : (TIntegerParamType) x.size() - offset;
+
+        if (nSwitchAt >= 0 && offset <= nSwitchAt && nSwitchAt < offset + n)
+        {
+            d.SetCrossoverFrequency(fSwitchTo);
+            CHECK(d.UpdateLinearPhaseKernel());
+            CHECK(! d.UpdateLinearPhaseKernel());
+        }
+
+        d.linearPhase.BeginBlock();
+        d.linearPhase.Split(0, x.data() + offset, low.data() + offset, n);
+        d.linearPhase.EndBlock();
+        offset += n;
+    }
+
+    return low;
+}
+
+// x through the designed taps, directly, and delayed by the latency
+static std::vector<double> direct_low(const std::vector<double>& x, TIntegerParamType nKernel, TFloatParamType fCrossover, TIntegerParamType nLatency)
+{
+    std::vector<double> taps((size_t) nKernel), y(x.size(), 0.0);
+    LinearPhaseCrossoverT<double>::DesignTaps(taps.data(), nKernel, fCrossover, kFs);
+
+    const TIntegerParamType nShift = nLatency - (nKernel - 1) / 2;
+    for (size_t t = (size_t) nShift; t < x.size(); ++t)
+        for (size_t k = 0; k < taps.size() && k <= t - nShift; ++k)
+            y[t] += taps[k] * x[t - nShift - k];
+
+    return y;
+}
+
+TEST(partitioned_convolution_matches_direct_fir)
+{
+    for (TIntegerParamType nMode : { kLinearPhaseUniform, kLinearPhaseLowLatency })
+        for (TIntegerParamType nKernel : { 63, 1001, 4095 })
+        {
+            DSPT<double> d;
+            prepare_linear_phase(d, nMode, nKernel, 700.f);
+
+            std::mt19937 rng(nKernel);
+            std::uniform_real_distribution<double> dist(-1.0, 1.0);
+            std::vector<double> x(20000);
+            for (double& v : x)
+                v = dist(rng);
+
+            std::vector<double> low = split_low(d, x);
+            std::vector<double> expected = direct_low(x, d.linearPhase.nKernelLength, 700.f, d.linearPhase.nLatency);
+
+            double maxError = 0;
+            for (size_t t = 0; t < x.size(); ++t)
+                maxError = fmax(maxError, fabs(low[t] - expected[t]));
+
+            if (maxError > 1e-9)
+                printf("  mode %d, %d taps: max error %g\n", nMode, nKernel, maxError);
+            CHECK_LE(maxError, 1e-9);
+
+            d.Release();
+        }
+}
+
+TEST(low_band_is_symmetric_with_lr2_magnitude)
+{
+    const TIntegerParamType nKernel = 4095;
+    std::vector<double> taps((size_t) nKernel);
+    LinearPhaseCrossoverT<double>::DesignTaps(taps.data(), nKernel, 1000.f, kFs);
+
+    double maxAsymmetry = 0;
+    for (TIntegerParamType n = 0; n < nKernel; ++n)
+        maxAsymmetry = fmax(maxAsymmetry, fabs(taps[(size_t) n] - taps[(size_t) (nKernel - 1 - n)]));
+    CHECK(maxAsymmetry == 0);
+
+    // |LP| of the LR2 low-pass, against the zero-phase response of the taps
+    const double a = FilterT<double>::_lrPole(1000.f, kFs);
+    const double g = (1.0 + a) * (1.0 + a) / 4.0;
+
+    for (double f : { 50.0, 300.0, 1000.0, 3000.0, 10000.0 })
+    {
+        std::complex<double> z = std::polar(1.0, 2.0 * M_PI * f / kFs);
+        std::complex<double> lp = g * (1.0 + 1.0 / z) * (1.0 + 1.0 / z) / ((1.0 + a / z) * (1.0 + a / z));
+
+        double h = 0;
+        for (TIntegerParamType n = 0; n < nKernel; ++n)
+            h += taps[(size_t) n] * cos(2.0 * M_PI * f / kFs * (n - (nKernel - 1) / 2));
+
+        CHECK_LE(fabs(h - std::abs(lp)), 1e-4);
+    }
+}
+
+TEST(bands_sum_to_the_delayed_input_at_the_reported_latency)
+{
+    for (TIntegerParamType nMode : { kLinearPhaseUniform, kLinearPhaseLowLatency })
+    {
+        DSP d;
+        prepare_linear_phase(d, nMode, 2047, 500.f);
+
+        const TIntegerParamType nLatency = d.GetLatencySamples();
+        CHECK(nLatency == 1023 + (nMode == kLinearPhaseUniform ? 256 : 64));
+
+        // An impulse, then silence: the skipped-silence path must not cut it off inside the delay lines
+        const TIntegerParamType nSamples = 8192, nBlock = 512;
+        std::vector<float> x = white_noise((size_t) (2 * nSamples), 0.5f, 3);
+        for (TIntegerParamType c = 0; c < 2; ++c)
+        {
+            std::fill(x.begin() + c * nSamples + nSamples / 2, x.begin() + (c + 1) * nSamples, 0.f);
+            x[(size_t) (c * nSamples + nSamples / 2 - 1)] = 1.f;
+        }
+
+        std::vector<float> y = x;
+        process_planar(d, y, 2, nSamples, nBlock);
+
+        double maxError = 0;
+        for (TIntegerParamType c = 0; c < 2; ++c)
+            for (TIntegerParamType t = 0; t < nSamples; ++t)
+            {
+                float expected = t >= nLatency ? x[(size_t) (c * nSamples + t - nLatency)] : 0.f;
+                maxError = fmax(maxError, fabs(y[(size_t) (c * nSamples + t)] - expected));
+            }
+        CHECK_LE(maxError, 1e-6);
+
+        // Oversampling delays the whole path further, by its own latency
+        d.SetOversampling(2, kOversamplingQuality);
+        CHECK(d.GetLatencySamples() == nLatency + d._nLatency);
+        CHECK(d._nLatency > 0);
+
+        d.Release();
+    }
+}
+
+TEST(long_segments_spread_their_work_over_a_block)
+{
+    DSPT<double> d;
+    prepare_linear_phase(d, kLinearPhaseLowLatency, 32767, 700.f);
+
+    LinearPhaseCrossoverT<double>& lp = d.linearPhase;
+    CHECK(lp.segments[0].nBlock == 64 && ! lp.segments[0].bSpread);
+    CHECK(lp.segments[lp.nSegments - 1].nBlock == 4096);
+
+    std::vector<double> x = std::vector<double>(64), low(64);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    TIntegerParamType nWorst[LinearPhaseCrossoverT<double>::kMaxSegments] = {}, nFair[LinearPhaseCrossoverT<double>::kMaxSegments] = {};
+
+    // A block of the first segment per call: every call runs one step of each spread segment's job
+    for (int64_t t = 0; t < 3 * 4096 + 64; t += 64)
+    {
+        TIntegerParamType nBefore[LinearPhaseCrossoverT<double>::kMaxSegments] = {};
+        for (TIntegerParamType s = 1; s < lp.nSegments; ++s)
+        {
+            const LinearPhaseCrossoverT<double>::Job& job = lp.segments[s].jobs[0];
+            nBefore[s] = job.nUnitsLeft;
+
+            // The previous block is finished by the time the next one starts, one block after its own start
+            if (t > lp.segments[s].nBlock && t % lp.segments[s].nBlock == 0)
+                CHECK(job.nStage == job.nStages && job.nUnitsLeft == 0);
+        }
+
+        for (double& v : x)
+            v = dist(rng);
+
+        lp.BeginBlock();
+        lp.Split(0, x.data(), low.data(), 64);
+        lp.EndBlock();
+
+        for (TIntegerParamType s = 1; s < lp.nSegments; ++s)
+        {
+            const LinearPhaseCrossoverT<double>::Segment& seg = lp.segments[s];
+            const LinearPhaseCrossoverT<double>::Job& job = seg.jobs[0];
+            if (t == 0 || job.nStages == 0)
+                continue;
+
+            TIntegerParamType nTotal = 0;
+            for (TIntegerParamType n = 0; n < job.nStages; ++n)
+            {
+                LinearPhaseCrossoverT<double>::JobStage stage = lp._JobStage(seg, n);
+                nTotal += stage.nLength * stage.nWeight;
+            }
+
+            TIntegerParamType nDone = (t % seg.nBlock == 0 ? nTotal : nBefore[s]) - job.nUnitsLeft;
+            nWorst[s] = nDone > nWorst[s] ? nDone : nWorst[s];
+            nFair[s] = nTotal / (seg.nBlock / 64);
+        }
+    }
+
+    // Within a slice's rounding of the even share, never the whole block at once
+    for (TIntegerParamType s = 1; s < lp.nSegments; ++s)
+    {
+        CHECK(nFair[s] > 0);
+        CHECK_LE(nWorst[s], nFair[s] + 8);
+    }
+
+    d.Release();
+}
+
+TEST(kernel_switch_crossfades_between_old_and_new)
+{
+    for (TIntegerParamType nMode : { kLinearPhaseUniform, kLinearPhaseLowLatency })
+    {
+        DSPT<double> d;
+        prepare_linear_phase(d, nMode, 1001, 400.f);
+
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        std::vector<double> x(24000);
+        for (double& v : x)
+            v = dist(rng);
+
+        const TIntegerParamType nSwitch = 9000;
+        std::vector<double> low = split_low(d, x, nSwitch, 3000.f);
+
+        const TIntegerParamType nLatency = d.linearPhase.nLatency;
+        std::vector<double> before = direct_low(x, 1001, 400.f, nLatency);
+        std::vector<double> after = direct_low(x, 1001, 3000.f, nLatency);
+
+        // Old kernel up to the call that picked up the switch, new one a partition or two later, and in between nothing louder
+        // than either
+        const size_t nFadeEnd = (size_t) (nSwitch + 1024 + 2 * d.linearPhase.segments[d.linearPhase.nSegments - 1].nBlock + nLatency);
+        double errorBefore = 0, errorAfter = 0, peakFade = 0, peakEither = 0;
+
+        for (size_t t = 0; t < x.size(); ++t)
+        {
+            if (t < (size_t) nSwitch - 1024)
+                errorBefore = fmax(errorBefore, fabs(low[t] - before[t]));
+            else if (t >= nFadeEnd)
+                errorAfter = fmax(errorAfter, fabs(low[t] - after[t]));
+            else
+            {
+                peakFade = fmax(peakFade, fabs(low[t]));
+                peakEither = fmax(peakEither, fmax(fabs(before[t]), fabs(after[t])));
+            }
+        }
+
+        CHECK_LE(errorBefore, 1e-9);
+        CHECK_LE(errorAfter, 1e-9);
+        CHECK_LE(peakFade, 1.1 * peakEither);
+        CHECK(d.linearPhase.adopted.load() == 1);
+
+        // Nothing left to build: same frequency again
+        d.SetCrossoverFrequency(3000.f);
+        CHECK(! d.UpdateLinearPhaseKernel());
+
+        d.Release();
+    }
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,322 @@
+
+// Red Rock Sound (RRS):
+// Telemetry of Source/DSPMetering.h: the triple buffer under a concurrent writer and reader, the SIMD meter kernels against the
+// scalar one, the band meters of both paths on signals of known level, the output left alone by metering, and the analyzer thread.
+
+#include "TestHarness.h"
+
+#include <thread>
+
+static const TFloatParamType kFs = 48000.f;
+
+struct CounterFrame
+{
+    uint64_t values[64];
+};
+
+TEST(triple_buffer_hands_over_whole_frames_in_order)
+{
+    TripleBufferT<CounterFrame> buffer;
+    const uint64_t nFrames = 200000;
+    std::atomic<bool> bDone { false };
+
+    std::thread writer([&]
+    {
+        for (uint64_t n = 1; n <= nFrames; ++n)
+        {
+            CounterFrame& f = buffer.WriteSlot();
+            for (uint64_t& v : f.values)
+                v = n;
+            buffer.Publish();
+        }
+        bDone.store(true);
+    });
+
+    uint64_t last = 0, nSeen = 0;
+    bool bTorn = false, bBackwards = false;
+
+    for (bool bFinal = false; ! bFinal; )
+    {
+        bFinal = bDone.load();
+
+        if (! buffer.Update())
+            continue;
+
+        const CounterFrame& f = buffer.Read();
+        for (uint64_t v : f.values)
+            bTorn = bTorn || v != f.values[0];
+
+        bBackwards = bBackwards || f.values[0] <= last;
+        last = f.values[0];
+        ++nSeen;
+    }
+
+    writer.join();
+
+    CHECK(! bTorn);
+    CHECK(! bBackwards);
+    CHECK(last == nFrames);     // the last one is never lost
+    CHECK(nSeen > 0);
+    CHECK(! buffer.Update());   // and nothing is handed over twice
+}
+
+TEST(simd_meter_kernels_match_scalar)
+{
+    for (size_t n : { (size_t) 1, (size_t) 7, (size_t) 64, (size_t) 1001 })
+    {
+        std::vector<float> x = white_noise(n, 0.9f, (unsigned) n);
+        std::vector<double> xd(x.begin(), x.end());
+
+        MeterSums reference = { 0, 0, 0 };
+        meter_block_scalar(xd.data(), (TIntegerParamType) n, 0.3, reference);
+
+        for (TIntegerParamType level = kSimdScalar; level <= simd_detect_level(); ++level)
+        {
+            MeterSums sf = { 0, 0, 0 }, sd = { 0, 0, 0 };
+            meter_block(x.data(), (TIntegerParamType) n, 0.3f, sf, level);
+            meter_block(xd.data(), (TIntegerParamType) n, 0.3, sd, level);
+
+            CHECK(sf.peak == reference.peak && sd.peak == reference.peak);
+            CHECK(sf.nActive == reference.nActive && sd.nActive == reference.nActive);
+            CHECK_LE(fabs(sf.sumSquares - reference.sumSquares), 1e-5 * reference.sumSquares);
+            CHECK_LE(fabs(sd.sumSquares - reference.sumSquares), 1e-12 * reference.sumSquares);
+        }
+    }
+}
+
+static std::vector<float> two_tones(TIntegerParamType nSamples, float lowAmplitude, float highAmplitude)
+{
+    std::vector<float> x((size_t) nSamples);
+    for (TIntegerParamType t = 0; t < nSamples; ++t)
+        x[(size_t) t] = lowAmplitude * sinf(2.f * (float) M_PI * 60.f * t / kFs) + highAmplitude * sinf(2.f * (float) M_PI * 12000.f * t / kFs);
+    return x;
+}
+
+// Planar stereo of the same signal through d in blocks of 256, with telemetry into meters
+static void run_metered(DSP& d, BandMeterBuffer& meters, const std::vector<float>& mono)
+{
+    const TIntegerParamType nSamples = (TIntegerParamType) mono.size();
+    std::vector<float> x(2 * mono.size());
+    std::copy(mono.begin(), mono.end(), x.begin());
+    std::copy(mono.begin(), mono.end(), x.begin() + nSamples);
+
+    d.SetTelemetry(&meters, NULL);
+    process_planar(d, x, 2, nSamples, 256);
+}
+
+TEST(band_meters_read_the_level_of_each_band)
+{
+    // Crossover at 1 kHz: the 60 Hz tone is the low band, the 12 kHz one the high band
+    DSP d;
+    prepare_dsp(d, 2, 256, kFs, 1000.f);
+    d.SetDrive(1.f);
+
+    BandMeterBuffer meters;
+    run_metered(d, meters, two_tones(48000, 0.25f, 0.1f));
+
+    CHECK(meters.Update());
+    const BandMeterFrame& f = meters.Read();
+
+    CHECK(f.nBands == 2);
+    CHECK(f.nBlocks == 48000 / 256 + 1);
+    CHECK_LE(fabs(f.peak[0] - 0.25), 0.01);
+    CHECK_LE(fabs(f.rms[0] - 0.25 / sqrt(2.0)), 0.01);
+    CHECK_LE(fabs(f.peak[1] - 0.1), 0.01);
+    CHECK_LE(fabs(f.rms[1] - 0.1 / sqrt(2.0)), 0.01);
+
+    // Drive 1 keeps 0.25 under the knee at 1/3; drive 4 takes most of the cycle past it, and the high band is never saturated
+    CHECK(f.activity[0] == 0.f);
+    CHECK(f.activity[1] == 0.f);
+
+    // Two seconds, so the zero activity of the first run has averaged out
+    d.SetDrive(4.f);
+    run_metered(d, meters, two_tones(96000, 0.25f, 0.1f));
+    CHECK(meters.Update());
+
+    // |sin| > 1/3 for 1 - 2 asin(1/3) / pi of the time
+    CHECK_LE(fabs(meters.Read().activity[0] - (1.0 - 2.0 * asin(1.0 / 3.0) / M_PI)), 0.02);
+    CHECK(meters.Read().activity[1] == 0.f);
+
+    // Silence: the peaks fall back, by kPeakRelease_s per e-fold
+    run_metered(d, meters, std::vector<float>(24000, 0.f));
+    CHECK(meters.Update());
+    CHECK_LE(meters.Read().peak[0], 0.25 * exp(-0.5 / BandMeterFrame::kPeakRelease_s) * 1.05);
+    CHECK_LE(meters.Read().rms[0], 0.25 * exp(-0.25 / BandMeterFrame::kAverage_s));
+
+    d.Release();
+}
+
+TEST(multiband_meters_cover_every_band)
+{
+    DSP d;
+    // The crossovers are LR2: an octave or more away from either tone, the neighbouring band hears it only faintly
+    prepare_dsp(d, 2, 256, kFs, 600.f);
+    d.SetNumBands(3);
+    d.SetBandCrossoverFrequency(1, 2000.f);
+    d.SetBandBypass(1, true);
+
+    BandMeterBuffer meters;
+    run_metered(d, meters, two_tones(48000, 0.25f, 0.1f));
+    CHECK(meters.Update());
+
+    const BandMeterFrame& f = meters.Read();
+    CHECK(f.nBands == 3);
+    CHECK_LE(fabs(f.rms[0] - 0.25 / sqrt(2.0)), 0.01);
+    CHECK_LE(f.rms[1], 0.01);
+    CHECK_LE(fabs(f.rms[2] - 0.1 / sqrt(2.0)), 0.01);
+
+    d.Release();
+}
+
+// One frame of meters over nSamples of x (planar), at SIMD level simd with filter kernel kernel; blocks of 250 leave every kernel a tail
+template <typename TSample>
+static BandMeterFrame metered_frame(const std::vector<float>& x, TIntegerParamType nChannels, TIntegerParamType nSamples, TIntegerParamType simd,
+                                    TIntegerParamType kernel)
+{
+    DSPT<TSample> d;
+    d.Init();
+    d.SetMaxChannels(nChannels);
+    d.SetMaxBlockSize(250);
+    d.SetCrossoverFrequency(700.f);
+    d.SetDrive(10.f);
+    d.SetSampleRate(kFs);
+    d.SetSimdLevel(simd);
+    d.SetFilterKernel(kernel);
+
+    BandMeterBuffer meters;
+    d.SetTelemetry(&meters, NULL);
+
+    std::vector<TSample> y(x.begin(), x.end());
+    std::vector<TSample*> ptrs((size_t) nChannels);
+
+    for (TIntegerParamType offset = 0; offset < nSamples; offset += 250)
+    {
+        for (TIntegerParamType c = 0; c < nChannels; ++c)
+            ptrs[(size_t) c] = y.data() + (size_t) (c * nSamples + offset);
+        d.Process(ptrs.data(), nChannels, 250);
+    }
+
+    d.Release();
+    meters.Update();
+    return meters.Read();
+}
+
+TEST(fused_kernels_meter_like_the_scalar_path)
+{
+    // The scalar level is the reference; every SIMD level and kernel sums the same in its lanes, tails included
+    const TIntegerParamType nSamples = 12000;
+
+    for (TIntegerParamType nChannels : { 1, 2, 3, 4, 6 })
+    {
+        std::vector<float> x = white_noise((size_t) (nChannels * nSamples), 0.5f, (unsigned) nChannels);
+        const BandMeterFrame ref = metered_frame<float>(x, nChannels, nSamples, kSimdScalar, kFilterKernelSequential);
+        const BandMeterFrame refDouble = metered_frame<double>(x, nChannels, nSamples, kSimdScalar, kFilterKernelSequential);
+
+        CHECK(ref.activity[0] > 0.1f && ref.rms[1] > 0.1f);
+
+        for (TIntegerParamType simd = kSimdSSE2; simd <= simd_detect_level(); ++simd)
+            for (TIntegerParamType kernel : { kFilterKernelSequential, kFilterKernelTimeParallel })
+            {
+                const BandMeterFrame f = metered_frame<float>(x, nChannels, nSamples, simd, kernel);
+                const BandMeterFrame fd = metered_frame<double>(x, nChannels, nSamples, simd, kernel);
+
+                for (TIntegerParamType b = 0; b < 2; ++b)
+                {
+                    CHECK_LE(fabs(f.peak[b] - ref.peak[b]), 1e-5);
+                    CHECK_LE(fabs(f.rms[b] - ref.rms[b]), 1e-4 * ref.rms[b]);
+                    CHECK_LE(fabs(f.activity[b] - ref.activity[b]), 1e-3);
+
+                    CHECK_LE(fabs(fd.peak[b] - refDouble.peak[b]), 1e-6);
+                    CHECK_LE(fabs(fd.rms[b] - refDouble.rms[b]), 1e-6 * refDouble.rms[b]);
+                    CHECK_LE(fabs(fd.activity[b] - refDouble.activity[b]), 1e-3);
+                }
+            }
+    }
+}
+
+TEST(metering_leaves_the_output_alone)
+{
+    std::vector<float> x = white_noise(2 * 24000, 0.5f, 4);
+
+    for (bool bMultiband : { false, true })
+    {
+        DSP plain, metered;
+        prepare_dsp(plain, 2, 256, kFs, 700.f);
+        prepare_dsp(metered, 2, 256, kFs, 700.f);
+        plain.SetDrive(3.f);
+        metered.SetDrive(3.f);
+        plain.SetNumBands(bMultiband ? 3 : 2);
+        metered.SetNumBands(bMultiband ? 3 : 2);
+
+        BandMeterBuffer meters;
+        SpectrumAnalyzer analyzer;
+        metered.SetTelemetry(&meters, &analyzer);
+
+        std::vector<float> a = x, b = x;
+        process_planar(plain, a, 2, 24000, 256);
+        process_planar(metered, b, 2, 24000, 256);
+
+        // Bit for bit: the kernels and the scalar path meter beside the same arithmetic
+        CHECK(max_abs_diff(a, b) == 0.0);
+
+        plain.Release();
+        metered.Release();
+    }
+}
+
+TEST(analyzer_finds_a_tone_on_its_bin)
+{
+    SpectrumAnalyzer analyzer;
+    analyzer.SetSampleRate(kFs);
+
+    // Nothing is taken while nobody looks
+    std::vector<float> tone(4096);
+    float* channels[1] = { tone.data() };
+    analyzer.Push(channels, 1, 4096);
+    CHECK(analyzer.writePos.load() == 0);
+
+    analyzer.Open();
+
+    // Bin 44, at full scale, in stereo: the mono sum reads the same
+    const TIntegerParamType kBin = 44;
+    std::vector<float> left(512), right(512);
+    float* stereo[2] = { left.data(), right.data() };
+    TIntegerParamType t = 0;
+
+    for (int block = 0; block < 64; ++block)
+    {
+        for (TIntegerParamType i = 0; i < 512; ++i, ++t)
+            left[(size_t) i] = right[(size_t) i] = sinf(2.f * (float) M_PI * kBin * t / SpectrumFrame::kFftSize);
+
+        analyzer.Push(stereo, 2, 512);
+    }
+
+    // The FIFO holds all of it, so the worker analyzes every hop: wait for the last one, whatever the scheduling, and the frame read
+    // is always the same
+    const uint64_t nLast = 64 * 512 / SpectrumAnalyzer::kHop;
+    uint64_t nFrames = 0;
+    for (int wait = 0; wait < 2000 && nFrames < nLast; ++wait)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (analyzer.spectra.Update())
+            nFrames = analyzer.spectra.Read().nFrames;
+    }
+
+    analyzer.Close();
+    CHECK(nFrames == nLast);
+
+    const SpectrumFrame& f = analyzer.spectra.Read();
+    CHECK(f.fSampleRate == kFs);
+    CHECK_LE(fabs(f.magnitude_dB[kBin]), 0.1);
+
+    // Hann leaks into the neighbours at -6 dB; further out only the onset, still falling off the smoothing, and far away nothing
+    CHECK_LE(fabs(f.magnitude_dB[kBin + 1] + 6.02), 0.1);
+    for (TIntegerParamType k = 0; k < SpectrumFrame::kBins; ++k)
+        CHECK_LE(f.magnitude_dB[k], k < kBin - 1 || k > kBin + 1 ? -40.0 : 0.1);
+    CHECK_LE(f.magnitude_dB[400], -80.0);
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,181 @@
+
+// Red Rock Sound (RRS):
+// Chunked parallel offline processing against one serial DSP::Process() run over the same signal, and the oversampled path
+// run in empty and odd-sized blocks against the same signal in whole ones.
+
+#include "TestHarness.h"
+#include "../Source/DSPOffline.h"
+
+struct OfflineSetup
+{
+    TIntegerParamType nChannels = 2;
+    TIntegerParamType nBlock = 512;
+    TFloatParamType fs = 48000.f;
+    TFloatParamType crossover = 100.f;
+    TFloatParamType drive = 4.f;
+    TIntegerParamType oversampling = 1;
+    TIntegerParamType oversamplingMode = kOversamplingQuality;
+    TIntegerParamType saturationMode = kSaturationNaive;
+    TIntegerParamType bands = 2;
+
+    void operator()(DSP& d) const
+    {
+        d.Init();
+        d.SetMaxChannels(nChannels);
+        d.SetMaxBlockSize(nBlock);
+        d.SetCrossoverFrequency(crossover);
+        d.SetNumBands(bands);
+        for (TIntegerParamType k = 1; k < bands - 1; ++k)
+            d.SetBandCrossoverFrequency(k, crossover * (TFloatParamType) (4 << (2 * k)));
+        d.SetDrive(drive);
+        d.SetSampleRate(fs);
+        d.SetOversampling(oversampling, oversamplingMode);
+        d.SetSaturationMode(saturationMode);
+    }
+};
+
+// Largest difference of the parallel run to the serial one; checks the seam report on the way
+static double parallel_vs_serial(const OfflineSetup& setup, TIntegerParamType nSamples, TIntegerParamType nThreads, OfflineProcessResult& r)
+{
+    std::vector<float> x = white_noise((size_t) (setup.nChannels * nSamples), 0.5f, 11);
+    std::vector<float> serial = x, parallel(x.size());
+
+    DSP d;
+    setup(d);
+    process_planar(d, serial, setup.nChannels, nSamples, setup.nBlock);
+    d.Release();
+
+    std::vector<const TAudioSampleType*> in((size_t) setup.nChannels);
+    std::vector<TAudioSampleType*> out((size_t) setup.nChannels);
+    for (TIntegerParamType c = 0; c < setup.nChannels; ++c)
+    {
+        in[(size_t) c] = x.data() + (size_t) (c * nSamples);
+        out[(size_t) c] = parallel.data() + (size_t) (c * nSamples);
+    }
+
+    r = process_offline_parallel(setup, in.data(), out.data(), setup.nChannels, nSamples, nThreads);
+    return max_abs_diff(serial, parallel);
+}
+
+TEST(parallel_matches_serial_within_bound)
+{
+    OfflineSetup setup;
+    OfflineProcessResult r;
+    double error = parallel_vs_serial(setup, 1 << 18, 4, r);
+
+    CHECK(r.nChunks == 4);
+    CHECK(r.nPreRoll > 0);
+    CHECK(r.bVerified);
+    CHECK_LE(error, r.errorBound);
+    CHECK_LE(r.seamError, 2.0 * error + 1e-7);  // the overlap measures the same seams
+}
+
+TEST(parallel_matches_serial_with_oversampling)
+{
+    for (TIntegerParamType mode : { (TIntegerParamType) kOversamplingQuality, (TIntegerParamType) kOversamplingLowLatency })
+    {
+        OfflineSetup setup;
+        setup.crossover = 300.f;
+        setup.oversampling = 4;
+        setup.oversamplingMode = mode;
+        setup.saturationMode = kSaturationADAA2;
+
+        OfflineProcessResult r;
+        double error = parallel_vs_serial(setup, 1 << 17, 3, r);
+
+        CHECK(r.nChunks == 3);
+        CHECK(r.bVerified);
+        CHECK_LE(error, r.errorBound);
+    }
+}
+
+TEST(oversampling_takes_empty_and_odd_blocks)
+{
+    const TIntegerParamType nSamples = 8192;
+    const TIntegerParamType sizes[] = { 0, 1, 7, 0, 255, 3, 0, 511 };
+
+    for (TIntegerParamType factor : { 2, 4, 8 })
+        for (TIntegerParamType mode : { (TIntegerParamType) kOversamplingQuality, (TIntegerParamType) kOversamplingLowLatency })
+        {
+            OfflineSetup setup;
+            setup.crossover = 300.f;
+            setup.oversampling = factor;
+            setup.oversamplingMode = mode;
+            setup.saturationMode = kSaturationADAA1;
+
+            std::vector<float> whole = white_noise((size_t) (setup.nChannels * nSamples), 0.5f, 5), pieces = whole;
+
+            DSP d;
+            setup(d);
+            process_planar(d, whole, setup.nChannels, nSamples, setup.nBlock);
+            d.Release();
+
+            // An empty block (hosts send them) in between every few others, and odd lengths that leave the pad mid-way
+            setup(d);
+            std::vector<TAudioSampleType*> ptrs((size_t) setup.nChannels);
+            for (TIntegerParamType k = 0, offset = 0; offset < nSamples; ++k)
+            {
+                TIntegerParamType n = sizes[k % (TIntegerParamType) (sizeof(sizes) / sizeof(sizes[0]))];
+                n = n < nSamples - offset ? n : nSamples - offset;
+                for (TIntegerParamType c = 0; c < setup.nChannels; ++c)
+                    ptrs[(size_t) c] = pieces.data() + (size_t) (c * nSamples + offset);
+                d.Process(ptrs.data(), setup.nChannels, n);
+                offset += n;
+            }
+            d.Release();
+
+            double error = max_abs_diff(whole, pieces);
+            if (error > 1e-6)
+                printf("  %dx, mode %d: max difference %g\n", factor, mode, error);
+            CHECK_LE(error, 1e-6);
+        }
+}
+
+TEST(parallel_matches_serial_multiband)
+{
+    OfflineSetup setup;
+    setup.bands = 4;
+
+    OfflineProcessResult r;
+    double error = parallel_vs_serial(setup, 1 << 17, 4, r);
+
+    CHECK(r.nChunks == 4);
+    CHECK(r.bVerified);
+    CHECK_LE(error, r.errorBound);
+}
+
+TEST(short_signal_runs_as_one_chunk)
+{
+    OfflineSetup setup;
+    setup.crossover = 20.f;
+
+    OfflineProcessResult r;
+    double error = parallel_vs_serial(setup, 4096, 8, r);
+
+    CHECK(r.nChunks == 1);
+    CHECK(error == 0.0);
+}
+
+TEST(settling_grows_as_the_pole_nears_the_unit_circle)
+{
+    TIntegerParamType previous = 0;
+
+    for (TFloatParamType f : { 5000.f, 1000.f, 100.f, 20.f })
+    {
+        OfflineSetup setup;
+        setup.crossover = f;
+
+        DSP d;
+        setup(d);
+        TIntegerParamType n = d.GetSettlingSamples(1e-6f);
+        d.Release();
+
+        CHECK(n > previous);
+        previous = n;
+    }
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,142 @@
+
+// Red Rock Sound (RRS):
+// Parameter smoothing tests: glide times, output gain, and crossover automation without zipper noise.
+
+#include "TestHarness.h"
+
+TEST(smoother_reaches_target_after_length)
+{
+    ParameterSmoother s;
+    s.Reset(0.f);
+    s.length = 1000;
+    s.SetTarget(1.f);
+
+    TIntegerParamType done = 0;
+    TFloatParamType start, inc, last = 0.f;
+
+    for (TIntegerParamType n : { 100, 37, 512, 64, 500 })
+    {
+        s.Next(n, start, inc);
+        CHECK(start >= last);
+        CHECK_LE(inc, 1.f / 1000.f * 1.0001f);
+        last = start + inc * n;
+        done += n;
+    }
+
+    CHECK(! s.IsRamping());
+    CHECK(s.current == 1.f);
+
+    // Retargeting mid-glide continues from the current value
+    s.SetTarget(0.f);
+    s.Next(500, start, inc);
+    CHECK(start == 1.f);
+    CHECK_LE(fabs(start + inc * 500 - 0.5f), 1e-6);
+}
+
+TEST(gain_is_applied_after_the_glide)
+{
+    const TIntegerParamType n = 4800;
+    std::vector<float> ref = white_noise((size_t) (2 * n), 0.5f, 21), out = ref;
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        DSP d;
+        prepare_dsp(d, 2, 480, 48000.f, 1000.f);
+        if (pass == 1)
+            d.SetGain(0.5f);
+        process_planar(d, pass == 0 ? ref : out, 2, n, 480);
+        d.Release();
+    }
+
+    // 20 ms default glide = 960 samples; compare the rest
+    double worst = 0.0;
+    for (TIntegerParamType c = 0; c < 2; ++c)
+        for (TIntegerParamType i = 960; i < n; ++i)
+            worst = std::max(worst, (double) fabs(out[(size_t) (c * n + i)] - 0.5f * ref[(size_t) (c * n + i)]));
+
+    CHECK_LE(worst, 1e-6);
+}
+
+// Largest second difference of a signal: steps in the output show up here, a smooth sine stays at (2 pi f / fs)^2
+static double max_second_difference(const std::vector<float>& x, size_t from)
+{
+    double m = 0.0;
+    for (size_t i = from + 2; i < x.size(); ++i)
+        m = std::max(m, fabs((double) x[i] - 2.0 * x[i - 1] + x[i - 2]));
+    return m;
+}
+
+TEST(crossover_automation_does_not_zipper)
+{
+    const TIntegerParamType n = 48000, block = 256;
+    const double f = 300.0, fs = 48000.0;
+    double peak[2];
+
+    for (int smoothed = 0; smoothed < 2; ++smoothed)
+    {
+        DSP d;
+        prepare_dsp(d, 1, block, (TFloatParamType) fs, 100.f);
+        d.SetSmoothingTime(smoothed ? 20.f : 0.f);
+        d.SetMix(0.f);  // the crossover alone: low + high is an allpass, so only coefficient steps disturb the sine
+
+        std::vector<float> x((size_t) n);
+        for (TIntegerParamType i = 0; i < n; ++i)
+            x[(size_t) i] = (float) (0.5 * sin(2.0 * M_PI * f * i / fs));
+
+        for (TIntegerParamType offset = 0, k = 0; offset < n; offset += block, ++k)
+        {
+            // Hard jumps across the sine every block, as a fast automation burst would do
+            d.SetCrossoverFrequency(k % 2 ? 150.f : 2000.f);
+            TAudioSampleType* p = x.data() + offset;
+            d.Process(&p, 1, block < n - offset ? block : n - offset);
+        }
+
+        peak[smoothed] = max_second_difference(x, 4800);
+        d.Release();
+    }
+
+    double sine = 0.5 * pow(2.0 * M_PI * f / fs, 2.0);
+    // The glide itself bends the phase a little, but no more than a few times the sine's own curvature
+    CHECK_LE(peak[1], 4.0 * sine);
+    CHECK_LE(peak[1], 0.1 * peak[0]);
+}
+
+TEST(automation_burst_stays_finite)
+{
+    const TIntegerParamType n = 1 << 15;
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> u(0.f, 1.f);
+
+    DSP d;
+    prepare_dsp(d, 2, 64, 44100.f, 1000.f);
+    std::vector<float> x = white_noise((size_t) (2 * n), 1.f, 17);
+    std::vector<TAudioSampleType*> p(2);
+
+    for (TIntegerParamType offset = 0; offset < n; offset += 64)
+    {
+        d.SetCrossoverFrequency(20.f + 19980.f * u(rng));
+        d.SetDrive(1.f + 9.f * u(rng));
+        d.SetMix(u(rng));
+        d.SetGain(2.f * u(rng));
+        p[0] = x.data() + offset;
+        p[1] = x.data() + n + offset;
+        d.Process(p.data(), 2, 64);
+    }
+
+    double peak = 0.0;
+    bool finite = true;
+    for (float v : x)
+    {
+        finite = finite && std::isfinite(v);
+        peak = std::max(peak, (double) fabs(v));
+    }
+
+    CHECK(finite);
+    CHECK_LE(peak, 8.0);
+    d.Release();
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,290 @@
+
+// Red Rock Sound (RRS):
+// Presets of Source/DSPPreset.h: the binary form (round trip, byte layout, what a reader rejects and what it skips), the DSP's
+// GetPreset()/ApplyPreset(), and the switch through SubmitPreset(): handover, crossfade, and where the output ends up.
+
+#include "TestHarness.h"
+
+static const TFloatParamType kFs = 48000.f;
+
+static DSPPreset sample_preset()
+{
+    DSPPreset p;
+    p.gain = 0.7f;
+    p.drive = 3.5f;
+    p.mix = 0.8f;
+    p.smoothing_ms = 12.f;
+    p.nBands = 4;
+    for (int k = 0; k < DSPPreset::kMaxSplits; ++k)
+        p.splitFrequency_Hz[k] = 150.f * (float) (k + 1) * (float) (k + 1);
+    for (int b = 0; b < DSPPreset::kMaxBands; ++b)
+        p.bandAmount[b] = 0.5f + 0.25f * (float) b;
+    p.bandBypass = 0x52;
+    p.oversampling = 4;
+    p.oversamplingMode = kOversamplingLowLatency;
+    p.saturationMode = kSaturationADAA2;
+    p.topology = kCrossoverComplementary;
+    p.linearPhaseMode = kLinearPhaseUniform;
+    p.linearPhaseKernel = 2047;
+    return p;
+}
+
+static bool same_preset(const DSPPreset& a, const DSPPreset& b)
+{
+    bool bSame = a.gain == b.gain && a.drive == b.drive && a.mix == b.mix && a.smoothing_ms == b.smoothing_ms && a.nBands == b.nBands &&
+                 a.bandBypass == b.bandBypass && a.oversampling == b.oversampling && a.oversamplingMode == b.oversamplingMode &&
+                 a.saturationMode == b.saturationMode && a.topology == b.topology && a.linearPhaseMode == b.linearPhaseMode &&
+                 a.linearPhaseKernel == b.linearPhaseKernel;
+
+    for (int k = 0; k < DSPPreset::kMaxSplits; ++k)
+        bSame = bSame && a.splitFrequency_Hz[k] == b.splitFrequency_Hz[k];
+    for (int n = 0; n < DSPPreset::kMaxBands; ++n)
+        bSame = bSame && a.bandAmount[n] == b.bandAmount[n];
+
+    return bSame;
+}
+
+TEST(binary_form_round_trips_with_a_fixed_layout)
+{
+    DSPPreset p = sample_preset(), q;
+    uint8_t bytes[DSPPreset::kBytes];
+
+    CHECK(preset_write(p, bytes) == DSPPreset::kBytes);
+    CHECK(preset_read(bytes, sizeof(bytes), q));
+    CHECK(same_preset(p, q));
+
+    // "RRSP", version 1, payload size, then the gain as a little-endian float
+    const uint8_t header[] = { 'R', 'R', 'S', 'P', 1, 0, (uint8_t) DSPPreset::kPayloadBytesV1, 0 };
+    CHECK(memcmp(bytes, header, sizeof(header)) == 0);
+
+    DSPPreset defaults;
+    preset_write(defaults, bytes);
+    const uint8_t unity[] = { 0x00, 0x00, 0x80, 0x3f };
+    CHECK(memcmp(bytes + DSPPreset::kHeaderBytes, unity, 4) == 0);
+}
+
+TEST(reader_rejects_what_it_cannot_take_and_skips_what_it_does_not_know)
+{
+    DSPPreset p = sample_preset(), q;
+    std::vector<uint8_t> bytes(DSPPreset::kBytes);
+    preset_write(p, bytes.data());
+
+    CHECK(! preset_read(NULL, 0, q));
+    CHECK(! preset_read(bytes.data(), bytes.size() - 1, q));
+
+    std::vector<uint8_t> bad = bytes;
+    bad[0] = 'X';
+    CHECK(! preset_read(bad.data(), bad.size(), q));
+
+    bad = bytes;
+    bad[4] = 0;
+    CHECK(! preset_read(bad.data(), bad.size(), q));
+
+    bad = bytes;
+    _preset_put_f32(bad.data() + DSPPreset::kHeaderBytes + 4, std::numeric_limits<float>::quiet_NaN());
+    CHECK(! preset_read(bad.data(), bad.size(), q));
+
+    // A rejected read leaves the preset alone
+    CHECK(same_preset(q, DSPPreset()));
+
+    // A later version with fields appended: the known ones come through, the rest is skipped
+    std::vector<uint8_t> newer = bytes;
+    newer.insert(newer.end(), { 0xde, 0xad, 0xbe, 0xef });
+    _preset_put_u16(newer.data() + 4, 2);
+    _preset_put_u16(newer.data() + 6, (uint32_t) DSPPreset::kPayloadBytesV1 + 4);
+    CHECK(preset_read(newer.data(), newer.size(), q));
+    CHECK(same_preset(p, q));
+}
+
+TEST(reader_rejects_structural_settings_outside_their_enums)
+{
+    DSPPreset p = sample_preset(), q;
+    std::vector<uint8_t> bytes(DSPPreset::kBytes);
+    preset_write(p, bytes.data());
+
+    // The structural fields close the version 1 payload: oversampling, its mode, saturation, topology, linear phase, kernel (u16)
+    const size_t structural = DSPPreset::kBytes - 7;
+    const struct { size_t offset; uint8_t value; } damaged[] =
+    {
+        { structural, 0 }, { structural, 3 }, { structural, 16 },
+        { structural + 1, kOversamplingLowLatency + 1 },
+        { structural + 2, kSaturationADAA2 + 1 }, { structural + 2, 7 },
+        { structural + 3, kCrossoverComplementary + 1 },
+        { structural + 4, kLinearPhaseLowLatency + 1 },
+    };
+
+    for (const auto& d : damaged)
+    {
+        std::vector<uint8_t> bad = bytes;
+        bad[d.offset] = d.value;
+        CHECK(! preset_read(bad.data(), bad.size(), q));
+    }
+
+    // Kernel lengths outside 63 .. 32767
+    for (uint32_t nKernel : { 0u, 62u, 32768u, 65535u })
+    {
+        std::vector<uint8_t> bad = bytes;
+        _preset_put_u16(bad.data() + structural + 5, nKernel);
+        CHECK(! preset_read(bad.data(), bad.size(), q));
+    }
+    CHECK(same_preset(q, DSPPreset()));
+
+    // The ends of every range still read
+    for (uint32_t nKernel : { 63u, 32767u })
+    {
+        _preset_put_u16(bytes.data() + structural + 5, nKernel);
+        CHECK(preset_read(bytes.data(), bytes.size(), q) && q.linearPhaseKernel == (int32_t) nKernel);
+    }
+}
+
+TEST(apply_then_get_gives_the_preset_back)
+{
+    DSPPreset p = sample_preset(), q;
+
+    DSP d;
+    prepare_dsp(d, 2, 512, kFs, 1000.f);
+    d.ApplyPreset(p);
+    d.GetPreset(q);
+    CHECK(same_preset(p, q));
+
+    CHECK(d.GetLatencySamples() == 0);      // 4 bands: the tree, which has no latency
+    CHECK(d._nOversampling == 4 && d._bLinearPhase && d._nTopology == kCrossoverComplementary);
+
+    d.Release();
+}
+
+// Stereo noise through d in blocks of 256; before block nSwitch, p is submitted
+static std::vector<float> run_switch(DSP& d, const std::vector<float>& x, TIntegerParamType nSamples, TIntegerParamType nSwitch, const DSPPreset* p)
+{
+    std::vector<float> y = x;
+    std::vector<TAudioSampleType*> ptrs(2);
+
+    for (TIntegerParamType offset = 0, block = 0; offset < nSamples; offset += 256, ++block)
+    {
+        if (p != NULL && block == nSwitch)
+            CHECK(d.SubmitPreset(*p));
+
+        for (TIntegerParamType c = 0; c < 2; ++c)
+            ptrs[(size_t) c] = y.data() + (size_t) c * nSamples + offset;
+        d.Process(ptrs.data(), 2, 256);
+    }
+
+    return y;
+}
+
+TEST(submitted_preset_is_swapped_in_with_a_crossfade)
+{
+    for (TIntegerParamType topology : { kCrossoverTwoFilter, kCrossoverComplementary })
+    {
+        const TIntegerParamType nSamples = 188 * 256, nSwitch = 40;
+
+        // A 90 Hz tone under noise, low band saturated; the preset moves the crossover from 200 Hz to 2 kHz and changes drive
+        std::vector<float> x = white_noise((size_t) (2 * nSamples), 0.05f, 6);
+        for (TIntegerParamType c = 0; c < 2; ++c)
+            for (TIntegerParamType t = 0; t < nSamples; ++t)
+                x[(size_t) (c * nSamples + t)] += 0.4f * sinf(2.f * (float) M_PI * 90.f * t / kFs);
+
+        DSPPreset from, to;
+        from.splitFrequency_Hz[0] = 200.f;
+        from.drive = 2.f;
+        from.mix = 1.f;
+        to = from;
+        to.splitFrequency_Hz[0] = 2000.f;
+        to.drive = 3.f;
+
+        auto prepare = [&](DSP& d, const DSPPreset& p)
+        {
+            prepare_dsp(d, 2, 256, kFs, p.splitFrequency_Hz[0]);
+            d.SetCrossoverTopology(topology);
+            d.ApplyPreset(p);
+            d.SetSampleRate(kFs);
+        };
+
+        DSP switched, before, after;
+        prepare(switched, from);
+        prepare(before, from);
+        prepare(after, to);
+
+        std::vector<float> y = run_switch(switched, x, nSamples, nSwitch, &to);
+        std::vector<float> yBefore = run_switch(before, x, nSamples, -1, NULL);
+        std::vector<float> yAfter = run_switch(after, x, nSamples, -1, NULL);
+
+        // Taken at the next block, and nothing else pending
+        DSPPreset q;
+        switched.GetPreset(q);
+        CHECK(q.splitFrequency_Hz[0] == 2000.f && q.drive == 3.f);
+        CHECK(switched.SubmitPreset(to));
+
+        const TIntegerParamType tSwitch = nSwitch * 256;
+        const TIntegerParamType nFade = (TIntegerParamType) (DSP::kPresetFade_ms * 0.001f * kFs);
+        double errorBefore = 0, errorAfter = 0, stepFade = 0, stepEither = 0;
+
+        for (TIntegerParamType c = 0; c < 2; ++c)
+            for (TIntegerParamType t = 1; t < nSamples; ++t)
+            {
+                const size_t i = (size_t) (c * nSamples + t);
+
+                if (t < tSwitch)
+                    errorBefore = fmax(errorBefore, fabs(y[i] - yBefore[i]));
+                else if (t >= tSwitch + nFade + 4800)
+                    errorAfter = fmax(errorAfter, fabs(y[i] - yAfter[i]));
+
+                // Sample to sample, the crossfade moves no faster than either preset's output does on its own
+                if (t >= tSwitch - 1 && t < tSwitch + nFade + 256)
+                    stepFade = fmax(stepFade, fabs(y[i] - y[i - 1]));
+                else if (t >= tSwitch - 4800 && t < tSwitch + 4800)
+                    stepEither = fmax(stepEither, fmax(fabs(yBefore[i] - yBefore[i - 1]), fabs(yAfter[i] - yAfter[i - 1])));
+            }
+
+        CHECK(errorBefore == 0.0);
+        CHECK_LE(errorAfter, 1e-4);
+        CHECK_LE(stepFade, 1.1 * stepEither);
+
+        switched.Release();
+        before.Release();
+        after.Release();
+    }
+}
+
+TEST(submit_waits_for_the_previous_preset_and_a_sample_rate)
+{
+    DSP d;
+    d.Init();
+    d.SetMaxChannels(2);
+    d.SetMaxBlockSize(256);
+
+    DSPPreset p;
+    CHECK(! d.SubmitPreset(p));     // nothing to design for yet
+
+    d.SetSampleRate(kFs);
+    CHECK(d.SubmitPreset(p));
+    CHECK(! d.SubmitPreset(p));     // not taken yet
+
+    std::vector<float> x(2 * 256, 0.f);
+    process_planar(d, x, 2, 256, 256);
+    CHECK(d.SubmitPreset(p));
+
+    // Designed for 96 kHz, taken at 48: the crossover glides there instead of swapping in coefficients of the wrong rate
+    p.splitFrequency_Hz[0] = 3000.f;
+    d.SubmitPreset(p);
+    process_planar(d, x, 2, 256, 256);
+    d.SetSampleRate(2 * kFs);
+
+    p.nBands = 3;
+    p.splitFrequency_Hz[1] = 8000.f;
+    CHECK(d.SubmitPreset(p));
+    d.SetSampleRate(kFs);
+    process_planar(d, x, 2, 256, 256);
+
+    DSPPreset q;
+    d.GetPreset(q);
+    CHECK(q.nBands == 3 && q.splitFrequency_Hz[0] == 3000.f && q.splitFrequency_Hz[1] == 8000.f);
+    CHECK(d._bMultiband);
+
+    d.Release();
+}
+
+int main()
+{
+    return run_all_tests();
+}
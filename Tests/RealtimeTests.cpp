@@ -0,0 +1,500 @@
+
+// Red Rock Sound (RRS):
+// Real-time safety: built with RRS_RT_INSTRUMENTATION and the hooks from Source/DSPRealtime.cpp, so every allocation, free and lock
+// made inside DSP::Process() and the "No memory allocations" setters is counted. Also the block timing histogram.
+
+#include "TestHarness.h"
+#include "../Source/DSPBatch.h"
+
+#include <mutex>
+
+#if ! RRS_RT_INSTRUMENTATION
+ #error RealtimeTests needs RRS_RT_INSTRUMENTATION (see Tests/Makefile)
+#endif
+
+// Keeps the allocations below from being optimized out
+void* volatile g_pSink;
+
+static uint64_t total_violations()
+{
+    uint64_t n = 0;
+    for (int k = 0; k < kNumRealtimeViolations; ++k)
+        n += rt_violation_count((RealtimeViolation) k);
+    return n;
+}
+
+struct RealtimeSetup
+{
+    const char* name;
+    TIntegerParamType nChannels, bands, oversampling, oversamplingMode, saturationMode, topology, simd, kernel;
+};
+
+static const RealtimeSetup kSetups[] =
+{
+    { "2-band avx2",           2, 2, 1, kOversamplingQuality,    kSaturationNaive, kCrossoverTwoFilter,     kSimdAVX2,   kFilterKernelSequential },
+    { "mono time-parallel",    1, 2, 1, kOversamplingQuality,    kSaturationNaive, kCrossoverTwoFilter,     kSimdSSE2,   kFilterKernelTimeParallel },
+    { "7 channels scalar",     7, 2, 1, kOversamplingQuality,    kSaturationNaive, kCrossoverTwoFilter,     kSimdScalar, kFilterKernelSequential },
+    { "complementary",         2, 2, 1, kOversamplingQuality,    kSaturationNaive, kCrossoverComplementary, kSimdSSE2,   kFilterKernelSequential },
+    { "multiband",             6, 5, 1, kOversamplingQuality,    kSaturationNaive, kCrossoverTwoFilter,     kSimdAVX2,   kFilterKernelSequential },
+    { "os4 adaa2",             2, 2, 4, kOversamplingQuality,    kSaturationADAA2, kCrossoverTwoFilter,     kSimdAVX2,   kFilterKernelSequential },
+    { "os2 low latency adaa1", 2, 2, 2, kOversamplingLowLatency, kSaturationADAA1, kCrossoverTwoFilter,     kSimdAVX2,   kFilterKernelSequential },
+};
+
+TEST(process_and_setters_do_not_allocate_or_lock)
+{
+    const TIntegerParamType nBlock = 256;
+
+    for (const RealtimeSetup& s : kSetups)
+    {
+        // Setup may allocate: it runs outside the scope
+        DSP d;
+        prepare_dsp(d, s.nChannels, nBlock, 48000.f, 500.f);
+        d.SetNumBands(s.bands);
+        for (TIntegerParamType k = 1; k < s.bands - 1; ++k)
+            d.SetBandCrossoverFrequency(k, 500.f * (TFloatParamType) (4 << (2 * k)));
+        d.SetOversampling(s.oversampling, s.oversamplingMode);
+        d.SetSaturationMode(s.saturationMode);
+
+        std::vector<float> x = white_noise((size_t) (s.nChannels * nBlock), 0.5f, 5);
+        std::vector<TAudioSampleType*> ptrs((size_t) s.nChannels);
+        for (TIntegerParamType c = 0; c < s.nChannels; ++c)
+            ptrs[(size_t) c] = x.data() + c * nBlock;
+
+        uint64_t before = total_violations();
+        {
+            RealtimeScope scope;
+
+            d.SetCrossoverTopology(s.topology);
+            d.SetSimdLevel(s.simd);
+            d.SetFilterKernel(s.kernel);
+
+            // Parameters move every block, so the crossover glide and the smoothers are exercised too; odd sizes hit every tail
+            for (TIntegerParamType b = 0; b < 64; ++b)
+            {
+                d.SetGain(0.5f + 0.01f * b);
+                d.SetDrive(1.f + 0.1f * b);
+                d.SetMix(0.5f + 0.005f * b);
+                d.SetCrossoverFrequency(200.f + 50.f * b);
+                d.SetBandSaturation(0, 1.f);
+                d.SetBandBypass(s.bands - 1, true);
+                d.SetSmoothingTime(b % 3 == 0 ? 0.f : 10.f);
+                d.Process(ptrs.data(), s.nChannels, b % 2 == 0 ? nBlock : nBlock - 1 - b);
+            }
+        }
+        uint64_t after = total_violations();
+
+        if (after != before)
+            printf("  %s: %llu violation(s)\n", s.name, (unsigned long long) (after - before));
+        CHECK(after == before);
+
+        d.Release();
+    }
+}
+
+TEST(violations_inside_a_scope_are_counted)
+{
+    std::mutex m;
+
+    uint64_t allocations = rt_violation_count(kRealtimeAllocation), frees = rt_violation_count(kRealtimeFree), locks = rt_violation_count(kRealtimeLock);
+    {
+        RealtimeScope scope;
+
+        int* p = new int[16];
+        g_pSink = p;
+        delete[] p;
+
+        void* q = malloc(64);
+        g_pSink = q;
+        free(q);
+
+        m.lock();
+        m.unlock();
+    }
+
+    CHECK(rt_violation_count(kRealtimeAllocation) == allocations + 2);
+    CHECK(rt_violation_count(kRealtimeFree) == frees + 2);
+    CHECK(rt_violation_count(kRealtimeLock) == locks + 1);
+
+    // ... and outside one they are not
+    uint64_t before = total_violations();
+    std::vector<float> v(1024);
+    g_pSink = v.data();
+    m.lock();
+    m.unlock();
+    CHECK(total_violations() == before);
+}
+
+// DSP.h's own calloc()/free() go through the hooks too: setup made on the audio thread is caught
+TEST(setup_on_the_audio_thread_is_counted)
+{
+    DSP d;
+    prepare_dsp(d, 2, 64, 48000.f, 1000.f);
+
+    uint64_t allocations = rt_violation_count(kRealtimeAllocation), frees = rt_violation_count(kRealtimeFree);
+    {
+        RealtimeScope scope;
+        d.SetMaxChannels(16);
+    }
+
+    CHECK(rt_violation_count(kRealtimeAllocation) > allocations);
+    CHECK(rt_violation_count(kRealtimeFree) > frees);
+
+    d.Release();
+}
+
+// The arena is only reallocated when a new layout needs more room than it has
+TEST(reconfiguring_within_the_arena_does_not_allocate)
+{
+    DSP d;
+    prepare_dsp(d, 8, 512, 48000.f, 1000.f);
+    d.SetOversampling(4, kOversamplingQuality);
+
+    uint64_t before = total_violations();
+    {
+        RealtimeScope scope;
+        d.SetOversampling(2, kOversamplingQuality);
+        d.SetSaturationMode(kSaturationADAA1);
+        d.SetMaxBlockSize(256);
+        d.SetMaxChannels(6);
+    }
+    CHECK(total_violations() == before);
+
+    d.Release();
+}
+
+// Once the maximums are declared, nothing within them allocates again: layouts, channel and block counts, and sample rates
+TEST(preallocated_reconfiguration_does_not_allocate)
+{
+    DSP d;
+    prepare_dsp(d, 2, 256, 48000.f, 1000.f);
+    d.Preallocate(8, 1024, 8, 8191);
+
+    const void* raw = d._arena.raw;
+    uint64_t before = total_violations();
+    {
+        RealtimeScope scope;
+        d.SetMaxChannels(8);
+        d.SetMaxBlockSize(1024);
+        d.SetOversampling(8, kOversamplingLowLatency);
+        d.SetSaturationMode(kSaturationADAA2);
+        d.SetLinearPhase(kLinearPhaseUniform, 8191);
+        d.SetLinearPhase(kLinearPhaseLowLatency, 8191);
+        d.SetOversampling(4, kOversamplingQuality);
+        d.SetLinearPhase(kLinearPhaseUniform, 1001);
+        d.SetMaxChannels(3);
+
+        for (TFloatParamType fs : { 44100.f, 96000.f, 192000.f, 48000.f })
+            d.SetSampleRate(fs);
+
+        d.Preallocate(4, 512, 2, 4095);
+    }
+    CHECK(total_violations() == before);
+    CHECK(d._arena.raw == raw);
+
+    // And it still processes at full size
+    std::vector<float> x = white_noise(8 * 1024, 0.5f, 1);
+    process_planar(d, x, 8, 1024, 1024);
+    CHECK(std::isfinite(x[8 * 1024 - 1]));
+
+    d.Release();
+}
+
+// prepareToPlay() again with the same settings, or a sample rate change, keeps the filter states: the output carries on as if
+// nothing had happened (the new rate only moves the coefficients)
+TEST(preparing_again_keeps_the_states)
+{
+    std::vector<float> x = white_noise(2 * 8192, 0.5f, 2);
+
+    auto prepare = [](DSP& d, TFloatParamType fs)
+    {
+        d.Preallocate(2, 512, 2, 0);
+        d.SetMaxChannels(2);
+        d.SetMaxBlockSize(512);
+        d.SetCrossoverFrequency(800.f);
+        d.SetSampleRate(fs);
+        d.SetOversampling(2, kOversamplingQuality);
+        d.SetSaturationMode(kSaturationADAA1);
+    };
+
+    DSP once, twice;
+    once.Init();
+    twice.Init();
+    prepare(once, 48000.f);
+    prepare(twice, 48000.f);
+    once.SetDrive(3.f);
+    twice.SetDrive(3.f);
+
+    std::vector<float> a = x, b = x;
+    process_planar(once, a, 2, 4096, 512);
+    process_planar(twice, b, 2, 4096, 512);
+
+    const void* raw = twice._arena.raw;
+    prepare(twice, 48000.f);
+    CHECK(twice._arena.raw == raw);
+
+    std::vector<float> restA(x.begin() + 4096, x.end()), restB = restA;
+    process_planar(once, restA, 2, 4096, 512);
+    process_planar(twice, restB, 2, 4096, 512);
+    CHECK(max_abs_diff(restA, restB) == 0.0);
+
+    // A new rate: no click from states cleared mid-signal
+    prepare(twice, 44100.f);
+    CHECK(twice._arena.raw == raw);
+    CHECK(twice.crossoverStates[kStateLow1] != 0.f);
+
+    once.Release();
+    twice.Release();
+}
+
+// Every buffer is carved from the one aligned block, and each group of 4 channels has its crossover state in one cache line
+TEST(state_lives_in_one_aligned_arena)
+{
+    DSP d;
+    prepare_dsp(d, 6, 512, 48000.f, 1000.f);
+    d.SetOversampling(2, kOversamplingLowLatency);
+    d.SetSaturationMode(kSaturationADAA2);
+
+    const uintptr_t base = (uintptr_t) d._arena.base, end = base + d._arena.capacity;
+    auto inside = [&](const void* p) { return (uintptr_t) p >= base && (uintptr_t) p < end; };
+
+    CHECK(base % MemoryArena::kAlignment == 0);
+    CHECK(inside(d.crossoverStates) && inside(d.filters) && inside(d.allpass_states) && inside(d._vSubBlocks));
+    CHECK(inside(d.oversamplers) && inside(d.adaaStates) && inside(d.lowBand) && inside(d.highDelay) && inside(d.highDelayPos));
+    CHECK(inside(d.multiband.lowStates1) && inside(d.multiband.frame));
+    CHECK(inside(d.oversamplers[5].buffers[0]));
+
+    for (TIntegerParamType c = 0; c < 6; ++c)
+    {
+        uintptr_t line = (uintptr_t) d._CrossoverStates(c) / 64;
+        for (int k : { kStateLow1, kStateHigh1, kStateLow2, kStateHigh2 })
+            CHECK((uintptr_t) (d._CrossoverStates(c) + k) / 64 == line);
+    }
+
+    d.Release();
+    CHECK(d._arena.base == NULL && d.crossoverStates == NULL && d.oversamplers == NULL);
+}
+
+// Voices come and go, and move, on the audio thread
+TEST(batch_voices_do_not_allocate_or_lock)
+{
+    const TIntegerParamType nVoices = 20, nBlock = 128;
+
+    SaturatorBatch b;
+    b.Init();
+    b.SetMaxVoices(nVoices);
+    b.SetSampleRate(48000.f);
+
+    std::vector<float> x = white_noise((size_t) (nVoices * nBlock), 0.5f, 8);
+    std::vector<TAudioSampleType*> ptrs((size_t) nVoices);
+    for (TIntegerParamType v = 0; v < nVoices; ++v)
+        ptrs[(size_t) v] = x.data() + v * nBlock;
+
+    uint64_t before = total_violations();
+    {
+        RealtimeScope scope;
+
+        for (TIntegerParamType k = 0; k < 64; ++k)
+        {
+            if (b.AddVoice(200.f + 10.f * k, 2.f, 1.f, 0.8f) < 0)
+                b.RemoveVoice(k % nVoices);
+
+            b.SetVoiceCrossoverFrequency(k % nVoices, 500.f + 20.f * k);
+            b.SetVoiceDrive((k + 1) % nVoices, 1.f + 0.1f * k);
+            b.SetSimdLevel(k % 3);
+            b.Process(ptrs.data(), nVoices, nBlock - k);
+        }
+    }
+    CHECK(total_violations() == before);
+
+    b.Release();
+}
+
+// A 16-channel bus over a worker pool: neither the audio thread nor the workers (which open their own scope) allocate or lock
+TEST(worker_pool_does_not_allocate_or_lock)
+{
+    const TIntegerParamType nChannels = 16, nBlock = 256;
+
+    WorkerPool pool;
+    pool.Start(3);
+
+    for (TIntegerParamType oversampling : { 1, 4 })
+    {
+        DSP d;
+        prepare_dsp(d, nChannels, nBlock, 48000.f, 500.f);
+        d.SetOversampling(oversampling, kOversamplingQuality);
+        d.SetWorkerPool(&pool);
+
+        std::vector<float> x = white_noise((size_t) (nChannels * nBlock), 0.5f, 6);
+        std::vector<TAudioSampleType*> ptrs((size_t) nChannels);
+        for (TIntegerParamType c = 0; c < nChannels; ++c)
+            ptrs[(size_t) c] = x.data() + c * nBlock;
+
+        uint64_t before = total_violations();
+        {
+            RealtimeScope scope;
+
+            for (TIntegerParamType b = 0; b < 64; ++b)
+            {
+                d.SetCrossoverFrequency(200.f + 50.f * b);
+                d.Process(ptrs.data(), nChannels, nBlock - b);
+            }
+        }
+        CHECK(total_violations() == before);
+
+        d.Release();
+    }
+
+    pool.Stop();
+}
+
+TEST(telemetry_does_not_allocate_or_lock)
+{
+    const TIntegerParamType nChannels = 8, nBlock = 256;
+
+    WorkerPool pool;
+    pool.Start(1);
+
+    BandMeterBuffer meters;
+    SpectrumAnalyzer analyzer;
+    analyzer.Open();
+
+    for (TIntegerParamType bands : { 2, 4 })
+    {
+        DSP d;
+        prepare_dsp(d, nChannels, nBlock, 48000.f, 500.f);
+        d.SetNumBands(bands);
+        d.SetWorkerPool(&pool);
+
+        std::vector<float> x = white_noise((size_t) (nChannels * nBlock), 0.5f, 7);
+        std::vector<TAudioSampleType*> ptrs((size_t) nChannels);
+        for (TIntegerParamType c = 0; c < nChannels; ++c)
+            ptrs[(size_t) c] = x.data() + c * nBlock;
+
+        uint64_t before = total_violations();
+        {
+            RealtimeScope scope;
+
+            // On and off between blocks, as editors open and close
+            for (TIntegerParamType b = 0; b < 64; ++b)
+            {
+                d.SetTelemetry(b % 8 < 6 ? &meters : NULL, b % 8 < 4 ? &analyzer : NULL);
+                d.Process(ptrs.data(), nChannels, nBlock - b);
+            }
+        }
+        CHECK(total_violations() == before);
+
+        d.Release();
+    }
+
+    analyzer.Close();
+    pool.Stop();
+}
+
+TEST(preset_switch_does_not_allocate_or_lock)
+{
+    const TIntegerParamType nChannels = 2, nBlock = 256;
+
+    DSP d;
+    prepare_dsp(d, nChannels, nBlock, 48000.f, 500.f);
+
+    std::vector<float> x = white_noise((size_t) (nChannels * nBlock), 0.5f, 8);
+    std::vector<TAudioSampleType*> ptrs((size_t) nChannels);
+    for (TIntegerParamType c = 0; c < nChannels; ++c)
+        ptrs[(size_t) c] = x.data() + c * nBlock;
+
+    // Crossover moves (with the crossfade), a multiband tree, and back to 2 bands
+    DSPPreset p;
+    uint64_t before = total_violations();
+
+    for (TIntegerParamType n = 0; n < 6; ++n)
+    {
+        p.splitFrequency_Hz[0] = 300.f * (float) (n + 1);
+        p.drive = 1.f + (float) n;
+        p.nBands = n == 3 ? 3 : 2;
+
+        // Designed out here, as setStateInformation() does; taken and faded in there
+        CHECK(d.SubmitPreset(p));
+        {
+            RealtimeScope scope;
+            for (TIntegerParamType b = 0; b < 4; ++b)
+                d.Process(ptrs.data(), nChannels, nBlock);
+        }
+    }
+    CHECK(total_violations() == before);
+
+    d.Release();
+}
+
+TEST(scopes_nest)
+{
+    uint64_t allocations = rt_violation_count(kRealtimeAllocation);
+    {
+        RealtimeScope outer;
+        {
+            RealtimeScope inner;
+        }
+
+        void* p = malloc(8);
+        g_pSink = p;
+        free(p);
+    }
+
+    CHECK(rt_violation_count(kRealtimeAllocation) == allocations + 1);
+    CHECK(rt_scope_depth() == 0);
+}
+
+TEST(histogram_buckets_block_load)
+{
+    BlockTimingHistogram h;
+    const double fs = 48000.0;
+    const int n = 480;     // 10 ms
+
+    h.Record(1000000, n, fs);    // 10%
+    h.Record(1200000, n, fs);    // 12%
+    h.Record(9900000, n, fs);    // 99%
+    h.Record(12000000, n, fs);   // 120%, an overrun
+    h.Record(50000000, n, fs);   // 500%, the last bucket
+
+    BlockTimingHistogram::Snapshot s = h.GetSnapshot();
+    CHECK(s.nBlocks == 5);
+    CHECK(s.nOverruns == 2);
+    CHECK(s.nMax_ns == 50000000);
+    CHECK(s.nMaxLoad_permille == 5000);
+    CHECK(s.buckets[2] == 2);
+    CHECK(s.buckets[19] == 1);
+    CHECK(s.buckets[24] == 1);
+    CHECK(s.buckets[BlockTimingHistogram::kBuckets - 1] == 1);
+
+    char text[2048];
+    CHECK(h.Format(text, sizeof(text)) > 0);
+    CHECK(strstr(text, "blocks 5, overruns 2") != NULL);
+
+    // A reset is carried out by the next Record(), which then counts itself
+    h.RequestReset();
+    CHECK(h.GetSnapshot().nBlocks == 5);
+    h.Record(100000, n, fs);
+    s = h.GetSnapshot();
+    CHECK(s.nBlocks == 1);
+    CHECK(s.nOverruns == 0);
+    CHECK(s.buckets[0] == 1);
+}
+
+TEST(block_timer_records_its_lifetime)
+{
+    BlockTimingHistogram h;
+    {
+        BlockTimer timer(h, 64, 48000.0);
+        volatile double x = 0.0;
+        for (int i = 0; i < 10000; ++i)
+            x = x + sqrt((double) i);
+    }
+
+    BlockTimingHistogram::Snapshot s = h.GetSnapshot();
+    CHECK(s.nBlocks == 1);
+    CHECK(s.nMax_ns > 0);
+}
+
+int main()
+{
+    return run_all_tests();
+}
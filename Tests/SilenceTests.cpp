@@ -0,0 +1,135 @@
+
+// Red Rock Sound (RRS):
+// Silence fast path of DSP::Process(): a burst, a long digital silence and another burst, with the fast path on and off. The run
+// with it on has to go idle during the silence and still give the same output, and GetTailSamples() has to cover the ring-out.
+
+#include "TestHarness.h"
+
+static const DspSetup kSilenceSetups[] =
+{
+    { "stereo",                   2, 1, kOversamplingQuality,    kSaturationNaive, 2, kCrossoverTwoFilter },
+    { "5 channels complementary", 5, 1, kOversamplingQuality,    kSaturationNaive, 2, kCrossoverComplementary },
+    { "stereo os4 ADAA1",         2, 4, kOversamplingQuality,    kSaturationADAA1, 2, kCrossoverTwoFilter },
+    { "stereo os2 low latency",   2, 2, kOversamplingLowLatency, kSaturationADAA2, 2, kCrossoverTwoFilter },
+    { "stereo 4 bands",           2, 1, kOversamplingQuality,    kSaturationNaive, 4, kCrossoverTwoFilter },
+};
+
+static const TIntegerParamType kBlock = 512;
+static const TIntegerParamType kBurst = 16 * kBlock;
+static const TIntegerParamType kSilence = 300 * kBlock;     // 3.2 s at 48 kHz
+static const TIntegerParamType kSamples = kBurst + kSilence + kBurst;
+
+// Burst, silence, burst; the crossover and the gain change halfway through the silence. Returns the block the DSP went idle in (-1: never)
+template <typename TSample>
+static TIntegerParamType run_silence(DSPT<TSample>& d, std::vector<TSample>& x, TIntegerParamType nChannels)
+{
+    std::vector<TSample*> ptrs((size_t) nChannels);
+    TIntegerParamType idleBlock = -1;
+
+    for (TIntegerParamType b = 0; b * kBlock < kSamples; ++b)
+    {
+        if (b * kBlock == kBurst + kSilence / 2)
+        {
+            d.SetCrossoverFrequency(150.f);
+            d.SetGain(0.5f);
+        }
+
+        for (TIntegerParamType c = 0; c < nChannels; ++c)
+            ptrs[(size_t) c] = x.data() + (size_t) c * kSamples + b * kBlock;
+
+        d.Process(ptrs.data(), nChannels, kBlock);
+
+        if (d._bIdle && idleBlock < 0)
+            idleBlock = b;
+    }
+
+    return idleBlock;
+}
+
+template <typename TSample>
+static std::vector<TSample> burst_silence_burst(TIntegerParamType nChannels)
+{
+    std::vector<float> noise = white_noise((size_t) (nChannels * kSamples), 0.9f, 11);
+    std::vector<TSample> x((size_t) (nChannels * kSamples), 0);
+
+    for (TIntegerParamType c = 0; c < nChannels; ++c)
+        for (TIntegerParamType i = 0; i < kSamples; ++i)
+            if (i < kBurst || i >= kBurst + kSilence)
+                x[(size_t) (c * kSamples + i)] = noise[(size_t) (c * kSamples + i)];
+
+    return x;
+}
+
+template <typename TSample>
+static void check_skipped_matches_full(const DspSetup& s)
+{
+    std::vector<TSample> full = burst_silence_burst<TSample>(s.nChannels), skipped = full;
+
+    DSPT<TSample> reference, fast;
+    prepare_setup(reference, s, kBlock, 48000.f, 40.f, 2.f);
+    prepare_setup(fast, s, kBlock, 48000.f, 40.f, 2.f);
+    reference.SetSkipSilence(false);
+
+    CHECK(run_silence(reference, full, s.nChannels) < 0);
+    TIntegerParamType idleBlock = run_silence(fast, skipped, s.nChannels);
+
+    // Idle well before the silence is over, and the burst after it wakes the DSP up again
+    CHECK(idleBlock >= kBurst / kBlock && idleBlock < (kBurst + kSilence / 2) / kBlock);
+    CHECK(! fast._bIdle);
+
+    double diff = 0.0;
+    for (size_t i = 0; i < full.size(); ++i)
+        diff = std::max(diff, (double) fabs(full[i] - skipped[i]));
+
+    if (diff > 1e-8)
+        printf("  %s (%d-byte samples): max difference %g, idle from block %d\n", s.name, (int) sizeof(TSample), diff, idleBlock);
+    CHECK_LE(diff, 1e-8);
+
+    reference.Release();
+    fast.Release();
+}
+
+TEST(skipped_silence_matches_full_processing)
+{
+    for (const DspSetup& s : kSilenceSetups)
+    {
+        check_skipped_matches_full<float>(s);
+        check_skipped_matches_full<double>(s);
+    }
+}
+
+TEST(tail_length_covers_ring_out)
+{
+    for (const DspSetup& s : kSilenceSetups)
+        for (TFloatParamType fc : { 40.f, 1000.f })
+        {
+            std::vector<double> x = burst_silence_burst<double>(s.nChannels);
+
+            DSPT<double> d;
+            prepare_setup(d, s, kBlock, 48000.f, fc, 2.f);
+            d.SetSkipSilence(false);
+
+            TIntegerParamType tail = d.GetTailSamples(fc);
+            CHECK(tail > 0 && tail < kSilence);
+            CHECK(d.GetTailSamples(20.f) > tail);
+
+            run_silence(d, x, s.nChannels);
+
+            // The burst peaks around 1; after the tail the output is down at the threshold
+            double after = 0.0;
+            for (TIntegerParamType c = 0; c < s.nChannels; ++c)
+                for (TIntegerParamType i = kBurst + tail; i < kBurst + kSilence / 2; ++i)
+                    after = std::max(after, fabs(x[(size_t) (c * kSamples + i)]));
+
+            if (after > 1e-9)
+                printf("  %s at %g Hz: %g after a tail of %d samples\n", s.name, fc, after, tail);
+            CHECK_LE(after, 1e-9);
+
+            d.Release();
+        }
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,155 @@
+
+// Red Rock Sound (RRS):
+// Minimal self-registering checks for the JUCE-free DSP code: each TEST() body runs once from main(),
+// CHECK() logs the failing expression and marks the run as failed, so `make test` exits non-zero.
+
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+#include <complex>
+#include <random>
+
+#include "../Source/DSP.h"
+
+struct TestCase
+{
+    const char* name;
+    void (*body)();
+    TestCase* next;
+};
+
+static TestCase* g_pTests = NULL;
+static inline int g_nFailures = 0;
+
+struct TestRegistrar
+{
+    TestRegistrar(TestCase* a_pTest) { a_pTest->next = g_pTests; g_pTests = a_pTest; }
+};
+
+#define TEST(name) \
+    static void test_##name(); \
+    static TestCase testCase_##name = { #name, test_##name, NULL }; \
+    static TestRegistrar testRegistrar_##name(&testCase_##name); \
+    static void test_##name()
+
+#define CHECK(expr) \
+    do { if (! (expr)) { ++g_nFailures; printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #expr); } } while (0)
+
+// CHECK() for "a <= limit" that also prints both values
+#define CHECK_LE(a, limit) \
+    do { double va_ = (a), vl_ = (limit); if (! (va_ <= vl_)) { ++g_nFailures; printf("  FAILED %s:%d: %s = %g > %g\n", __FILE__, __LINE__, #a, va_, vl_); } } while (0)
+
+static inline int run_all_tests()
+{
+    // Registration prepends, so reverse to run in file order
+    std::vector<TestCase*> tests;
+    for (TestCase* t = g_pTests; t != NULL; t = t->next)
+        tests.insert(tests.begin(), t);
+
+    for (TestCase* t : tests)
+    {
+        int nBefore = g_nFailures;
+        t->body();
+        printf("%s %s\n", g_nFailures == nBefore ? "[ ok ]" : "[FAIL]", t->name);
+    }
+
+    printf("%d failure(s)\n", g_nFailures);
+    return g_nFailures == 0 ? 0 : 1;
+}
+
+//RRS: Helpers shared by the tests
+
+// DSP prepared the way PluginProcessor::prepareToPlay() does, for the given channels/block/sample rate; drive and mix are set before
+// the sample rate, so they start at their values rather than glide to them
+template <typename TSample>
+static inline void prepare_dsp(DSPT<TSample>& d, TIntegerParamType nChannels, TIntegerParamType nBlock, TFloatParamType fs, TFloatParamType fCrossover,
+                               TFloatParamType fDrive = 1.f, TFloatParamType fMix = 1.f)
+{
+    d.Init();
+    d.SetMaxChannels(nChannels);
+    d.SetMaxBlockSize(nBlock);
+    d.SetCrossoverFrequency(fCrossover);
+    d.SetDrive(fDrive);
+    d.SetMix(fMix);
+    d.SetSampleRate(fs);
+}
+
+// One case of a test that runs across the DSP's structural settings; each test keeps its own table of them
+struct DspSetup
+{
+    const char* name;
+    TIntegerParamType nChannels, oversampling, oversamplingMode, saturationMode, bands, topology;
+};
+
+// prepare_dsp() for the setup's channels, then its structural settings
+template <typename TSample>
+static inline void prepare_setup(DSPT<TSample>& d, const DspSetup& s, TIntegerParamType nBlock, TFloatParamType fs, TFloatParamType fCrossover,
+                                 TFloatParamType fDrive = 1.f, TFloatParamType fMix = 1.f)
+{
+    prepare_dsp(d, s.nChannels, nBlock, fs, fCrossover, fDrive, fMix);
+    d.SetNumBands(s.bands);
+    d.SetOversampling(s.oversampling, s.oversamplingMode);
+    d.SetSaturationMode(s.saturationMode);
+    d.SetCrossoverTopology(s.topology);
+}
+
+// Runs a planar signal (channel after channel, nSamples each) through d.Process() in blocks of nBlock, in place
+static inline void process_planar(DSP& d, std::vector<float>& x, TIntegerParamType nChannels, TIntegerParamType nSamples, TIntegerParamType nBlock)
+{
+    std::vector<TAudioSampleType*> ptrs((size_t) nChannels);
+
+    for (TIntegerParamType offset = 0; offset < nSamples; offset += nBlock)
+    {
+        TIntegerParamType n = nSamples - offset < nBlock ? nSamples - offset : nBlock;
+        for (TIntegerParamType c = 0; c < nChannels; ++c)
+            ptrs[(size_t) c] = x.data() + (size_t) c * nSamples + offset;
+        d.Process(ptrs.data(), nChannels, n);
+    }
+}
+
+static inline std::vector<float> white_noise(size_t n, float amplitude, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-amplitude, amplitude);
+    std::vector<float> x(n);
+    for (float& v : x)
+        v = dist(rng);
+    return x;
+}
+
+static inline double max_abs_diff(const std::vector<float>& a, const std::vector<float>& b)
+{
+    double m = 0.0;
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i)
+        m = std::max(m, (double) fabs(a[i] - b[i]));
+    return m;
+}
+
+// Null-test residual of test against ref, in dB relative to ref's energy
+static inline double residual_db(const std::vector<float>& ref, const std::vector<float>& test)
+{
+    double e = 0.0, d = 0.0;
+    for (size_t i = 0; i < ref.size() && i < test.size(); ++i)
+    {
+        e += (double) ref[i] * ref[i];
+        d += ((double) test[i] - ref[i]) * ((double) test[i] - ref[i]);
+    }
+    return 10.0 * log10((d + 1e-30) / (e + 1e-30));
+}
+
+// Frequency response of an impulse response at f (Hz)
+static inline std::complex<double> response_at(const std::vector<float>& h, double f, double fs)
+{
+    std::complex<double> sum = 0.0;
+    std::complex<double> w = std::polar(1.0, -2.0 * M_PI * f / fs), z = 1.0;
+    for (float v : h)
+    {
+        sum += (double) v * z;
+        z *= w;
+    }
+    return sum;
+}
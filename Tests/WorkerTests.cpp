@@ -0,0 +1,191 @@
+
+// Red Rock Sound (RRS):
+// WorkerPool (Source/DSPWorkers.h) on its own, shared by concurrent callers and asleep between jobs, and DSP::Process() on wide
+// buses with its channel groups spread over a pool, against the same DSP run on the calling thread alone: the groups share no
+// state, so the output must be identical.
+
+#include "TestHarness.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static const DspSetup kWorkerSetups[] =
+{
+    { "7.1.4",              12, 1, kOversamplingQuality, kSaturationNaive, 2, kCrossoverTwoFilter },
+    { "3rd-order ambi",     16, 1, kOversamplingQuality, kSaturationNaive, 2, kCrossoverTwoFilter },
+    { "13 channels",        13, 1, kOversamplingQuality, kSaturationNaive, 2, kCrossoverTwoFilter },
+    { "16 channels os4",    16, 4, kOversamplingQuality, kSaturationADAA1, 2, kCrossoverTwoFilter },
+    { "16 channels bands",  16, 1, kOversamplingQuality, kSaturationNaive, 4, kCrossoverTwoFilter },
+};
+
+TEST(pool_runs_every_task_once)
+{
+    WorkerPool pool;
+    pool.Start(3);
+    CHECK(pool.GetNumWorkers() == 3);
+
+    static std::atomic<int> counts[40];
+    for (std::atomic<int>& c : counts)
+        c.store(0);
+
+    auto count = [](void* a_pContext, TIntegerParamType a_nTask) { ((std::atomic<int>*) a_pContext)[a_nTask].fetch_add(1); };
+
+    // Jobs back to back and of every size, so late workers meet a newer job than the one that woke them
+    int nJobs = 0;
+    for (int k = 0; k < 4000; ++k, ++nJobs)
+        pool.Run(count, counts, 1 + k % 40);
+
+    bool bExact = true;
+    for (int t = 0; t < 40; ++t)
+    {
+        int expected = 0;
+        for (int k = 0; k < nJobs; ++k)
+            expected += t < 1 + k % 40;
+        bExact = bExact && counts[t].load() == expected;
+    }
+    CHECK(bExact);
+
+    pool.Stop();
+    CHECK(pool.GetNumWorkers() == 0);
+
+    // Without workers every task runs on the caller
+    pool.Run(count, counts, 40);
+    CHECK(counts[39].load() == nJobs / 40 + 1);
+}
+
+TEST(parallel_channels_match_serial)
+{
+    const TIntegerParamType nSamples = 1 << 14;
+
+    WorkerPool pool;
+    pool.Start(3);
+
+    for (const DspSetup& s : kWorkerSetups)
+    {
+        std::vector<float> x = white_noise((size_t) (s.nChannels * nSamples), 0.7f, 21), y = x;
+
+        DSP serial, parallel;
+        prepare_setup(serial, s, 512, 48000.f, 300.f, 3.f);
+        prepare_setup(parallel, s, 512, 48000.f, 300.f, 3.f);
+        parallel.SetWorkerPool(&pool);
+
+        // Odd block sizes and a crossover glide halfway, so the sub-blocks of the glide are spread over the pool as well
+        std::vector<TAudioSampleType*> px((size_t) s.nChannels), py((size_t) s.nChannels);
+        TIntegerParamType offset = 0;
+
+        for (TIntegerParamType b = 0; offset < nSamples; ++b)
+        {
+            TIntegerParamType n = 1 + (b * 97) % 512;
+            n = n < nSamples - offset ? n : nSamples - offset;
+
+            if (b == 20)
+            {
+                serial.SetCrossoverFrequency(2000.f);
+                parallel.SetCrossoverFrequency(2000.f);
+            }
+
+            for (TIntegerParamType c = 0; c < s.nChannels; ++c)
+            {
+                px[(size_t) c] = x.data() + c * nSamples + offset;
+                py[(size_t) c] = y.data() + c * nSamples + offset;
+            }
+
+            serial.Process(px.data(), s.nChannels, n);
+            parallel.Process(py.data(), s.nChannels, n);
+            offset += n;
+        }
+
+        bool bSame = memcmp(x.data(), y.data(), x.size() * sizeof(float)) == 0;
+        if (! bSame)
+            printf("  %s: max difference %g\n", s.name, max_abs_diff(x, y));
+        CHECK(bSame);
+
+        serial.Release();
+        parallel.Release();
+    }
+
+    pool.Stop();
+}
+
+TEST(shared_pool_serves_concurrent_callers)
+{
+    // Instances on separate audio threads, all on the process's pool: every job of every caller runs each of its tasks once
+    WorkerPool* pool = WorkerPool::AcquireShared();
+    pool->Reserve(3);
+    CHECK(pool->GetNumWorkers() == 3);
+    CHECK(WorkerPool::AcquireShared() == pool);
+
+    const int nCallers = 4, nJobs = 2000;
+    static std::atomic<int> counts[nCallers][16];
+    for (auto& caller : counts)
+        for (std::atomic<int>& c : caller)
+            c.store(0);
+
+    auto count = [](void* a_pContext, TIntegerParamType a_nTask) { ((std::atomic<int>*) a_pContext)[a_nTask].fetch_add(1); };
+
+    std::vector<std::thread> callers;
+    for (int k = 0; k < nCallers; ++k)
+        callers.emplace_back([&, k]()
+        {
+            for (int j = 0; j < nJobs; ++j)
+                pool->Run(count, counts[k], 1 + (j + k) % 16);
+        });
+
+    for (std::thread& t : callers)
+        t.join();
+
+    bool bExact = true;
+    for (int k = 0; k < nCallers; ++k)
+        for (int t = 0; t < 16; ++t)
+        {
+            int expected = 0;
+            for (int j = 0; j < nJobs; ++j)
+                expected += t < 1 + (j + k) % 16;
+            bExact = bExact && counts[k][t].load() == expected;
+        }
+    CHECK(bExact);
+
+    // The threads stay while anyone uses the pool
+    WorkerPool::ReleaseShared();
+    CHECK(pool->GetNumWorkers() == 3);
+    WorkerPool::ReleaseShared();
+    CHECK(pool->GetNumWorkers() == 0);
+}
+
+TEST(idle_workers_block_and_wake)
+{
+    WorkerPool pool;
+    pool.Start(3);
+
+    static std::atomic<int> counts[8];
+    for (std::atomic<int>& c : counts)
+        c.store(0);
+
+    auto count = [](void* a_pContext, TIntegerParamType a_nTask) { ((std::atomic<int>*) a_pContext)[a_nTask].fetch_add(1); };
+
+    // Gaps far longer than the spin, as between the callbacks of a large block: the workers go to sleep in between, and each
+    // job wakes them again without losing a task
+    for (int k = 0; k < 20; ++k)
+    {
+        pool.Run(count, counts, 8);
+
+        int nWait = 0;
+        while (pool.nSleeping.load() < 3 && nWait++ < 1000)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        CHECK(pool.nSleeping.load() == 3);
+    }
+
+    bool bExact = true;
+    for (std::atomic<int>& c : counts)
+        bExact = bExact && c.load() == 20;
+    CHECK(bExact);
+
+    pool.Stop();
+    CHECK(pool.GetNumWorkers() == 0);
+}
+
+int main()
+{
+    return run_all_tests();
+}
@@ -0,0 +1,230 @@
+
+// Red Rock Sound (RRS):
+// Memory-mapped audio input and float WAV output for the command-line tools (POSIX only).
+// Reads PCM 16/24/32-bit and IEEE float 32-bit WAV (plain or WAVE_FORMAT_EXTENSIBLE), and headerless interleaved float32 ("raw").
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum SampleEncoding
+{
+    kSampleInt16 = 0,
+    kSampleInt24,
+    kSampleInt32,
+    kSampleFloat32
+};
+
+//RRS: A read-only view of an audio file; frames are decoded straight from the mapping
+struct MappedAudioFile
+{
+    const uint8_t* map = NULL;
+    size_t mapSize = 0;
+    const uint8_t* data = NULL;     // first frame
+    int64_t frames = 0;
+    int channels = 0;
+    double sampleRate = 0;
+    int encoding = kSampleFloat32;
+    int bytesPerSample = 4;
+
+    MappedAudioFile() = default;
+    MappedAudioFile(const MappedAudioFile&) = delete;
+    MappedAudioFile& operator=(const MappedAudioFile&) = delete;
+    ~MappedAudioFile() { Close(); }
+
+    // a_nRawChannels/a_fRawSampleRate describe headerless input and are ignored for WAV. Returns false with a_sError set on failure.
+    bool Open(const std::string& a_sPath, bool a_bRaw, int a_nRawChannels, double a_fRawSampleRate, std::string& a_sError)
+    {
+        Close();
+
+        int fd = open(a_sPath.c_str(), O_RDONLY);
+        if (fd < 0)
+            return _Fail(a_sError, "cannot open");
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close(fd);
+            return _Fail(a_sError, "empty or unreadable");
+        }
+
+        void* p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (p == MAP_FAILED)
+            return _Fail(a_sError, "mmap failed");
+
+        map = (const uint8_t*) p;
+        mapSize = (size_t) st.st_size;
+        madvise(p, mapSize, MADV_SEQUENTIAL);
+
+        if (a_bRaw)
+        {
+            if (a_nRawChannels <= 0 || a_fRawSampleRate <= 0)
+                return _Fail(a_sError, "raw input needs --channels and --rate");
+
+            data = map;
+            channels = a_nRawChannels;
+            sampleRate = a_fRawSampleRate;
+            encoding = kSampleFloat32;
+            bytesPerSample = 4;
+            frames = (int64_t) (mapSize / (size_t) (4 * channels));
+            return true;
+        }
+
+        return _ParseWav(a_sError);
+    }
+
+    void Close()
+    {
+        if (map != NULL)
+            munmap((void*) map, mapSize);
+
+        map = data = NULL;
+        mapSize = 0;
+        frames = 0;
+    }
+
+    //RRS: Decodes a_nFrames frames starting at a_nFrame into planar float buffers (one per channel)
+    void ReadPlanar(int64_t a_nFrame, int a_nFrames, float** a_vChannels) const
+    {
+        const size_t frameBytes = (size_t) (channels * bytesPerSample);
+        const uint8_t* src = data + (size_t) a_nFrame * frameBytes;
+
+        for (int i = 0; i < a_nFrames; ++i, src += frameBytes)
+            for (int c = 0; c < channels; ++c)
+                a_vChannels[c][i] = _Decode(src + c * bytesPerSample);
+    }
+
+    float _Decode(const uint8_t* p) const
+    {
+        switch (encoding)
+        {
+            case kSampleInt16:
+                return (float) (int16_t) (p[0] | (p[1] << 8)) * (1.f / 32768.f);
+
+            case kSampleInt24:
+            {
+                int32_t v = (int32_t) ((uint32_t) p[0] << 8 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 24) >> 8;
+                return (float) v * (1.f / 8388608.f);
+            }
+
+            case kSampleInt32:
+            {
+                int32_t v;
+                memcpy(&v, p, 4);
+                return (float) ((double) v * (1.0 / 2147483648.0));
+            }
+
+            default:
+            {
+                float v;
+                memcpy(&v, p, 4);
+                return v;
+            }
+        }
+    }
+
+    static uint32_t _U32(const uint8_t* p) { return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24; }
+    static uint16_t _U16(const uint8_t* p) { return (uint16_t) (p[0] | p[1] << 8); }
+
+    bool _ParseWav(std::string& a_sError)
+    {
+        if (mapSize < 12 || memcmp(map, "RIFF", 4) != 0 || memcmp(map + 8, "WAVE", 4) != 0)
+            return _Fail(a_sError, "not a RIFF/WAVE file");
+
+        bool bFormat = false;
+        int bits = 0;
+        uint16_t tag = 0;
+        size_t pos = 12;
+
+        while (pos + 8 <= mapSize)
+        {
+            const uint8_t* chunk = map + pos;
+            size_t size = _U32(chunk + 4);
+            const uint8_t* body = chunk + 8;
+
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+            {
+                tag = _U16(body);
+                channels = _U16(body + 2);
+                sampleRate = _U32(body + 4);
+                bits = _U16(body + 14);
+
+                if (tag == 0xFFFE && size >= 26)
+                    tag = _U16(body + 24);      // first two bytes of the sub-format GUID
+
+                bFormat = true;
+            }
+            else if (memcmp(chunk, "data", 4) == 0)
+            {
+                if (! bFormat)
+                    return _Fail(a_sError, "data chunk before fmt chunk");
+
+                if (tag == 1 && bits == 16)         encoding = kSampleInt16;
+                else if (tag == 1 && bits == 24)    encoding = kSampleInt24;
+                else if (tag == 1 && bits == 32)    encoding = kSampleInt32;
+                else if (tag == 3 && bits == 32)    encoding = kSampleFloat32;
+                else
+                    return _Fail(a_sError, "unsupported sample format");
+
+                if (channels <= 0)
+                    return _Fail(a_sError, "no channels");
+
+                bytesPerSample = bits / 8;
+                data = body;
+
+                // Files still being written (or streamed) often carry a 0 or oversized data length
+                size_t available = mapSize - (size_t) (body - map);
+                size_t bytes = size == 0 || size > available ? available : size;
+                frames = (int64_t) (bytes / (size_t) (channels * bytesPerSample));
+                return true;
+            }
+
+            pos += 8 + size + (size & 1);
+        }
+
+        return _Fail(a_sError, "no data chunk");
+    }
+
+    bool _Fail(std::string& a_sError, const char* a_sWhat)
+    {
+        a_sError = a_sWhat;
+        Close();
+        return false;
+    }
+};
+
+//RRS: 44-byte header of an IEEE float WAV; written before the data since the length is known up front
+static inline void write_float_wav_header(FILE* a_pFile, int a_nChannels, double a_fSampleRate, int64_t a_nFrames)
+{
+    uint8_t h[44];
+    uint32_t dataBytes = (uint32_t) (a_nFrames * a_nChannels * 4);
+    uint32_t rate = (uint32_t) a_fSampleRate;
+
+    auto u32 = [&](int at, uint32_t v) { h[at] = (uint8_t) v; h[at + 1] = (uint8_t) (v >> 8); h[at + 2] = (uint8_t) (v >> 16); h[at + 3] = (uint8_t) (v >> 24); };
+    auto u16 = [&](int at, uint16_t v) { h[at] = (uint8_t) v; h[at + 1] = (uint8_t) (v >> 8); };
+
+    memcpy(h, "RIFF", 4);
+    u32(4, 36 + dataBytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    u32(16, 16);
+    u16(20, 3);
+    u16(22, (uint16_t) a_nChannels);
+    u32(24, rate);
+    u32(28, rate * (uint32_t) a_nChannels * 4);
+    u16(32, (uint16_t) (a_nChannels * 4));
+    u16(34, 32);
+    memcpy(h + 36, "data", 4);
+    u32(40, dataBytes);
+
+    fwrite(h, 1, sizeof(h), a_pFile);
+}
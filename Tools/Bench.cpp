@@ -0,0 +1,650 @@
+
+// Red Rock Sound (RRS):
+// lr_bench: timings of the DSP hot path (DSP::Process() across block sizes, channel counts with and without worker threads, sample
+// rates, saturation modes, float or double samples and band meters open or not,
+// the batch engine against as many separate DSP instances, the worst callback of the low-latency linear-phase crossover, and the
+// per-sample Filter and tubeSaturation() kernels) with an optional regression gate against a stored baseline.
+//
+//   lr_bench [--json <out>] [--baseline <in>] [--tolerance <percent>] [--filter <substring>] [--quick]
+//
+// Each case runs for a fixed time, several times over, and keeps the fastest run. Audio is processed in place over a long noise
+// ring, so every call sees fresh data without a copy. Denormals are flushed, as under the plugin's ScopedNoDenormals.
+// Cycles are TSC (reference) cycles, so they track ns at the TSC frequency, not the core clock under turbo.
+// With --baseline, a case more than --tolerance percent (default 10) slower per sample than in the baseline fails the run.
+
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <functional>
+
+#include "../Source/DSP.h"
+#include "../Source/DSPBatch.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <x86intrin.h>
+#define RRS_BENCH_TSC 1
+#endif
+
+struct BenchResult
+{
+    std::string name;
+    double nsPerSample;
+    double cyclesPerSample;     // 0 where there is no TSC
+    double percentRealtime;     // processing time over audio time, for one instance
+};
+
+struct BenchOptions
+{
+    double secondsPerRun = 0.05;
+    int runs = 5;
+    std::string filter;
+};
+
+static uint64_t read_cycles()
+{
+#ifdef RRS_BENCH_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+//RRS: a_fnStep() processes some samples and returns how many; it is called until the run time is up, and the fastest run is kept
+static BenchResult time_case(const std::string& a_sName, double a_fSampleRate, const BenchOptions& o, const std::function<int64_t()>& a_fnStep)
+{
+    // Warm up caches, branch predictors and the crossover glide that SetSampleRate() may have started
+    for (int i = 0; i < 100; ++i)
+        a_fnStep();
+
+    double bestNs = 1e300, bestCycles = 0;
+
+    for (int run = 0; run < o.runs; ++run)
+    {
+        int64_t samples = 0;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t c0 = read_cycles();
+        double elapsed = 0;
+
+        do
+        {
+            // Check the clock only every few steps, so tiny blocks are not dominated by it
+            for (int i = 0; i < 16; ++i)
+                samples += a_fnStep();
+
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < o.secondsPerRun);
+
+        uint64_t c1 = read_cycles();
+        double ns = elapsed * 1e9 / (double) samples;
+
+        if (ns < bestNs)
+        {
+            bestNs = ns;
+            bestCycles = (double) (c1 - c0) / (double) samples;
+        }
+    }
+
+    BenchResult r = { a_sName, bestNs, bestCycles, bestNs * 1e-9 * a_fSampleRate * 100.0 };
+    return r;
+}
+
+struct ProcessCase
+{
+    TIntegerParamType block = 512;
+    TIntegerParamType channels = 2;
+    TFloatParamType fs = 48000.f;
+    std::string mode = "naive";     // naive, adaa1, adaa2, os2, os4, os4ll, bands4, lin4095 (uniform), lin4095ll (low-latency)
+    TIntegerParamType workers = 0;  // WorkerPool threads next to the calling one
+    bool bDouble = false;           // DSPT<double> instead of DSP
+    bool bSilent = false;           // Digital silence in, so the DSP idles once the crossover has rung out
+    bool bMetered = false;          // Band meters attached, as while an editor is open
+    std::string format;             // empty: planar through Process(); f32i, s16i or s24i: interleaved frames through ProcessInterleaved()
+
+    std::string Name() const
+    {
+        char s[128];
+        snprintf(s, sizeof(s), "process/%s/b%d/c%d/fs%d%s%s%s%s%s", mode.c_str(), block, channels, (int) fs,
+                 workers > 0 ? ("/w" + std::to_string(workers)).c_str() : "", bDouble ? "/f64" : "", bSilent ? "/silent" : "",
+                 format.empty() ? "" : ("/" + format).c_str(), bMetered ? "/metered" : "");
+        return s;
+    }
+};
+
+enum { kRingSamples = 1 << 16 };
+
+template <typename TSample>
+static BenchResult bench_process(const ProcessCase& c, const BenchOptions& o)
+{
+    WorkerPool pool;
+    pool.Start(c.workers);
+
+    DSPT<TSample> d;
+    d.Init();
+    d.SetWorkerPool(c.workers > 0 ? &pool : NULL);
+    d.SetMaxChannels(c.channels);
+    d.SetMaxBlockSize(c.block);
+    d.SetCrossoverFrequency(1000.f);
+    d.SetDrive(2.f);
+
+    if (c.mode == "bands4")
+        d.SetNumBands(4);
+
+    d.SetSampleRate(c.fs);
+
+    BandMeterBuffer meters;
+    if (c.bMetered)
+        d.SetTelemetry(&meters, NULL);
+
+    if (c.mode == "adaa1" || c.mode == "adaa2")
+        d.SetSaturationMode(c.mode == "adaa1" ? kSaturationADAA1 : kSaturationADAA2);
+    else if (c.mode == "os2" || c.mode == "os4" || c.mode == "os4ll")
+        d.SetOversampling(c.mode == "os2" ? 2 : 4, c.mode == "os4ll" ? kOversamplingLowLatency : kOversamplingQuality);
+    else if (c.mode == "lin4095" || c.mode == "lin4095ll")
+        d.SetLinearPhase(c.mode == "lin4095" ? kLinearPhaseUniform : kLinearPhaseLowLatency, 4095);
+
+    // A ring of noise, walked block by block; the crossover is near-allpass and the saturator bounded, so the level holds
+    const int64_t ring = kRingSamples - kRingSamples % c.block;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+    std::vector<TSample> audio((size_t) (ring * c.channels));
+    for (TSample& v : audio)
+        v = c.bSilent ? (TSample) 0 : dist(rng);
+
+    std::vector<TSample*> ptrs((size_t) c.channels);
+    int64_t pos = 0;
+
+    // The same ring as interleaved frames in each format (the integer ones at about -6 dBFS)
+    std::vector<int16_t> s16(audio.size());
+    std::vector<Int24> s24(audio.size());
+    convert_to_int(audio.data(), s16.data(), audio.size(), NULL, kSimdScalar);
+    convert_to_int(audio.data(), s24.data(), audio.size(), NULL, kSimdScalar);
+
+    BenchResult r = time_case(c.Name(), c.fs, o, [&]()
+    {
+        size_t frame = (size_t) (pos * c.channels);
+
+        if (c.format == "f32i")
+            d.ProcessInterleaved(audio.data() + frame, c.channels, c.block);
+        else if (c.format == "s16i")
+            d.ProcessInterleaved(s16.data() + frame, c.channels, c.block);
+        else if (c.format == "s24i")
+            d.ProcessInterleaved(s24.data() + frame, c.channels, c.block);
+        else
+        {
+            for (TIntegerParamType ch = 0; ch < c.channels; ++ch)
+                ptrs[(size_t) ch] = audio.data() + ch * ring + pos;
+
+            d.Process(ptrs.data(), c.channels, c.block);
+        }
+
+        pos = pos + c.block < ring ? pos + c.block : 0;
+
+        return (int64_t) c.block * c.channels;
+    });
+
+    d.Release();
+    return r;
+}
+
+// Many mono streams at one block size: SaturatorBatch against one DSP per stream, the way a server would otherwise run them.
+// Same settings (naive saturator, no smoothing in flight), per-stream crossover and drive; ns are per stream sample.
+static std::vector<BenchResult> bench_batch(const BenchOptions& o, bool a_bQuick, const std::function<bool(const std::string&)>& a_fnWanted)
+{
+    std::vector<BenchResult> results;
+    const TFloatParamType fs = 48000.f;
+    const TIntegerParamType block = 64;
+
+    for (TIntegerParamType nVoices : a_bQuick ? std::vector<TIntegerParamType> { 256 } : std::vector<TIntegerParamType> { 8, 64, 256 })
+    {
+        const int64_t ring = kRingSamples / 16 - (kRingSamples / 16) % block;
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+        std::vector<float> audio((size_t) (ring * nVoices));
+        for (float& v : audio)
+            v = dist(rng);
+
+        std::vector<TAudioSampleType*> ptrs((size_t) nVoices);
+        int64_t pos = 0;
+
+        auto step = [&](const std::function<void()>& a_fnProcess)
+        {
+            for (TIntegerParamType v = 0; v < nVoices; ++v)
+                ptrs[(size_t) v] = audio.data() + v * ring + pos;
+
+            a_fnProcess();
+            pos = pos + block < ring ? pos + block : 0;
+            return (int64_t) block * nVoices;
+        };
+
+        char name[64];
+        snprintf(name, sizeof(name), "batch/v%d/b%d", nVoices, block);
+        if (a_fnWanted(name))
+        {
+            SaturatorBatch b;
+            b.Init();
+            b.SetMaxVoices(nVoices);
+            for (TIntegerParamType v = 0; v < nVoices; ++v)
+                b.AddVoice(200.f + 10.f * v, 1.f + 0.01f * v, 1.f, 1.f);
+            b.SetSampleRate(fs);
+
+            results.push_back(time_case(name, fs, o, [&]() { return step([&]() { b.Process(ptrs.data(), nVoices, block); }); }));
+            b.Release();
+        }
+
+        snprintf(name, sizeof(name), "instances/v%d/b%d", nVoices, block);
+        if (a_fnWanted(name))
+        {
+            std::vector<DSP> dsps((size_t) nVoices);
+            for (TIntegerParamType v = 0; v < nVoices; ++v)
+            {
+                DSP& d = dsps[(size_t) v];
+                d.Init();
+                d.SetMaxChannels(1);
+                d.SetMaxBlockSize(block);
+                d.SetCrossoverFrequency(200.f + 10.f * v);
+                d.SetDrive(1.f + 0.01f * v);
+                d.SetSampleRate(fs);
+            }
+
+            results.push_back(time_case(name, fs, o, [&]()
+            {
+                return step([&]()
+                {
+                    for (TIntegerParamType v = 0; v < nVoices; ++v)
+                        dsps[(size_t) v].Process(&ptrs[(size_t) v], 1, block);
+                });
+            }));
+
+            for (DSP& d : dsps)
+                d.Release();
+        }
+    }
+
+    return results;
+}
+
+// The slowest Process() call over a stretch of 64-sample blocks against the average one, in ns per sample of the block, with the
+// low-latency linear-phase crossover: the long partitions' FFTs show here if they land in one callback rather than spread out.
+// The worst is the smallest of the runs' worsts, so a preemption in one run does not count
+static std::vector<BenchResult> bench_callbacks(const BenchOptions& o, const std::function<bool(const std::string&)>& a_fnWanted)
+{
+    std::vector<BenchResult> results;
+    const TFloatParamType fs = 48000.f;
+    const TIntegerParamType block = 64, channels = 2;
+
+    for (TIntegerParamType kernel : { 4095, 32767 })
+    {
+        const std::string name = "callback/lin" + std::to_string(kernel) + "ll/b64/c2/fs48000";
+        if (! a_fnWanted(name + "/worst") && ! a_fnWanted(name + "/mean"))
+            continue;
+
+        DSP d;
+        d.Init();
+        d.SetMaxChannels(channels);
+        d.SetMaxBlockSize(block);
+        d.SetCrossoverFrequency(1000.f);
+        d.SetSampleRate(fs);
+        d.SetLinearPhase(kLinearPhaseLowLatency, kernel);
+
+        const int64_t ring = kRingSamples;
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+        std::vector<float> audio((size_t) (ring * channels));
+        for (float& v : audio)
+            v = dist(rng);
+
+        std::vector<float*> ptrs((size_t) channels);
+        int64_t pos = 0;
+
+        // At least a few periods of the longest partition (4096 blocks of 64 for the longest kernels)
+        const int64_t nCalls = (int64_t) (o.secondsPerRun * fs / block) > 8192 ? (int64_t) (o.secondsPerRun * fs / block) : 8192;
+        double bestWorst = 1e300, bestMean = 1e300;
+
+        for (int run = 0; run < o.runs; ++run)
+        {
+            double worst = 0, total = 0;
+
+            for (int64_t k = 0; k < nCalls; ++k)
+            {
+                for (TIntegerParamType ch = 0; ch < channels; ++ch)
+                    ptrs[(size_t) ch] = audio.data() + ch * ring + pos;
+
+                auto start = std::chrono::steady_clock::now();
+                d.Process(ptrs.data(), channels, block);
+                double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+                worst = ns > worst ? ns : worst;
+                total += ns;
+                pos = pos + block < ring ? pos + block : 0;
+            }
+
+            bestWorst = worst < bestWorst ? worst : bestWorst;
+            bestMean = total / (double) nCalls < bestMean ? total / (double) nCalls : bestMean;
+        }
+
+        for (bool bWorst : { true, false })
+        {
+            double ns = (bWorst ? bestWorst : bestMean) / (double) (block * channels);
+            BenchResult r = { name + (bWorst ? "/worst" : "/mean"), ns, 0, ns * 1e-9 * fs * 100.0 };
+            if (a_fnWanted(r.name))
+                results.push_back(r);
+        }
+
+        d.Release();
+    }
+
+    return results;
+}
+
+// The per-sample building blocks, one call per sample as the scalar paths use them
+static std::vector<BenchResult> bench_kernels(const BenchOptions& o, const std::function<bool(const std::string&)>& a_fnWanted)
+{
+    std::vector<BenchResult> results;
+    const TFloatParamType fs = 48000.f;
+
+    std::vector<float> x(4096);
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+    for (float& v : x)
+        v = dist(rng);
+
+    Filter f;
+    f.lpfLRCoeffs(1000.f, fs);
+    f.hpfLRCoeffs(1000.f, fs);
+    const LRCoefficients lp = f.lpfCoeffs, hp = f.hpfCoeffs;
+
+    // Outputs go to a volatile sink so the loops cannot be dropped
+    volatile float sink = 0.f;
+    TFloatParamType s1 = 0.f, s2 = 0.f;
+
+    auto add = [&](const char* a_sName, const std::function<int64_t()>& a_fnStep)
+    {
+        if (a_fnWanted(a_sName))
+            results.push_back(time_case(a_sName, fs, o, a_fnStep));
+    };
+
+    add("kernel/lowpass_filter", [&]()
+    {
+        float acc = 0.f;
+        for (float v : x)
+            acc += f.lowpass_filter(v, &s1, &s2, lp.a0, lp.a1, lp.a2, lp.b1, lp.b2);
+        sink = acc;
+        return (int64_t) x.size();
+    });
+
+    s1 = s2 = 0.f;
+    add("kernel/highpass_filter", [&]()
+    {
+        float acc = 0.f;
+        for (float v : x)
+            acc += f.highpass_filter(v, &s1, &s2, hp.a0, hp.a1, hp.a2, hp.b1, hp.b2);
+        sink = acc;
+        return (int64_t) x.size();
+    });
+
+    DSP d;
+    d.Init();
+
+    add("kernel/tubeSaturation", [&]()
+    {
+        float acc = 0.f;
+        for (float v : x)
+            acc += d.tubeSaturation(2.f * v, 0.7f);
+        sink = acc;
+        return (int64_t) x.size();
+    });
+
+    std::vector<float> block(x);
+    add("kernel/saturateBlock", [&]()
+    {
+        memcpy(block.data(), x.data(), x.size() * sizeof(float));
+        d.saturateBlock(block.data(), (TIntegerParamType) block.size(), 2.f, 0.7f);
+        sink = block[0];
+        return (int64_t) x.size();
+    });
+
+    (void) sink;
+    return results;
+}
+
+static std::vector<ProcessCase> process_cases(bool a_bQuick)
+{
+    std::vector<ProcessCase> cases;
+    ProcessCase c;
+
+    // Block sizes, 1 to 4096
+    std::vector<TIntegerParamType> blocks = a_bQuick ? std::vector<TIntegerParamType> { 1, 64, 4096 }
+                                                     : std::vector<TIntegerParamType> { 1, 4, 16, 64, 256, 1024, 4096 };
+    for (TIntegerParamType b : blocks)
+    {
+        c = ProcessCase();
+        c.block = b;
+        cases.push_back(c);
+    }
+
+    for (const char* mode : { "adaa1", "adaa2", "os2", "os4", "os4ll", "bands4", "lin4095", "lin4095ll" })
+    {
+        c = ProcessCase();
+        c.mode = mode;
+        cases.push_back(c);
+    }
+
+    for (TIntegerParamType ch : { 1, 6, 8 })
+    {
+        c = ProcessCase();
+        c.channels = ch;
+        cases.push_back(c);
+    }
+
+    for (TFloatParamType fs : { 44100.f, 96000.f, 192000.f })
+    {
+        c = ProcessCase();
+        c.fs = fs;
+        cases.push_back(c);
+    }
+
+    // Immersive buses (7.1.4, 3rd-order ambisonics) on the calling thread alone and spread over workers, one per extra channel group
+    for (TIntegerParamType ch : { 12, 16 })
+        for (TIntegerParamType workers : { 0, (ch + 3) / 4 - 1 })
+        {
+            c = ProcessCase();
+            c.block = 256;
+            c.channels = ch;
+            c.workers = workers;
+            cases.push_back(c);
+        }
+
+    // Double precision, as 64-bit hosts render: the default case, a low crossover at 192 kHz and the oversampled path
+    for (const char* mode : { "naive", "os4" })
+        for (TFloatParamType fs : { 48000.f, 192000.f })
+        {
+            c = ProcessCase();
+            c.mode = mode;
+            c.fs = fs;
+            c.bDouble = true;
+            cases.push_back(c);
+        }
+
+    // Interleaved frames as streaming integrations deliver them, against the planar default case above
+    for (const char* format : { "", "f32i", "s16i", "s24i" })
+    {
+        c = ProcessCase();
+        c.format = format;
+        cases.push_back(c);
+    }
+
+    // Band meters open, against the same cases closed: mono (scalar loop), stereo (SSE2), 8 channels (AVX2), double and multiband
+    for (TIntegerParamType ch : { 1, 2, 8 })
+        for (bool bDouble : { false, true })
+        {
+            c = ProcessCase();
+            c.channels = ch;
+            c.bDouble = bDouble;
+            c.bMetered = true;
+            cases.push_back(c);
+
+            if (ch != 2 && bDouble)
+            {
+                c.bMetered = false;
+                cases.push_back(c);
+            }
+        }
+
+    c = ProcessCase();
+    c.mode = "bands4";
+    c.bMetered = true;
+    cases.push_back(c);
+
+    // Silent input: the cost of a track that plays nothing, once the DSP has gone idle
+    for (const char* mode : { "naive", "os4", "bands4" })
+    {
+        c = ProcessCase();
+        c.mode = mode;
+        c.bSilent = true;
+        cases.push_back(c);
+    }
+
+    return cases;
+}
+
+static void write_json(const std::string& a_sPath, const std::vector<BenchResult>& results)
+{
+    FILE* f = fopen(a_sPath.c_str(), "w");
+    if (f == NULL)
+    {
+        fprintf(stderr, "cannot write %s\n", a_sPath.c_str());
+        return;
+    }
+
+    // One case per line, so the baseline reader (and diff) can take it line by line
+    fprintf(f, "{\n  \"simd_level\": %d,\n  \"cases\": [\n", (int) simd_detect_level());
+    for (size_t i = 0; i < results.size(); ++i)
+        fprintf(f, "    {\"name\": \"%s\", \"ns_per_sample\": %.4f, \"cycles_per_sample\": %.3f, \"percent_realtime\": %.5f}%s\n",
+                results[i].name.c_str(), results[i].nsPerSample, results[i].cyclesPerSample, results[i].percentRealtime,
+                i + 1 < results.size() ? "," : "");
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+// Reads what write_json() writes: name -> ns_per_sample
+static bool read_baseline(const std::string& a_sPath, std::map<std::string, double>& a_mBaseline)
+{
+    FILE* f = fopen(a_sPath.c_str(), "r");
+    if (f == NULL)
+        return false;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        const char* name = strstr(line, "\"name\": \"");
+        const char* ns = strstr(line, "\"ns_per_sample\": ");
+        if (name == NULL || ns == NULL)
+            continue;
+
+        name += strlen("\"name\": \"");
+        const char* end = strchr(name, '"');
+        if (end != NULL)
+            a_mBaseline[std::string(name, end)] = atof(ns + strlen("\"ns_per_sample\": "));
+    }
+
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions o;
+    std::string jsonPath, baselinePath;
+    double tolerance = 10.0;
+    bool bQuick = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        bool bHasValue = i + 1 < argc;
+
+        if (a == "--json" && bHasValue)              jsonPath = argv[++i];
+        else if (a == "--baseline" && bHasValue)     baselinePath = argv[++i];
+        else if (a == "--tolerance" && bHasValue)    tolerance = atof(argv[++i]);
+        else if (a == "--filter" && bHasValue)       o.filter = argv[++i];
+        else if (a == "--quick")                     bQuick = true;
+        else
+        {
+            fprintf(stderr, "usage: lr_bench [--json <out>] [--baseline <in>] [--tolerance <percent>] [--filter <substring>] [--quick]\n");
+            return 2;
+        }
+    }
+
+    if (bQuick)
+    {
+        o.secondsPerRun = 0.01;
+        o.runs = 3;
+    }
+
+#if defined(__SSE2__) || defined(_M_X64)
+    _mm_setcsr(_mm_getcsr() | 0x8040);  // FTZ | DAZ
+#endif
+
+    std::vector<BenchResult> results;
+    auto wanted = [&](const std::string& name) { return o.filter.empty() || name.find(o.filter) != std::string::npos; };
+
+    printf("%-40s %12s %14s %12s\n", "case", "ns/sample", "cycles/sample", "% realtime");
+
+    auto report = [&](const BenchResult& r)
+    {
+        printf("%-40s %12.3f %14.2f %12.4f\n", r.name.c_str(), r.nsPerSample, r.cyclesPerSample, r.percentRealtime);
+        fflush(stdout);
+        results.push_back(r);
+    };
+
+    for (const ProcessCase& c : process_cases(bQuick))
+        if (wanted(c.Name()))
+            report(c.bDouble ? bench_process<double>(c, o) : bench_process<float>(c, o));
+
+    for (const BenchResult& r : bench_batch(o, bQuick, wanted))
+        report(r);
+
+    for (const BenchResult& r : bench_callbacks(o, wanted))
+        report(r);
+
+    for (const BenchResult& r : bench_kernels(o, wanted))
+        report(r);
+
+    if (! jsonPath.empty())
+        write_json(jsonPath, results);
+
+    if (baselinePath.empty())
+        return 0;
+
+    std::map<std::string, double> baseline;
+    if (! read_baseline(baselinePath, baseline))
+    {
+        fprintf(stderr, "cannot read baseline %s\n", baselinePath.c_str());
+        return 2;
+    }
+
+    int nRegressions = 0;
+    for (const BenchResult& r : results)
+    {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0)
+            continue;
+
+        double change = (r.nsPerSample / it->second - 1.0) * 100.0;
+        if (change > tolerance)
+        {
+            printf("REGRESSION %s: %.3f ns/sample vs %.3f baseline (+%.1f%%)\n", r.name.c_str(), r.nsPerSample, it->second, change);
+            ++nRegressions;
+        }
+    }
+
+    printf("%d regression(s) over %.1f%% against %s\n", nRegressions, tolerance, baselinePath.c_str());
+    return nRegressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,441 @@
+
+// Red Rock Sound (RRS):
+// lr_render: headless batch renderer around DSP::Process(), for running the saturator outside a plugin host.
+// Input files are memory-mapped and decoded block by block; output goes through a double buffer, so the disk write of one block
+// overlaps the processing of the next. Files are shared out to a pool of workers, each with its own DSP instance.
+//
+//   lr_render [options] -o <dir> <file>...
+//
+// Output is 32-bit float WAV named after the input. Latency (oversampling, ADAA, linear phase) is compensated, so output and input line up.
+// With --parallel-file, files are instead rendered one at a time, each cut into chunks across the workers (see DSPOffline.h);
+// that needs the whole file in memory, but keeps every core busy on a few very long files.
+
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+#include "../Source/DSP.h"
+#include "../Source/DSPOffline.h"
+#include "AudioFile.h"
+
+struct RenderSettings
+{
+    TFloatParamType crossover = 5000.f;
+    std::vector<TFloatParamType> splits;    // further splits above the crossover, one more band each
+    TFloatParamType drive = 1.f;
+    TFloatParamType mix = 1.f;
+    TFloatParamType gain_dB = 0.f;
+    TIntegerParamType oversampling = 1;
+    TIntegerParamType oversamplingMode = kOversamplingQuality;
+    TIntegerParamType saturationMode = kSaturationNaive;
+    TIntegerParamType linearPhaseTaps = 0;  // 0: LR2 crossover; otherwise the kernel length of the linear-phase one
+    TIntegerParamType blockSize = 8192;
+    int threads = 0;                        // 0: one per hardware thread
+    bool parallelFile = false;              // chunks of one file across the workers instead of one file per worker
+    bool raw = false;
+    int rawChannels = 0;
+    double rawSampleRate = 0;
+    std::string outputDir;
+    std::string suffix = "_lr";
+};
+
+//RRS: Two interleaved buffers and a thread that writes one while the caller fills the other
+class DoubleBufferedWriter
+{
+public:
+    DoubleBufferedWriter() : _thread(&DoubleBufferedWriter::_Run, this) {}
+
+    ~DoubleBufferedWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _bQuit = true;
+        }
+        _cv.notify_all();
+        _thread.join();
+    }
+
+    // The buffer to fill next; never the one being written
+    float* Buffer(size_t a_nFloats)
+    {
+        if (_buffers[_nCurrent].size() < a_nFloats)
+            _buffers[_nCurrent].resize(a_nFloats);
+        return _buffers[_nCurrent].data();
+    }
+
+    // Queues the first a_nFloats of Buffer() for writing to a_pFile and flips to the other buffer
+    void Submit(FILE* a_pFile, size_t a_nFloats)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this] { return ! _bBusy; });
+
+        _pFile = a_pFile;
+        _pPending = _buffers[_nCurrent].data();
+        _nPending = a_nFloats;
+        _bBusy = true;
+        _nCurrent ^= 1;
+
+        lock.unlock();
+        _cv.notify_all();
+    }
+
+    // Waits for the last Submit(); returns false if any write since the previous Flush() came up short
+    bool Flush()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this] { return ! _bBusy; });
+
+        bool bOk = ! _bError;
+        _bError = false;
+        return bOk;
+    }
+
+private:
+    void _Run()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        for (;;)
+        {
+            _cv.wait(lock, [this] { return _bBusy || _bQuit; });
+
+            if (! _bBusy)
+                return;
+
+            FILE* file = _pFile;
+            const float* data = _pPending;
+            size_t n = _nPending;
+
+            lock.unlock();
+            bool bOk = fwrite(data, sizeof(float), n, file) == n;
+            lock.lock();
+
+            _bError = _bError || ! bOk;
+            _bBusy = false;
+            _cv.notify_all();
+        }
+    }
+
+    std::vector<float> _buffers[2];
+    int _nCurrent = 0;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    FILE* _pFile = NULL;
+    const float* _pPending = NULL;
+    size_t _nPending = 0;
+    bool _bBusy = false;
+    bool _bQuit = false;
+    bool _bError = false;
+
+    std::thread _thread;    // last, so it starts after the members above exist
+};
+
+struct FileReport
+{
+    std::string error;
+    double audioSeconds = 0;
+    double renderSeconds = 0;
+    OfflineProcessResult chunks = { 1, 0, 0.0, 0.0, true };
+};
+
+static std::string output_path(const std::string& a_sInput, const RenderSettings& s)
+{
+    size_t slash = a_sInput.find_last_of('/');
+    std::string name = slash == std::string::npos ? a_sInput : a_sInput.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+
+    if (dot != std::string::npos && dot > 0)
+        name = name.substr(0, dot);
+
+    return s.outputDir + "/" + name + s.suffix + ".wav";
+}
+
+// Same order as PluginProcessor::prepareToPlay(); parameters are set before SetSampleRate() so nothing glides
+static void prepare(DSP& dsp, int a_nChannels, double a_fSampleRate, const RenderSettings& s)
+{
+    dsp.Init();
+    dsp.SetMaxChannels(a_nChannels);
+    dsp.SetMaxBlockSize(s.blockSize);
+    dsp.SetCrossoverFrequency(s.crossover);
+
+    dsp.SetNumBands(2 + (TIntegerParamType) s.splits.size());
+    for (size_t k = 0; k < s.splits.size(); ++k)
+        dsp.SetBandCrossoverFrequency((TIntegerParamType) k + 1, s.splits[k]);
+
+    dsp.SetGain((TFloatParamType) pow(10.0, s.gain_dB / 20.0));
+    dsp.SetDrive(s.drive);
+    dsp.SetMix(s.mix);
+    dsp.SetSampleRate((TFloatParamType) a_fSampleRate);
+    dsp.SetOversampling(s.oversampling, s.oversamplingMode);
+    dsp.SetSaturationMode(s.saturationMode);
+
+    // Latency is compensated anyway, so the cheaper uniform partitioning
+    if (s.linearPhaseTaps > 0)
+        dsp.SetLinearPhase(kLinearPhaseUniform, s.linearPhaseTaps);
+}
+
+static void render_file(const std::string& a_sInput, const RenderSettings& s, DSP& dsp, DoubleBufferedWriter& writer, FileReport& report)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    MappedAudioFile in;
+    if (! in.Open(a_sInput, s.raw, s.rawChannels, s.rawSampleRate, report.error))
+        return;
+
+    std::string outPath = output_path(a_sInput, s);
+    FILE* out = fopen(outPath.c_str(), "wb");
+    if (out == NULL)
+    {
+        report.error = "cannot create " + outPath;
+        return;
+    }
+
+    const int nChannels = in.channels;
+    const TIntegerParamType block = s.blockSize;
+
+    prepare(dsp, nChannels, in.sampleRate, s);
+    const int64_t latency = dsp.GetLatencySamples();
+
+    std::vector<float> planar((size_t) nChannels * (size_t) block);
+    std::vector<TAudioSampleType*> channels((size_t) nChannels);
+    for (int c = 0; c < nChannels; ++c)
+        channels[(size_t) c] = planar.data() + (size_t) c * (size_t) block;
+
+    write_float_wav_header(out, nChannels, in.sampleRate, in.frames);
+
+    // Run latency extra frames of silence through, and drop as many from the front
+    const int64_t total = in.frames + latency;
+
+    for (int64_t pos = 0; pos < total; pos += block)
+    {
+        int n = (int) (total - pos < block ? total - pos : block);
+        int nInput = (int) (pos >= in.frames ? 0 : (in.frames - pos < n ? in.frames - pos : n));
+
+        in.ReadPlanar(pos, nInput, channels.data());
+        for (int c = 0; c < nChannels; ++c)
+            memset(channels[(size_t) c] + nInput, 0, (size_t) (n - nInput) * sizeof(float));
+
+        dsp.Process(channels.data(), nChannels, n);
+
+        int skip = pos >= latency ? 0 : (int) (latency - pos < n ? latency - pos : n);
+        int nOut = n - skip;
+
+        if (nOut == 0)
+            continue;
+
+        float* dst = writer.Buffer((size_t) nOut * (size_t) nChannels);
+
+        for (int i = 0; i < nOut; ++i)
+            for (int c = 0; c < nChannels; ++c)
+                *dst++ = channels[(size_t) c][skip + i];
+
+        writer.Submit(out, (size_t) nOut * (size_t) nChannels);
+    }
+
+    if (! writer.Flush() || fclose(out) != 0)
+        report.error = "write failed for " + outPath;
+
+    dsp.Release();
+
+    report.audioSeconds = (double) in.frames / in.sampleRate;
+    report.renderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Whole file in memory, processed by process_offline_parallel() on a_nThreads threads, then written out through the writer
+static void render_file_chunked(const std::string& a_sInput, const RenderSettings& s, int a_nThreads, DoubleBufferedWriter& writer, FileReport& report)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    MappedAudioFile in;
+    if (! in.Open(a_sInput, s.raw, s.rawChannels, s.rawSampleRate, report.error))
+        return;
+
+    std::string outPath = output_path(a_sInput, s);
+    FILE* out = fopen(outPath.c_str(), "wb");
+    if (out == NULL)
+    {
+        report.error = "cannot create " + outPath;
+        return;
+    }
+
+    const int nChannels = in.channels;
+    auto configure = [&](DSP& dsp) { prepare(dsp, nChannels, in.sampleRate, s); };
+
+    DSP probe;
+    configure(probe);
+    const int64_t latency = probe.GetLatencySamples();
+    probe.Release();
+
+    // Input padded with latency frames of silence, as in render_file()
+    const int64_t total = in.frames + latency;
+    std::vector<float> input((size_t) nChannels * (size_t) total, 0.f), output(input.size());
+    std::vector<const TAudioSampleType*> inputs((size_t) nChannels);
+    std::vector<TAudioSampleType*> outputs((size_t) nChannels);
+
+    for (int c = 0; c < nChannels; ++c)
+    {
+        inputs[(size_t) c] = input.data() + (size_t) c * (size_t) total;
+        outputs[(size_t) c] = output.data() + (size_t) c * (size_t) total;
+    }
+
+    in.ReadPlanar(0, (int) in.frames, const_cast<TAudioSampleType**>(inputs.data()));
+
+    report.chunks = process_offline_parallel(configure, inputs.data(), outputs.data(), nChannels, total, a_nThreads);
+    if (! report.chunks.bVerified)
+        report.error = "seam error above bound";
+
+    write_float_wav_header(out, nChannels, in.sampleRate, in.frames);
+
+    for (int64_t pos = latency; pos < total; pos += s.blockSize)
+    {
+        int n = (int) (total - pos < s.blockSize ? total - pos : s.blockSize);
+        float* dst = writer.Buffer((size_t) n * (size_t) nChannels);
+
+        for (int i = 0; i < n; ++i)
+            for (int c = 0; c < nChannels; ++c)
+                *dst++ = outputs[(size_t) c][pos + i];
+
+        writer.Submit(out, (size_t) n * (size_t) nChannels);
+    }
+
+    if (! writer.Flush() || fclose(out) != 0)
+        report.error = "write failed for " + outPath;
+
+    report.audioSeconds = (double) in.frames / in.sampleRate;
+    report.renderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void usage()
+{
+    fprintf(stderr,
+        "usage: lr_render [options] -o <dir> <file>...\n"
+        "  -o <dir>             output directory (required)\n"
+        "  -j <n>               worker threads (default: hardware threads)\n"
+        "  --parallel-file      split each file across the workers instead of one file per worker\n"
+        "  --block <n>          frames per DSP::Process() call (default 8192)\n"
+        "  --crossover <Hz>     low/high split (default 5000)\n"
+        "  --split <Hz>         one more band above the previous split; repeatable\n"
+        "  --drive <x>          saturator input gain (default 1)\n"
+        "  --mix <0..1>         saturated/dry blend (default 1)\n"
+        "  --gain <dB>          output gain (default 0)\n"
+        "  --oversampling <n>   1, 2, 4, 8 or 16 (default 1)\n"
+        "  --low-latency        IIR instead of linear-phase oversampling filters\n"
+        "  --adaa <0|1|2>       antiderivative anti-aliasing order (default 0)\n"
+        "  --linear-phase <n>   linear-phase crossover with an n-tap kernel (2 bands only)\n"
+        "  --raw                inputs are headless interleaved float32; needs --channels and --rate\n"
+        "  --channels <n>       channels of raw input\n"
+        "  --rate <Hz>          sample rate of raw input\n"
+        "  --suffix <s>         appended to output names (default _lr)\n");
+}
+
+int main(int argc, char** argv)
+{
+    RenderSettings s;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        bool bHasValue = i + 1 < argc;
+        auto value = [&]() { return std::string(argv[++i]); };
+
+        if (a == "-o" && bHasValue)                     s.outputDir = value();
+        else if (a == "-j" && bHasValue)                s.threads = atoi(value().c_str());
+        else if (a == "--parallel-file")                s.parallelFile = true;
+        else if (a == "--block" && bHasValue)           s.blockSize = atoi(value().c_str());
+        else if (a == "--crossover" && bHasValue)       s.crossover = (TFloatParamType) atof(value().c_str());
+        else if (a == "--split" && bHasValue)           s.splits.push_back((TFloatParamType) atof(value().c_str()));
+        else if (a == "--drive" && bHasValue)           s.drive = (TFloatParamType) atof(value().c_str());
+        else if (a == "--mix" && bHasValue)             s.mix = (TFloatParamType) atof(value().c_str());
+        else if (a == "--gain" && bHasValue)            s.gain_dB = (TFloatParamType) atof(value().c_str());
+        else if (a == "--oversampling" && bHasValue)    s.oversampling = atoi(value().c_str());
+        else if (a == "--low-latency")                  s.oversamplingMode = kOversamplingLowLatency;
+        else if (a == "--adaa" && bHasValue)            s.saturationMode = atoi(value().c_str());
+        else if (a == "--linear-phase" && bHasValue)    s.linearPhaseTaps = atoi(value().c_str());
+        else if (a == "--raw")                          s.raw = true;
+        else if (a == "--channels" && bHasValue)        s.rawChannels = atoi(value().c_str());
+        else if (a == "--rate" && bHasValue)            s.rawSampleRate = atof(value().c_str());
+        else if (a == "--suffix" && bHasValue)          s.suffix = value();
+        else if (a.size() > 1 && a[0] == '-')
+        {
+            usage();
+            return 2;
+        }
+        else
+            inputs.push_back(a);
+    }
+
+    if (s.outputDir.empty() || inputs.empty() || s.blockSize <= 0 || s.splits.size() + 2 > MultibandCrossover::kMaxBands)
+    {
+        usage();
+        return 2;
+    }
+
+    int nThreads = s.threads > 0 ? s.threads : (int) std::thread::hardware_concurrency();
+    nThreads = nThreads < 1 ? 1 : nThreads;
+    int nWorkers = s.parallelFile ? 1 : (nThreads > (int) inputs.size() ? (int) inputs.size() : nThreads);
+
+    std::vector<FileReport> reports(inputs.size());
+    std::atomic<size_t> next(0);
+    std::mutex printMutex;
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]()
+    {
+        DSP dsp;
+        DoubleBufferedWriter writer;
+
+        for (size_t i = next++; i < inputs.size(); i = next++)
+        {
+            if (s.parallelFile)
+                render_file_chunked(inputs[i], s, nThreads, writer, reports[i]);
+            else
+                render_file(inputs[i], s, dsp, writer, reports[i]);
+
+            const FileReport& r = reports[i];
+            std::lock_guard<std::mutex> lock(printMutex);
+
+            if (r.error.empty())
+            {
+                printf("%s: %.1f s audio, %.1fx realtime", inputs[i].c_str(), r.audioSeconds, r.audioSeconds / (r.renderSeconds > 0 ? r.renderSeconds : 1e-9));
+                if (r.chunks.nChunks > 1)
+                    printf(", %d chunks, pre-roll %d, seam error %.3g (bound %.3g)", r.chunks.nChunks, r.chunks.nPreRoll, r.chunks.seamError, r.chunks.errorBound);
+                printf("\n");
+            }
+            else
+                fprintf(stderr, "%s: %s\n", inputs[i].c_str(), reports[i].error.c_str());
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int w = 0; w < nWorkers; ++w)
+        pool.emplace_back(worker);
+    for (std::thread& t : pool)
+        t.join();
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double audio = 0;
+    int nFailed = 0;
+
+    for (const FileReport& r : reports)
+    {
+        audio += r.audioSeconds;
+        nFailed += r.error.empty() ? 0 : 1;
+    }
+
+    wall = wall > 0 ? wall : 1e-9;
+    printf("%zu file(s), %d failed, %.1f s audio in %.2f s on %d thread(s): %.1fx realtime, %.1fx realtime per core\n",
+           inputs.size(), nFailed, audio, wall, s.parallelFile ? nThreads : nWorkers, audio / wall, audio / (wall * (s.parallelFile ? nThreads : nWorkers)));
+
+    return nFailed == 0 ? 0 : 1;
+}